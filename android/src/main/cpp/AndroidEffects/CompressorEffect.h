@@ -0,0 +1,84 @@
+/*
+ * A feed-forward peak compressor with linked stereo detection.
+ * This is used on Android only, on iOS effects are AudioUnits in the AVAudioEngine graph
+ */
+
+#ifndef COMPRESSOR_EFFECT_H
+#define COMPRESSOR_EFFECT_H
+
+#include <algorithm>
+#include <cmath>
+#include "IEffect.h"
+
+// Remember to keep lib/models/effects.dart in sync with this file.
+enum CompressorParameter {
+    COMPRESSOR_THRESHOLD_DB = 0,
+    COMPRESSOR_RATIO = 1,
+    COMPRESSOR_ATTACK_MS = 2,
+    COMPRESSOR_RELEASE_MS = 3,
+    COMPRESSOR_MAKEUP_DB = 4,
+};
+
+class CompressorEffect : public IEffect {
+public:
+    void setSampleRate(int32_t sampleRate) override {
+        mSampleRate = sampleRate;
+        updateCoefficients();
+    }
+
+    void clear() override {
+        mEnvelopeDb = 0.0f;
+    }
+
+    void setParameter(uint8_t parameter, float value) override {
+        switch (parameter) {
+            case COMPRESSOR_THRESHOLD_DB: mThresholdDb = std::min(value, 0.0f); break;
+            case COMPRESSOR_RATIO: mRatio = std::max(value, 1.0f); break;
+            case COMPRESSOR_ATTACK_MS: mAttackMs = std::max(value, 0.01f); break;
+            case COMPRESSOR_RELEASE_MS: mReleaseMs = std::max(value, 0.01f); break;
+            case COMPRESSOR_MAKEUP_DB: mMakeupDb = value; break;
+            default: return;
+        }
+
+        updateCoefficients();
+    }
+
+    void process(float* audioData, int32_t numFrames) override {
+        const float slope = 1.0f - 1.0f / mRatio;
+
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            float& left = audioData[frame * 2];
+            float& right = audioData[frame * 2 + 1];
+
+            const float peak = std::max(std::fabs(left), std::fabs(right));
+            const float peakDb = 20.0f * std::log10(std::max(peak, 1e-6f));
+            const float overDb = std::max(peakDb - mThresholdDb, 0.0f);
+
+            // The envelope follows how far the signal is over the threshold
+            const float coefficient = overDb > mEnvelopeDb ? mAttackCoefficient : mReleaseCoefficient;
+            mEnvelopeDb = overDb + coefficient * (mEnvelopeDb - overDb);
+
+            const float gain = std::pow(10.0f, (mMakeupDb - mEnvelopeDb * slope) / 20.0f);
+            left *= gain;
+            right *= gain;
+        }
+    }
+
+private:
+    void updateCoefficients() {
+        mAttackCoefficient = std::exp(-1000.0f / (mAttackMs * mSampleRate));
+        mReleaseCoefficient = std::exp(-1000.0f / (mReleaseMs * mSampleRate));
+    }
+
+    int32_t mSampleRate = 44100;
+    float mThresholdDb = -12.0f;
+    float mRatio = 4.0f;
+    float mAttackMs = 10.0f;
+    float mReleaseMs = 100.0f;
+    float mMakeupDb = 0.0f;
+    float mAttackCoefficient = 0.0f;
+    float mReleaseCoefficient = 0.0f;
+    float mEnvelopeDb = 0.0f;
+};
+
+#endif //COMPRESSOR_EFFECT_H
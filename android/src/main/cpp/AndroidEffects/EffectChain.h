@@ -0,0 +1,73 @@
+/*
+ * This is used on Android only, on iOS effects are AudioUnits in the AVAudioEngine graph
+ */
+
+#ifndef EFFECT_CHAIN_H
+#define EFFECT_CHAIN_H
+
+#include <array>
+#include <atomic>
+#include "IEffect.h"
+
+constexpr int32_t kMaxEffectsPerChain = 4;
+
+/**
+ * A fixed number of effect slots that are processed in order. Slots are filled and emptied from a
+ * control thread while the audio thread processes the chain, so the chain never owns its effects;
+ * whoever removes an effect has to keep it alive until the audio thread can no longer be using it.
+ */
+class EffectChain {
+public:
+    // Returns the slot the effect was put in, or -1 if the chain is full.
+    int32_t add(IEffect* effect) {
+        for (int32_t slot = 0; slot < kMaxEffectsPerChain; slot++) {
+            IEffect* expected = nullptr;
+
+            if (mSlots[slot].compare_exchange_strong(expected, effect, std::memory_order_acq_rel)) {
+                return slot;
+            }
+        }
+
+        return -1;
+    }
+
+    // Returns the effect that was in the slot, or nullptr if it was empty.
+    IEffect* remove(int32_t slot) {
+        if (slot < 0 || slot >= kMaxEffectsPerChain) return nullptr;
+
+        return mSlots[slot].exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    bool isEmpty() {
+        for (auto& slot : mSlots) {
+            if (slot.load(std::memory_order_relaxed) != nullptr) return false;
+        }
+
+        return true;
+    }
+
+    void process(float* audioData, int32_t numFrames) {
+        for (auto& slot : mSlots) {
+            auto effect = slot.load(std::memory_order_acquire);
+
+            if (effect != nullptr) {
+                effect->process(audioData, numFrames);
+            }
+        }
+    }
+
+    void setParameter(uint8_t slot, uint8_t parameter, float value) {
+        if (slot >= kMaxEffectsPerChain) return;
+
+        auto effect = mSlots[slot].load(std::memory_order_acquire);
+
+        if (effect != nullptr) {
+            effect->setParameter(parameter, value);
+        }
+    }
+
+private:
+    std::array<std::atomic<IEffect*>, kMaxEffectsPerChain> mSlots = {};
+};
+
+#endif //EFFECT_CHAIN_H
@@ -0,0 +1,31 @@
+/*
+ * This is used on Android only, on iOS effects are AudioUnits in the AVAudioEngine graph
+ */
+
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <memory>
+#include "CompressorEffect.h"
+#include "EqEffect.h"
+#include "LimiterEffect.h"
+#include "ReverbEffect.h"
+
+// Returns nullptr for an unknown effect type. Must not be called from the audio thread.
+inline std::unique_ptr<IEffect> createEffect(int32_t effectType, int32_t sampleRate) {
+    std::unique_ptr<IEffect> effect;
+
+    switch (effectType) {
+        case EFFECT_REVERB: effect = std::make_unique<ReverbEffect>(); break;
+        case EFFECT_COMPRESSOR: effect = std::make_unique<CompressorEffect>(); break;
+        case EFFECT_EQ: effect = std::make_unique<EqEffect>(); break;
+        case EFFECT_LIMITER: effect = std::make_unique<LimiterEffect>(); break;
+        default: return nullptr;
+    }
+
+    effect->setSampleRate(sampleRate);
+    effect->clear();
+    return effect;
+}
+
+#endif //EFFECTS_H
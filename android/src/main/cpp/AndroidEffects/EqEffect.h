@@ -0,0 +1,111 @@
+/*
+ * A single band equalizer using the biquads from the Audio EQ Cookbook.
+ * This is used on Android only, on iOS effects are AudioUnits in the AVAudioEngine graph
+ */
+
+#ifndef EQ_EFFECT_H
+#define EQ_EFFECT_H
+
+#include <algorithm>
+#include <cmath>
+#include "IEffect.h"
+
+// Remember to keep lib/models/effects.dart in sync with this file.
+enum EqParameter {
+    EQ_FREQUENCY = 0,
+    EQ_GAIN_DB = 1,
+    EQ_Q = 2,
+    EQ_SHAPE = 3,
+};
+
+enum EqShape {
+    EQ_SHAPE_PEAK = 0,
+    EQ_SHAPE_LOW_SHELF = 1,
+    EQ_SHAPE_HIGH_SHELF = 2,
+};
+
+class EqEffect : public IEffect {
+public:
+    void setSampleRate(int32_t sampleRate) override {
+        mSampleRate = sampleRate;
+        updateCoefficients();
+    }
+
+    void clear() override {
+        for (auto& state : mState) {
+            state[0] = state[1] = 0.0f;
+        }
+    }
+
+    void setParameter(uint8_t parameter, float value) override {
+        switch (parameter) {
+            case EQ_FREQUENCY: mFrequency = std::clamp(value, 10.0f, mSampleRate * 0.49f); break;
+            case EQ_GAIN_DB: mGainDb = value; break;
+            case EQ_Q: mQ = std::max(value, 0.05f); break;
+            case EQ_SHAPE: mShape = static_cast<int32_t>(value); break;
+            default: return;
+        }
+
+        updateCoefficients();
+    }
+
+    void process(float* audioData, int32_t numFrames) override {
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            for (int32_t channel = 0; channel < 2; channel++) {
+                float& sample = audioData[frame * 2 + channel];
+                auto& state = mState[channel];
+
+                // Transposed direct form II
+                const float output = mB0 * sample + state[0];
+                state[0] = mB1 * sample - mA1 * output + state[1];
+                state[1] = mB2 * sample - mA2 * output;
+                sample = output;
+            }
+        }
+    }
+
+private:
+    void updateCoefficients() {
+        const float a = std::pow(10.0f, mGainDb / 40.0f);
+        const float w0 = 2.0f * static_cast<float>(M_PI) * mFrequency / mSampleRate;
+        const float cosW0 = std::cos(w0);
+        const float alpha = std::sin(w0) / (2.0f * mQ);
+
+        float b0, b1, b2, a0, a1, a2;
+
+        if (mShape == EQ_SHAPE_LOW_SHELF || mShape == EQ_SHAPE_HIGH_SHELF) {
+            const float sign = mShape == EQ_SHAPE_LOW_SHELF ? 1.0f : -1.0f;
+            const float twoSqrtAAlpha = 2.0f * std::sqrt(a) * alpha;
+
+            b0 = a * ((a + 1) - sign * (a - 1) * cosW0 + twoSqrtAAlpha);
+            b1 = sign * 2 * a * ((a - 1) - sign * (a + 1) * cosW0);
+            b2 = a * ((a + 1) - sign * (a - 1) * cosW0 - twoSqrtAAlpha);
+            a0 = (a + 1) + sign * (a - 1) * cosW0 + twoSqrtAAlpha;
+            a1 = -sign * 2 * ((a - 1) + sign * (a + 1) * cosW0);
+            a2 = (a + 1) + sign * (a - 1) * cosW0 - twoSqrtAAlpha;
+        } else {
+            b0 = 1 + alpha * a;
+            b1 = -2 * cosW0;
+            b2 = 1 - alpha * a;
+            a0 = 1 + alpha / a;
+            a1 = -2 * cosW0;
+            a2 = 1 - alpha / a;
+        }
+
+        mB0 = b0 / a0;
+        mB1 = b1 / a0;
+        mB2 = b2 / a0;
+        mA1 = a1 / a0;
+        mA2 = a2 / a0;
+    }
+
+    int32_t mSampleRate = 44100;
+    float mFrequency = 1000.0f;
+    float mGainDb = 0.0f;
+    float mQ = 0.707f;
+    int32_t mShape = EQ_SHAPE_PEAK;
+    float mB0 = 1.0f, mB1 = 0.0f, mB2 = 0.0f, mA1 = 0.0f, mA2 = 0.0f;
+    float mState[2][2] = {};
+};
+
+#endif //EQ_EFFECT_H
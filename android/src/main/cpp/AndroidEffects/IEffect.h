@@ -0,0 +1,33 @@
+/*
+ * This is used on Android only, on iOS effects are AudioUnits in the AVAudioEngine graph
+ */
+
+#ifndef IEFFECT_H
+#define IEFFECT_H
+
+#include <cstdint>
+
+// Remember to keep lib/models/effects.dart in sync with this file.
+enum EffectType {
+    EFFECT_REVERB = 0,
+    EFFECT_COMPRESSOR = 1,
+    EFFECT_EQ = 2,
+    EFFECT_LIMITER = 3,
+};
+
+/**
+ * An effect processes interleaved stereo audio in place. Modeled on sfz::Effect: it is created and
+ * sized off the audio thread, and process() and setParameter() are called from the audio thread.
+ */
+class IEffect {
+public:
+    virtual ~IEffect() = default;
+
+    // Allocates any buffers, so it must not be called from the audio thread.
+    virtual void setSampleRate(int32_t sampleRate) = 0;
+    virtual void clear() = 0;
+    virtual void setParameter(uint8_t parameter, float value) = 0;
+    virtual void process(float* audioData, int32_t numFrames) = 0;
+};
+
+#endif //IEFFECT_H
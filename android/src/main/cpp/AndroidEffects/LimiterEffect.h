@@ -0,0 +1,219 @@
+/*
+ * A look-ahead true-peak limiter with linked stereo detection.
+ * This is used on Android only, on iOS effects are AudioUnits in the AVAudioEngine graph
+ */
+
+#ifndef LIMITER_EFFECT_H
+#define LIMITER_EFFECT_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "IEffect.h"
+
+// Remember to keep lib/models/effects.dart in sync with this file.
+enum LimiterParameter {
+    LIMITER_CEILING_DB = 0,
+    LIMITER_RELEASE_MS = 1,
+};
+
+/**
+ * The output is delayed by the look-ahead so that the gain is already down when a peak arrives.
+ * Peaks are detected between samples too, by interpolating the midpoint of each pair of samples,
+ * which catches most of the overs that a 2x oversampled DAC would otherwise clip.
+ *
+ * The detection and gain passes work on whole blocks without loop-carried dependencies so that
+ * they vectorize; only the gain envelope itself is computed sample by sample, once per frame
+ * rather than once per sample because the channels are linked.
+ */
+class LimiterEffect : public IEffect {
+public:
+    static constexpr float kLookaheadMs = 1.5f;
+    static constexpr int32_t kMaxBlockFrames = 1024;
+
+    void setSampleRate(int32_t sampleRate) override {
+        mSampleRate = sampleRate;
+        mLookahead = std::max(1, static_cast<int32_t>(std::lround(kLookaheadMs * sampleRate / 1000.0f)));
+
+        mDelayLine.assign((mLookahead + kMaxBlockFrames) * 2, 0.0f);
+        mHoldValues.assign(mLookahead + 1, 1.0f);
+        mHoldExpiries.assign(mLookahead + 1, 0);
+        mBoxValues.assign(mLookahead, 1.0f);
+        mPeaks.assign(kMaxBlockFrames, 0.0f);
+        mGains.assign(kMaxBlockFrames, 1.0f);
+
+        updateRelease();
+        clear();
+    }
+
+    void clear() override {
+        std::fill(mDelayLine.begin(), mDelayLine.end(), 0.0f);
+        std::fill(mBoxValues.begin(), mBoxValues.end(), 1.0f);
+        std::fill(mHistory, mHistory + kHistorySamples, 0.0f);
+        mHoldHead = 0;
+        mHoldCount = 0;
+        mFrameCount = 0;
+        mBoxIndex = 0;
+        mReleasedGain = 1.0f;
+    }
+
+    void setParameter(uint8_t parameter, float value) override {
+        switch (parameter) {
+            case LIMITER_CEILING_DB: mCeiling = std::pow(10.0f, std::min(value, 0.0f) / 20.0f); break;
+            case LIMITER_RELEASE_MS: mReleaseMs = std::max(value, 1.0f); updateRelease(); break;
+            default: return;
+        }
+    }
+
+    int32_t getLatencyFrames() const {
+        return mLookahead;
+    }
+
+    void process(float* audioData, int32_t numFrames) override {
+        for (int32_t offset = 0; offset < numFrames; offset += kMaxBlockFrames) {
+            const int32_t blockFrames = std::min(kMaxBlockFrames, numFrames - offset);
+
+            detectPeaks(audioData + offset * 2, blockFrames);
+            computeGains(blockFrames);
+            applyGains(audioData + offset * 2, blockFrames);
+        }
+    }
+
+private:
+    // The last three frames of the previous block, which the first midpoints of a block need
+    static constexpr int32_t kHistorySamples = 6;
+
+    static float framePeak(float x0, float x1, float x2, float x3) {
+        // Cubic interpolation of the point halfway between x1 and x2
+        const float midpoint = (9.0f * (x1 + x2) - (x0 + x3)) * (1.0f / 16.0f);
+        return std::max(std::fabs(x2), std::fabs(midpoint));
+    }
+
+    // Writes the peak of each frame, including the inter-sample peak before it, to mPeaks.
+    void detectPeaks(const float* audioData, int32_t numFrames) {
+        float* peaks = mPeaks.data();
+        float window[kHistorySamples + 6];
+
+        // The first three frames look back into the previous block
+        std::copy(mHistory, mHistory + kHistorySamples, window);
+        std::copy(audioData, audioData + std::min(numFrames, 3) * 2, window + kHistorySamples);
+
+        for (int32_t frame = 0; frame < std::min(numFrames, 3); frame++) {
+            const float* x = window + frame * 2;
+            peaks[frame] = std::max(framePeak(x[0], x[2], x[4], x[6]), framePeak(x[1], x[3], x[5], x[7]));
+        }
+
+        for (int32_t frame = 3; frame < numFrames; frame++) {
+            const float* x = audioData + (frame - 3) * 2;
+            peaks[frame] = std::max(framePeak(x[0], x[2], x[4], x[6]), framePeak(x[1], x[3], x[5], x[7]));
+        }
+
+        // Shift the history along by the frames of this block
+        const int32_t totalSamples = numFrames * 2;
+        for (int32_t i = 0; i < kHistorySamples; i++) {
+            const int32_t sample = totalSamples - kHistorySamples + i;
+            mHistory[i] = sample >= 0 ? audioData[sample] : mHistory[i + totalSamples];
+        }
+    }
+
+    // Turns mPeaks into gains in mGains. The gain needed for each peak is held for one more frame
+    // than the look-ahead, released exponentially, and smoothed with a box filter as long as the
+    // look-ahead, so the gain has fully reached its target by the time the delayed peak is output.
+    void computeGains(int32_t numFrames) {
+        const float* peaks = mPeaks.data();
+        float* gains = mGains.data();
+
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            gains[frame] = mCeiling / std::max(peaks[frame], mCeiling);
+        }
+
+        // Summing again every block keeps rounding errors from accumulating
+        float boxSum = 0.0f;
+        for (auto value : mBoxValues) boxSum += value;
+
+        const float boxScale = 1.0f / mLookahead;
+
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            const float heldGain = pushHold(gains[frame]);
+
+            if (heldGain < mReleasedGain) {
+                mReleasedGain = heldGain;
+            } else {
+                mReleasedGain = heldGain + (mReleasedGain - heldGain) * mReleaseCoefficient;
+            }
+
+            boxSum += mReleasedGain - mBoxValues[mBoxIndex];
+            mBoxValues[mBoxIndex] = mReleasedGain;
+            if (++mBoxIndex == mLookahead) mBoxIndex = 0;
+
+            gains[frame] = boxSum * boxScale;
+        }
+    }
+
+    // Running minimum over the last mLookahead + 1 gains, using a monotonic queue.
+    float pushHold(float gain) {
+        const int64_t frame = mFrameCount++;
+        const int32_t capacity = mLookahead + 1;
+
+        if (mHoldCount > 0 && mHoldExpiries[mHoldHead] <= frame) {
+            mHoldHead = (mHoldHead + 1) % capacity;
+            mHoldCount--;
+        }
+
+        while (mHoldCount > 0 && mHoldValues[(mHoldHead + mHoldCount - 1) % capacity] >= gain) {
+            mHoldCount--;
+        }
+
+        const int32_t slot = (mHoldHead + mHoldCount) % capacity;
+        mHoldValues[slot] = gain;
+        mHoldExpiries[slot] = frame + capacity;
+        mHoldCount++;
+
+        return mHoldValues[mHoldHead];
+    }
+
+    // Outputs the audio from the look-ahead ago, scaled by the gains. The delay line is linear
+    // rather than circular so that this is a plain multiply the compiler can vectorize.
+    void applyGains(float* audioData, int32_t numFrames) {
+        const float* gains = mGains.data();
+        float* delayLine = mDelayLine.data();
+        const int32_t totalSamples = numFrames * 2;
+
+        std::copy(audioData, audioData + totalSamples, delayLine + mLookahead * 2);
+
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            audioData[frame * 2] = delayLine[frame * 2] * gains[frame];
+            audioData[frame * 2 + 1] = delayLine[frame * 2 + 1] * gains[frame];
+        }
+
+        std::copy(delayLine + totalSamples, delayLine + totalSamples + mLookahead * 2, delayLine);
+    }
+
+    void updateRelease() {
+        mReleaseCoefficient = std::exp(-1000.0f / (mReleaseMs * mSampleRate));
+    }
+
+    int32_t mSampleRate = 44100;
+    int32_t mLookahead = 1;
+    float mCeiling = 0.966f; // -0.3 dBFS
+    float mReleaseMs = 60.0f;
+    float mReleaseCoefficient = 0.0f;
+
+    std::vector<float> mDelayLine;
+    float mHistory[kHistorySamples] = {};
+
+    std::vector<float> mHoldValues;
+    std::vector<int64_t> mHoldExpiries;
+    int32_t mHoldHead = 0;
+    int32_t mHoldCount = 0;
+    int64_t mFrameCount = 0;
+
+    std::vector<float> mBoxValues;
+    int32_t mBoxIndex = 0;
+    float mReleasedGain = 1.0f;
+
+    std::vector<float> mPeaks;
+    std::vector<float> mGains;
+};
+
+#endif //LIMITER_EFFECT_H
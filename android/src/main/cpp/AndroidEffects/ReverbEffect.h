@@ -0,0 +1,181 @@
+/*
+ * A stereo Schroeder-Moorer reverb in the style of Freeverb.
+ * This is used on Android only, on iOS effects are AudioUnits in the AVAudioEngine graph
+ */
+
+#ifndef REVERB_EFFECT_H
+#define REVERB_EFFECT_H
+
+#include <algorithm>
+#include <vector>
+#include "IEffect.h"
+
+// Remember to keep lib/models/effects.dart in sync with this file.
+enum ReverbParameter {
+    REVERB_ROOM_SIZE = 0,
+    REVERB_DAMPING = 1,
+    REVERB_WET = 2,
+    REVERB_DRY = 3,
+    REVERB_WIDTH = 4,
+};
+
+class ReverbEffect : public IEffect {
+public:
+    void setSampleRate(int32_t sampleRate) override {
+        // Delay lengths are tuned for 44.1 kHz
+        const float scale = sampleRate / 44100.0f;
+
+        for (int32_t channel = 0; channel < 2; channel++) {
+            const int32_t spread = channel * kStereoSpread;
+
+            for (int32_t i = 0; i < kNumCombs; i++) {
+                mCombs[channel][i].setLength(static_cast<int32_t>((kCombTuning[i] + spread) * scale));
+            }
+            for (int32_t i = 0; i < kNumAllpasses; i++) {
+                mAllpasses[channel][i].setLength(static_cast<int32_t>((kAllpassTuning[i] + spread) * scale));
+            }
+        }
+
+        updateCombs();
+    }
+
+    void clear() override {
+        for (auto& channelCombs : mCombs) {
+            for (auto& comb : channelCombs) comb.clear();
+        }
+        for (auto& channelAllpasses : mAllpasses) {
+            for (auto& allpass : channelAllpasses) allpass.clear();
+        }
+    }
+
+    void setParameter(uint8_t parameter, float value) override {
+        value = std::clamp(value, 0.0f, 1.0f);
+
+        switch (parameter) {
+            case REVERB_ROOM_SIZE: mRoomSize = value; break;
+            case REVERB_DAMPING: mDamping = value; break;
+            case REVERB_WET: mWet = value; break;
+            case REVERB_DRY: mDry = value; break;
+            case REVERB_WIDTH: mWidth = value; break;
+            default: return;
+        }
+
+        updateCombs();
+    }
+
+    void process(float* audioData, int32_t numFrames) override {
+        const float wet1 = mWet * kScaleWet * (mWidth / 2.0f + 0.5f);
+        const float wet2 = mWet * kScaleWet * ((1.0f - mWidth) / 2.0f);
+        const float dry = mDry * kScaleDry;
+
+        for (int32_t frame = 0; frame < numFrames; frame++) {
+            const float inputL = audioData[frame * 2];
+            const float inputR = audioData[frame * 2 + 1];
+            const float input = (inputL + inputR) * kFixedGain;
+
+            float outL = 0.0f;
+            float outR = 0.0f;
+
+            for (int32_t i = 0; i < kNumCombs; i++) {
+                outL += mCombs[0][i].process(input);
+                outR += mCombs[1][i].process(input);
+            }
+            for (int32_t i = 0; i < kNumAllpasses; i++) {
+                outL = mAllpasses[0][i].process(outL);
+                outR = mAllpasses[1][i].process(outR);
+            }
+
+            audioData[frame * 2] = outL * wet1 + outR * wet2 + inputL * dry;
+            audioData[frame * 2 + 1] = outR * wet1 + outL * wet2 + inputR * dry;
+        }
+    }
+
+private:
+    static constexpr int32_t kNumCombs = 8;
+    static constexpr int32_t kNumAllpasses = 4;
+    static constexpr int32_t kStereoSpread = 23;
+    static constexpr float kFixedGain = 0.015f;
+    static constexpr float kScaleWet = 3.0f;
+    static constexpr float kScaleDry = 2.0f;
+    static constexpr float kScaleRoom = 0.28f;
+    static constexpr float kOffsetRoom = 0.7f;
+    static constexpr float kScaleDamp = 0.4f;
+    static constexpr int32_t kCombTuning[kNumCombs] = { 1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617 };
+    static constexpr int32_t kAllpassTuning[kNumAllpasses] = { 556, 441, 341, 225 };
+
+    class Comb {
+    public:
+        void setLength(int32_t length) {
+            mBuffer.assign(std::max(length, 1), 0.0f);
+            mIndex = 0;
+        }
+
+        void clear() {
+            std::fill(mBuffer.begin(), mBuffer.end(), 0.0f);
+            mFilterStore = 0.0f;
+        }
+
+        float process(float input) {
+            const float output = mBuffer[mIndex];
+            mFilterStore = output * (1.0f - damping) + mFilterStore * damping;
+            mBuffer[mIndex] = input + mFilterStore * feedback;
+
+            if (++mIndex >= mBuffer.size()) mIndex = 0;
+            return output;
+        }
+
+        float feedback = 0.0f;
+        float damping = 0.0f;
+
+    private:
+        std::vector<float> mBuffer = std::vector<float>(1, 0.0f);
+        size_t mIndex = 0;
+        float mFilterStore = 0.0f;
+    };
+
+    class Allpass {
+    public:
+        void setLength(int32_t length) {
+            mBuffer.assign(std::max(length, 1), 0.0f);
+            mIndex = 0;
+        }
+
+        void clear() {
+            std::fill(mBuffer.begin(), mBuffer.end(), 0.0f);
+        }
+
+        float process(float input) {
+            const float buffered = mBuffer[mIndex];
+            mBuffer[mIndex] = input + buffered * 0.5f;
+
+            if (++mIndex >= mBuffer.size()) mIndex = 0;
+            return buffered - input;
+        }
+
+    private:
+        std::vector<float> mBuffer = std::vector<float>(1, 0.0f);
+        size_t mIndex = 0;
+    };
+
+    void updateCombs() {
+        const float feedback = mRoomSize * kScaleRoom + kOffsetRoom;
+        const float damping = mDamping * kScaleDamp;
+
+        for (auto& channelCombs : mCombs) {
+            for (auto& comb : channelCombs) {
+                comb.feedback = feedback;
+                comb.damping = damping;
+            }
+        }
+    }
+
+    Comb mCombs[2][kNumCombs];
+    Allpass mAllpasses[2][kNumAllpasses];
+    float mRoomSize = 0.5f;
+    float mDamping = 0.5f;
+    float mWet = 1.0f / kScaleWet;
+    float mDry = 0.0f;
+    float mWidth = 1.0f;
+};
+
+#endif //REVERB_EFFECT_H
@@ -13,6 +13,7 @@
 
 AndroidEngine::AndroidEngine(Dart_Port sampleRateCallbackPort) {
     mSchedulerMixer.setChannelCount(kChannelCount);
+    mSchedulerMixer.setSampleRate(kSampleRate);
     
     LOGI("AndroidEngine: Initializing with %d channels, %d Hz sample rate", kChannelCount, kSampleRate);
     
@@ -41,6 +42,10 @@ AndroidEngine::AndroidEngine(Dart_Port sampleRateCallbackPort) {
     // Initialize OpenSL ES with performance settings
     if (!initOpenSLES()) {
         LOGE("Failed to initialize OpenSL ES, falling back to simulation mode");
+    } else {
+        // A block is rendered when a buffer finishes playing, so it is queued behind the others.
+        // The latency of the device itself isn't known and isn't included.
+        mSchedulerMixer.setOutputLatency((kNumBuffers - 1) * kBufferSizeFrames);
     }
     
     // Notify Dart about sample rate
@@ -266,14 +271,11 @@ inline void AndroidEngine::convertFloatToInt16(const float* input, int16_t* outp
     for (int i = 0; i < vectorSamples; i += 4) {
         float32x4_t samples = vld1q_f32(&src[i]);
         
-        // Clamp to [-1.0, 1.0]
-        samples = vmaxq_f32(samples, vdupq_n_f32(-1.0f));
-        samples = vminq_f32(samples, vdupq_n_f32(1.0f));
-        
-        // Scale and convert to int16
+        // The mixer's limiter already keeps samples within full scale, so there is no clamp here;
+        // the saturating conversion and narrow still guard against overflow
         samples = vmulq_f32(samples, vdupq_n_f32(32767.0f));
         int32x4_t int32_samples = vcvtq_s32_f32(samples);
-        int16x4_t int16_samples = vmovn_s32(int32_samples);
+        int16x4_t int16_samples = vqmovn_s32(int32_samples);
         
         vst1_s16(&dst[i], int16_samples);
     }
@@ -313,22 +315,7 @@ void AndroidEngine::playerCallback(SLAndroidSimpleBufferQueueItf bq, void* conte
     if (engine->mIsPlaying.load(std::memory_order_relaxed)) {
         try {
             // Render audio through the mixer to float buffer
-            engine->mSchedulerMixer.renderAudio(floatBuffer, kBufferSizeFrames);
-            
-            // CRITICAL DEBUG: Check if audio is being rendered
-            static int debugCounter = 0;
-            if (++debugCounter % 2000 == 0) { // Much less frequent - every 2000 frames (~12 seconds)
-                float maxSample = 0.0f;
-                const int totalSamples = kBufferSizeFrames * kChannelCount;
-                for (int i = 0; i < totalSamples; ++i) {
-                    maxSample = std::max(maxSample, std::abs(floatBuffer[i]));
-                }
-                if (maxSample > 0.001f) {
-                    LOGI("AndroidEngine: ✅ Audio activity detected - max sample: %.4f", maxSample);
-                } else {
-                    LOGI("AndroidEngine: ⚠️ Still no audio from instruments (%.6f)", maxSample);
-                }
-            }
+            engine->renderBlock(floatBuffer);
         } catch (const std::exception& e) {
             LOGE("Error rendering audio: %s", e.what());
             engine->mDroppedFrames.fetch_add(1);
@@ -336,26 +323,10 @@ void AndroidEngine::playerCallback(SLAndroidSimpleBufferQueueItf bq, void* conte
         }
     }
     
-    // DEBUGGING: Test tone disabled - audio pipeline confirmed working
-    // The "bip" sound confirms OpenSL ES works, now focusing on MIDI->Audio generation
-    
     // Convert float to int16 using optimized function
     const int totalSamples = kBufferSizeFrames * kChannelCount;
     engine->convertFloatToInt16(floatBuffer, int16Buffer, totalSamples);
     
-    // DEBUG: Check what we're sending to OpenSL ES
-    static int bufferDebugCounter = 0;
-    if (++bufferDebugCounter % 500 == 0) { // Reduced frequency
-        float maxInt16Sample = 0.0f;
-        const int totalSamples = kBufferSizeFrames * kChannelCount;
-        for (int i = 0; i < totalSamples; ++i) {
-            maxInt16Sample = std::max(maxInt16Sample, std::abs((float)int16Buffer[i]));
-        }
-        if (maxInt16Sample > 100.0f) { // Only log if there's actual audio
-            LOGI("AndroidEngine: OpenSL ES output level: %.1f/32767", maxInt16Sample);
-        }
-    }
-    
     // Enqueue buffer
     SLresult result = (*bq)->Enqueue(bq, int16Buffer, 
                                     kBufferSizeFrames * kChannelCount * sizeof(int16_t));
@@ -363,13 +334,21 @@ void AndroidEngine::playerCallback(SLAndroidSimpleBufferQueueItf bq, void* conte
         LOGE("Failed to enqueue OpenSL ES buffer, result: %d", result);
         engine->mDroppedFrames.fetch_add(1);
     }
-    // Success logging removed - OpenSL ES is working fine
     
     // Switch to next buffer atomically
     int nextBuffer = (currentBufferIndex + 1) % kNumBuffers;
     engine->mCurrentBuffer.store(nextBuffer, std::memory_order_relaxed);
 }
 
+void AndroidEngine::renderBlock(float* audioData) {
+    const auto startTime = std::chrono::steady_clock::now();
+
+    mSchedulerMixer.renderAudio(audioData, kBufferSizeFrames);
+
+    const auto renderTimeUs = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+    mSchedulerMixer.setLoadStage(mLoadGovernor.update(renderTimeUs));
+}
+
 void AndroidEngine::audioThreadFunc() {
     // Simple audio rendering loop (fallback when OpenSL ES fails)
     auto buffer = std::make_unique<float[]>(kBufferSizeFrames * kChannelCount);
@@ -387,7 +366,7 @@ void AndroidEngine::audioThreadFunc() {
         std::fill_n(buffer.get(), kBufferSizeFrames * kChannelCount, 0.0f);
         
         // Render audio through the mixer
-        mSchedulerMixer.renderAudio(buffer.get(), kBufferSizeFrames);
+        renderBlock(buffer.get());
         
         // Note: In a real implementation, this audio would be sent to the Android audio system
         // For now, this just simulates the timing
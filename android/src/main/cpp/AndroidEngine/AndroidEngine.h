@@ -9,6 +9,9 @@
 #include "CallbackManager.h"
 #include "IInstrument.h"
 #include "../AndroidInstruments/Mixer.h"
+#include "InstrumentLoader.h"
+#include "LoadGovernor.h"
+#include "TrackFreezer.h"
 
 class AndroidEngine {
 public:
@@ -22,6 +25,11 @@ public:
     void pause();
 
     Mixer mSchedulerMixer;
+    TrackFreezer mTrackFreezer { mSchedulerMixer };
+    // Declared after the mixer and freezer so that loads and freezes still in flight finish before
+    // they are destroyed
+    InstrumentLoader mInstrumentLoader;
+    LoadGovernor mLoadGovernor { kBufferSizeFrames * 1000000.0f / kSampleRate };
     
 private:
     static constexpr int32_t kSampleRate = 44100;
@@ -50,6 +58,8 @@ private:
     std::atomic<uint64_t> mTotalFrames{0};
     
     void audioThreadFunc();
+    // Renders one buffer through the mixer and lets the load governor know how long it took
+    void renderBlock(float* audioData);
     bool initOpenSLES();
     void cleanupOpenSLES();
     static void playerCallback(SLAndroidSimpleBufferQueueItf bq, void* context);
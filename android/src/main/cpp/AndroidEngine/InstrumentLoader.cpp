@@ -0,0 +1,140 @@
+#include "InstrumentLoader.h"
+#include <algorithm>
+
+InstrumentLoader::InstrumentLoader(int32_t threadCount) {
+    for (int32_t i = 0; i < threadCount; i++) {
+        mThreads.emplace_back(&InstrumentLoader::workerThreadFunc, this);
+    }
+}
+
+InstrumentLoader::~InstrumentLoader() {
+    std::vector<Request> unstartedRequests;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsStopping = true;
+        unstartedRequests.swap(mQueue);
+
+        for (auto& request : mRunning) {
+            request.isCancelled->store(true);
+        }
+    }
+
+    mCondition.notify_all();
+
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+
+    for (auto& request : unstartedRequests) {
+        if (request.onCancel) request.onCancel();
+    }
+}
+
+load_request_id_t InstrumentLoader::enqueue(int32_t priority, LoadTask task, CancelHandler onCancel) {
+    load_request_id_t requestId;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        requestId = mNextRequestId++;
+
+        mQueue.push_back({
+            requestId,
+            priority,
+            std::move(task),
+            std::move(onCancel),
+            std::make_shared<std::atomic<bool>>(false)
+        });
+    }
+
+    mCondition.notify_one();
+    return requestId;
+}
+
+bool InstrumentLoader::cancel(load_request_id_t requestId) {
+    CancelHandler onCancel;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        auto queued = std::find_if(mQueue.begin(), mQueue.end(), [=](const Request& request) {
+            return request.id == requestId;
+        });
+
+        if (queued != mQueue.end()) {
+            onCancel = std::move(queued->onCancel);
+            mQueue.erase(queued);
+        } else {
+            auto running = std::find_if(mRunning.begin(), mRunning.end(), [=](const Request& request) {
+                return request.id == requestId;
+            });
+
+            if (running == mRunning.end()) return false;
+
+            // The task sees the flag and reports the cancellation itself
+            running->isCancelled->store(true);
+            return true;
+        }
+    }
+
+    if (onCancel) onCancel();
+    return true;
+}
+
+void InstrumentLoader::setPriority(load_request_id_t requestId, int32_t priority) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (auto& request : mQueue) {
+        if (request.id == requestId) {
+            request.priority = priority;
+            return;
+        }
+    }
+}
+
+bool InstrumentLoader::commit(const std::atomic<bool>& isCancelled, const std::function<void()>& commitResult) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (isCancelled) return false;
+
+    commitResult();
+
+    // Without a running entry, cancel() reports that there is nothing left to cancel
+    mRunning.erase(std::remove_if(mRunning.begin(), mRunning.end(), [&](const Request& running) {
+        return running.isCancelled.get() == &isCancelled;
+    }), mRunning.end());
+
+    return true;
+}
+
+void InstrumentLoader::workerThreadFunc() {
+    while (true) {
+        Request request;
+
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this] { return mIsStopping || !mQueue.empty(); });
+
+            if (mIsStopping) return;
+
+            // Request ids increase monotonically, so the lowest id breaks ties in FIFO order
+            auto next = std::min_element(mQueue.begin(), mQueue.end(), [](const Request& a, const Request& b) {
+                if (a.priority != b.priority) return a.priority > b.priority;
+                return a.id < b.id;
+            });
+
+            request = std::move(*next);
+            mQueue.erase(next);
+            mRunning.push_back({ request.id, request.priority, nullptr, nullptr, request.isCancelled });
+        }
+
+        request.task(*request.isCancelled);
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+
+            mRunning.erase(std::remove_if(mRunning.begin(), mRunning.end(), [&](const Request& running) {
+                return running.id == request.id;
+            }), mRunning.end());
+        }
+    }
+}
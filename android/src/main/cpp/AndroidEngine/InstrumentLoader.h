@@ -0,0 +1,65 @@
+#ifndef INSTRUMENT_LOADER_H
+#define INSTRUMENT_LOADER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef int32_t load_request_id_t;
+
+// Progress values sent to a load request's progress port
+constexpr int32_t kLoadProgressStarted = 0;
+constexpr int32_t kLoadProgressParsed = 50;
+constexpr int32_t kLoadProgressReady = 100;
+
+/**
+ * A fixed-size pool of threads that load instruments. Requests wait in a queue and the one with
+ * the highest priority runs first; requests with equal priority run in the order they were added.
+ * A request can be cancelled while it is queued or while it is running.
+ */
+class InstrumentLoader {
+public:
+    // Runs on a loader thread. It should check isCancelled before committing its result.
+    using LoadTask = std::function<void(const std::atomic<bool>& isCancelled)>;
+    // Runs if the request is cancelled before a loader thread picked it up.
+    using CancelHandler = std::function<void()>;
+
+    explicit InstrumentLoader(int32_t threadCount = kDefaultThreadCount);
+    ~InstrumentLoader();
+
+    load_request_id_t enqueue(int32_t priority, LoadTask task, CancelHandler onCancel);
+    bool cancel(load_request_id_t requestId);
+    void setPriority(load_request_id_t requestId, int32_t priority);
+    // Called by a running task to publish its result. Runs commitResult under the loader's lock
+    // unless the request has been cancelled, and returns whether it ran. Once it has, cancel()
+    // treats the request as finished, so a result is either committed or cancelled, never both.
+    bool commit(const std::atomic<bool>& isCancelled, const std::function<void()>& commitResult);
+
+private:
+    // Loading is bound by memory bandwidth and flash I/O, so more threads don't help.
+    static constexpr int32_t kDefaultThreadCount = 2;
+
+    struct Request {
+        load_request_id_t id;
+        int32_t priority;
+        LoadTask task;
+        CancelHandler onCancel;
+        std::shared_ptr<std::atomic<bool>> isCancelled;
+    };
+
+    void workerThreadFunc();
+
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::vector<Request> mQueue;
+    std::vector<Request> mRunning;
+    std::vector<std::thread> mThreads;
+    load_request_id_t mNextRequestId = 0;
+    bool mIsStopping = false;
+};
+
+#endif //INSTRUMENT_LOADER_H
@@ -0,0 +1,132 @@
+#ifndef LOAD_GOVERNOR_H
+#define LOAD_GOVERNOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include "IInstrument.h"
+
+// Read by get_load_governor_status. Remember to keep lib/models/load_governor.dart in sync.
+struct LoadGovernorStatus {
+    // Smoothed render time as a fraction of the buffer duration
+    float load;
+    // Highest load of a single callback since the last status read
+    float peakLoad;
+    float degradeLoad;
+    float recoverLoad;
+    int32_t stage;
+    uint32_t stageChanges;
+};
+
+/**
+ * Keeps the audio callback within its time budget by trading quality for CPU time before it
+ * underruns. Each callback reports how long it took to render. When the smoothed load stays above
+ * the degrade threshold, the governor moves one LoadStage down, waits for that to take effect,
+ * and moves down again if it wasn't enough. It only moves back up once the load has stayed below
+ * the lower recover threshold for a while, so it doesn't flap between stages.
+ *
+ * update() runs on the audio thread; everything else may be called from any thread.
+ */
+class LoadGovernor {
+public:
+    static constexpr float kDefaultDegradeLoad = 0.8f;
+    static constexpr float kDefaultRecoverLoad = 0.5f;
+
+    explicit LoadGovernor(float bufferDurationUs) : mBufferDurationUs(bufferDurationUs) {}
+
+    // Returns the stage the instruments should render at
+    LoadStage update(float renderTimeUs) {
+        if (!mIsEnabled.load(std::memory_order_relaxed)) {
+            mStage.store(LOAD_STAGE_NORMAL, std::memory_order_relaxed);
+            return LOAD_STAGE_NORMAL;
+        }
+
+        const float load = renderTimeUs / mBufferDurationUs;
+
+        // Rise quickly, fall slowly, so a busy stretch isn't hidden by the quiet blocks around it
+        const float coefficient = load > mSmoothedLoad ? kRiseCoefficient : kFallCoefficient;
+        mSmoothedLoad += (load - mSmoothedLoad) * coefficient;
+
+        mLoad.store(mSmoothedLoad, std::memory_order_relaxed);
+        if (load > mPeakLoad.load(std::memory_order_relaxed)) {
+            mPeakLoad.store(load, std::memory_order_relaxed);
+        }
+
+        auto stage = static_cast<LoadStage>(mStage.load(std::memory_order_relaxed));
+
+        if (mSettleBlocks > 0) {
+            // The last stage change hasn't shown in the load yet
+            mSettleBlocks--;
+            return stage;
+        }
+
+        const float degradeLoad = mDegradeLoad.load(std::memory_order_relaxed);
+        const float recoverLoad = mRecoverLoad.load(std::memory_order_relaxed);
+
+        mBlocksOverBudget = mSmoothedLoad > degradeLoad ? mBlocksOverBudget + 1 : 0;
+        mBlocksUnderBudget = mSmoothedLoad < recoverLoad ? mBlocksUnderBudget + 1 : 0;
+
+        if (mBlocksOverBudget >= kDegradeBlocks && stage < LOAD_STAGE_SHED_VOICES) {
+            stage = static_cast<LoadStage>(stage + 1);
+        } else if (mBlocksUnderBudget >= kRecoverBlocks && stage > LOAD_STAGE_NORMAL) {
+            stage = static_cast<LoadStage>(stage - 1);
+        } else {
+            return stage;
+        }
+
+        mStage.store(stage, std::memory_order_relaxed);
+        mStageChanges.fetch_add(1, std::memory_order_relaxed);
+        mBlocksOverBudget = 0;
+        mBlocksUnderBudget = 0;
+        mSettleBlocks = kSettleBlocks;
+
+        return stage;
+    }
+
+    void setEnabled(bool isEnabled) {
+        mIsEnabled.store(isEnabled);
+    }
+
+    // recoverLoad is kept below degradeLoad, which is what gives the hysteresis
+    void setThresholds(float degradeLoad, float recoverLoad) {
+        degradeLoad = std::clamp(degradeLoad, 0.1f, 2.0f);
+
+        mDegradeLoad.store(degradeLoad);
+        mRecoverLoad.store(std::clamp(recoverLoad, 0.0f, degradeLoad * 0.9f));
+    }
+
+    void getStatus(LoadGovernorStatus* status) {
+        status->load = mLoad.load(std::memory_order_relaxed);
+        status->peakLoad = mPeakLoad.exchange(0.0f, std::memory_order_relaxed);
+        status->degradeLoad = mDegradeLoad.load(std::memory_order_relaxed);
+        status->recoverLoad = mRecoverLoad.load(std::memory_order_relaxed);
+        status->stage = mStage.load(std::memory_order_relaxed);
+        status->stageChanges = mStageChanges.load(std::memory_order_relaxed);
+    }
+
+private:
+    // In callbacks, which are 128 frames or ~2.9 ms long
+    static constexpr int32_t kDegradeBlocks = 4;
+    static constexpr int32_t kSettleBlocks = 32;
+    static constexpr int32_t kRecoverBlocks = 700; // ~2 s
+    static constexpr float kRiseCoefficient = 0.3f;
+    static constexpr float kFallCoefficient = 0.02f;
+
+    const float mBufferDurationUs;
+
+    // Audio thread only
+    float mSmoothedLoad = 0.0f;
+    int32_t mBlocksOverBudget = 0;
+    int32_t mBlocksUnderBudget = 0;
+    int32_t mSettleBlocks = 0;
+
+    std::atomic<bool> mIsEnabled { true };
+    std::atomic<float> mDegradeLoad { kDefaultDegradeLoad };
+    std::atomic<float> mRecoverLoad { kDefaultRecoverLoad };
+    std::atomic<float> mLoad { 0.0f };
+    std::atomic<float> mPeakLoad { 0.0f };
+    std::atomic<int32_t> mStage { LOAD_STAGE_NORMAL };
+    std::atomic<uint32_t> mStageChanges { 0 };
+};
+
+#endif //LOAD_GOVERNOR_H
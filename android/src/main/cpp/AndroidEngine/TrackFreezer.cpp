@@ -0,0 +1,164 @@
+#include "TrackFreezer.h"
+#include <algorithm>
+#include <unistd.h>
+#include "../Utils/Logging.h"
+
+namespace {
+    // reset() leaves notes to the scheduler, so rendering starts and ends with all sound off
+    void silence(IInstrument* instrument) {
+        for (uint8_t channel = 0; channel < 16; channel++) {
+            instrument->handleMidiEvent(0xB0 | channel, 120, 0);
+        }
+        instrument->reset();
+    }
+}
+
+TrackFreezer::~TrackFreezer() {
+    for (auto& pair : mFrozenTracks) {
+        unlink(pair.second.cachePath.c_str());
+    }
+}
+
+bool TrackFreezer::freeze(track_index_t trackIndex, std::vector<SchedulerEvent> events, uint32_t numFrames,
+                          const std::string& cachePath, const std::atomic<bool>& isCancelled) {
+    if (mMixer.getChannelCount() != 2) {
+        LOGE("TrackFreezer: Track %d can't be frozen, only stereo output is supported", trackIndex);
+        return false;
+    }
+    if (numFrames == 0) return false;
+
+    IInstrument* instrument;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mFrozenTracks.find(trackIndex) != mFrozenTracks.end()) return false;
+
+        // Until the file is ready, an empty player keeps the track silent
+        auto placeholder = std::make_unique<FrozenTrackPlayer>();
+        instrument = mMixer.replaceTrackInstrument(trackIndex, placeholder.get());
+        if (instrument == nullptr) return false;
+
+        mFrozenTracks.emplace(trackIndex, FrozenTrack { instrument, std::move(placeholder), cachePath, true, false });
+    }
+
+    std::stable_sort(events.begin(), events.end(), [](const SchedulerEvent& a, const SchedulerEvent& b) {
+        return a.frame < b.frame;
+    });
+
+    bool didRender = false;
+    FILE* file = fopen(cachePath.c_str(), "wb");
+
+    if (file != nullptr) {
+        didRender = renderToFile(instrument, events, numFrames, file, isCancelled);
+        didRender = fclose(file) == 0 && didRender;
+    } else {
+        LOGE("TrackFreezer: Cannot create %s", cachePath.c_str());
+    }
+
+    auto player = std::make_unique<FrozenTrackPlayer>();
+    const bool isReady = didRender && !isCancelled && player->open(cachePath.c_str());
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto search = mFrozenTracks.find(trackIndex);
+    auto& frozenTrack = search->second;
+    frozenTrack.isFreezing = false;
+
+    if (frozenTrack.isRemoved || !isReady) {
+        if (!frozenTrack.isRemoved) {
+            mMixer.replaceTrackInstrument(trackIndex, instrument);
+        }
+
+        unlink(cachePath.c_str());
+        mFrozenTracks.erase(search);
+        return false;
+    }
+
+    mMixer.replaceTrackInstrument(trackIndex, player.get());
+    frozenTrack.player = std::move(player);
+    return true;
+}
+
+bool TrackFreezer::unfreeze(track_index_t trackIndex) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto search = mFrozenTracks.find(trackIndex);
+    if (search == mFrozenTracks.end() || search->second.isFreezing) return false;
+
+    thaw(trackIndex, search->second);
+    mFrozenTracks.erase(search);
+    return true;
+}
+
+void TrackFreezer::forget(track_index_t trackIndex) {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto search = mFrozenTracks.find(trackIndex);
+    if (search == mFrozenTracks.end()) return;
+
+    // The freeze cleans up after itself once it sees this
+    if (search->second.isFreezing) {
+        search->second.isRemoved = true;
+        return;
+    }
+
+    // The track was just removed from the mixer, but the block being rendered may still play it
+    mMixer.waitForAudioThread();
+
+    unlink(search->second.cachePath.c_str());
+    mFrozenTracks.erase(search);
+}
+
+void TrackFreezer::thaw(track_index_t trackIndex, FrozenTrack& frozenTrack) {
+    mMixer.replaceTrackInstrument(trackIndex, frozenTrack.instrument);
+
+    frozenTrack.player.reset();
+    unlink(frozenTrack.cachePath.c_str());
+}
+
+bool TrackFreezer::renderToFile(IInstrument* instrument, const std::vector<SchedulerEvent>& events,
+                                uint32_t numFrames, FILE* file, const std::atomic<bool>& isCancelled) {
+    float chunk[kChunkFrames * 2];
+    size_t nextEvent = 0;
+    bool didRender = true;
+
+    // Rendering offline isn't bound by the audio callback, so it gets full quality whatever the load
+    instrument->setLoadStage(LOAD_STAGE_NORMAL);
+    silence(instrument);
+
+    for (position_frame_t frame = 0; frame < numFrames && didRender;) {
+        if (isCancelled) {
+            didRender = false;
+            break;
+        }
+
+        const position_frame_t chunkEndFrame = std::min(frame + kChunkFrames, numFrames);
+        uint32_t chunkFrames = 0;
+
+        // Events split the chunk, so each one is handled on its own frame
+        while (frame < chunkEndFrame) {
+            while (nextEvent < events.size() && events[nextEvent].frame <= frame) {
+                auto event = events[nextEvent];
+
+                if (event.type == MIDI_EVENT) {
+                    auto midiEvent = MidiEventData(event.data);
+                    instrument->handleMidiEvent(midiEvent.midiStatus, midiEvent.midiData1, midiEvent.midiData2);
+                }
+                nextEvent++;
+            }
+
+            position_frame_t untilFrame = chunkEndFrame;
+            if (nextEvent < events.size()) {
+                untilFrame = std::min(untilFrame, events[nextEvent].frame);
+            }
+
+            instrument->renderAudio(chunk + chunkFrames * 2, untilFrame - frame);
+            chunkFrames += untilFrame - frame;
+            frame = untilFrame;
+        }
+
+        didRender = fwrite(chunk, sizeof(float) * 2, chunkFrames, file) == chunkFrames;
+    }
+
+    silence(instrument);
+    return didRender;
+}
@@ -0,0 +1,60 @@
+#ifndef TRACK_FREEZER_H
+#define TRACK_FREEZER_H
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "IInstrument.h"
+#include "SchedulerEvent.h"
+#include "../AndroidInstruments/FrozenTrackPlayer.h"
+#include "../AndroidInstruments/Mixer.h"
+
+/**
+ * Freezes tracks: renders a track's events offline, faster than real time, to a file of
+ * interleaved stereo floats, and swaps the track's instrument for a FrozenTrackPlayer that plays
+ * the file back. Unfreezing swaps the instrument back in.
+ *
+ * The instrument is taken out of the mixer while it renders, so the track is silent until the
+ * freeze is done. A frozen track keeps its effects, level and sends, and ignores MIDI.
+ */
+class TrackFreezer {
+public:
+    explicit TrackFreezer(Mixer& mixer) : mMixer(mixer) {}
+    ~TrackFreezer();
+
+    // Blocks until the track is frozen. events are the track's MIDI events, with frames relative
+    // to the start of the sequence, and are rendered up to numFrames. Runs on a loader thread.
+    bool freeze(track_index_t trackIndex, std::vector<SchedulerEvent> events, uint32_t numFrames,
+                const std::string& cachePath, const std::atomic<bool>& isCancelled);
+    bool unfreeze(track_index_t trackIndex);
+    // Called when a track is removed, so its player and cache file go too
+    void forget(track_index_t trackIndex);
+
+private:
+    static constexpr uint32_t kChunkFrames = 128;
+
+    struct FrozenTrack {
+        IInstrument* instrument;
+        std::unique_ptr<FrozenTrackPlayer> player;
+        std::string cachePath;
+        bool isFreezing;
+        // The track was removed while it was being frozen
+        bool isRemoved;
+    };
+
+    static bool renderToFile(IInstrument* instrument, const std::vector<SchedulerEvent>& events,
+                             uint32_t numFrames, FILE* file, const std::atomic<bool>& isCancelled);
+    // Puts the instrument back in place of the player, which is closed and deleted
+    void thaw(track_index_t trackIndex, FrozenTrack& frozenTrack);
+
+    Mixer& mMixer;
+    std::mutex mMutex;
+    // A track is in here from the moment its freeze starts, so it can't be frozen twice at once
+    std::unordered_map<track_index_t, FrozenTrack> mFrozenTracks;
+};
+
+#endif //TRACK_FREEZER_H
@@ -0,0 +1,347 @@
+/*
+ * Streams an audio file, such as a vocal or backing track stem, in time with the sequence.
+ * This is used on Android only
+ */
+
+#ifndef AUDIO_CLIP_PLAYER_H
+#define AUDIO_CLIP_PLAYER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "IInstrument.h"
+#include "MediaDecoder.h"
+#include "RenderAhead.h"
+#include "../Utils/Logging.h"
+
+/**
+ * Plays an audio file that is decoded by MediaDecoder on a streamer thread, which keeps a
+ * FIFO of a few hundred milliseconds filled ahead of the audio thread, resampled to the output
+ * rate. Memory use doesn't depend on how long the file is.
+ *
+ * Like FrozenTrackPlayer, it doesn't follow the position by itself: each SEEK_EVENT says which
+ * frame of the clip plays at that point, which is negative until the clip starts, and it plays
+ * silence until the first one arrives. A seek to a frame that is already in the FIFO only skips
+ * ahead. Otherwise the streamer is asked to start over from that frame, which seeks the decoder
+ * unless the frame has been decoded already, and the audio thread
+ * plays silence until it catches up, then skips whatever it missed, so the clip stays
+ * sample-accurate after the first few milliseconds.
+ *
+ * Starting over goes in three steps, so the audio thread never reads frames from before the
+ * seek: the audio thread bumps the generation, the streamer moves to the frame and says so, the
+ * audio thread drops everything in the FIFO, and only then does the streamer write again.
+ */
+class AudioClipPlayer : public IInstrument {
+public:
+    ~AudioClipPlayer() {
+        close();
+    }
+
+    // gain is linear. The fades are in output frames, at the start and the end of the file. Must
+    // not be called while the player is being rendered.
+    bool open(const char* path, float gain, uint32_t fadeInFrames, uint32_t fadeOutFrames) {
+        close();
+
+        auto decoder = std::make_unique<MediaDecoder>();
+
+        if (!decoder->open(path) || decoder->frames() <= 0) {
+            LOGE("AudioClipPlayer: Cannot read %s", path);
+            return false;
+        }
+
+        mPath = path;
+        mDecoder = std::move(decoder);
+        mSourceRatio = static_cast<double>(mDecoder->sampleRate()) / mSampleRate;
+        mNumFrames = static_cast<int64_t>(mDecoder->frames() / mSourceRatio);
+        mGain = gain;
+        mFadeInFrames = fadeInFrames;
+        mFadeOutFrames = fadeOutFrames;
+
+        // The streamer starts out at the beginning of the clip, so playing from there is instant
+        mSourceFrames.clear();
+        mSourceStartFrame = 0;
+        mStreamFrame = 0;
+        mGeneration = 0;
+        mRequestedGeneration.store(0);
+        mStreamerGeneration.store(0);
+        mFlushedGeneration.store(0);
+        mFifoFrame = 0;
+        mIsFlushed = true;
+
+        mIsStopping.store(false);
+        mStreamerThread = std::thread(&AudioClipPlayer::streamerThreadFunc, this);
+        return true;
+    }
+
+    void close() {
+        if (mStreamerThread.joinable()) {
+            mIsStopping.store(true);
+            mStreamerThread.join();
+        }
+
+        mDecoder.reset();
+        mFifo.skip(mFifo.availableToRead());
+    }
+
+    // Must be called before open()
+    bool setOutputFormat(int32_t sampleRate, bool isStereo) override {
+        mSampleRate = sampleRate;
+        return isStereo;
+    }
+
+    // There are no notes to play
+    void handleMidiEvent(uint8_t /*status*/, uint8_t /*data1*/, uint8_t /*data2*/) override {}
+
+    void reset() override {
+        mIsPlaying = false;
+    }
+
+    void seekToFrame(uint32_t frame) override {
+        // The frame is signed, since the seek lands before the clip until it starts
+        const int64_t clipFrame = static_cast<int32_t>(frame);
+
+        if (clipFrame != mNextFrame) {
+            mDeclickFrame = 0;
+        }
+
+        mNextFrame = clipFrame;
+        mIsPlaying = true;
+
+        const int64_t streamFrame = std::max<int64_t>(clipFrame, 0);
+        const bool isBuffered = mIsFlushed && streamFrame >= mFifoFrame
+            && streamFrame <= mFifoFrame + mFifo.availableToRead();
+
+        if (!isBuffered) {
+            mGeneration++;
+            mRequestedFrame.store(streamFrame, std::memory_order_relaxed);
+            mRequestedGeneration.store(mGeneration, std::memory_order_release);
+            mIsFlushed = false;
+        }
+    }
+
+    void renderAudio(float* audioData, int32_t numFrames) override {
+        int32_t framesRendered = 0;
+
+        if (mIsPlaying && !mIsFlushed && mStreamerGeneration.load(std::memory_order_acquire) == mGeneration) {
+            // The streamer has moved, so anything left in the FIFO is from before the seek
+            mFifo.skip(mFifo.availableToRead());
+            mFifoFrame = mRequestedFrame.load(std::memory_order_relaxed);
+            mIsFlushed = true;
+            mFlushedGeneration.store(mGeneration, std::memory_order_release);
+        }
+
+        if (mIsPlaying && mIsFlushed) {
+            // Catch up on whatever was missed while waiting for the streamer
+            if (mFifoFrame < mNextFrame) {
+                const auto framesToSkip = static_cast<uint32_t>(std::min<int64_t>(mNextFrame - mFifoFrame, mFifo.availableToRead()));
+                mFifo.skip(framesToSkip);
+                mFifoFrame += framesToSkip;
+            }
+
+            if (mFifoFrame >= mNextFrame) {
+                // Silence until the clip starts
+                const auto framesOfSilence = static_cast<int32_t>(std::min<int64_t>(mFifoFrame - mNextFrame, numFrames));
+                memset(audioData, 0, framesOfSilence * kFrameSize);
+                framesRendered = framesOfSilence;
+
+                const auto framesToRead = std::min<uint32_t>(numFrames - framesRendered, mFifo.availableToRead());
+                mFifo.read(audioData + framesRendered * 2, framesToRead);
+                applyGain(audioData + framesRendered * 2, framesToRead, mFifoFrame);
+
+                mFifoFrame += framesToRead;
+                framesRendered += framesToRead;
+            }
+        }
+
+        if (framesRendered < numFrames) {
+            memset(audioData + framesRendered * 2, 0, (numFrames - framesRendered) * kFrameSize);
+            // The clip comes back in after a gap with a short fade, so it doesn't click
+            if (mFifoFrame > 0 && mFifoFrame < mNumFrames) mDeclickFrame = 0;
+        }
+
+        if (mIsPlaying) {
+            mNextFrame += numFrames;
+        }
+    }
+
+private:
+    static constexpr size_t kFrameSize = sizeof(float) * 2;
+    // About 370 ms at 44.1 kHz
+    static constexpr uint32_t kFifoFrames = 16384;
+    static constexpr uint32_t kChunkFrames = 1024;
+    static constexpr uint32_t kDeclickFrames = 64;
+    static constexpr auto kIdleInterval = std::chrono::milliseconds(5);
+    static constexpr auto kSeekPollInterval = std::chrono::milliseconds(1);
+
+    void applyGain(float* audioData, uint32_t numFrames, int64_t clipFrame) {
+        const bool isFading = clipFrame < mFadeInFrames || clipFrame + numFrames > mNumFrames - mFadeOutFrames
+            || mDeclickFrame < kDeclickFrames;
+
+        if (!isFading) {
+            for (uint32_t i = 0; i < numFrames * 2; i++) {
+                audioData[i] *= mGain;
+            }
+            return;
+        }
+
+        for (uint32_t i = 0; i < numFrames; i++) {
+            const int64_t frame = clipFrame + i;
+            float gain = mGain;
+
+            if (frame < mFadeInFrames) {
+                gain *= static_cast<float>(frame) / mFadeInFrames;
+            }
+            if (frame > mNumFrames - mFadeOutFrames) {
+                gain *= static_cast<float>(std::max<int64_t>(mNumFrames - frame, 0)) / mFadeOutFrames;
+            }
+            if (mDeclickFrame < kDeclickFrames) {
+                gain *= static_cast<float>(mDeclickFrame++) / kDeclickFrames;
+            }
+
+            audioData[i * 2] *= gain;
+            audioData[i * 2 + 1] *= gain;
+        }
+    }
+
+    // Streamer thread only, from here down
+    void streamerThreadFunc() {
+        uint32_t generation = 0;
+        std::vector<float> chunk(kChunkFrames * 2);
+
+        while (!mIsStopping.load()) {
+            const auto requestedGeneration = mRequestedGeneration.load(std::memory_order_acquire);
+
+            if (requestedGeneration != generation) {
+                generation = requestedGeneration;
+                moveTo(mRequestedFrame.load(std::memory_order_relaxed));
+                mStreamerGeneration.store(generation, std::memory_order_release);
+            }
+
+            // Wait for the audio thread to drop what was streamed before the seek
+            if (mFlushedGeneration.load(std::memory_order_acquire) != generation) {
+                std::this_thread::sleep_for(kSeekPollInterval);
+                continue;
+            }
+
+            const auto framesToStream = static_cast<uint32_t>(std::min<int64_t>(kChunkFrames, mNumFrames - mStreamFrame));
+            if (framesToStream == 0 || mFifo.availableToWrite() < framesToStream) {
+                std::this_thread::sleep_for(kIdleInterval);
+                continue;
+            }
+
+            resample(chunk.data(), framesToStream);
+            mFifo.write(chunk.data(), framesToStream);
+            mStreamFrame += framesToStream;
+        }
+    }
+
+    // Frames that have been decoded already are kept, anything else is sought to
+    void moveTo(int64_t frame) {
+        const auto sourceFrame = static_cast<int64_t>(frame * mSourceRatio);
+        const auto decodedEndFrame = mSourceStartFrame + static_cast<int64_t>(mSourceFrames.size() / 2);
+
+        if (sourceFrame >= mSourceStartFrame && sourceFrame <= decodedEndFrame) {
+            mSourceFrames.erase(mSourceFrames.begin(), mSourceFrames.begin() + (sourceFrame - mSourceStartFrame) * 2);
+        } else {
+            mSourceFrames.clear();
+
+            if (mDecoder && !mDecoder->seek(sourceFrame)) {
+                // Streams silence until the next seek tries again
+                LOGE("AudioClipPlayer: Cannot seek in %s", mPath.c_str());
+            }
+        }
+
+        mSourceStartFrame = sourceFrame;
+        mStreamFrame = frame;
+    }
+
+    // Appends up to numFrames frames from the decoder to mSourceFrames, as stereo
+    uint32_t decode(uint32_t numFrames) {
+        if (!mDecoder) return 0;
+
+        const auto channelCount = mDecoder->channels();
+        mDecodeBuffer.resize(numFrames * channelCount);
+
+        const auto framesDecoded = static_cast<uint32_t>(mDecoder->readNextBlock(mDecodeBuffer.data(), numFrames));
+
+        for (uint32_t i = 0; i < framesDecoded; i++) {
+            const float* frame = mDecodeBuffer.data() + i * channelCount;
+            mSourceFrames.push_back(frame[0]);
+            mSourceFrames.push_back(frame[std::min(channelCount, 2u) - 1]);
+        }
+
+        return framesDecoded;
+    }
+
+    // Fills output with the next numFrames frames at the output rate, interpolating linearly
+    // between source frames. Past the end of the file, the source is silent.
+    void resample(float* output, uint32_t numFrames) {
+        for (uint32_t i = 0; i < numFrames; i++) {
+            const double sourcePosition = (mStreamFrame + i) * mSourceRatio;
+            const auto sourceFrame = static_cast<int64_t>(sourcePosition);
+            const auto fraction = static_cast<float>(sourcePosition - sourceFrame);
+
+            // Both frames to interpolate between have to be decoded
+            while (sourceFrame + 1 >= mSourceStartFrame + static_cast<int64_t>(mSourceFrames.size() / 2)) {
+                if (decode(kChunkFrames) == 0) {
+                    mSourceFrames.push_back(0.0f);
+                    mSourceFrames.push_back(0.0f);
+                }
+            }
+
+            const float* before = mSourceFrames.data() + (sourceFrame - mSourceStartFrame) * 2;
+            const float* after = before + 2;
+            output[i * 2] = before[0] + (after[0] - before[0]) * fraction;
+            output[i * 2 + 1] = before[1] + (after[1] - before[1]) * fraction;
+        }
+
+        // Keep only the frame the next chunk starts from
+        const auto nextSourceFrame = static_cast<int64_t>((mStreamFrame + numFrames) * mSourceRatio);
+        const auto framesToDrop = std::min<int64_t>(nextSourceFrame - mSourceStartFrame, mSourceFrames.size() / 2);
+        mSourceFrames.erase(mSourceFrames.begin(), mSourceFrames.begin() + framesToDrop * 2);
+        mSourceStartFrame += framesToDrop;
+    }
+
+    int32_t mSampleRate = 44100;
+    std::string mPath;
+    // The length of the clip in output frames
+    int64_t mNumFrames = 0;
+    double mSourceRatio = 1.0;
+    float mGain = 1.0f;
+    int64_t mFadeInFrames = 0;
+    int64_t mFadeOutFrames = 0;
+
+    AudioFifo<kFifoFrames> mFifo;
+    std::atomic<int64_t> mRequestedFrame { 0 };
+    std::atomic<uint32_t> mRequestedGeneration { 0 };
+    std::atomic<uint32_t> mStreamerGeneration { 0 };
+    std::atomic<uint32_t> mFlushedGeneration { 0 };
+    std::atomic<bool> mIsStopping { false };
+    std::thread mStreamerThread;
+
+    // Audio thread only
+    int64_t mNextFrame = 0;
+    // The clip frame at the front of the FIFO, once it has been flushed for mGeneration
+    int64_t mFifoFrame = 0;
+    uint32_t mGeneration = 0;
+    uint32_t mDeclickFrame = kDeclickFrames;
+    bool mIsFlushed = true;
+    bool mIsPlaying = false;
+
+    // Streamer thread only
+    std::unique_ptr<MediaDecoder> mDecoder;
+    // Decoded stereo frames, starting at source frame mSourceStartFrame
+    std::vector<float> mSourceFrames;
+    std::vector<float> mDecodeBuffer;
+    int64_t mSourceStartFrame = 0;
+    // The next clip frame to write to the FIFO
+    int64_t mStreamFrame = 0;
+};
+
+#endif //AUDIO_CLIP_PLAYER_H
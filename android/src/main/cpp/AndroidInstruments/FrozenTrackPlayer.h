@@ -0,0 +1,112 @@
+/*
+ * Plays back a track that was rendered to a file by TrackFreezer.
+ * This is used on Android only
+ */
+
+#ifndef FROZEN_TRACK_PLAYER_H
+#define FROZEN_TRACK_PLAYER_H
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "IInstrument.h"
+#include "../Utils/Logging.h"
+
+/**
+ * Streams interleaved stereo float frames from a memory-mapped file. It doesn't follow the
+ * position by itself: each SEEK_EVENT says which frame of the file plays at that point, so loops
+ * and jumps stay sample-accurate, and it plays silence until the first one arrives.
+ *
+ * The audio thread may still have to fault in pages that were evicted. MADV_WILLNEED reads the
+ * file in up front, and with render-ahead enabled the faults happen on a worker instead.
+ */
+class FrozenTrackPlayer : public IInstrument {
+public:
+    ~FrozenTrackPlayer() {
+        close();
+    }
+
+    bool open(const char* path) {
+        close();
+
+        int fd = ::open(path, O_RDONLY);
+        if (fd == -1) {
+            LOGE("FrozenTrackPlayer: Cannot open %s", path);
+            return false;
+        }
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0 || fileStat.st_size < static_cast<off_t>(kFrameSize)) {
+            ::close(fd);
+            return false;
+        }
+
+        const size_t mappedSize = fileStat.st_size;
+        void* data = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+
+        if (data == MAP_FAILED) {
+            LOGE("FrozenTrackPlayer: Cannot map %s", path);
+            return false;
+        }
+
+        madvise(data, mappedSize, MADV_SEQUENTIAL);
+        madvise(data, mappedSize, MADV_WILLNEED);
+
+        mData = static_cast<const float*>(data);
+        mMappedSize = mappedSize;
+        mNumFrames = mappedSize / kFrameSize;
+        return true;
+    }
+
+    void close() {
+        if (mData != nullptr) {
+            munmap(const_cast<float*>(mData), mMappedSize);
+            mData = nullptr;
+            mMappedSize = 0;
+            mNumFrames = 0;
+        }
+    }
+
+    bool setOutputFormat(int32_t /*sampleRate*/, bool isStereo) override {
+        return isStereo;
+    }
+
+    // The notes are already in the file
+    void handleMidiEvent(uint8_t /*status*/, uint8_t /*data1*/, uint8_t /*data2*/) override {}
+
+    void reset() override {
+        mIsPlaying = false;
+    }
+
+    void seekToFrame(uint32_t frame) override {
+        mNextFrame = frame;
+        mIsPlaying = true;
+    }
+
+    void renderAudio(float* audioData, int32_t numFrames) override {
+        uint32_t framesCopied = 0;
+
+        if (mIsPlaying && mNextFrame < mNumFrames) {
+            framesCopied = std::min(static_cast<uint32_t>(numFrames), mNumFrames - mNextFrame);
+            memcpy(audioData, mData + mNextFrame * 2, framesCopied * kFrameSize);
+        }
+
+        memset(audioData + framesCopied * 2, 0, (numFrames - framesCopied) * kFrameSize);
+        mNextFrame += numFrames;
+    }
+
+private:
+    static constexpr size_t kFrameSize = sizeof(float) * 2;
+
+    const float* mData = nullptr;
+    size_t mMappedSize = 0;
+    uint32_t mNumFrames = 0;
+    uint32_t mNextFrame = 0;
+    bool mIsPlaying = false;
+};
+
+#endif //FROZEN_TRACK_PLAYER_H
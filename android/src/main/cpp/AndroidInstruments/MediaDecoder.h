@@ -0,0 +1,298 @@
+/*
+ * Decodes an audio file with the platform codecs, for AudioClipPlayer.
+ * This is used on Android only
+ */
+
+#ifndef MEDIA_DECODER_H
+#define MEDIA_DECODER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <media/NdkMediaCodec.h>
+#include <media/NdkMediaExtractor.h>
+#include <media/NdkMediaFormat.h>
+#include "../Utils/Logging.h"
+
+/**
+ * Reads the first audio track of a file through AMediaExtractor and AMediaCodec, so it takes
+ * whatever the device can decode (WAV, MP3, AAC, FLAC, Ogg and so on). Frames come out as
+ * interleaved floats, in the channel count and sample rate of the decoded stream.
+ *
+ * seek() moves the extractor to the sync frame before the target and drops what the codec
+ * outputs before it, so reads continue exactly at the target frame.
+ */
+class MediaDecoder {
+public:
+    ~MediaDecoder() {
+        close();
+    }
+
+    bool open(const char* path) {
+        close();
+
+        mFd = ::open(path, O_RDONLY | O_CLOEXEC);
+        struct stat fileStat;
+
+        if (mFd < 0 || fstat(mFd, &fileStat) != 0) {
+            LOGE("MediaDecoder: Cannot open %s", path);
+            close();
+            return false;
+        }
+
+        mExtractor = AMediaExtractor_new();
+
+        if (AMediaExtractor_setDataSourceFd(mExtractor, mFd, 0, fileStat.st_size) != AMEDIA_OK
+            || !openAudioTrack()) {
+            LOGE("MediaDecoder: No audio to decode in %s", path);
+            close();
+            return false;
+        }
+
+        // The stream can differ from what the container says, so the format is only known once
+        // the codec has output something
+        if (!decodeNextBuffer()) {
+            LOGE("MediaDecoder: Cannot decode %s", path);
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void close() {
+        if (mCodec != nullptr) {
+            AMediaCodec_stop(mCodec);
+            AMediaCodec_delete(mCodec);
+            mCodec = nullptr;
+        }
+
+        if (mExtractor != nullptr) {
+            AMediaExtractor_delete(mExtractor);
+            mExtractor = nullptr;
+        }
+
+        if (mFd >= 0) {
+            ::close(mFd);
+            mFd = -1;
+        }
+
+        mPending.clear();
+        mPendingOffset = 0;
+    }
+
+    // The length of the stream in frames, as far as the container knows it
+    int64_t frames() const {
+        return static_cast<int64_t>(mDurationUs * mSampleRate / 1000000.0);
+    }
+
+    uint32_t channels() const {
+        return mChannelCount;
+    }
+
+    uint32_t sampleRate() const {
+        return mSampleRate;
+    }
+
+    // Reads up to numFrames interleaved frames into output and returns how many were read, which
+    // is less than numFrames only at the end of the stream
+    size_t readNextBlock(float* output, size_t numFrames) {
+        size_t framesRead = 0;
+
+        while (framesRead < numFrames) {
+            if (mPendingOffset == mPending.size()) {
+                mPending.clear();
+                mPendingOffset = 0;
+
+                if (!decodeNextBuffer()) break;
+            }
+
+            const size_t framesToCopy = std::min(numFrames - framesRead, (mPending.size() - mPendingOffset) / mChannelCount);
+            const size_t samplesToCopy = framesToCopy * mChannelCount;
+
+            std::copy(mPending.begin() + mPendingOffset, mPending.begin() + mPendingOffset + samplesToCopy,
+                output + framesRead * mChannelCount);
+            mPendingOffset += samplesToCopy;
+            framesRead += framesToCopy;
+        }
+
+        return framesRead;
+    }
+
+    // The next read starts at frame. If this fails, reads return nothing until the next seek.
+    bool seek(int64_t frame) {
+        if (mCodec == nullptr) return false;
+
+        mPending.clear();
+        mPendingOffset = 0;
+        mDropUntilFrame = frame;
+        mIsInputDone = false;
+        mIsOutputDone = false;
+
+        const auto timeUs = static_cast<int64_t>(frame * 1000000.0 / mSampleRate);
+
+        if (AMediaExtractor_seekTo(mExtractor, timeUs, AMEDIAEXTRACTOR_SEEK_PREVIOUS_SYNC) != AMEDIA_OK
+            || AMediaCodec_flush(mCodec) != AMEDIA_OK) {
+            mIsOutputDone = true;
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    static constexpr int64_t kOutputTimeoutUs = 10000;
+    // How long the codec may hold back output before the stream counts as ended
+    static constexpr int32_t kMaxOutputRetries = 100;
+    // android.media.AudioFormat encodings, for the "pcm-encoding" key
+    static constexpr int32_t kPcmEncoding16Bit = 2;
+    static constexpr int32_t kPcmEncodingFloat = 4;
+
+    bool openAudioTrack() {
+        const auto trackCount = AMediaExtractor_getTrackCount(mExtractor);
+
+        for (size_t i = 0; i < trackCount; i++) {
+            AMediaFormat* format = AMediaExtractor_getTrackFormat(mExtractor, i);
+            const char* mime = nullptr;
+            int32_t sampleRate = 0;
+            int32_t channelCount = 0;
+
+            const bool isAudio = AMediaFormat_getString(format, AMEDIAFORMAT_KEY_MIME, &mime)
+                && strncmp(mime, "audio/", 6) == 0
+                && AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_SAMPLE_RATE, &sampleRate)
+                && AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_CHANNEL_COUNT, &channelCount)
+                && AMediaFormat_getInt64(format, AMEDIAFORMAT_KEY_DURATION, &mDurationUs)
+                && sampleRate > 0 && channelCount > 0;
+
+            if (isAudio) {
+                mSampleRate = sampleRate;
+                mChannelCount = channelCount;
+                mCodec = AMediaCodec_createDecoderByType(mime);
+
+                const bool didStart = mCodec != nullptr
+                    && AMediaExtractor_selectTrack(mExtractor, i) == AMEDIA_OK
+                    && AMediaCodec_configure(mCodec, format, nullptr, nullptr, 0) == AMEDIA_OK
+                    && AMediaCodec_start(mCodec) == AMEDIA_OK;
+
+                AMediaFormat_delete(format);
+                return didStart;
+            }
+
+            AMediaFormat_delete(format);
+        }
+
+        return false;
+    }
+
+    void readOutputFormat() {
+        AMediaFormat* format = AMediaCodec_getOutputFormat(mCodec);
+        int32_t value = 0;
+
+        if (AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_SAMPLE_RATE, &value) && value > 0) mSampleRate = value;
+        if (AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_CHANNEL_COUNT, &value) && value > 0) mChannelCount = value;
+        mPcmEncoding = AMediaFormat_getInt32(format, "pcm-encoding", &value) ? value : kPcmEncoding16Bit;
+
+        AMediaFormat_delete(format);
+    }
+
+    void queueInput() {
+        const auto index = AMediaCodec_dequeueInputBuffer(mCodec, 0);
+        if (index < 0) return;
+
+        size_t capacity = 0;
+        uint8_t* buffer = AMediaCodec_getInputBuffer(mCodec, index, &capacity);
+        const auto size = AMediaExtractor_readSampleData(mExtractor, buffer, capacity);
+
+        if (size < 0) {
+            AMediaCodec_queueInputBuffer(mCodec, index, 0, 0, 0, AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM);
+            mIsInputDone = true;
+        } else {
+            AMediaCodec_queueInputBuffer(mCodec, index, 0, size, AMediaExtractor_getSampleTime(mExtractor), 0);
+            AMediaExtractor_advance(mExtractor);
+        }
+    }
+
+    // Decodes until some frames at or after mDropUntilFrame are in mPending. Returns false at the
+    // end of the stream.
+    bool decodeNextBuffer() {
+        int32_t retries = 0;
+
+        while (!mIsOutputDone) {
+            if (!mIsInputDone) queueInput();
+
+            AMediaCodecBufferInfo info;
+            const auto index = AMediaCodec_dequeueOutputBuffer(mCodec, &info, kOutputTimeoutUs);
+
+            if (index == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
+                readOutputFormat();
+                continue;
+            }
+
+            if (index < 0) {
+                if (++retries >= kMaxOutputRetries) mIsOutputDone = true;
+                continue;
+            }
+
+            retries = 0;
+
+            size_t bufferSize = 0;
+            const uint8_t* buffer = AMediaCodec_getOutputBuffer(mCodec, index, &bufferSize);
+
+            if (buffer != nullptr && info.size > 0) {
+                appendOutput(buffer + info.offset, info.size, info.presentationTimeUs);
+            }
+
+            AMediaCodec_releaseOutputBuffer(mCodec, index, false);
+            if (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) mIsOutputDone = true;
+
+            if (!mPending.empty()) return true;
+        }
+
+        return false;
+    }
+
+    // Converts a buffer of PCM to floats, leaving out the frames before mDropUntilFrame
+    void appendOutput(const uint8_t* data, int32_t size, int64_t presentationTimeUs) {
+        const bool isFloat = mPcmEncoding == kPcmEncodingFloat;
+        const size_t sampleSize = isFloat ? sizeof(float) : sizeof(int16_t);
+        const int64_t bufferFrames = size / (sampleSize * mChannelCount);
+
+        const auto startFrame = static_cast<int64_t>(std::llround(presentationTimeUs * mSampleRate / 1000000.0));
+        const int64_t framesToDrop = std::min(std::max<int64_t>(mDropUntilFrame - startFrame, 0), bufferFrames);
+        const size_t firstSample = framesToDrop * mChannelCount;
+        const size_t sampleCount = bufferFrames * mChannelCount;
+
+        for (size_t i = firstSample; i < sampleCount; i++) {
+            if (isFloat) {
+                float sample;
+                memcpy(&sample, data + i * sizeof(float), sizeof(float));
+                mPending.push_back(sample);
+            } else {
+                int16_t sample;
+                memcpy(&sample, data + i * sizeof(int16_t), sizeof(int16_t));
+                mPending.push_back(sample / 32768.0f);
+            }
+        }
+    }
+
+    int mFd = -1;
+    AMediaExtractor* mExtractor = nullptr;
+    AMediaCodec* mCodec = nullptr;
+    int64_t mDurationUs = 0;
+    uint32_t mSampleRate = 0;
+    uint32_t mChannelCount = 0;
+    int32_t mPcmEncoding = kPcmEncoding16Bit;
+    bool mIsInputDone = false;
+    bool mIsOutputDone = false;
+    int64_t mDropUntilFrame = 0;
+
+    // Decoded samples that haven't been read yet, from mPendingOffset on
+    std::vector<float> mPending;
+    size_t mPendingOffset = 0;
+};
+
+#endif //MEDIA_DECODER_H
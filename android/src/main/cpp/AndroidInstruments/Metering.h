@@ -0,0 +1,328 @@
+/*
+ * Level and spectrum metering of the mixer's tracks and output.
+ * This is used on Android only
+ */
+
+#ifndef METERING_H
+#define METERING_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include "kiss_fftr.h"
+#include "RenderAhead.h"
+
+constexpr int32_t kMaxMeteredTracks = 64;
+constexpr int32_t kSpectrumBands = 48;
+
+// Written by the analysis thread and read in place by Dart, see get_meter_readout. Levels are
+// linear amplitudes where 1.0 is full scale, the spectrum is in dBFS from the lowest band up. Each
+// value is written whole, but they aren't updated together.
+// Remember to keep lib/ffi/functions.dart in sync.
+struct MeterReadout {
+    // Goes up by one every time the analysis thread publishes
+    uint32_t updateCount;
+    uint32_t isSpectrumEnabled;
+    float masterPeak[2];
+    float masterRms[2];
+    float trackPeak[kMaxMeteredTracks];
+    float trackRms[kMaxMeteredTracks];
+    float spectrum[kSpectrumBands];
+};
+
+/**
+ * Meters the mixer without doing more on the audio thread than one pass over each buffer. For
+ * every block, the audio thread measures the peak and the sum of squares of each track, post-fader,
+ * and of the output, and queues them in a MeterBlock. If the spectrum is on, it also copies the
+ * output into a FIFO. Both are lock-free, and if either is full the block just isn't metered.
+ *
+ * The analysis thread wakes up about 60 times a second, applies the blocks to the meter ballistics,
+ * runs an FFT over the newest output, and writes the results to the MeterReadout. It only runs
+ * while metering is enabled.
+ */
+class Metering {
+public:
+    Metering() {
+        mFftConfig = kiss_fftr_alloc(kFftSize, 0, nullptr, nullptr);
+
+        for (uint32_t i = 0; i < kFftSize; i++) {
+            mWindow[i] = 0.5f - 0.5f * std::cos(2.0f * static_cast<float>(M_PI) * i / kFftSize);
+        }
+
+        for (auto& band : mReadout.spectrum) band = kSpectrumFloorDb;
+    }
+
+    ~Metering() {
+        setEnabled(false);
+        kiss_fftr_free(mFftConfig);
+    }
+
+    void setEnabled(bool isEnabled) {
+        if (isEnabled == mAnalysisThread.joinable()) return;
+
+        if (isEnabled) {
+            mIsStopping.store(false);
+            mIsEnabled.store(true);
+            mAnalysisThread = std::thread(&Metering::analysisThreadFunc, this);
+        } else {
+            mIsEnabled.store(false);
+            mIsStopping.store(true);
+            mAnalysisThread.join();
+        }
+    }
+
+    void setSpectrumEnabled(bool isEnabled) {
+        mIsSpectrumEnabled.store(isEnabled);
+    }
+
+    void setSampleRate(int32_t sampleRate) {
+        mSampleRate.store(sampleRate);
+    }
+
+    // Stays valid for as long as the mixer does
+    const MeterReadout* getReadout() const {
+        return &mReadout;
+    }
+
+    // Audio thread only, from here down to endBlock()
+    void beginBlock(uint32_t numFrames) {
+        mBlock = nullptr;
+        if (!mIsEnabled.load(std::memory_order_relaxed)) return;
+
+        const uint32_t writeIndex = mBlockWriteIndex.load(std::memory_order_relaxed);
+        if (writeIndex - mBlockReadIndex.load(std::memory_order_acquire) == kBlockQueueSize) return;
+
+        mBlock = &mBlocks[writeIndex & (kBlockQueueSize - 1)];
+        mBlock->numFrames = numFrames;
+        mBlock->trackMask = 0;
+    }
+
+    // audioData is the track's buffer before its level is applied
+    void meterTrack(track_index_t trackIndex, const float* audioData, uint32_t numSamples, float level) {
+        if (mBlock == nullptr || trackIndex < 0 || trackIndex >= kMaxMeteredTracks) return;
+
+        float peak = 0.0f;
+        float squares = 0.0f;
+
+        for (uint32_t i = 0; i < numSamples; i++) {
+            peak = std::max(peak, std::fabs(audioData[i]));
+            squares += audioData[i] * audioData[i];
+        }
+
+        mBlock->trackPeak[trackIndex] = peak * level;
+        // Mean over both channels, so a track reads the same in mono and stereo
+        mBlock->trackMeanSquare[trackIndex] = squares * level * level / numSamples;
+        mBlock->trackMask |= uint64_t(1) << trackIndex;
+    }
+
+    void meterOutput(const float* audioData, uint32_t numFrames, int32_t channelCount) {
+        if (mBlock == nullptr) return;
+
+        for (int32_t channel = 0; channel < 2; channel++) {
+            const float* samples = audioData + std::min(channel, channelCount - 1);
+            float peak = 0.0f;
+            float squares = 0.0f;
+
+            for (uint32_t i = 0; i < numFrames; i++) {
+                const float sample = samples[i * channelCount];
+                peak = std::max(peak, std::fabs(sample));
+                squares += sample * sample;
+            }
+
+            mBlock->outputPeak[channel] = peak;
+            mBlock->outputMeanSquare[channel] = squares / numFrames;
+        }
+
+        // The spectrum is of the stereo output only, as that is all the mixer applies effects to
+        if (channelCount == 2 && mIsSpectrumEnabled.load(std::memory_order_relaxed)
+            && mSpectrumFifo.availableToWrite() >= numFrames) {
+            mSpectrumFifo.write(audioData, numFrames);
+        }
+    }
+
+    void endBlock() {
+        if (mBlock == nullptr) return;
+
+        mBlockWriteIndex.fetch_add(1, std::memory_order_release);
+        mBlock = nullptr;
+    }
+
+private:
+    static constexpr uint32_t kBlockQueueSize = 64; // ~190 ms of 128 frame blocks
+    static constexpr uint32_t kFftSize = 2048;
+    static constexpr uint32_t kFftHop = kFftSize / 2;
+    static constexpr uint32_t kSpectrumFifoFrames = 8192;
+    static constexpr auto kAnalysisInterval = std::chrono::milliseconds(16);
+    static constexpr float kPeakFallDbPerSecond = 20.0f;
+    static constexpr float kRmsTimeConstantSeconds = 0.3f;
+    static constexpr float kSpectrumFallDbPerSecond = 40.0f;
+    static constexpr float kSpectrumFloorDb = -120.0f;
+    static constexpr float kLowestBandHz = 20.0f;
+
+    struct MeterBlock {
+        uint32_t numFrames;
+        uint64_t trackMask;
+        float outputPeak[2];
+        float outputMeanSquare[2];
+        float trackPeak[kMaxMeteredTracks];
+        float trackMeanSquare[kMaxMeteredTracks];
+    };
+
+    // Analysis thread only
+    struct Ballistics {
+        float peak = 0.0f;
+        float meanSquare = 0.0f;
+
+        void apply(float blockPeak, float blockMeanSquare, float peakFall, float rmsCoefficient) {
+            peak = std::max(peak * peakFall, blockPeak);
+            meanSquare += (blockMeanSquare - meanSquare) * rmsCoefficient;
+        }
+    };
+
+    void analysisThreadFunc() {
+        while (!mIsStopping.load()) {
+            const auto wakeTime = std::chrono::steady_clock::now() + kAnalysisInterval;
+
+            applyBlocks();
+            if (mIsSpectrumEnabled.load(std::memory_order_relaxed)) {
+                analyzeSpectrum();
+            }
+
+            mReadout.isSpectrumEnabled = mIsSpectrumEnabled.load(std::memory_order_relaxed);
+            mReadout.updateCount++;
+
+            std::this_thread::sleep_until(wakeTime);
+        }
+    }
+
+    void applyBlocks() {
+        const float sampleRate = static_cast<float>(mSampleRate.load());
+        const uint32_t writeIndex = mBlockWriteIndex.load(std::memory_order_acquire);
+        uint32_t readIndex = mBlockReadIndex.load(std::memory_order_relaxed);
+
+        if (readIndex == writeIndex) {
+            // Nothing is being rendered, so the meters fall as if it were silence
+            const float seconds = std::chrono::duration<float>(kAnalysisInterval).count();
+            const float peakFall = std::pow(10.0f, -kPeakFallDbPerSecond * seconds / 20.0f);
+            const float rmsCoefficient = 1.0f - std::exp(-seconds / kRmsTimeConstantSeconds);
+
+            for (auto& ballistics : mOutputBallistics) ballistics.apply(0.0f, 0.0f, peakFall, rmsCoefficient);
+            for (auto& ballistics : mTrackBallistics) ballistics.apply(0.0f, 0.0f, peakFall, rmsCoefficient);
+        }
+
+        for (; readIndex != writeIndex; readIndex++) {
+            const auto& block = mBlocks[readIndex & (kBlockQueueSize - 1)];
+            const float seconds = block.numFrames / sampleRate;
+            const float peakFall = std::pow(10.0f, -kPeakFallDbPerSecond * seconds / 20.0f);
+            const float rmsCoefficient = 1.0f - std::exp(-seconds / kRmsTimeConstantSeconds);
+
+            for (int32_t channel = 0; channel < 2; channel++) {
+                mOutputBallistics[channel].apply(block.outputPeak[channel], block.outputMeanSquare[channel], peakFall, rmsCoefficient);
+            }
+
+            for (int32_t track = 0; track < kMaxMeteredTracks; track++) {
+                // Tracks that weren't rendered in the block were silent
+                const bool wasMetered = block.trackMask & (uint64_t(1) << track);
+                mTrackBallistics[track].apply(wasMetered ? block.trackPeak[track] : 0.0f,
+                                              wasMetered ? block.trackMeanSquare[track] : 0.0f, peakFall, rmsCoefficient);
+            }
+        }
+
+        mBlockReadIndex.store(readIndex, std::memory_order_release);
+
+        for (int32_t channel = 0; channel < 2; channel++) {
+            mReadout.masterPeak[channel] = mOutputBallistics[channel].peak;
+            mReadout.masterRms[channel] = std::sqrt(mOutputBallistics[channel].meanSquare);
+        }
+
+        for (int32_t track = 0; track < kMaxMeteredTracks; track++) {
+            mReadout.trackPeak[track] = mTrackBallistics[track].peak;
+            mReadout.trackRms[track] = std::sqrt(mTrackBallistics[track].meanSquare);
+        }
+    }
+
+    void analyzeSpectrum() {
+        const float sampleRate = static_cast<float>(mSampleRate.load());
+        float frames[kFftHop * 2];
+        bool didAnalyze = false;
+
+        // Only the newest window matters, so anything older than that is skipped through
+        while (mSpectrumFifo.availableToRead() >= kFftHop) {
+            mSpectrumFifo.read(frames, kFftHop);
+
+            std::copy(mHistory.begin() + kFftHop, mHistory.end(), mHistory.begin());
+            for (uint32_t i = 0; i < kFftHop; i++) {
+                mHistory[kFftSize - kFftHop + i] = 0.5f * (frames[i * 2] + frames[i * 2 + 1]);
+            }
+
+            didAnalyze = true;
+        }
+
+        const float seconds = std::chrono::duration<float>(kAnalysisInterval).count();
+        const float fallDb = kSpectrumFallDbPerSecond * seconds;
+
+        if (!didAnalyze) {
+            for (auto& band : mReadout.spectrum) band = std::max(band - fallDb, kSpectrumFloorDb);
+            return;
+        }
+
+        for (uint32_t i = 0; i < kFftSize; i++) {
+            mFftInput[i] = mHistory[i] * mWindow[i];
+        }
+        kiss_fftr(mFftConfig, mFftInput.data(), mFftOutput.data());
+
+        // A full scale sine peaks at kFftSize / 4 through the Hann window, which is 0 dB
+        const float normalization = 4.0f / kFftSize;
+        const float binHz = sampleRate / kFftSize;
+        const float nyquist = sampleRate / 2;
+        const float bandRatio = std::pow(nyquist / kLowestBandHz, 1.0f / kSpectrumBands);
+
+        float bandLowHz = kLowestBandHz;
+        for (int32_t band = 0; band < kSpectrumBands; band++) {
+            const float bandHighHz = bandLowHz * bandRatio;
+            const uint32_t firstBin = static_cast<uint32_t>(bandLowHz / binHz);
+            const uint32_t lastBin = std::max(firstBin, std::min(static_cast<uint32_t>(bandHighHz / binHz), kFftSize / 2));
+
+            // The loudest bin, so a sine reads at its level however wide the band is
+            float magnitude = 0.0f;
+            for (uint32_t bin = firstBin; bin <= lastBin; bin++) {
+                magnitude = std::max(magnitude, std::hypot(mFftOutput[bin].r, mFftOutput[bin].i));
+            }
+
+            const float db = std::max(20.0f * std::log10(magnitude * normalization + 1e-9f), kSpectrumFloorDb);
+            mReadout.spectrum[band] = std::max(db, mReadout.spectrum[band] - fallDb);
+
+            bandLowHz = bandHighHz;
+        }
+    }
+
+    // Audio thread only
+    MeterBlock* mBlock = nullptr;
+
+    std::array<MeterBlock, kBlockQueueSize> mBlocks;
+    std::atomic<uint32_t> mBlockWriteIndex { 0 };
+    std::atomic<uint32_t> mBlockReadIndex { 0 };
+    AudioFifo<kSpectrumFifoFrames> mSpectrumFifo;
+
+    std::atomic<bool> mIsEnabled { false };
+    std::atomic<bool> mIsSpectrumEnabled { false };
+    std::atomic<bool> mIsStopping { false };
+    std::atomic<int32_t> mSampleRate { 44100 };
+    std::thread mAnalysisThread;
+
+    // Analysis thread only
+    std::array<Ballistics, 2> mOutputBallistics;
+    std::array<Ballistics, kMaxMeteredTracks> mTrackBallistics;
+    std::array<float, kFftSize> mHistory = {};
+    std::array<float, kFftSize> mWindow;
+    std::array<kiss_fft_scalar, kFftSize> mFftInput;
+    std::array<kiss_fft_cpx, kFftSize / 2 + 1> mFftOutput;
+    kiss_fftr_cfg mFftConfig;
+
+    MeterReadout mReadout = {};
+};
+
+#endif //METERING_H
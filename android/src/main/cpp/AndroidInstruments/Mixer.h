@@ -7,25 +7,80 @@
 #define MIXER_H
 
 #include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
 #include "BaseScheduler.h"
 #include "IRenderableAudio.h"
+#include "Metering.h"
+#include "RenderAhead.h"
+#include "../AndroidEffects/EffectChain.h"
+#include "../AndroidEffects/LimiterEffect.h"
 #include "../Utils/OptionArray.h"
 #include "../Utils/Logging.h"
 
 constexpr int32_t kBufferSize = 128*2;  // Match AndroidEngine buffer size (128 frames * 2 channels)
 constexpr uint8_t kMaxTracks = 64;  // Reasonable limit for mobile performance
+constexpr uint8_t kMaxAuxBuses = 4;
+constexpr int32_t kMaxRenderAheadWorkers = 3;
+constexpr int32_t kLiveInputHoldoffSeconds = 2;
 
 /**
  * A Mixer object which sums the output from multiple tracks into a single output. The number of
  * input channels on each track must match the number of output channels (default 1=mono). This can
  * be changed by calling `setChannelCount`.
  * The inputs to the mixer are not owned by the mixer, they should not be deleted while rendering.
+ *
+ * Each track runs through its insert effects and is then summed into the output and, post-fader,
+ * into any of the aux buses it sends to. Each bus runs through its own effects and is returned to
+ * the output, and the output runs through the master effects. Effects are owned by the mixer.
+ * Last of all, a limiter keeps the output below full scale, so instruments don't need to clip.
+ *
+ * With render-ahead enabled, tracks that only play scheduled events are rendered by worker threads
+ * up to kRenderAheadFrames ahead of the position, and the audio thread just mixes what they
+ * rendered. A track goes back to rendering just in time when it gets live input, when events it
+ * has already rendered are cleared, or when the workers fall behind.
+ *
+ * When the engine's LoadGovernor asks for a lower LoadStage, each instrument is switched over by
+ * whichever thread renders it next, so it is never changed while it is being rendered.
+ *
+ * With metering enabled, each track is metered post-fader and the output after the limiter, see
+ * Metering.
  */
 
+struct TrackEffects {
+    EffectChain inserts;
+    std::array<std::atomic<float>, kMaxAuxBuses> sendLevels = {};
+};
+
 struct TrackInfo {
-    IInstrument* track;
-    float level;
+    // Swapped by replaceTrackInstrument while the audio thread renders
+    std::atomic<IInstrument*> track { nullptr };
+    float level = 1.0f;
+    TrackEffects* effects = nullptr;
+
+    TrackInfo() = default;
+
+    TrackInfo(const TrackInfo& other)
+        : track(other.track.load(std::memory_order_acquire)), level(other.level), effects(other.effects) {}
+
+    TrackInfo& operator=(const TrackInfo& other) {
+        track.store(other.track.load(std::memory_order_acquire), std::memory_order_release);
+        level = other.level;
+        effects = other.effects;
+        return *this;
+    }
+};
+
+struct AuxBus {
+    EffectChain effects;
+    std::atomic<float> returnLevel = { 1.0f };
+    float buffer[kBufferSize];
 };
 
 class Mixer : public IRenderableAudio, public BaseScheduler {
@@ -33,6 +88,20 @@ class Mixer : public IRenderableAudio, public BaseScheduler {
 public:
     Mixer() {
         static_assert(std::is_base_of<IRenderableAudio, IInstrument>::value, "TTrack must be derived from IRenderableAudio");
+        static_assert(kMaxTracks <= kMaxMeteredTracks, "Every track must have a meter");
+    }
+
+    ~Mixer() {
+        setRenderAheadEnabled(false);
+
+        for (auto& auxBus : mAuxBuses) {
+            deleteEffects(auxBus.effects);
+        }
+        deleteEffects(mMasterEffects);
+
+        for (auto& pair : mTrackEffects) {
+            deleteEffects(pair.second->inserts);
+        }
     }
 
     void renderAudio(float *audioData, int32_t numFrames) {
@@ -40,29 +109,83 @@ public:
             return;
         }
 
+        const auto hostTimeUs = RenderClock::nowUs();
+        mIsRendering.store(true);
+        // Pairs with the fence in waitForAudioThread, so any track map reads below see a swapped instrument
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
         // Zero out the incoming container array efficiently
         const size_t totalSamples = numFrames * mChannelCount;
         memset(audioData, 0, sizeof(float) * totalSamples);
 
+        // Effects process interleaved stereo
+        const bool canProcessEffects = mChannelCount == 2;
+        mMetering.beginBlock(numFrames);
+
         // Early exit if no tracks
         if (mTrackMap.empty()) {
+            // Keep the limiter running so its look-ahead doesn't replay stale audio later
+            if (canProcessEffects) mMasterLimiter.process(audioData, numFrames);
+            mMetering.meterOutput(audioData, numFrames, mChannelCount);
+            mMetering.endBlock();
+
+            mRenderedBlockCount.fetch_add(1, std::memory_order_release);
+            mIsRendering.store(false, std::memory_order_release);
             return;
         }
+        std::array<bool, kMaxAuxBuses> isBusActive = {};
+
+        // Either every track sees a pending batch or none of them do. The render-ahead workers share
+        // the lock, since no two renderers consume the buffer of the same track.
+        std::shared_lock<SharedSpinLock> batchLock(mBatchLock, std::try_to_lock);
+        const bool canHandleEvents = batchLock.owns_lock();
+
+        const bool isPlaying = getIsPlaying();
+        const auto startFrame = getPosition();
+        // Only one track starts rendering ahead per block, since it renders a few blocks up front
+        bool canStartRenderingAhead = isPlaying && canHandleEvents && canProcessEffects
+            && mIsRenderAheadEnabled.load(std::memory_order_relaxed);
 
         // Render each track and mix
         for (const auto& pair : mTrackMap) {
             const auto trackIndex = pair.first;
             const auto& trackInfo = pair.second;
+            auto renderAhead = getRenderAheadTrack(trackIndex);
+
+            // Levels are applied here rather than by the workers, so a batch's volume isn't late
+            if (canHandleEvents) handlePendingVolume(trackIndex);
+
+            if (isPlaying && renderAhead != nullptr) {
+                handleDueEvents(*renderAhead, startFrame + numFrames);
+            }
+
+            // Skip silent tracks, unless they were rendered ahead and have to keep up with the position
+            const bool isRenderedAhead = renderAhead != nullptr
+                && renderAhead->mode.load(std::memory_order_acquire) != RENDER_JUST_IN_TIME;
+            if (trackInfo.level <= 0.0f && !isRenderedAhead) {
+                // Nothing is rendered, but live input still has to reach the instrument
+                handleLiveEvents(trackIndex);
+                continue;
+            }
+
+            if (isPlaying) {
+                renderTrackBlock(trackIndex, renderAhead, startFrame, numFrames, canHandleEvents, canStartRenderingAhead);
+            } else {
+                handleLiveEventsWhilePaused(trackIndex, renderAhead);
+                memset(mixingBuffer, 0, sizeof(float) * totalSamples);
+            }
 
-            // Skip silent tracks
             if (trackInfo.level <= 0.0f) {
                 continue;
             }
 
-            handleFrames(trackIndex, numFrames);
+            if (canProcessEffects) {
+                trackInfo.effects->inserts.process(mixingBuffer, numFrames);
+            }
 
             // Optimized mixing loop with level scaling
             const float level = trackInfo.level;
+            mMetering.meterTrack(trackIndex, mixingBuffer, totalSamples, level);
             if (level == 1.0f) {
                 // Fast path for unity gain
                 for (size_t j = 0; j < totalSamples; ++j) {
@@ -74,13 +197,54 @@ public:
                     audioData[j] += mixingBuffer[j] * level;
                 }
             }
+
+            if (canProcessEffects) {
+                sendToAuxBuses(trackInfo, totalSamples, isBusActive);
+            }
+        }
+
+        if (canProcessEffects) {
+            for (uint8_t bus = 0; bus < kMaxAuxBuses; bus++) {
+                auto& auxBus = mAuxBuses[bus];
+
+                // A bus with effects keeps running so that reverb and delay tails ring out
+                if (!isBusActive[bus]) {
+                    if (auxBus.effects.isEmpty()) continue;
+                    memset(auxBus.buffer, 0, sizeof(float) * totalSamples);
+                }
+
+                auxBus.effects.process(auxBus.buffer, numFrames);
+
+                const float returnLevel = auxBus.returnLevel.load(std::memory_order_relaxed);
+                for (size_t j = 0; j < totalSamples; ++j) {
+                    audioData[j] += auxBus.buffer[j] * returnLevel;
+                }
+            }
+
+            mMasterEffects.process(audioData, numFrames);
+            mMasterLimiter.process(audioData, numFrames);
+        }
+
+        mMetering.meterOutput(audioData, numFrames, mChannelCount);
+        mMetering.endBlock();
+
+        if (isPlaying) {
+            advancePosition(startFrame, numFrames, hostTimeUs);
         }
+
+        mRenderedBlockCount.fetch_add(1, std::memory_order_release);
+        mIsRendering.store(false, std::memory_order_release);
     }
 
     void handleRenderAudioRange(track_index_t trackIndex, uint32_t offsetFrame, uint32_t numFramesToRender) {
         if (numFramesToRender == 0) return;
 
-        auto offsetMixingBuffer = mixingBuffer + offsetFrame * mChannelCount;
+        if (auto target = tRenderAheadTarget) {
+            target->instrument->renderAudio(target->audioData + offsetFrame * 2, numFramesToRender);
+            return;
+        }
+
+        auto offsetMixingBuffer = mixingBuffer + (mMixingOffsetFrames + offsetFrame) * mChannelCount;
 
         auto maybeTrackInfo = getTrackInfo(trackIndex);
         if (maybeTrackInfo.has_value()) {
@@ -91,6 +255,11 @@ public:
     }
 
     void handleEvent(track_index_t trackIndex, SchedulerEvent event, position_frame_t offsetFrame) {
+        if (auto target = tRenderAheadTarget) {
+            handleEventAhead(*target, event, offsetFrame);
+            return;
+        }
+
         if (event.type == VOLUME_EVENT) {
             auto volumeEvent = VolumeEventData(event.data);
 
@@ -111,15 +280,53 @@ public:
             } else {
                 LOGE("❌ MIXER ERROR: Track %d doesn't exist!", trackIndex);
             }
+        } else if (event.type == EFFECT_PARAM_EVENT) {
+            auto paramEvent = EffectParamEventData(event.data);
+            auto chain = getEffectChain(trackIndex, paramEvent.chain);
+
+            if (chain != nullptr) {
+                chain->setParameter(paramEvent.slot, paramEvent.parameter, paramEvent.value);
+            }
+        } else if (event.type == SEND_LEVEL_EVENT) {
+            auto sendEvent = SendLevelEventData(event.data);
+            auto maybeTrackInfo = getTrackInfo(trackIndex);
+
+            if (maybeTrackInfo.has_value() && sendEvent.bus < kMaxAuxBuses) {
+                maybeTrackInfo.value().effects->sendLevels[sendEvent.bus].store(sendEvent.level, std::memory_order_relaxed);
+            }
+        } else if (event.type == SEEK_EVENT) {
+            auto track = getTrack(trackIndex);
+
+            if (track.has_value()) {
+                track.value()->seekToFrame(SeekEventData(event.data).frame);
+            }
         }
     }
 
     track_index_t addTrack(IInstrument *track) {
         auto trackIndex = BaseScheduler::addTrack();
 
+        auto effects = std::make_shared<TrackEffects>();
+
         TrackInfo trackInfo;
         trackInfo.track = track;
         trackInfo.level = 1.0;
+        trackInfo.effects = effects.get();
+
+        {
+            std::lock_guard<std::mutex> lock(mEffectsMutex);
+            mTrackEffects.insert({ trackIndex, effects });
+
+            if (trackIndex >= 0 && trackIndex < kMaxTracks) {
+                auto renderAhead = std::make_shared<RenderAheadTrack>();
+                renderAhead->trackIndex = trackIndex;
+                renderAhead->instrument = track;
+                renderAhead->events = mBufferMap[trackIndex];
+
+                mRenderAheadTracks.insert({ trackIndex, renderAhead });
+                mRenderAhead[trackIndex].store(renderAhead.get());
+            }
+        }
 
         mTrackMap.insert({ trackIndex, trackInfo });
 
@@ -128,6 +335,142 @@ public:
 
     void onRemoveTrack(track_index_t trackIndex) {
         mTrackMap.erase(trackIndex);
+
+        {
+            std::lock_guard<std::mutex> lock(mEffectsMutex);
+            auto search = mTrackEffects.find(trackIndex);
+
+            if (search != mTrackEffects.end()) {
+                for (int32_t slot = 0; slot < kMaxEffectsPerChain; slot++) {
+                    retire(std::unique_ptr<IEffect>(search->second->inserts.remove(slot)));
+                }
+
+                retire(search->second);
+                mTrackEffects.erase(search);
+            }
+
+            auto renderAheadSearch = mRenderAheadTracks.find(trackIndex);
+
+            if (renderAheadSearch != mRenderAheadTracks.end()) {
+                mRenderAhead[trackIndex].store(nullptr);
+                waitForRenderAheadWorkers();
+
+                retire(renderAheadSearch->second);
+                mRenderAheadTracks.erase(renderAheadSearch);
+            }
+        }
+    }
+
+    // Live input has to be heard now, so the track stops rendering ahead for a while
+    void handleEventsNow(track_index_t trackIndex, const SchedulerEvent* events, uint32_t eventsCount) {
+        requestFallBack(trackIndex, kNoFallBack, true);
+
+        BaseScheduler::handleEventsNow(trackIndex, events, eventsCount);
+    }
+
+    void onClearEvents(track_index_t trackIndex, position_frame_t fromFrame) {
+        requestFallBack(trackIndex, fromFrame, false);
+    }
+
+    // Swaps the instrument that renders a track and returns the previous one, or nullptr if there
+    // is no such track. Once this returns, neither the audio thread nor the render-ahead workers
+    // use the previous instrument, so the caller may render or delete it.
+    IInstrument* replaceTrackInstrument(track_index_t trackIndex, IInstrument* instrument) {
+        auto search = mTrackMap.find(trackIndex);
+        if (search == mTrackMap.end()) return nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(mEffectsMutex);
+            auto renderAheadSearch = mRenderAheadTracks.find(trackIndex);
+
+            if (renderAheadSearch != mRenderAheadTracks.end()) {
+                auto& renderAhead = *renderAheadSearch->second;
+
+                {
+                    std::lock_guard<SpinLock> renderLock(renderAhead.renderLock);
+                    renderAhead.instrument = instrument;
+                    renderAhead.loadStage = -1;
+                }
+
+                // Whatever the previous instrument rendered ahead is dropped
+                requestFallBackLocked(renderAhead, 0);
+            }
+        }
+
+        auto previous = search->second.track.exchange(instrument, std::memory_order_acq_rel);
+
+        waitForAudioThread();
+        return previous;
+    }
+
+    // Waits until the audio thread has finished the block it is rendering, if any
+    void waitForAudioThread() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!mIsRendering.load()) return;
+
+        const auto renderedBlockCount = mRenderedBlockCount.load();
+        while (mIsRendering.load() && mRenderedBlockCount.load() == renderedBlockCount) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Starts or stops the render-ahead workers. Once started, tracks switch over one per block.
+    void setRenderAheadEnabled(bool isEnabled) {
+        std::lock_guard<std::mutex> lock(mEffectsMutex);
+        if (isEnabled == !mRenderAheadWorkers.empty()) return;
+
+        mIsRenderAheadEnabled.store(isEnabled);
+
+        if (isEnabled) {
+            mIsStoppingWorkers.store(false);
+
+            for (int32_t i = 0; i < getRenderAheadWorkerCount(); i++) {
+                mRenderAheadWorkers.emplace_back(&Mixer::renderAheadWorkerFunc, this, i);
+            }
+        } else {
+            // Tracks play out what was rendered for them, then go back to rendering just in time
+            for (auto& pair : mRenderAheadTracks) {
+                requestFallBackLocked(*pair.second, kNoFallBack);
+            }
+
+            mIsStoppingWorkers.store(true);
+
+            for (auto& worker : mRenderAheadWorkers) {
+                worker.join();
+            }
+            mRenderAheadWorkers.clear();
+        }
+    }
+
+    // Adds an effect to a track's inserts, an aux bus or the master chain. chain is one of
+    // TRACK_INSERT_CHAIN, MASTER_CHAIN or 1 + bus index. Returns the slot, or -1 on failure.
+    int32_t addEffect(track_index_t trackIndex, uint8_t chain, std::unique_ptr<IEffect> effect) {
+        std::lock_guard<std::mutex> lock(mEffectsMutex);
+        collectRetired();
+
+        auto effectChain = getEffectChainLocked(trackIndex, chain);
+        if (effectChain == nullptr || effect == nullptr) return -1;
+
+        auto slot = effectChain->add(effect.get());
+        if (slot != -1) effect.release();
+
+        return slot;
+    }
+
+    void removeEffect(track_index_t trackIndex, uint8_t chain, int32_t slot) {
+        std::lock_guard<std::mutex> lock(mEffectsMutex);
+        collectRetired();
+
+        auto effectChain = getEffectChainLocked(trackIndex, chain);
+        if (effectChain == nullptr) return;
+
+        retire(std::unique_ptr<IEffect>(effectChain->remove(slot)));
+    }
+
+    void setBusReturnLevel(uint8_t bus, float level) {
+        if (bus < kMaxAuxBuses) {
+            mAuxBuses[bus].returnLevel.store(level, std::memory_order_relaxed);
+        }
     }
 
     std::optional<IInstrument*> getTrack(track_index_t trackIndex) {
@@ -141,6 +484,8 @@ public:
     }
 
     void onResetTrack(track_index_t trackIndex) {
+        requestFallBack(trackIndex, 0, false);
+
         auto search = mTrackMap.find(trackIndex);
 
         if (search != mTrackMap.end()) {
@@ -152,12 +497,11 @@ public:
     }
 
     void setLevel(track_index_t trackIndex, float level) {
-        auto maybeTrackInfo = getTrackInfo(trackIndex);
+        auto search = mTrackMap.find(trackIndex);
 
-        if (maybeTrackInfo.has_value()) {
-            TrackInfo nextTrackInfo = maybeTrackInfo.value();
-            nextTrackInfo.level = level;
-            mTrackMap.insert_or_assign(trackIndex, nextTrackInfo);
+        if (search != mTrackMap.end()) {
+            // Only the level changes, so an instrument swapped in meanwhile isn't written back
+            search->second.level = level;
             
             LOGI("Mixer: Set track %d level to %.3f", trackIndex, level);
         } else {
@@ -177,10 +521,377 @@ public:
         }
     }
 
+    // Must not be called while rendering
+    void setSampleRate(int32_t sampleRate) {
+        BaseScheduler::setSampleRate(sampleRate);
+        mSampleRate = sampleRate;
+        mMasterLimiter.setSampleRate(sampleRate);
+        mMetering.setSampleRate(sampleRate);
+    }
+
     int32_t getChannelCount() { return mChannelCount; }
     void setChannelCount(int32_t channelCount) { mChannelCount = channelCount; }
 
+    // Instruments pick the stage up the next time they are rendered
+    void setLoadStage(LoadStage stage) { mLoadStage.store(stage, std::memory_order_relaxed); }
+
+    void setMeteringEnabled(bool isEnabled) { mMetering.setEnabled(isEnabled); }
+    void setSpectrumEnabled(bool isEnabled) { mMetering.setSpectrumEnabled(isEnabled); }
+    const MeterReadout* getMeterReadout() const { return mMetering.getReadout(); }
+
 private:
+    // Called holding the track's renderLock, just before its instrument renders
+    void applyLoadStage(RenderAheadTrack& renderAhead) {
+        const int32_t stage = mLoadStage.load(std::memory_order_relaxed);
+        if (renderAhead.loadStage == stage) return;
+
+        renderAhead.instrument->setLoadStage(static_cast<LoadStage>(stage));
+        renderAhead.loadStage = stage;
+    }
+
+    // The position doesn't move while paused, so live events are handled at once. A worker may
+    // still be finishing a chunk, in which case they wait for the next block.
+    void handleLiveEventsWhilePaused(track_index_t trackIndex, RenderAheadTrack* renderAhead) {
+        if (renderAhead == nullptr) {
+            handleLiveEvents(trackIndex);
+            return;
+        }
+
+        std::unique_lock<SpinLock> renderLock(renderAhead->renderLock, std::try_to_lock);
+        if (renderLock.owns_lock()) handleLiveEvents(trackIndex);
+    }
+
+    // Fills mixingBuffer with the track's next block, using what was rendered ahead where possible
+    void renderTrackBlock(track_index_t trackIndex, RenderAheadTrack* renderAhead, position_frame_t startFrame,
+                          uint32_t numFrames, bool canHandleEvents, bool& canStartRenderingAhead) {
+        uint32_t framesRenderedAhead = 0;
+        std::shared_ptr<Buffer<>> buffer;
+
+        if (renderAhead != nullptr) {
+            if (renderAhead->hadLiveInput.load(std::memory_order_relaxed)) {
+                renderAhead->hadLiveInput.store(false, std::memory_order_relaxed);
+                renderAhead->liveUntilFrame = startFrame + mSampleRate * kLiveInputHoldoffSeconds;
+            }
+
+            framesRenderedAhead = readRenderedAhead(*renderAhead, startFrame, numFrames);
+            buffer = renderAhead->events;
+        } else {
+            auto search = mBufferMap.find(trackIndex);
+            if (search != mBufferMap.end()) buffer = search->second;
+        }
+
+        if (framesRenderedAhead < numFrames && buffer != nullptr) {
+            if (renderAhead != nullptr && renderAhead->renderLock.try_lock()) {
+                applyLoadStage(*renderAhead);
+                renderAhead->renderLock.unlock();
+            }
+
+            mMixingOffsetFrames = framesRenderedAhead;
+            renderTrack(trackIndex, *buffer, startFrame + framesRenderedAhead, numFrames - framesRenderedAhead, canHandleEvents,
+                        getLiveEventQueue(trackIndex));
+            mMixingOffsetFrames = 0;
+        }
+
+        if (canStartRenderingAhead && renderAhead != nullptr
+            && renderAhead->mode.load(std::memory_order_relaxed) == RENDER_JUST_IN_TIME
+            && startFrame >= renderAhead->liveUntilFrame) {
+            canStartRenderingAhead = !startRenderingAhead(*renderAhead, startFrame + numFrames);
+        }
+    }
+
+    // Copies as much of the block as was rendered ahead to mixingBuffer and returns the number of
+    // frames copied. This is also where the track falls back to rendering just in time.
+    uint32_t readRenderedAhead(RenderAheadTrack& renderAhead, position_frame_t startFrame, uint32_t numFrames) {
+        const auto mode = renderAhead.mode.load(std::memory_order_acquire);
+        if (mode == RENDER_JUST_IN_TIME) return 0;
+
+        // A block that went out partly silent has been played, so its frames are dropped as they arrive
+        if (renderAhead.nextReadFrame < renderAhead.skipUntilFrame) {
+            const uint32_t framesToSkip = std::min(renderAhead.skipUntilFrame - renderAhead.nextReadFrame,
+                                                   renderAhead.fifo.availableToRead());
+            renderAhead.fifo.skip(framesToSkip);
+            renderAhead.nextReadFrame += framesToSkip;
+        }
+
+        // Anything rendered for another position is no use
+        const bool isAligned = renderAhead.nextReadFrame == startFrame;
+        const uint32_t available = isAligned ? renderAhead.fifo.availableToRead() : 0;
+
+        if (mode == RENDER_AHEAD) {
+            const bool mustFallBack = available < numFrames
+                || renderAhead.fallBackFromFrame.load(std::memory_order_acquire) != kNoFallBack;
+
+            if (!mustFallBack) {
+                return readFifo(renderAhead, numFrames);
+            }
+
+            if (!renderAhead.renderLock.try_lock()) {
+                // A worker is rendering a chunk, so the instrument can't be rendered here. What is
+                // missing goes out silent, and is skipped once rendered so the next block stays aligned.
+                if (available >= numFrames) return readFifo(renderAhead, numFrames);
+
+                readFifo(renderAhead, available);
+                memset(mixingBuffer + available * 2, 0, sizeof(float) * (numFrames - available) * 2);
+                if (isAligned) renderAhead.skipUntilFrame = startFrame + numFrames;
+                return numFrames;
+            }
+
+            fallBack(renderAhead, startFrame, available);
+            renderAhead.renderLock.unlock();
+        } else if (!isAligned) {
+            renderAhead.fifo.truncate(0);
+            renderAhead.nextReadFrame = startFrame;
+            renderAhead.skipUntilFrame = startFrame;
+        }
+
+        const auto framesRead = readFifo(renderAhead, std::min(renderAhead.fifo.availableToRead(), numFrames));
+
+        if (renderAhead.fifo.availableToRead() == 0) {
+            renderAhead.mode.store(RENDER_JUST_IN_TIME, std::memory_order_release);
+        }
+
+        return framesRead;
+    }
+
+    uint32_t readFifo(RenderAheadTrack& renderAhead, uint32_t numFrames) {
+        renderAhead.fifo.read(mixingBuffer, numFrames);
+        renderAhead.nextReadFrame += numFrames;
+        return numFrames;
+    }
+
+    // Called by the audio thread, holding renderLock. Keeps the frames that are still valid and
+    // leaves the track draining them.
+    void fallBack(RenderAheadTrack& renderAhead, position_frame_t startFrame, uint32_t available) {
+        const auto fromFrame = renderAhead.fallBackFromFrame.exchange(kNoFallBack, std::memory_order_relaxed);
+
+        uint32_t framesToKeep = available;
+        if (fromFrame != kNoFallBack) {
+            framesToKeep = fromFrame > startFrame ? std::min(fromFrame - startFrame, available) : 0;
+        }
+
+        renderAhead.fifo.truncate(framesToKeep);
+        // Events in the dropped frames are scheduled again by whoever cleared them
+        renderAhead.deferredEvents.clearAfter(startFrame + framesToKeep);
+        renderAhead.nextReadFrame = startFrame;
+        renderAhead.skipUntilFrame = startFrame;
+        renderAhead.mode.store(RENDER_DRAINING, std::memory_order_release);
+    }
+
+    // Called by the audio thread, only in blocks where it holds mBatchLock. Renders the start of the
+    // next blocks itself, so the workers have time to catch up, then hands the track over to them.
+    bool startRenderingAhead(RenderAheadTrack& renderAhead, position_frame_t nextFrame) {
+        std::unique_lock<SpinLock> renderLock(renderAhead.renderLock, std::try_to_lock);
+        if (!renderLock.owns_lock()) return false;
+
+        applyLoadStage(renderAhead);
+
+        RenderAheadTarget target = { mPrimeBuffer, renderAhead.instrument, &renderAhead.deferredEvents, nextFrame };
+        tRenderAheadTarget = &target;
+        renderTrack(renderAhead.trackIndex, *renderAhead.events, nextFrame, kRenderAheadPrimeFrames, true);
+        tRenderAheadTarget = nullptr;
+
+        renderAhead.fifo.truncate(0);
+        renderAhead.fifo.write(mPrimeBuffer, kRenderAheadPrimeFrames);
+        renderAhead.nextReadFrame = nextFrame;
+        renderAhead.skipUntilFrame = nextFrame;
+        renderAhead.renderedUntilFrame = nextFrame + kRenderAheadPrimeFrames;
+        renderAhead.fallBackFromFrame.store(kNoFallBack, std::memory_order_relaxed);
+        renderAhead.mode.store(RENDER_AHEAD, std::memory_order_release);
+
+        return true;
+    }
+
+    // Handles the mixer events a worker came across, once the block they are due in starts
+    void handleDueEvents(RenderAheadTrack& renderAhead, position_frame_t untilFrame) {
+        SchedulerEvent event;
+
+        while (renderAhead.deferredEvents.peek(event) && event.frame < untilFrame) {
+            handleEvent(renderAhead.trackIndex, event, 0);
+            renderAhead.deferredEvents.removeTop();
+        }
+    }
+
+    // Instruments get their MIDI and seeks as they are rendered ahead, but mixer events wait until they are due
+    static void handleEventAhead(RenderAheadTarget& target, SchedulerEvent event, position_frame_t offsetFrame) {
+        if (event.type == MIDI_EVENT) {
+            auto midiEvent = MidiEventData(event.data);
+            target.instrument->handleMidiEvent(midiEvent.midiStatus, midiEvent.midiData1, midiEvent.midiData2);
+        } else if (event.type == SEEK_EVENT) {
+            target.instrument->seekToFrame(SeekEventData(event.data).frame);
+        } else {
+            event.frame = target.startFrame + offsetFrame;
+            target.deferredEvents->add(&event, 1);
+        }
+    }
+
+    void renderAheadWorkerFunc(int32_t workerIndex) {
+        // Same as Android's THREAD_PRIORITY_AUDIO. Without it, the workers fall behind under load.
+        setpriority(PRIO_PROCESS, 0, -16);
+
+        float chunk[kRenderAheadChunkFrames * 2];
+        auto& passes = mWorkerPasses[workerIndex];
+
+        while (!mIsStoppingWorkers.load()) {
+            // The count is odd while the worker may be looking at a track
+            passes.fetch_add(1);
+
+            bool didRender = false;
+            for (auto& slot : mRenderAhead) {
+                auto renderAhead = slot.load();
+                if (renderAhead != nullptr && renderAheadChunk(*renderAhead, chunk)) {
+                    didRender = true;
+                }
+            }
+
+            passes.fetch_add(1);
+
+            if (!didRender) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    bool renderAheadChunk(RenderAheadTrack& renderAhead, float* chunk) {
+        if (renderAhead.mode.load(std::memory_order_acquire) != RENDER_AHEAD
+            || renderAhead.fifo.availableToWrite() < kRenderAheadChunkFrames) {
+            return false;
+        }
+
+        // Like the audio thread, a worker leaves the events alone while a batch is being applied, so
+        // it never renders half of one. The chunk is tried again on the next pass.
+        std::shared_lock<SharedSpinLock> batchLock(mBatchLock, std::try_to_lock);
+        if (!batchLock.owns_lock()) return false;
+
+        std::unique_lock<SpinLock> renderLock(renderAhead.renderLock, std::try_to_lock);
+        if (!renderLock.owns_lock()) return false;
+
+        // The audio thread may have taken the track back in the meantime
+        if (renderAhead.mode.load(std::memory_order_relaxed) != RENDER_AHEAD
+            || renderAhead.fallBackFromFrame.load(std::memory_order_relaxed) != kNoFallBack) {
+            return false;
+        }
+
+        applyLoadStage(renderAhead);
+
+        RenderAheadTarget target = { chunk, renderAhead.instrument, &renderAhead.deferredEvents, renderAhead.renderedUntilFrame };
+        tRenderAheadTarget = &target;
+        renderTrack(renderAhead.trackIndex, *renderAhead.events, renderAhead.renderedUntilFrame, kRenderAheadChunkFrames, true);
+        tRenderAheadTarget = nullptr;
+
+        renderAhead.fifo.write(chunk, kRenderAheadChunkFrames);
+        renderAhead.renderedUntilFrame += kRenderAheadChunkFrames;
+
+        return true;
+    }
+
+    void requestFallBack(track_index_t trackIndex, position_frame_t fromFrame, bool isLiveInput) {
+        std::lock_guard<std::mutex> lock(mEffectsMutex);
+
+        auto search = mRenderAheadTracks.find(trackIndex);
+        if (search == mRenderAheadTracks.end()) return;
+
+        if (isLiveInput) {
+            search->second->hadLiveInput.store(true, std::memory_order_relaxed);
+        }
+
+        requestFallBackLocked(*search->second, fromFrame);
+    }
+
+    // Asks the audio thread to stop rendering the track ahead, dropping what was rendered from
+    // fromFrame on. With kNoFallBack everything rendered so far is kept. Once this returns, the
+    // workers leave the track alone.
+    void requestFallBackLocked(RenderAheadTrack& renderAhead, position_frame_t fromFrame) {
+        std::lock_guard<SpinLock> renderLock(renderAhead.renderLock);
+        if (renderAhead.mode.load(std::memory_order_relaxed) != RENDER_AHEAD) return;
+
+        // Events that haven't been rendered yet can change without affecting anything
+        if (fromFrame != kNoFallBack && fromFrame >= renderAhead.renderedUntilFrame) return;
+
+        const auto pendingFrame = renderAhead.fallBackFromFrame.load(std::memory_order_relaxed);
+        renderAhead.fallBackFromFrame.store(std::min({ fromFrame, renderAhead.renderedUntilFrame, pendingFrame }),
+                                            std::memory_order_release);
+    }
+
+    // Waits until no worker can still be looking at a track that was just unpublished
+    void waitForRenderAheadWorkers() {
+        for (size_t i = 0; i < mRenderAheadWorkers.size(); i++) {
+            const auto passes = mWorkerPasses[i].load();
+            if (passes % 2 == 0) continue;
+
+            while (mWorkerPasses[i].load() == passes) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    RenderAheadTrack* getRenderAheadTrack(track_index_t trackIndex) {
+        if (trackIndex < 0 || trackIndex >= kMaxTracks) return nullptr;
+
+        return mRenderAhead[trackIndex].load(std::memory_order_acquire);
+    }
+
+    static int32_t getRenderAheadWorkerCount() {
+        // Leave a core for the audio thread
+        const int32_t cores = static_cast<int32_t>(std::thread::hardware_concurrency());
+        return std::clamp(cores - 1, 1, kMaxRenderAheadWorkers);
+    }
+
+    void sendToAuxBuses(const TrackInfo& trackInfo, size_t totalSamples, std::array<bool, kMaxAuxBuses>& isBusActive) {
+        for (uint8_t bus = 0; bus < kMaxAuxBuses; bus++) {
+            const float send = trackInfo.effects->sendLevels[bus].load(std::memory_order_relaxed) * trackInfo.level;
+            if (send <= 0.0f) continue;
+
+            auto& auxBus = mAuxBuses[bus];
+            if (!isBusActive[bus]) {
+                memset(auxBus.buffer, 0, sizeof(float) * totalSamples);
+                isBusActive[bus] = true;
+            }
+
+            for (size_t j = 0; j < totalSamples; ++j) {
+                auxBus.buffer[j] += mixingBuffer[j] * send;
+            }
+        }
+    }
+
+    // Called from the audio thread, so it only looks at the track map
+    EffectChain* getEffectChain(track_index_t trackIndex, uint8_t chain) {
+        if (chain == MASTER_CHAIN) return &mMasterEffects;
+        if (chain != TRACK_INSERT_CHAIN) return chain <= kMaxAuxBuses ? &mAuxBuses[chain - 1].effects : nullptr;
+
+        auto maybeTrackInfo = getTrackInfo(trackIndex);
+        return maybeTrackInfo.has_value() ? &maybeTrackInfo.value().effects->inserts : nullptr;
+    }
+
+    EffectChain* getEffectChainLocked(track_index_t trackIndex, uint8_t chain) {
+        if (chain == MASTER_CHAIN) return &mMasterEffects;
+        if (chain != TRACK_INSERT_CHAIN) return chain <= kMaxAuxBuses ? &mAuxBuses[chain - 1].effects : nullptr;
+
+        auto search = mTrackEffects.find(trackIndex);
+        return search != mTrackEffects.end() ? &search->second->inserts : nullptr;
+    }
+
+    static void deleteEffects(EffectChain& chain) {
+        for (int32_t slot = 0; slot < kMaxEffectsPerChain; slot++) {
+            delete chain.remove(slot);
+        }
+    }
+
+    // The audio thread may still be using a removed effect in the block it is rendering, so
+    // removed effects are only deleted once a later block has finished.
+    void retire(std::shared_ptr<void> removed) {
+        if (removed == nullptr) return;
+
+        mRetired.push_back({ mRenderedBlockCount.load(std::memory_order_acquire) + 1, std::move(removed) });
+    }
+
+    void collectRetired() {
+        const auto renderedBlockCount = mRenderedBlockCount.load(std::memory_order_acquire);
+
+        mRetired.erase(std::remove_if(mRetired.begin(), mRetired.end(), [=](const auto& retired) {
+            return renderedBlockCount > retired.first;
+        }), mRetired.end());
+    }
+
     std::optional<TrackInfo> getTrackInfo(track_index_t trackIndex) {
         auto search = mTrackMap.find(trackIndex);
 
@@ -192,8 +903,34 @@ private:
     }
 
     float mixingBuffer[kBufferSize];
+    // Where in mixingBuffer a block that was partly rendered ahead continues
+    uint32_t mMixingOffsetFrames = 0;
     std::unordered_map<track_index_t, TrackInfo> mTrackMap = {};
     int32_t mChannelCount = 1; // Default to mono
+    int32_t mSampleRate = 44100;
+
+    std::array<AuxBus, kMaxAuxBuses> mAuxBuses;
+    EffectChain mMasterEffects;
+    LimiterEffect mMasterLimiter;
+    Metering mMetering;
+
+    // Owns the per-track effects and render-ahead state. Only touched off the audio thread.
+    std::mutex mEffectsMutex;
+    std::unordered_map<track_index_t, std::shared_ptr<TrackEffects>> mTrackEffects = {};
+    std::unordered_map<track_index_t, std::shared_ptr<RenderAheadTrack>> mRenderAheadTracks = {};
+    std::vector<std::pair<uint64_t, std::shared_ptr<void>>> mRetired;
+    std::atomic<uint64_t> mRenderedBlockCount = { 0 };
+    std::atomic<bool> mIsRendering = { false };
+    std::atomic<int32_t> mLoadStage = { LOAD_STAGE_NORMAL };
+
+    // Render-ahead. The workers are only started and stopped while holding mEffectsMutex.
+    static inline thread_local RenderAheadTarget* tRenderAheadTarget = nullptr;
+    std::array<std::atomic<RenderAheadTrack*>, kMaxTracks> mRenderAhead = {};
+    std::vector<std::thread> mRenderAheadWorkers;
+    std::array<std::atomic<uint64_t>, kMaxRenderAheadWorkers> mWorkerPasses = {};
+    std::atomic<bool> mIsRenderAheadEnabled = { false };
+    std::atomic<bool> mIsStoppingWorkers = { false };
+    float mPrimeBuffer[kRenderAheadPrimeFrames * 2];
 };
 
 #endif //MIXER_H
@@ -0,0 +1,133 @@
+/*
+ * State for rendering a track ahead of the audio callback on a worker thread.
+ * This is used on Android only
+ */
+
+#ifndef RENDER_AHEAD_H
+#define RENDER_AHEAD_H
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include "BaseScheduler.h"
+#include "IInstrument.h"
+
+constexpr uint32_t kRenderAheadFrames = 1024; // ~23 ms at 44.1 kHz, must be a power of two
+constexpr uint32_t kRenderAheadChunkFrames = 128;
+// Rendered by the audio thread when a track switches to render-ahead, so the worker has time to start
+constexpr uint32_t kRenderAheadPrimeFrames = kRenderAheadChunkFrames * 2;
+constexpr position_frame_t kNoFallBack = std::numeric_limits<position_frame_t>::max();
+
+/**
+ * A single-producer, single-consumer FIFO of interleaved stereo frames.
+ */
+template <uint32_t kCapacityFrames>
+class AudioFifo {
+public:
+    uint32_t availableToRead() const {
+        return mWriteFrame.load(std::memory_order_acquire) - mReadFrame.load(std::memory_order_relaxed);
+    }
+
+    uint32_t availableToWrite() const {
+        return kCapacityFrames - (mWriteFrame.load(std::memory_order_relaxed) - mReadFrame.load(std::memory_order_acquire));
+    }
+
+    // The caller must have checked availableToWrite()
+    void write(const float* audioData, uint32_t numFrames) {
+        const uint32_t writeFrame = mWriteFrame.load(std::memory_order_relaxed);
+        const uint32_t first = mask(writeFrame);
+        const uint32_t firstRun = std::min(numFrames, kCapacityFrames - first);
+
+        std::copy(audioData, audioData + firstRun * 2, mData + first * 2);
+        std::copy(audioData + firstRun * 2, audioData + numFrames * 2, mData);
+
+        mWriteFrame.store(writeFrame + numFrames, std::memory_order_release);
+    }
+
+    // The caller must have checked availableToRead()
+    void read(float* audioData, uint32_t numFrames) {
+        const uint32_t readFrame = mReadFrame.load(std::memory_order_relaxed);
+        const uint32_t first = mask(readFrame);
+        const uint32_t firstRun = std::min(numFrames, kCapacityFrames - first);
+
+        std::copy(mData + first * 2, mData + (first + firstRun) * 2, audioData);
+        std::copy(mData, mData + (numFrames - firstRun) * 2, audioData + firstRun * 2);
+
+        mReadFrame.store(readFrame + numFrames, std::memory_order_release);
+    }
+
+    // Like read(), but the frames are dropped. The caller must have checked availableToRead()
+    void skip(uint32_t numFrames) {
+        mReadFrame.store(mReadFrame.load(std::memory_order_relaxed) + numFrames, std::memory_order_release);
+    }
+
+    // Drops all but the first numFrames. Only safe while nothing is being written.
+    void truncate(uint32_t numFrames) {
+        const uint32_t readFrame = mReadFrame.load(std::memory_order_relaxed);
+        mWriteFrame.store(readFrame + std::min(numFrames, availableToRead()), std::memory_order_release);
+    }
+
+private:
+    static uint32_t mask(uint32_t frame) {
+        return frame & (kCapacityFrames - 1);
+    }
+
+    static_assert((kCapacityFrames & (kCapacityFrames - 1)) == 0, "kCapacityFrames must be a power of two");
+
+    std::atomic<uint32_t> mReadFrame { 0 };
+    std::atomic<uint32_t> mWriteFrame { 0 };
+    float mData[kCapacityFrames * 2];
+};
+
+enum RenderAheadMode {
+    // The audio thread renders the track in its callback
+    RENDER_JUST_IN_TIME = 0,
+    // A worker renders the track into the FIFO and the audio thread reads it
+    RENDER_AHEAD = 1,
+    // The audio thread reads what is left in the FIFO, then goes back to rendering just in time
+    RENDER_DRAINING = 2,
+};
+
+/**
+ * In RENDER_AHEAD, the worker owns the instrument and the track's event buffer while it holds
+ * renderLock. In the other modes the audio thread owns them. The audio thread only ever uses
+ * try_lock(), and other threads only hold the lock for as long as it takes to render one chunk.
+ */
+struct RenderAheadTrack {
+    track_index_t trackIndex;
+    IInstrument* instrument;
+    std::shared_ptr<Buffer<>> events;
+
+    SpinLock renderLock;
+    // Only changed to or from RENDER_AHEAD while holding renderLock
+    std::atomic<int32_t> mode { RENDER_JUST_IN_TIME };
+    // If set, the audio thread stops rendering ahead, dropping the rendered frames from this frame on
+    std::atomic<position_frame_t> fallBackFromFrame { kNoFallBack };
+    std::atomic<bool> hadLiveInput { false };
+
+    // The frame the worker renders next. Guarded by renderLock.
+    position_frame_t renderedUntilFrame = 0;
+    // The frame at the start of the FIFO. Audio thread only.
+    position_frame_t nextReadFrame = 0;
+    // Frames before this one went out silent, so they are dropped from the FIFO. Audio thread only.
+    position_frame_t skipUntilFrame = 0;
+    // Live input keeps the track rendering just in time until this frame. Audio thread only.
+    position_frame_t liveUntilFrame = 0;
+    // The LoadStage the instrument was last set to, or -1 if it hasn't been yet. Guarded by renderLock.
+    int32_t loadStage = -1;
+
+    AudioFifo<kRenderAheadFrames> fifo;
+    // Mixer events the worker came across, which the audio thread handles once they are due
+    Buffer<> deferredEvents;
+};
+
+// Where a track that is rendered ahead of the position goes, instead of the mixing buffer
+struct RenderAheadTarget {
+    float* audioData;
+    IInstrument* instrument;
+    Buffer<>* deferredEvents;
+    position_frame_t startFrame;
+};
+
+#endif //RENDER_AHEAD_H
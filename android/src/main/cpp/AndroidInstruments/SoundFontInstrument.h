@@ -111,33 +111,15 @@ public:
             return;
         }
         
+        if (mLoadStage >= LOAD_STAGE_SHED_VOICES) {
+            tsf_shed_voices(mTsf, kShedVoices);
+        }
+
         // TinySoundFont requires 4 parameters: f, buffer, samples, flag_mixing
         // Use 0 for replace mode - the Mixer handles combining tracks
         tsf_render_float(mTsf, audioData, numFrames, 0);
-        
-        // Check for audio activity (very infrequent logging for performance)
-        const int32_t totalSamples = numFrames * (mIsStereo ? 2 : 1);
-        float maxSample = 0.0f;
-        for (int32_t i = 0; i < totalSamples; ++i) {
-            maxSample = std::max(maxSample, std::abs(audioData[i]));
-        }
-        
-        // Log audio activity much less frequently (only every 2000 frames with audio)
-        static int frameCounter = 0;
-        if (++frameCounter % 2000 == 0 && maxSample > 0.001f) {
-            LOGI("TSF: Audio rendered - max sample level: %.4f", maxSample);
-        }
-        
-        // Apply soft limiting to prevent clipping distortion
-        constexpr float maxLevel = 0.95f;  // Leave headroom
-        for (int32_t i = 0; i < totalSamples; ++i) {
-            float sample = audioData[i];
-            if (sample > maxLevel) {
-                audioData[i] = maxLevel;
-            } else if (sample < -maxLevel) {
-                audioData[i] = -maxLevel;
-            }
-        }
+
+        // No clipping here: the mixer limits the summed output on the master bus
     }
 
     void handleMidiEvent(uint8_t status, uint8_t data1, uint8_t data2) override {
@@ -158,6 +140,10 @@ public:
                 
                 // Minimal logging for performance - only log errors
                 tsf_note_on(mTsf, channel, data1, velocity);
+
+                if (mLoadStage >= LOAD_STAGE_CAPPED_POLYPHONY) {
+                    tsf_shed_voices(mTsf, mLoadStage >= LOAD_STAGE_SHED_VOICES ? kShedVoices : kCappedVoices);
+                }
                 
                 // Only log failures to prevent performance issues
                 static int errorLogCount = 0;
@@ -187,8 +173,22 @@ public:
     void reset() override {
     }
 
+    void setLoadStage(LoadStage stage) override {
+        mLoadStage = stage;
+
+        if (mTsf != nullptr) {
+            tsf_set_interpolation(mTsf, stage >= LOAD_STAGE_NEAREST_INTERPOLATION
+                                        ? TSF_INTERPOLATION_NEAREST : TSF_INTERPOLATION_LINEAR);
+        }
+    }
+
 private:
+    // Voices left playing once polyphony is capped, and once the quietest voices are shed
+    static constexpr int kCappedVoices = 24;
+    static constexpr int kShedVoices = 12;
+
     tsf* mTsf = nullptr;
+    LoadStage mLoadStage = LOAD_STAGE_NORMAL;
     bool mIsStereo;
     int32_t mSampleRate;
 };
@@ -1,6 +1,9 @@
-#include <thread>
+#include <mutex>
+#include <string>
 #include <vector>
 #include "AndroidEngine/AndroidEngine.h"
+#include "AndroidEffects/Effects.h"
+#include "AndroidInstruments/AudioClipPlayer.h"
 #include "AndroidInstruments/SoundFontInstrument.h"
 #include "Utils/OptionArray.h"
 #include "Scheduler/BaseScheduler.h"
@@ -15,6 +18,9 @@
 
 std::unique_ptr<AndroidEngine> engine;
 
+// Dart never hands out port 0, so it marks a load request without a progress port
+constexpr Dart_Port kNoProgressPort = 0;
+
 bool check_engine() {
     if (engine == nullptr) {
         LOGE("Engine is not set up. Ensure that setup_engine() is called before calling this method.");
@@ -23,14 +29,34 @@ bool check_engine() {
     return true;
 }
 
-void setInstrumentOutputFormat(IInstrument* instrument) {
-    auto sampleRate = engine->getSampleRate();
-    auto channelCount = engine->getChannelCount();
+void setInstrumentOutputFormat(AndroidEngine* androidEngine, IInstrument* instrument) {
+    auto sampleRate = androidEngine->getSampleRate();
+    auto channelCount = androidEngine->getChannelCount();
     auto isStereo = channelCount > 1;
 
     instrument->setOutputFormat(sampleRate, isStereo);
 }
 
+// Adds the track under the loader's lock, so a cancellation that arrives while the instrument
+// loaded can't also miss the track. Loader threads that finish at the same time are serialized
+// by the same lock. Returns -1 and drops the instrument if the load was cancelled.
+template <typename Instrument>
+track_index_t addLoadedTrack(AndroidEngine* androidEngine, const std::atomic<bool>& isCancelled, std::unique_ptr<Instrument>& instrument) {
+    track_index_t trackIndex = -1;
+
+    androidEngine->mInstrumentLoader.commit(isCancelled, [&]() {
+        trackIndex = androidEngine->mSchedulerMixer.addTrack(instrument.release());
+    });
+
+    return trackIndex;
+}
+
+void reportLoadProgress(Dart_Port progressPort, int32_t progress) {
+    if (progressPort != kNoProgressPort) {
+        callbackToDartInt32(progressPort, progress);
+    }
+}
+
 extern "C" {
     __attribute__((visibility("default"))) __attribute__((used))
     void setup_engine(Dart_Port sampleRateCallbackPort) {
@@ -43,22 +69,28 @@ extern "C" {
     }
 
     __attribute__((visibility("default"))) __attribute__((used))
-    void add_track_sf2(const char* filename, bool isAsset, int32_t presetIndex, Dart_Port callbackPort) {
+    load_request_id_t load_track_sf2(const char* filename, bool isAsset, int32_t presetIndex, int32_t priority, Dart_Port callbackPort, Dart_Port progressPort) {
         if (!check_engine()) {
             callbackToDartInt32(callbackPort, -1);
-            return;
+            return -1;
         }
 
-        // Use a detached thread to avoid blocking the calling thread
-        std::thread([=]() {
+        auto androidEngine = engine.get();
+        std::string path(filename);
+
+        return engine->mInstrumentLoader.enqueue(priority, [=](const std::atomic<bool>& isCancelled) {
             try {
+                reportLoadProgress(progressPort, kLoadProgressStarted);
+
                 auto sf2Instrument = std::make_unique<SoundFontInstrument>();
-                setInstrumentOutputFormat(sf2Instrument.get());
+                setInstrumentOutputFormat(androidEngine, sf2Instrument.get());
 
-                auto didLoad = sf2Instrument->loadSf2File(filename, isAsset, presetIndex);
+                auto didLoad = sf2Instrument->loadSf2File(path.c_str(), isAsset, presetIndex);
 
-                if (didLoad) {
-                    auto trackIndex = engine->mSchedulerMixer.addTrack(sf2Instrument.release());
+                if (didLoad && !isCancelled) {
+                    reportLoadProgress(progressPort, kLoadProgressParsed);
+                    auto trackIndex = addLoadedTrack(androidEngine, isCancelled, sf2Instrument);
+                    if (trackIndex != -1) reportLoadProgress(progressPort, kLoadProgressReady);
                     callbackToDartInt32(callbackPort, trackIndex);
                 } else {
                     callbackToDartInt32(callbackPort, -1);
@@ -67,76 +99,167 @@ extern "C" {
                 LOGE("Error loading SF2 track: %s", e.what());
                 callbackToDartInt32(callbackPort, -1);
             }
-        }).detach();
+        }, [=]() {
+            callbackToDartInt32(callbackPort, -1);
+        });
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void add_track_sf2(const char* filename, bool isAsset, int32_t presetIndex, Dart_Port callbackPort) {
+        load_track_sf2(filename, isAsset, presetIndex, 0, callbackPort, kNoProgressPort);
     }
 
     __attribute__((visibility("default"))) __attribute__((used))
-    void add_track_sfz(const char* filename, const char* tuningFilename, Dart_Port callbackPort) {
+    load_request_id_t load_track_sfz(const char* filename, const char* tuningFilename, int32_t oversamplingFactor, int32_t priority, Dart_Port callbackPort, Dart_Port progressPort) {
 #if defined(SFIZZ_AVAILABLE) && SFIZZ_AVAILABLE
         if (!check_engine()) {
             callbackToDartInt32(callbackPort, -1);
-            return;
+            return -1;
         }
 
-        std::thread([=]() {
-            auto sfzInstrument = new SfizzSamplerInstrument();
-            setInstrumentOutputFormat(sfzInstrument);
+        auto androidEngine = engine.get();
+        std::string path(filename);
+        auto hasTuning = tuningFilename != nullptr;
+        std::string tuningPath(hasTuning ? tuningFilename : "");
+
+        return engine->mInstrumentLoader.enqueue(priority, [=](const std::atomic<bool>& isCancelled) {
+            reportLoadProgress(progressPort, kLoadProgressStarted);
 
-            auto didLoad = sfzInstrument->loadSfzFile(filename, tuningFilename);
+            auto sfzInstrument = std::make_unique<SfizzSamplerInstrument>();
+            sfzInstrument->setOversamplingFactor(oversamplingFactor);
+            setInstrumentOutputFormat(androidEngine, sfzInstrument.get());
 
-            if (didLoad) {
-                auto bufferSize = engine->getBufferSize();
-                sfzInstrument->setSamplesPerBlock(bufferSize);
-                auto trackIndex = engine->mSchedulerMixer.addTrack(sfzInstrument);
+            auto didLoad = sfzInstrument->loadSfzFile(path.c_str(), hasTuning ? tuningPath.c_str() : nullptr);
 
+            if (didLoad && !isCancelled) {
+                reportLoadProgress(progressPort, kLoadProgressParsed);
+                sfzInstrument->setSamplesPerBlock(androidEngine->getBufferSize());
+                auto trackIndex = addLoadedTrack(androidEngine, isCancelled, sfzInstrument);
+                if (trackIndex != -1) reportLoadProgress(progressPort, kLoadProgressReady);
                 callbackToDartInt32(callbackPort, trackIndex);
             } else {
                 callbackToDartInt32(callbackPort, -1);
             }
-        }).detach();
+        }, [=]() {
+            callbackToDartInt32(callbackPort, -1);
+        });
 #else
         // SFZ support not available in this build
         callbackToDartInt32(callbackPort, -1);
+        return -1;
 #endif
     }
 
     __attribute__((visibility("default"))) __attribute__((used))
-    void add_track_sfz_string(const char* sampleRoot, const char* sfzString, const char* tuningString, Dart_Port callbackPort) {
+    void add_track_sfz(const char* filename, const char* tuningFilename, int32_t oversamplingFactor, Dart_Port callbackPort) {
+        load_track_sfz(filename, tuningFilename, oversamplingFactor, 0, callbackPort, kNoProgressPort);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    load_request_id_t load_track_sfz_string(const char* sampleRoot, const char* sfzString, const char* tuningString, int32_t oversamplingFactor, int32_t priority, Dart_Port callbackPort, Dart_Port progressPort) {
 #if defined(SFIZZ_AVAILABLE) && SFIZZ_AVAILABLE
         if (!check_engine()) {
             callbackToDartInt32(callbackPort, -1);
-            return;
+            return -1;
         }
 
-        std::thread([=]() {
-            auto sfzInstrument = new SfizzSamplerInstrument();
-            setInstrumentOutputFormat(sfzInstrument);
+        auto androidEngine = engine.get();
+        std::string root(sampleRoot);
+        std::string sfz(sfzString);
+        auto hasTuning = tuningString != nullptr;
+        std::string tuning(hasTuning ? tuningString : "");
+
+        return engine->mInstrumentLoader.enqueue(priority, [=](const std::atomic<bool>& isCancelled) {
+            reportLoadProgress(progressPort, kLoadProgressStarted);
 
-            auto didLoad = sfzInstrument->loadSfzString(sampleRoot, sfzString, tuningString);
+            auto sfzInstrument = std::make_unique<SfizzSamplerInstrument>();
+            sfzInstrument->setOversamplingFactor(oversamplingFactor);
+            setInstrumentOutputFormat(androidEngine, sfzInstrument.get());
 
-            if (didLoad) {
-                auto bufferSize = engine->getBufferSize();
-                sfzInstrument->setSamplesPerBlock(bufferSize);
-                auto trackIndex = engine->mSchedulerMixer.addTrack(sfzInstrument);
+            auto didLoad = sfzInstrument->loadSfzString(root.c_str(), sfz.c_str(), hasTuning ? tuning.c_str() : nullptr);
 
+            if (didLoad && !isCancelled) {
+                reportLoadProgress(progressPort, kLoadProgressParsed);
+                sfzInstrument->setSamplesPerBlock(androidEngine->getBufferSize());
+                auto trackIndex = addLoadedTrack(androidEngine, isCancelled, sfzInstrument);
+                if (trackIndex != -1) reportLoadProgress(progressPort, kLoadProgressReady);
                 callbackToDartInt32(callbackPort, trackIndex);
             } else {
                 callbackToDartInt32(callbackPort, -1);
             }
-        }).detach();
+        }, [=]() {
+            callbackToDartInt32(callbackPort, -1);
+        });
 #else
         // SFZ support not available in this build
         callbackToDartInt32(callbackPort, -1);
+        return -1;
 #endif
     }
 
-__attribute__((visibility("default"))) __attribute__((used))
+    __attribute__((visibility("default"))) __attribute__((used))
+    void add_track_sfz_string(const char* sampleRoot, const char* sfzString, const char* tuningString, int32_t oversamplingFactor, Dart_Port callbackPort) {
+        load_track_sfz_string(sampleRoot, sfzString, tuningString, oversamplingFactor, 0, callbackPort, kNoProgressPort);
+    }
+
+    // gain is linear, the fades are in frames
+    __attribute__((visibility("default"))) __attribute__((used))
+    load_request_id_t load_track_audio_clip(const char* filename, float gain, uint32_t fadeInFrames, uint32_t fadeOutFrames, int32_t priority, Dart_Port callbackPort, Dart_Port progressPort) {
+        if (!check_engine()) {
+            callbackToDartInt32(callbackPort, -1);
+            return -1;
+        }
+
+        auto androidEngine = engine.get();
+        std::string path(filename);
+
+        return engine->mInstrumentLoader.enqueue(priority, [=](const std::atomic<bool>& isCancelled) {
+            reportLoadProgress(progressPort, kLoadProgressStarted);
+
+            auto clipPlayer = std::make_unique<AudioClipPlayer>();
+            setInstrumentOutputFormat(androidEngine, clipPlayer.get());
+
+            auto didOpen = clipPlayer->open(path.c_str(), gain, fadeInFrames, fadeOutFrames);
+
+            if (didOpen && !isCancelled) {
+                reportLoadProgress(progressPort, kLoadProgressParsed);
+                auto trackIndex = addLoadedTrack(androidEngine, isCancelled, clipPlayer);
+                if (trackIndex != -1) reportLoadProgress(progressPort, kLoadProgressReady);
+                callbackToDartInt32(callbackPort, trackIndex);
+            } else {
+                callbackToDartInt32(callbackPort, -1);
+            }
+        }, [=]() {
+            callbackToDartInt32(callbackPort, -1);
+        });
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    bool cancel_track_load(load_request_id_t requestId) {
+        if (!check_engine()) {
+            return false;
+        }
+
+        return engine->mInstrumentLoader.cancel(requestId);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_track_load_priority(load_request_id_t requestId, int32_t priority) {
+        if (!check_engine()) {
+            return;
+        }
+
+        engine->mInstrumentLoader.setPriority(requestId, priority);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
     void remove_track(track_index_t trackIndex) {
         if (!check_engine()) {
             return;
         }
 
         engine->mSchedulerMixer.removeTrack(trackIndex);
+        engine->mTrackFreezer.forget(trackIndex);
     }
 
     __attribute__((visibility("default"))) __attribute__((used))
@@ -178,6 +301,15 @@ __attribute__((visibility("default"))) __attribute__((used))
         return engine->mSchedulerMixer.getLastRenderTimeUs();
     }
 
+    __attribute__((visibility("default"))) __attribute__((used))
+    position_frame_t get_audible_frame() {
+        if (!check_engine()) {
+            return 0;
+        }
+
+        return engine->mSchedulerMixer.getAudibleFrame();
+    }
+
     __attribute__((visibility("default"))) __attribute__((used))
     uint32_t get_buffer_available_count(track_index_t trackIndex) {
         if (!check_engine()) {
@@ -259,6 +391,158 @@ __attribute__((visibility("default"))) __attribute__((used))
         return engine->mSchedulerMixer.clearEvents(trackIndex, fromFrame);
     }
 
+    __attribute__((visibility("default"))) __attribute__((used))
+    uint32_t set_controller_timeline(track_index_t trackIndex, const uint8_t* eventData, uint32_t eventsCount) {
+        if (!check_engine()) {
+            return 0;
+        }
+
+        std::vector<SchedulerEvent> events(eventsCount);
+
+        rawEventDataToEvents(eventData, eventsCount, events.data());
+
+        return engine->mSchedulerMixer.setControllerTimeline(trackIndex, events.data(), eventsCount);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    uint32_t apply_batch(const uint8_t* commandData, uint32_t commandDataSize, uint32_t* results) {
+        if (!check_engine()) {
+            return 0;
+        }
+
+        return engine->mSchedulerMixer.applyBatch(commandData, commandDataSize, results);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    int32_t add_effect(track_index_t trackIndex, uint8_t chain, int32_t effectType) {
+        if (!check_engine()) {
+            return -1;
+        }
+
+        auto effect = createEffect(effectType, engine->getSampleRate());
+        if (effect == nullptr) {
+            LOGE("Plugin: add_effect called with unknown effect type %d", effectType);
+            return -1;
+        }
+
+        return engine->mSchedulerMixer.addEffect(trackIndex, chain, std::move(effect));
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void remove_effect(track_index_t trackIndex, uint8_t chain, int32_t slot) {
+        if (!check_engine()) {
+            return;
+        }
+
+        engine->mSchedulerMixer.removeEffect(trackIndex, chain, slot);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_bus_return_level(uint8_t bus, float level) {
+        if (!check_engine()) {
+            return;
+        }
+
+        engine->mSchedulerMixer.setBusReturnLevel(bus, level);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_render_ahead_enabled(bool isEnabled) {
+        if (!check_engine()) {
+            return;
+        }
+
+        engine->mSchedulerMixer.setRenderAheadEnabled(isEnabled);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    load_request_id_t freeze_track(track_index_t trackIndex, const uint8_t* eventData, uint32_t eventsCount,
+                                   uint32_t numFrames, const char* cachePath, int32_t priority, Dart_Port callbackPort) {
+        if (!check_engine()) {
+            callbackToDartInt32(callbackPort, -1);
+            return -1;
+        }
+
+        auto androidEngine = engine.get();
+        std::vector<SchedulerEvent> events(eventsCount);
+        rawEventDataToEvents(eventData, eventsCount, events.data());
+        std::string path(cachePath);
+
+        // Freezing shares the loader pool, so it can be prioritized and cancelled like a load
+        return engine->mInstrumentLoader.enqueue(priority, [=](const std::atomic<bool>& isCancelled) {
+            auto didFreeze = androidEngine->mTrackFreezer.freeze(trackIndex, events, numFrames, path, isCancelled);
+            callbackToDartInt32(callbackPort, didFreeze ? trackIndex : -1);
+        }, [=]() {
+            callbackToDartInt32(callbackPort, -1);
+        });
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    bool unfreeze_track(track_index_t trackIndex) {
+        if (!check_engine()) {
+            return false;
+        }
+
+        return engine->mTrackFreezer.unfreeze(trackIndex);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_load_governor_enabled(bool isEnabled) {
+        if (!check_engine()) {
+            return;
+        }
+
+        engine->mLoadGovernor.setEnabled(isEnabled);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_load_governor_thresholds(float degradeLoad, float recoverLoad) {
+        if (!check_engine()) {
+            return;
+        }
+
+        engine->mLoadGovernor.setThresholds(degradeLoad, recoverLoad);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    bool get_load_governor_status(LoadGovernorStatus* status) {
+        if (!check_engine()) {
+            return false;
+        }
+
+        engine->mLoadGovernor.getStatus(status);
+        return true;
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_metering_enabled(bool isEnabled) {
+        if (!check_engine()) {
+            return;
+        }
+
+        engine->mSchedulerMixer.setMeteringEnabled(isEnabled);
+    }
+
+    __attribute__((visibility("default"))) __attribute__((used))
+    void set_spectrum_enabled(bool isEnabled) {
+        if (!check_engine()) {
+            return;
+        }
+
+        engine->mSchedulerMixer.setSpectrumEnabled(isEnabled);
+    }
+
+    // The readout is updated in place, so Dart reads it through this pointer for as long as the
+    // engine lives
+    __attribute__((visibility("default"))) __attribute__((used))
+    const MeterReadout* get_meter_readout() {
+        if (!check_engine()) {
+            return nullptr;
+        }
+
+        return engine->mSchedulerMixer.getMeterReadout();
+    }
+
     __attribute__((visibility("default"))) __attribute__((used))
     void engine_play() {
         if (!check_engine()) {
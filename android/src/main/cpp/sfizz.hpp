@@ -8,6 +8,11 @@ namespace sfz {
 
 class Sfizz {
 public:
+    enum ProcessMode {
+        ProcessLive,
+        ProcessFreewheeling,
+    };
+
     Sfizz();
     ~Sfizz();
     
@@ -18,6 +23,12 @@ public:
     
     void setSampleRate(float sampleRate);
     void setSamplesPerBlock(int samplesPerBlock);
+    bool setOversamplingFactor(int factor) noexcept;
+
+    int getSampleQuality(ProcessMode mode);
+    void setSampleQuality(ProcessMode mode, int quality);
+    int getOscillatorQuality(ProcessMode mode);
+    void setOscillatorQuality(ProcessMode mode, int quality);
     
     void noteOn(int delay, int noteNumber, int velocity);
     void noteOff(int delay, int noteNumber, int velocity);
@@ -27,6 +38,7 @@ public:
     void renderBlock(float** buffers, size_t numFrames, int numOutputs = 2);
     
     int getNumRegions() const;
+    int getNumActiveVoices() const noexcept;
     
 private:
     class Impl;
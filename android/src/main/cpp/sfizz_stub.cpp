@@ -16,6 +16,9 @@ public:
     std::atomic<int> samplesPerBlock{512};
     std::atomic<bool> isLoaded{false};
     std::atomic<int> numRegions{0};
+    // Indexed by ProcessMode, with the defaults of the real library
+    std::atomic<int> sampleQuality[2] = {{2}, {10}};
+    std::atomic<int> oscillatorQuality[2] = {{1}, {3}};
     
     // Pre-allocated zero buffer to avoid repeated memset calls
     static constexpr size_t MAX_BUFFER_SIZE = 8192; // 8K samples should cover most cases
@@ -55,10 +58,31 @@ void Sfizz::setSampleRate(float sampleRate) {
     pImpl->sampleRate.store(sampleRate, std::memory_order_relaxed);
 }
 
+bool Sfizz::setOversamplingFactor(int factor) noexcept {
+    // The stub has no samples to upsample
+    return factor == 1;
+}
+
 void Sfizz::setSamplesPerBlock(int samplesPerBlock) {
     pImpl->samplesPerBlock.store(samplesPerBlock, std::memory_order_relaxed);
 }
 
+int Sfizz::getSampleQuality(ProcessMode mode) {
+    return pImpl->sampleQuality[mode].load(std::memory_order_relaxed);
+}
+
+void Sfizz::setSampleQuality(ProcessMode mode, int quality) {
+    pImpl->sampleQuality[mode].store(quality, std::memory_order_relaxed);
+}
+
+int Sfizz::getOscillatorQuality(ProcessMode mode) {
+    return pImpl->oscillatorQuality[mode].load(std::memory_order_relaxed);
+}
+
+void Sfizz::setOscillatorQuality(ProcessMode mode, int quality) {
+    pImpl->oscillatorQuality[mode].store(quality, std::memory_order_relaxed);
+}
+
 void Sfizz::noteOn(int delay, int noteNumber, int velocity) {
     // Stub implementation - no-op for performance
 }
@@ -100,4 +124,9 @@ int Sfizz::getNumRegions() const {
     return pImpl->numRegions.load(std::memory_order_relaxed);
 }
 
+int Sfizz::getNumActiveVoices() const noexcept {
+    // The stub never plays anything
+    return 0;
+}
+
 } // namespace sfz
\ No newline at end of file
@@ -164,6 +164,21 @@ TSFDEF void tsf_set_volume(tsf* f, float global_gain);
 //   (tsf_set_max_voices returns 0 if allocation failed, otherwise 1)
 TSFDEF int tsf_set_max_voices(tsf* f, int max_voices);
 
+// Sample interpolation, used when a sample plays at another pitch than it was recorded at
+enum TSFInterpolation
+{
+	// Linear interpolation between neighbouring samples (default)
+	TSF_INTERPOLATION_LINEAR,
+	// Drop-sample, cheaper but with audible aliasing
+	TSF_INTERPOLATION_NEAREST
+};
+
+// Set the sample interpolation
+TSFDEF void tsf_set_interpolation(tsf* f, enum TSFInterpolation interpolation);
+
+// Quickly end the quietest playing voices until at most max_voices are left
+TSFDEF void tsf_shed_voices(tsf* f, int max_voices);
+
 // Start playing a note
 //   preset_index: preset index >= 0 and < tsf_get_presetcount()
 //   key: note value between 0 and 127 (60 being middle C)
@@ -340,6 +355,7 @@ struct tsf
 	unsigned int voicePlayIndex;
 
 	enum TSFOutputMode outputmode;
+	enum TSFInterpolation interpolation;
 	float outSampleRate;
 	float globalGainDB;
 	int* refCount;
@@ -1241,6 +1257,8 @@ static void tsf_voice_render(tsf* f, struct tsf_voice* v, float* outputBuffer, i
 	TSF_BOOL dynamicGain = (region->modLfoToVolume != 0);
 	float noteGain = 0, tmpModLfoToVolume;
 
+	TSF_BOOL isNearest = (f->interpolation == TSF_INTERPOLATION_NEAREST);
+
 	if (dynamicLowpass) tmpInitialFilterFc = (float)region->initialFilterFc, tmpModLfoToFilterFc = (float)region->modLfoToFilterFc, tmpModEnvToFilterFc = (float)region->modEnvToFilterFc;
 	else tmpInitialFilterFc = 0, tmpModLfoToFilterFc = 0, tmpModEnvToFilterFc = 0;
 
@@ -1289,7 +1307,7 @@ static void tsf_voice_render(tsf* f, struct tsf_voice* v, float* outputBuffer, i
 					unsigned int pos = (unsigned int)tmpSourceSamplePosition, nextPos = (pos >= tmpLoopEnd && isLooping ? tmpLoopStart : pos + 1);
 
 					// Simple linear interpolation.
-					float alpha = (float)(tmpSourceSamplePosition - pos), val = (input[pos] * (1.0f - alpha) + input[nextPos] * alpha);
+					float alpha = (float)(tmpSourceSamplePosition - pos), val = (isNearest ? input[pos] : input[pos] * (1.0f - alpha) + input[nextPos] * alpha);
 
 					// Low-pass filter.
 					if (tmpLowpass.active) val = tsf_voice_lowpass_process(&tmpLowpass, val);
@@ -1310,7 +1328,7 @@ static void tsf_voice_render(tsf* f, struct tsf_voice* v, float* outputBuffer, i
 					unsigned int pos = (unsigned int)tmpSourceSamplePosition, nextPos = (pos >= tmpLoopEnd && isLooping ? tmpLoopStart : pos + 1);
 
 					// Simple linear interpolation.
-					float alpha = (float)(tmpSourceSamplePosition - pos), val = (input[pos] * (1.0f - alpha) + input[nextPos] * alpha);
+					float alpha = (float)(tmpSourceSamplePosition - pos), val = (isNearest ? input[pos] : input[pos] * (1.0f - alpha) + input[nextPos] * alpha);
 
 					// Low-pass filter.
 					if (tmpLowpass.active) val = tsf_voice_lowpass_process(&tmpLowpass, val);
@@ -1330,7 +1348,7 @@ static void tsf_voice_render(tsf* f, struct tsf_voice* v, float* outputBuffer, i
 					unsigned int pos = (unsigned int)tmpSourceSamplePosition, nextPos = (pos >= tmpLoopEnd && isLooping ? tmpLoopStart : pos + 1);
 
 					// Simple linear interpolation.
-					float alpha = (float)(tmpSourceSamplePosition - pos), val = (input[pos] * (1.0f - alpha) + input[nextPos] * alpha);
+					float alpha = (float)(tmpSourceSamplePosition - pos), val = (isNearest ? input[pos] : input[pos] * (1.0f - alpha) + input[nextPos] * alpha);
 
 					// Low-pass filter.
 					if (tmpLowpass.active) val = tsf_voice_lowpass_process(&tmpLowpass, val);
@@ -1534,6 +1552,35 @@ TSFDEF void tsf_set_volume(tsf* f, float global_volume)
 	f->globalGainDB = (global_volume == 1.0f ? 0 : -tsf_gainToDecibels(1.0f / global_volume));
 }
 
+TSFDEF void tsf_set_interpolation(tsf* f, enum TSFInterpolation interpolation)
+{
+	f->interpolation = interpolation;
+}
+
+TSFDEF void tsf_shed_voices(tsf* f, int max_voices)
+{
+	struct tsf_voice *v, *vEnd = f->voices + f->voiceNum, *quietest;
+	int count = 0;
+	float gain, quietestGain;
+
+	// Voices that already end quickly are on their way out and don't count
+	for (v = f->voices; v != vEnd; v++)
+		if (v->playingPreset != -1 && !(v->ampenv.segment == TSF_SEGMENT_RELEASE && v->ampenv.parameters.release == 0.0f)) count++;
+
+	for (; count > max_voices; count--)
+	{
+		quietest = TSF_NULL, quietestGain = 0;
+		for (v = f->voices; v != vEnd; v++)
+		{
+			if (v->playingPreset == -1 || (v->ampenv.segment == TSF_SEGMENT_RELEASE && v->ampenv.parameters.release == 0.0f)) continue;
+			gain = tsf_decibelsToGain(v->noteGainDB) * v->ampenv.level;
+			if (!quietest || gain < quietestGain) quietest = v, quietestGain = gain;
+		}
+		if (!quietest) break;
+		tsf_voice_endquick(f, quietest);
+	}
+}
+
 TSFDEF int tsf_set_max_voices(tsf* f, int max_voices)
 {
 	int i = f->voiceNum;
@@ -0,0 +1,146 @@
+// Block time of 16 tracks playing the same chords live from a SoundFont, as
+// SoundFontInstrument renders them, or frozen to files and played back by
+// FrozenTrackPlayer. Each frozen track has its own file, rendered before the
+// timed loop like TrackFreezer does.
+
+#define TSF_IMPLEMENTATION
+#include "tsf.h"
+#include "FrozenTrackPlayer.h"
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+constexpr int kNumTracks { 16 };
+constexpr int kSampleRate { 48000 };
+constexpr int kBlockFrames { 128 };
+// A chord starts on every track once per second
+constexpr int kBlocksPerChord { kSampleRate / kBlockFrames };
+constexpr int kNumChords { 4 };
+constexpr std::array<int, 4> kChord { 48, 55, 64, 67 };
+
+// Plays the next chord on the blocks where one starts, on every track
+static void playChords(tsf* soundFont, int block, int track)
+{
+    if (block % kBlocksPerChord != 0)
+        return;
+
+    tsf_note_off_all(soundFont);
+    const int transpose = (block / kBlocksPerChord) % kNumChords + track % 12;
+    for (int key : kChord)
+        tsf_note_on(soundFont, 0, key + transpose, 0.8f);
+}
+
+class Tracks : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& /*state*/)
+    {
+        tsf* soundFont = tsf_load_filename(SF2_PATH);
+        if (soundFont == nullptr)
+            return;
+
+        for (int track = 0; track < kNumTracks; ++track) {
+            liveTracks[track] = track == 0 ? soundFont : tsf_copy(soundFont);
+            tsf_set_output(liveTracks[track], TSF_STEREO_INTERLEAVED, kSampleRate, 0.0f);
+        }
+    }
+
+    void TearDown(const ::benchmark::State& /*state*/)
+    {
+        for (auto& soundFont : liveTracks) {
+            tsf_close(soundFont);
+            soundFont = nullptr;
+        }
+    }
+
+    bool isLoaded() const { return liveTracks[0] != nullptr; }
+
+    std::array<tsf*, kNumTracks> liveTracks {};
+    std::array<float, kBlockFrames * 2> trackBuffer {};
+    std::array<float, kBlockFrames * 2> output {};
+};
+
+BENCHMARK_DEFINE_F(Tracks, Live)(benchmark::State& state)
+{
+    if (!isLoaded()) {
+        state.SkipWithError("Cannot load " SF2_PATH);
+        return;
+    }
+
+    int block = 0;
+    for (auto _ : state) {
+        output.fill(0.0f);
+        for (int track = 0; track < kNumTracks; ++track) {
+            playChords(liveTracks[track], block, track);
+            tsf_render_float(liveTracks[track], trackBuffer.data(), kBlockFrames, 0);
+            for (size_t j = 0; j < output.size(); ++j)
+                output[j] += trackBuffer[j];
+        }
+        benchmark::DoNotOptimize(output.data());
+        block = (block + 1) % (kBlocksPerChord * kNumChords);
+    }
+
+    state.counters["tracks"] = kNumTracks;
+}
+
+BENCHMARK_DEFINE_F(Tracks, Frozen)(benchmark::State& state)
+{
+    if (!isLoaded()) {
+        state.SkipWithError("Cannot load " SF2_PATH);
+        return;
+    }
+
+    // Freeze the chords of each track, then play the files back in a loop
+    const fs::path directory = fs::temp_directory_path() / "frozen_tracks_benchmark";
+    fs::create_directories(directory);
+    constexpr int numBlocks = kBlocksPerChord * kNumChords;
+    std::array<std::unique_ptr<FrozenTrackPlayer>, kNumTracks> players;
+    for (int track = 0; track < kNumTracks; ++track) {
+        const std::string path = (directory / ("track" + std::to_string(track) + ".frozen")).string();
+        FILE* file = std::fopen(path.c_str(), "wb");
+        for (int block = 0; block < numBlocks; ++block) {
+            playChords(liveTracks[track], block, track);
+            tsf_render_float(liveTracks[track], trackBuffer.data(), kBlockFrames, 0);
+            std::fwrite(trackBuffer.data(), sizeof(float), trackBuffer.size(), file);
+        }
+        std::fclose(file);
+
+        players[track] = std::make_unique<FrozenTrackPlayer>();
+        if (!players[track]->open(path.c_str())) {
+            state.SkipWithError("Cannot open a frozen track");
+            return;
+        }
+        players[track]->seekToFrame(0);
+    }
+
+    int block = 0;
+    for (auto _ : state) {
+        output.fill(0.0f);
+        for (auto& player : players) {
+            if (block == 0)
+                player->seekToFrame(0);
+            player->renderAudio(trackBuffer.data(), kBlockFrames);
+            for (size_t j = 0; j < output.size(); ++j)
+                output[j] += trackBuffer[j];
+        }
+        benchmark::DoNotOptimize(output.data());
+        block = (block + 1) % numBlocks;
+    }
+
+    state.counters["tracks"] = kNumTracks;
+
+    for (auto& player : players)
+        player.reset();
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+}
+
+BENCHMARK_REGISTER_F(Tracks, Live)->Unit(benchmark::kMicrosecond);
+BENCHMARK_REGISTER_F(Tracks, Frozen)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
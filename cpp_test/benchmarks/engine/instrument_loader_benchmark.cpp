@@ -0,0 +1,148 @@
+// Total time to load N instruments through the InstrumentLoader, whose two
+// workers take the requests in turn, compared with starting one thread per
+// load. A load reads its own sample file and converts it to floats, which is
+// what most of an instrument load does. The files are written once to a
+// temporary directory, so they are read back from the page cache.
+
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "InstrumentLoader.h"
+
+namespace fs = std::filesystem;
+
+constexpr int kMaxInstruments { 32 };
+constexpr size_t kSampleFrames { 1 << 20 };
+
+/**
+ * One file of 16-bit samples per instrument. The files are removed at exit.
+ */
+class SampleFiles {
+public:
+    SampleFiles()
+        : directory(fs::temp_directory_path() / "instrument_loader_benchmark")
+    {
+        fs::create_directories(directory);
+        std::vector<int16_t> samples(kSampleFrames);
+        for (size_t i = 0; i < kSampleFrames; ++i)
+            samples[i] = static_cast<int16_t>(i * 31);
+
+        for (int i = 0; i < kMaxInstruments; ++i) {
+            std::ofstream file(path(i), std::ios::binary);
+            file.write(reinterpret_cast<const char*>(samples.data()), samples.size() * sizeof(int16_t));
+        }
+    }
+
+    ~SampleFiles()
+    {
+        std::error_code ec;
+        fs::remove_all(directory, ec);
+    }
+
+    fs::path path(int instrument) const
+    {
+        return directory / ("instrument" + std::to_string(instrument) + ".raw");
+    }
+
+private:
+    fs::path directory;
+};
+
+static const SampleFiles& sampleFiles()
+{
+    static SampleFiles files;
+    return files;
+}
+
+static void loadInstrument(int instrument)
+{
+    std::ifstream file(sampleFiles().path(instrument), std::ios::binary);
+    std::vector<int16_t> samples(kSampleFrames);
+    file.read(reinterpret_cast<char*>(samples.data()), samples.size() * sizeof(int16_t));
+
+    std::vector<float> decoded(kSampleFrames);
+    for (size_t i = 0; i < kSampleFrames; ++i)
+        decoded[i] = samples[i] * (1.0f / 32768.0f);
+    benchmark::DoNotOptimize(decoded.data());
+}
+
+// Counts the loads down, like the Dart side waiting for each callback
+class Completion {
+public:
+    explicit Completion(int count) : remaining(count) {}
+
+    void done()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--remaining == 0)
+            condition.notify_all();
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return remaining == 0; });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    int remaining;
+};
+
+/**
+ * Argument: the number of instruments, all queued at once.
+ */
+static void LoadThroughPool(benchmark::State& state)
+{
+    const int numInstruments = static_cast<int>(state.range(0));
+    sampleFiles();
+
+    InstrumentLoader loader;
+    for (auto _ : state) {
+        Completion completion { numInstruments };
+        for (int i = 0; i < numInstruments; ++i) {
+            loader.enqueue(0, [i, &completion](const std::atomic<bool>&) {
+                loadInstrument(i);
+                completion.done();
+            }, [&completion]() {
+                completion.done();
+            });
+        }
+        completion.wait();
+    }
+
+    state.counters["instruments"] = numInstruments;
+}
+
+/**
+ * Argument: the number of instruments, each loaded on a thread of its own.
+ */
+static void LoadThreadPerInstrument(benchmark::State& state)
+{
+    const int numInstruments = static_cast<int>(state.range(0));
+    sampleFiles();
+
+    for (auto _ : state) {
+        std::vector<std::thread> threads;
+        threads.reserve(numInstruments);
+        for (int i = 0; i < numInstruments; ++i)
+            threads.emplace_back(loadInstrument, i);
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    state.counters["instruments"] = numInstruments;
+}
+
+BENCHMARK(LoadThroughPool)->Arg(4)->Arg(16)->Arg(kMaxInstruments)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(LoadThreadPerInstrument)->Arg(4)->Arg(16)->Arg(kMaxInstruments)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
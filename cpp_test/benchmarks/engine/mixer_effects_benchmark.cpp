@@ -0,0 +1,125 @@
+// Block time of the Android mixer with 32 tracks: each one runs an insert chain
+// and sends to 2 aux buses, which return to the output before the master chain
+// and the master limiter. Mixer::renderAudio is timed as the engine calls it,
+// compared with a dry mix of the same tracks.
+
+#include <benchmark/benchmark.h>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+#include "Effects.h"
+#include "Mixer.h"
+
+constexpr int32_t kNumTracks { 32 };
+constexpr int32_t kNumBuses { 2 };
+constexpr int32_t kSampleRate { 48000 };
+constexpr int32_t kBlockFrames { kBufferSize / 2 };
+constexpr float kSendLevel { 0.3f };
+
+// Plays its own noise, so that no effect gets to idle
+class NoiseInstrument : public IInstrument {
+public:
+    explicit NoiseInstrument(uint32_t seed)
+    {
+        std::mt19937 random { seed };
+        std::uniform_real_distribution<float> noise { -0.25f, 0.25f };
+        for (auto& sample : mNoise)
+            sample = noise(random);
+    }
+
+    bool setOutputFormat(int32_t /*sampleRate*/, bool /*isStereo*/) override { return true; }
+    void handleMidiEvent(uint8_t /*status*/, uint8_t /*data1*/, uint8_t /*data2*/) override {}
+    void reset() override {}
+
+    void renderAudio(float* audioData, int32_t numFrames) override
+    {
+        std::memcpy(audioData, mNoise.data(), sizeof(float) * numFrames * 2);
+    }
+
+private:
+    std::array<float, kBufferSize> mNoise {};
+};
+
+class MixerEffects : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        mixer = std::make_unique<Mixer>();
+        mixer->setChannelCount(2);
+        mixer->setSampleRate(kSampleRate);
+
+        const bool withEffects = state.range(0) != 0;
+        for (int32_t i = 0; i < kNumTracks; ++i) {
+            instruments.push_back(std::make_unique<NoiseInstrument>(42 + i));
+            const auto track = mixer->addTrack(instruments.back().get());
+            if (!withEffects)
+                continue;
+
+            addEffect(track, TRACK_INSERT_CHAIN, EFFECT_EQ, { { EQ_FREQUENCY, 2000.0f }, { EQ_GAIN_DB, 3.0f } });
+            addEffect(track, TRACK_INSERT_CHAIN, EFFECT_COMPRESSOR, { { COMPRESSOR_THRESHOLD_DB, -18.0f }, { COMPRESSOR_RATIO, 4.0f } });
+            for (uint8_t bus = 0; bus < kNumBuses; ++bus)
+                setSendLevel(track, bus, kSendLevel);
+        }
+
+        if (withEffects) {
+            addEffect(0, 1, EFFECT_REVERB, { { REVERB_ROOM_SIZE, 0.8f }, { REVERB_WET, 1.0f }, { REVERB_DRY, 0.0f } });
+            addEffect(0, 2, EFFECT_COMPRESSOR, { { COMPRESSOR_THRESHOLD_DB, -30.0f }, { COMPRESSOR_RATIO, 8.0f } });
+            addEffect(0, MASTER_CHAIN, EFFECT_EQ, { { EQ_FREQUENCY, 80.0f }, { EQ_SHAPE, EQ_SHAPE_LOW_SHELF } });
+        }
+
+        // The tracks are only rendered while the mixer plays
+        mixer->play();
+    }
+
+    void TearDown(const ::benchmark::State& /*state*/)
+    {
+        // The mixer doesn't own the instruments, so it goes first
+        mixer.reset();
+        instruments.clear();
+    }
+
+    void addEffect(track_index_t track, uint8_t chain, int32_t effectType, std::initializer_list<std::pair<uint8_t, float>> parameters)
+    {
+        auto effect = createEffect(effectType, kSampleRate);
+        for (const auto& parameter : parameters)
+            effect->setParameter(parameter.first, parameter.second);
+        mixer->addEffect(track, chain, std::move(effect));
+    }
+
+    void setSendLevel(track_index_t track, uint8_t bus, float level)
+    {
+        SchedulerEvent event {};
+        event.type = SEND_LEVEL_EVENT;
+        event.data[0] = bus;
+        std::memcpy(&event.data[4], &level, sizeof(level));
+        mixer->handleEvent(track, event, 0);
+    }
+
+    std::unique_ptr<Mixer> mixer;
+    std::vector<std::unique_ptr<NoiseInstrument>> instruments;
+    std::array<float, kBufferSize> output {};
+};
+
+/**
+ * Argument: whether the tracks have effects and sends (1), or are only summed (0).
+ * The rate counter is how many seconds of audio one second of CPU time mixes.
+ */
+BENCHMARK_DEFINE_F(MixerEffects, RenderAudio)(benchmark::State& state)
+{
+    for (auto _ : state) {
+        mixer->renderAudio(output.data(), kBlockFrames);
+        benchmark::DoNotOptimize(output.data());
+    }
+
+    if (output[kBufferSize - 1] == 0.0f)
+        state.SkipWithError("The tracks rendered silence");
+    state.counters["tracks"] = kNumTracks;
+    state.counters["realtime_factor"] = benchmark::Counter(
+        static_cast<double>(state.iterations()) * kBlockFrames / kSampleRate, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK_REGISTER_F(MixerEffects, RenderAudio)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
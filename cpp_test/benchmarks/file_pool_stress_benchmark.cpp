@@ -0,0 +1,144 @@
+// Streaming stress test of the FilePool: many one-shot voices start in the
+// same block, each on its own sample, so that all of them need the rest of
+// their file from the loading threads at once. The blocks are rendered at
+// real time or as fast as possible, and the voices which play past their
+// streamed frames are counted through Synth::getStreamUnderruns.
+// Also the time from the promise of a file to its first streamed frame.
+
+#include "sfizz/Synth.h"
+#include "sfizz/AudioBuffer.h"
+#include "sfizz/FilePool.h"
+#include "synthetic_instruments.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+
+constexpr int kMaxVoices { 128 };
+constexpr int kStreamFrames { kSampleRate };
+constexpr int kBlockSize { 256 };
+constexpr uint32_t kPreloadSize { 1024 };
+
+/**
+ * Writes one second long samples and an SFZ file which maps each of them to
+ * its own key as a one-shot. The files are removed at exit.
+ */
+class StreamingInstrument {
+public:
+    StreamingInstrument()
+        : directory(fs::temp_directory_path() / "sfizz_file_pool_benchmark")
+    {
+        fs::create_directories(directory);
+        std::ofstream sfz(path());
+        for (int i = 0; i < kMaxVoices; ++i) {
+            const std::string sample = "stream" + std::to_string(i) + ".wav";
+            writeWav(directory / sample, 110.0f + i, kStreamFrames);
+            sfz << "<region> sample=" << sample << " key=" << i << " loop_mode=one_shot\n";
+        }
+    }
+
+    ~StreamingInstrument()
+    {
+        std::error_code ec;
+        fs::remove_all(directory, ec);
+    }
+
+    fs::path path() const { return directory / "streaming.sfz"; }
+
+private:
+    fs::path directory;
+};
+
+static const StreamingInstrument& streamingInstrument()
+{
+    static StreamingInstrument instrument;
+    return instrument;
+}
+
+/**
+ * Arguments: the number of voices, and whether the blocks are paced at real
+ * time (1) or rendered back to back (0).
+ */
+static void StreamVoices(benchmark::State& state)
+{
+    const int numVoices = static_cast<int>(state.range(0));
+    const bool realTime = state.range(1) != 0;
+    const auto blockPeriod = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(double(kBlockSize) / kSampleRate));
+
+    sfz::Synth synth;
+    synth.setSampleRate(kSampleRate);
+    synth.setSamplesPerBlock(kBlockSize);
+    synth.setNumVoices(kMaxVoices);
+    synth.setPreloadSize(kPreloadSize);
+    sfz::AudioBuffer<float> buffer { 2, kBlockSize };
+
+    size_t underruns = 0;
+    for (auto _ : state) {
+        // Reload so that every iteration starts with only the preloaded frames
+        state.PauseTiming();
+        synth.loadSfzFile(streamingInstrument().path());
+        const size_t underrunsBefore = synth.getStreamUnderruns();
+        state.ResumeTiming();
+
+        for (int i = 0; i < numVoices; ++i)
+            synth.noteOn(0, i, 100);
+
+        auto deadline = std::chrono::steady_clock::now();
+        do {
+            synth.renderBlock(buffer);
+            if (realTime) {
+                deadline += blockPeriod;
+                std::this_thread::sleep_until(deadline);
+            }
+        } while (synth.getNumActiveVoices() > 0);
+
+        underruns += synth.getStreamUnderruns() - underrunsBefore;
+    }
+
+    state.counters["underruns"] = benchmark::Counter(static_cast<double>(underruns), benchmark::Counter::kAvgIterations);
+    state.counters["voices"] = numVoices;
+}
+
+BENCHMARK(StreamVoices)
+    ->Args({ 16, 1 })->Args({ 64, 1 })->Args({ 128, 1 })
+    ->Args({ 16, 0 })->Args({ 64, 0 })->Args({ 128, 0 })
+    ->Iterations(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/**
+ * Argument: the number of preloaded frames, which the loading thread copies
+ * or decodes again before the frames after them.
+ */
+static void FirstStreamedFrame(benchmark::State& state)
+{
+    const auto preloadSize = static_cast<uint32_t>(state.range(0));
+    const fs::path directory = streamingInstrument().path().parent_path();
+    auto fileId = std::make_shared<sfz::FileId>("stream0.wav");
+
+    for (auto _ : state) {
+        // A new pool, so that the file is streamed again
+        sfz::FilePool pool;
+        pool.setRootDirectory(directory);
+        pool.setPreloadSize(preloadSize);
+        pool.preloadFile(*fileId, 0);
+
+        const auto start = std::chrono::steady_clock::now();
+        sfz::FileDataHolder holder = pool.getFilePromise(fileId);
+        while (holder->availableFrames.load() <= holder->getPreloadedFrames())
+            std::this_thread::yield();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        state.SetIterationTime(std::chrono::duration<double>(elapsed).count());
+
+        pool.waitForBackgroundLoading();
+    }
+
+    state.counters["preloaded"] = static_cast<double>(preloadSize);
+}
+
+BENCHMARK(FirstStreamedFrame)
+    ->Arg(kPreloadSize)->Arg(8192)->Arg(32768)
+    ->Unit(benchmark::kMicrosecond)->UseManualTime();
+
+BENCHMARK_MAIN();
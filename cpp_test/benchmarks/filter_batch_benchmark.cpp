@@ -0,0 +1,191 @@
+// Block time of the stereo voice filters of 16, 64 and 128 voices, each on
+// its own modulated cutoff, run one Filter per voice or all in a FilterBatch.
+// Then the block time of Synth::renderBlock with as many filtered voices,
+// with the filter batching of the synth on or off.
+
+#include "sfizz/AudioBuffer.h"
+#include "sfizz/Config.h"
+#include "sfizz/FilterBatch.h"
+#include "sfizz/SfzFilter.h"
+#include "sfizz/Synth.h"
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+constexpr int kBlockSize { 256 };
+constexpr double kSampleRate { 48000.0 };
+constexpr int kIntervals { kBlockSize / sfz::config::filterControlInterval };
+
+class VoiceFilters : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        const int numVoices = static_cast<int>(state.range(0));
+        const sfz::FilterType type = static_cast<sfz::FilterType>(state.range(1));
+
+        std::minstd_rand prng;
+        std::uniform_real_distribution<float> noise { -1.0f, 1.0f };
+        input.resize(2 * kBlockSize);
+        for (float& x : input)
+            x = noise(prng);
+
+        output.resize(numVoices * 2 * kBlockSize);
+        cutoffs.resize(numVoices * kBlockSize);
+        cutoffControls.resize(numVoices * kIntervals);
+        resonances.assign(kBlockSize, 3.0f);
+        gains.assign(kBlockSize, 0.0f);
+        for (int v = 0; v < numVoices; ++v) {
+            for (int i = 0; i < kBlockSize; ++i)
+                cutoffs[v * kBlockSize + i] = (300.0f + 20.0f * v) * std::exp2(float(i) / kBlockSize);
+            // The batch takes the parameters once per control interval
+            for (int i = 0; i < kIntervals; ++i)
+                cutoffControls[v * kIntervals + i] = cutoffs[v * kBlockSize + i * sfz::config::filterControlInterval];
+        }
+
+        filters.clear();
+        batch.reset(new sfz::FilterBatch);
+        batch->init(kSampleRate);
+        batch->reserve(type, 2 * numVoices);
+        ids.clear();
+        for (int v = 0; v < numVoices; ++v) {
+            filters.emplace_back(new sfz::Filter);
+            filters.back()->init(kSampleRate);
+            filters.back()->setType(type);
+            filters.back()->setChannels(2);
+            filters.back()->prepare(cutoffs[v * kBlockSize], 3.0f, 0.0f);
+            ids.push_back(batch->addFilter(type, 2));
+        }
+    }
+
+    void TearDown(const ::benchmark::State& /*state*/)
+    {
+        filters.clear();
+        batch.reset();
+    }
+
+    std::vector<float> input;
+    std::vector<float> output;
+    std::vector<float> cutoffs;
+    std::vector<float> cutoffControls;
+    std::vector<float> resonances;
+    std::vector<float> gains;
+    std::vector<std::unique_ptr<sfz::Filter>> filters;
+    std::unique_ptr<sfz::FilterBatch> batch;
+    std::vector<int> ids;
+};
+
+BENCHMARK_DEFINE_F(VoiceFilters, PerVoice)(benchmark::State& state)
+{
+    const float* in[2] = { input.data(), input.data() + kBlockSize };
+    for (auto _ : state) {
+        for (size_t v = 0; v < filters.size(); ++v) {
+            float* out[2] = { &output[(2 * v) * kBlockSize], &output[(2 * v + 1) * kBlockSize] };
+            filters[v]->processModulated(
+                in, out, &cutoffs[v * kBlockSize], resonances.data(), gains.data(), kBlockSize);
+        }
+        benchmark::DoNotOptimize(output.data());
+    }
+}
+
+BENCHMARK_DEFINE_F(VoiceFilters, Batched)(benchmark::State& state)
+{
+    const float* in[2] = { input.data(), input.data() + kBlockSize };
+    for (auto _ : state) {
+        for (size_t v = 0; v < ids.size(); ++v) {
+            float* out[2] = { &output[(2 * v) * kBlockSize], &output[(2 * v + 1) * kBlockSize] };
+            batch->setBuffers(ids[v], in, out);
+            batch->setModulatedParameters(
+                ids[v], &cutoffControls[v * kIntervals], resonances.data(), gains.data());
+        }
+        batch->process(kBlockSize);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.counters["lanes"] = batch->laneWidth();
+}
+
+static void voiceArguments(benchmark::internal::Benchmark* bench)
+{
+    for (int type : { sfz::kFilterLpf2p, sfz::kFilterLpf4p, sfz::kFilterLpf2pSv }) {
+        for (int numVoices : { 16, 64, 128 })
+            bench->Args({ numVoices, type });
+    }
+}
+
+BENCHMARK_REGISTER_F(VoiceFilters, PerVoice)->Apply(voiceArguments);
+BENCHMARK_REGISTER_F(VoiceFilters, Batched)->Apply(voiceArguments);
+
+static const char* filterOpcodes(int type)
+{
+    switch (type) {
+    case sfz::kFilterLpf4p:
+        return "fil_type=lpf_4p";
+    case sfz::kFilterLpf2pSv:
+        return "fil_type=lpf_2p_sv";
+    default:
+        return "fil_type=lpf_2p";
+    }
+}
+
+class SynthFilters : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        const int numVoices = static_cast<int>(state.range(0));
+        synth.setSampleRate(float(kSampleRate));
+        synth.setSamplesPerBlock(kBlockSize);
+        synth.setNumVoices(numVoices);
+        synth.setFilterBatching(state.range(2) != 0);
+        // An LFO keeps the cutoff of every voice moving
+        synth.loadSfzString("/filters.sfz", std::string(R"(
+            <region> sample=*saw ampeg_sustain=100 cutoff=800 resonance=3
+                lfo1_freq=2 lfo1_cutoff=1200 )") + filterOpcodes(int(state.range(1))));
+
+        for (int i = 0; i < numVoices; ++i)
+            synth.noteOn(0, 24 + i % 96, 100);
+
+        // Start the voices outside of the timed loop
+        synth.renderBlock(buffer);
+    }
+
+    void TearDown(const ::benchmark::State& /*state*/)
+    {
+        synth.allSoundOff();
+    }
+
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, kBlockSize };
+};
+
+/**
+ * Arguments: the number of voices, the filter type, and whether the filters
+ * are batched.
+ */
+BENCHMARK_DEFINE_F(SynthFilters, RenderBlock)(benchmark::State& state)
+{
+    for (auto _ : state) {
+        synth.renderBlock(buffer);
+        benchmark::DoNotOptimize(buffer.getSpan(0).data());
+    }
+
+    if (synth.getNumActiveVoices() != state.range(0))
+        state.SkipWithError("Unexpected number of active voices");
+    state.counters["voices"] = synth.getNumActiveVoices();
+    state.counters["batched"] = state.range(2);
+}
+
+static void synthArguments(benchmark::internal::Benchmark* bench)
+{
+    for (int type : { sfz::kFilterLpf2p, sfz::kFilterLpf4p, sfz::kFilterLpf2pSv }) {
+        for (int numVoices : { 16, 64, 128 }) {
+            bench->Args({ numVoices, type, 0 });
+            bench->Args({ numVoices, type, 1 });
+        }
+    }
+}
+
+BENCHMARK_REGISTER_F(SynthFilters, RenderBlock)->Apply(synthArguments)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,41 @@
+// Load time of an instrument with thousands of samples, which finalizeSfzLoad
+// probes and preloads on the loading threads. The samples are written once to
+// a temporary directory, so they are read back from the page cache.
+
+#include "sfizz/Synth.h"
+#include "synthetic_instruments.h"
+#include <benchmark/benchmark.h>
+
+constexpr int kMaxSamples { 5000 };
+
+static void LoadInstrument(benchmark::State& state)
+{
+    const int numSamples = static_cast<int>(state.range(0));
+    const fs::path path = syntheticInstruments("sfizz_load_benchmark").instrument(numSamples);
+
+    bool allPreloaded = false;
+    for (auto _ : state) {
+        state.PauseTiming();
+        {
+            sfz::Synth synth;
+            state.ResumeTiming();
+            synth.loadSfzFile(path);
+            state.PauseTiming();
+            allPreloaded = static_cast<int>(synth.getNumPreloadedSamples()) == numSamples;
+        }
+        state.ResumeTiming();
+
+        if (!allPreloaded) {
+            state.SkipWithError("Some samples were not preloaded");
+            break;
+        }
+    }
+
+    state.counters["samples"] = numSamples;
+    state.counters["samples_per_second"] = benchmark::Counter(
+        static_cast<double>(numSamples) * state.iterations(), benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(LoadInstrument)->Arg(1000)->Arg(kMaxSamples)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
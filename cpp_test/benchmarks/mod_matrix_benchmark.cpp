@@ -0,0 +1,59 @@
+// Time for the modulation matrix to start a cycle and a voice with more and
+// more sources registered, which should not grow with them.
+
+#include "sfizz/modulations/ModGenerator.h"
+#include "sfizz/modulations/ModId.h"
+#include "sfizz/modulations/ModKey.h"
+#include "sfizz/modulations/ModMatrix.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+
+constexpr int kBlockSize { 256 };
+
+class ConstantGenerator : public sfz::ModGenerator {
+public:
+    void init(const sfz::ModKey&, NumericId<sfz::Voice>, unsigned) override {}
+    void generate(const sfz::ModKey&, NumericId<sfz::Voice>, absl::Span<float> buffer) override
+    {
+        std::fill(buffer.begin(), buffer.end(), 1.0f);
+    }
+};
+
+class ModMatrixSources : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        // Half of the sources are controllers, the others belong to the
+        // voices of one region, and all go to the pitch of that region
+        const int numSources = static_cast<int>(state.range(0));
+        matrix.clear();
+        matrix.setSamplesPerBlock(kBlockSize);
+        const auto target = matrix.registerTarget(sfz::ModKey::createNXYZ(sfz::ModId::Pitch, region));
+        for (int i = 0; i < numSources / 2; ++i) {
+            const auto cc = matrix.registerSource(sfz::ModKey::createCC(i, 0, 0, 0.0f), generator);
+            const auto lfo = matrix.registerSource(
+                sfz::ModKey::createNXYZ(sfz::ModId::LFO, region, i % 256, i / 256), generator);
+            matrix.connect(cc, target, 1.0f, {}, 0.0f);
+            matrix.connect(lfo, target, 1.0f, {}, 0.0f);
+        }
+        matrix.init();
+    }
+
+    ConstantGenerator generator;
+    sfz::ModMatrix matrix;
+    const NumericId<sfz::Region> region { 0 };
+};
+
+BENCHMARK_DEFINE_F(ModMatrixSources, BeginCycleAndVoice)(benchmark::State& state)
+{
+    for (auto _ : state) {
+        matrix.beginCycle(kBlockSize);
+        matrix.beginVoice(NumericId<sfz::Voice> { 0 }, region, 0.0f);
+        benchmark::ClobberMemory();
+    }
+    state.counters["sources"] = static_cast<double>(state.range(0));
+}
+
+BENCHMARK_REGISTER_F(ModMatrixSources, BeginCycleAndVoice)->Arg(16)->Arg(256)->Arg(4096);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,91 @@
+// Load time, preloaded memory and block time of an instrument whose samples
+// are upsampled 1, 2, 4 and 8 times as they are preloaded and streamed.
+
+#include "sfizz/Synth.h"
+#include "sfizz/AudioBuffer.h"
+#include "synthetic_instruments.h"
+#include <benchmark/benchmark.h>
+
+constexpr int kNumSamples { 1000 };
+constexpr int kNumNotes { 16 };
+constexpr int kBlockSize { 256 };
+// Short enough for the highest note to stay within its sample
+constexpr int kBlocksPerNote { 8 };
+
+static void LoadOversampled(benchmark::State& state)
+{
+    const auto factor = static_cast<sfz::Oversampling>(state.range(0));
+    const fs::path path = syntheticInstruments("sfizz_oversampling_benchmark").instrument(kNumSamples);
+
+    int preloadedBytes = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        {
+            sfz::Synth synth;
+            synth.setOversamplingFactor(factor);
+            const int bytesBefore = synth.getAllocatedBytes();
+            state.ResumeTiming();
+            synth.loadSfzFile(path);
+            state.PauseTiming();
+            preloadedBytes = synth.getAllocatedBytes() - bytesBefore;
+        }
+        state.ResumeTiming();
+    }
+
+    state.counters["factor"] = static_cast<double>(state.range(0));
+    state.counters["preloaded_bytes"] = benchmark::Counter(
+        preloadedBytes, benchmark::Counter::kDefaults, benchmark::Counter::OneK::kIs1024);
+}
+
+BENCHMARK(LoadOversampled)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+class OversampledVoices : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        synth.setSampleRate(kSampleRate);
+        synth.setSamplesPerBlock(kBlockSize);
+        synth.setOversamplingFactor(static_cast<sfz::Oversampling>(state.range(0)));
+        synth.loadSfzFile(syntheticInstruments("sfizz_oversampling_benchmark").instrument(kNumSamples));
+        // Wait for the streamed frames, so that every run plays the same data
+        synth.enableFreeWheeling();
+    }
+
+    void TearDown(const ::benchmark::State& /*state*/)
+    {
+        synth.allSoundOff();
+    }
+
+    // The samples of velocity 1 on keys above their center, pitched up
+    void startNotes()
+    {
+        synth.allSoundOff();
+        for (int i = 0; i < kNumNotes; ++i)
+            synth.noteOn(0, 60 + i, 1);
+    }
+
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, kBlockSize };
+};
+
+BENCHMARK_DEFINE_F(OversampledVoices, RenderBlock)(benchmark::State& state)
+{
+    int block = 0;
+    for (auto _ : state) {
+        if (block++ % kBlocksPerNote == 0) {
+            state.PauseTiming();
+            startNotes();
+            state.ResumeTiming();
+        }
+        synth.renderBlock(buffer);
+        benchmark::DoNotOptimize(buffer.getSpan(0).data());
+    }
+
+    if (synth.getNumActiveVoices() != kNumNotes)
+        state.SkipWithError("Unexpected number of active voices");
+    state.counters["factor"] = static_cast<double>(state.range(0));
+}
+
+BENCHMARK_REGISTER_F(OversampledVoices, RenderBlock)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,103 @@
+// Load time, resident memory and block time of the synthetic instrument of
+// load_instrument_benchmark, with its samples mapped in memory or read as
+// floats. Freed heap memory stays resident, so the resident memory is only
+// meaningful with one argument per run, e.g. --benchmark_filter=/1/.
+
+#include "sfizz/Synth.h"
+#include "sfizz/AudioBuffer.h"
+#include "synthetic_instruments.h"
+#include <benchmark/benchmark.h>
+
+constexpr int kNumSamples { 5000 };
+constexpr int kNumNotes { 16 };
+constexpr int kBlockSize { 256 };
+// Short enough for the highest note to stay within its sample
+constexpr int kBlocksPerNote { 8 };
+
+static double kibibytes(long value)
+{
+    return static_cast<double>(value) * 1024;
+}
+
+static void LoadMapped(benchmark::State& state)
+{
+    const bool mapped = state.range(0) != 0;
+    const fs::path path = syntheticInstruments("sfizz_mapping_benchmark").instrument(kNumSamples);
+
+    long anonymous = 0;
+    long file = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        {
+            sfz::Synth synth;
+            synth.setSampleMemoryMapping(mapped);
+            const long anonymousBefore = procStatus("RssAnon:");
+            const long fileBefore = procStatus("RssFile:");
+            state.ResumeTiming();
+            synth.loadSfzFile(path);
+            state.PauseTiming();
+            anonymous = procStatus("RssAnon:") - anonymousBefore;
+            file = procStatus("RssFile:") - fileBefore;
+        }
+        state.ResumeTiming();
+    }
+
+    state.counters["mapped"] = mapped;
+    state.counters["resident_anonymous"] = benchmark::Counter(
+        kibibytes(anonymous), benchmark::Counter::kDefaults, benchmark::Counter::OneK::kIs1024);
+    state.counters["resident_file"] = benchmark::Counter(
+        kibibytes(file), benchmark::Counter::kDefaults, benchmark::Counter::OneK::kIs1024);
+}
+
+BENCHMARK(LoadMapped)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+class MappedVoices : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        synth.setSampleRate(kSampleRate);
+        synth.setSamplesPerBlock(kBlockSize);
+        synth.setSampleMemoryMapping(state.range(0) != 0);
+        synth.loadSfzFile(syntheticInstruments("sfizz_mapping_benchmark").instrument(kNumSamples));
+        // Wait for the streamed frames, so that every run plays the same data
+        synth.enableFreeWheeling();
+    }
+
+    void TearDown(const ::benchmark::State& /*state*/)
+    {
+        synth.allSoundOff();
+    }
+
+    // The samples of velocity 1 on keys above their center, pitched up
+    void startNotes()
+    {
+        synth.allSoundOff();
+        for (int i = 0; i < kNumNotes; ++i)
+            synth.noteOn(0, 60 + i, 1);
+    }
+
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, kBlockSize };
+};
+
+BENCHMARK_DEFINE_F(MappedVoices, RenderBlock)(benchmark::State& state)
+{
+    int block = 0;
+    for (auto _ : state) {
+        if (block++ % kBlocksPerNote == 0) {
+            state.PauseTiming();
+            startNotes();
+            state.ResumeTiming();
+        }
+        synth.renderBlock(buffer);
+        benchmark::DoNotOptimize(buffer.getSpan(0).data());
+    }
+
+    if (synth.getNumActiveVoices() != kNumNotes)
+        state.SkipWithError("Unexpected number of active voices");
+    state.counters["mapped"] = state.range(0) != 0;
+}
+
+BENCHMARK_REGISTER_F(MappedVoices, RenderBlock)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
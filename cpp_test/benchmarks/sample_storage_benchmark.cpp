@@ -0,0 +1,123 @@
+// Resident memory and block time of the synthetic instrument of
+// load_instrument_benchmark, with its samples kept as floats or in one of the
+// 16-bit storages. The 16-bit samples are decoded through a window of float
+// frames before they are interpolated, which the block time includes. Freed
+// heap memory stays resident, so the resident memory is only meaningful with
+// one argument per run, e.g. --benchmark_filter=/1/.
+
+#include "sfizz/Synth.h"
+#include "sfizz/AudioBuffer.h"
+#include "synthetic_instruments.h"
+#include <benchmark/benchmark.h>
+
+constexpr int kNumSamples { 5000 };
+constexpr int kNumNotes { 16 };
+constexpr int kBlockSize { 256 };
+// Short enough for the highest note to stay within its sample
+constexpr int kBlocksPerNote { 8 };
+
+static double kibibytes(long value)
+{
+    return static_cast<double>(value) * 1024;
+}
+
+/**
+ * Argument: the sample storage, as its value in sfz::SampleStorage.
+ */
+static void LoadStorage(benchmark::State& state)
+{
+    const auto storage = static_cast<sfz::SampleStorage>(state.range(0));
+    const fs::path path = syntheticInstruments("sfizz_storage_benchmark").instrument(kNumSamples);
+
+    long anonymous = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        {
+            sfz::Synth synth;
+            synth.setSampleStorage(storage);
+            const long anonymousBefore = procStatus("RssAnon:");
+            state.ResumeTiming();
+            synth.loadSfzFile(path);
+            state.PauseTiming();
+            anonymous = procStatus("RssAnon:") - anonymousBefore;
+        }
+        state.ResumeTiming();
+    }
+
+    state.counters["storage"] = state.range(0);
+    state.counters["resident_anonymous"] = benchmark::Counter(
+        kibibytes(anonymous), benchmark::Counter::kDefaults, benchmark::Counter::OneK::kIs1024);
+}
+
+BENCHMARK(LoadStorage)
+    ->Arg(static_cast<int>(sfz::SampleStorage::Float32))
+    ->Arg(static_cast<int>(sfz::SampleStorage::Int16))
+    ->Arg(static_cast<int>(sfz::SampleStorage::Float16))
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+class StorageVoices : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        synth.setSampleRate(kSampleRate);
+        synth.setSamplesPerBlock(kBlockSize);
+        synth.setSampleStorage(static_cast<sfz::SampleStorage>(state.range(0)));
+        synth.setSampleQuality(sfz::Synth::ProcessLive, static_cast<int>(state.range(1)));
+        synth.loadSfzFile(syntheticInstruments("sfizz_storage_benchmark").instrument(kNumSamples));
+        // Wait for the streamed frames, so that every run plays the same data
+        synth.enableFreeWheeling();
+    }
+
+    void TearDown(const ::benchmark::State& /*state*/)
+    {
+        synth.allSoundOff();
+    }
+
+    // The samples of velocity 1 on keys above their center, pitched up
+    void startNotes()
+    {
+        synth.allSoundOff();
+        for (int i = 0; i < kNumNotes; ++i)
+            synth.noteOn(0, 60 + i, 1);
+    }
+
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, kBlockSize };
+};
+
+/**
+ * Arguments: the sample storage, and the sample quality (1 is linear, 3 is
+ * the shortest sinc).
+ */
+BENCHMARK_DEFINE_F(StorageVoices, RenderBlock)(benchmark::State& state)
+{
+    int block = 0;
+    bool silent = true;
+    for (auto _ : state) {
+        if (block++ % kBlocksPerNote == 0) {
+            state.PauseTiming();
+            startNotes();
+            state.ResumeTiming();
+        }
+        synth.renderBlock(buffer);
+        benchmark::DoNotOptimize(buffer.getSpan(0).data());
+        silent = silent && buffer.getSpan(0)[kBlockSize - 1] == 0.0f;
+    }
+
+    if (synth.getNumActiveVoices() != kNumNotes)
+        state.SkipWithError("Unexpected number of active voices");
+    else if (silent)
+        state.SkipWithError("The voices rendered silence");
+    state.counters["storage"] = state.range(0);
+    state.counters["quality"] = state.range(1);
+}
+
+BENCHMARK_REGISTER_F(StorageVoices, RenderBlock)
+    ->Args({ static_cast<int>(sfz::SampleStorage::Float32), 1 })
+    ->Args({ static_cast<int>(sfz::SampleStorage::Int16), 1 })
+    ->Args({ static_cast<int>(sfz::SampleStorage::Float16), 1 })
+    ->Args({ static_cast<int>(sfz::SampleStorage::Float32), 3 })
+    ->Args({ static_cast<int>(sfz::SampleStorage::Int16), 3 })
+    ->Args({ static_cast<int>(sfz::SampleStorage::Float16), 3 });
+
+BENCHMARK_MAIN();
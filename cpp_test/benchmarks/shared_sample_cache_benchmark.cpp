@@ -0,0 +1,55 @@
+// Load time and memory of 10 synths loading the same instrument, with and
+// without the sample cache shared between them, and the threads they start.
+
+#include "sfizz/Synth.h"
+#include "synthetic_instruments.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+constexpr int kNumSamples { 1000 };
+constexpr int kNumSynths { 10 };
+
+static void LoadSynths(benchmark::State& state)
+{
+    const bool shared = state.range(0) != 0;
+    const fs::path path = syntheticInstruments("sfizz_shared_cache_benchmark").instrument(kNumSamples);
+
+    int allocatedBytes = 0;
+    size_t sharedBytes = 0;
+    int threads = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        {
+            const int bytesBefore = sfz::Buffer<float>::counter().getTotalBytes();
+            const int threadsBefore = threadCount();
+
+            std::vector<std::unique_ptr<sfz::Synth>> synths;
+            for (int i = 0; i < kNumSynths; ++i) {
+                synths.emplace_back(new sfz::Synth);
+                synths.back()->setSharedSampleCache(shared);
+            }
+
+            state.ResumeTiming();
+            for (auto& synth : synths)
+                synth->loadSfzFile(path);
+            state.PauseTiming();
+
+            allocatedBytes = sfz::Buffer<float>::counter().getTotalBytes() - bytesBefore;
+            sharedBytes = sfz::Synth::getSharedSampleCacheMemory();
+            threads = threadCount() - threadsBefore;
+        }
+        state.ResumeTiming();
+    }
+
+    state.counters["shared"] = shared;
+    state.counters["allocated_bytes"] = benchmark::Counter(
+        allocatedBytes, benchmark::Counter::kDefaults, benchmark::Counter::OneK::kIs1024);
+    state.counters["shared_cache_bytes"] = benchmark::Counter(
+        static_cast<double>(sharedBytes), benchmark::Counter::kDefaults, benchmark::Counter::OneK::kIs1024);
+    state.counters["threads"] = threads;
+}
+
+BENCHMARK(LoadSynths)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
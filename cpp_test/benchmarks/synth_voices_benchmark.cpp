@@ -0,0 +1,53 @@
+// Block time of Synth::renderBlock with a few, some and all of 256 allocated
+// voices playing. Only the playing voices should cost anything.
+
+#include "sfizz/Synth.h"
+#include "sfizz/AudioBuffer.h"
+#include <benchmark/benchmark.h>
+
+constexpr int kNumVoices { 256 };
+constexpr int kBlockSize { 256 };
+
+class SynthVoices : public benchmark::Fixture {
+public:
+    void SetUp(const ::benchmark::State& state)
+    {
+        synth.setSampleRate(48000.0f);
+        synth.setSamplesPerBlock(kBlockSize);
+        synth.setNumVoices(kNumVoices);
+        synth.loadSfzString("/voices.sfz", R"(
+            <region> sample=*saw ampeg_sustain=100
+        )");
+
+        const int activeVoices = static_cast<int>(state.range(0));
+        for (int i = 0; i < activeVoices; ++i)
+            synth.noteOn(0, 24 + i % 96, 100);
+
+        // Start the voices outside of the timed loop
+        synth.renderBlock(buffer);
+    }
+
+    void TearDown(const ::benchmark::State& /*state*/)
+    {
+        synth.allSoundOff();
+    }
+
+    sfz::Synth synth;
+    sfz::AudioBuffer<float> buffer { 2, kBlockSize };
+};
+
+BENCHMARK_DEFINE_F(SynthVoices, RenderBlock)(benchmark::State& state)
+{
+    for (auto _ : state) {
+        synth.renderBlock(buffer);
+        benchmark::DoNotOptimize(buffer.getSpan(0).data());
+    }
+
+    if (synth.getNumActiveVoices() != state.range(0))
+        state.SkipWithError("Unexpected number of active voices");
+    state.counters["active"] = synth.getNumActiveVoices();
+}
+
+BENCHMARK_REGISTER_F(SynthVoices, RenderBlock)->Arg(4)->Arg(32)->Arg(256);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,129 @@
+// Instruments made of synthetic mono WAV samples, shared by the benchmarks
+// which load SFZ files from disk.
+
+#pragma once
+#include <ghc/fs_std.hpp>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <string>
+
+// Long enough to skip the whole-file silence check, and to be cut at the preload size
+constexpr int kSampleFrames { 10000 };
+constexpr int kSampleRate { 48000 };
+
+inline void writeLE(std::ofstream& file, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+        file.put(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+inline void writeWav(const fs::path& path, float frequency, int numFrames = kSampleFrames)
+{
+    std::ofstream file(path, std::ios::binary);
+    const uint32_t dataSize = numFrames * 2;
+    file.write("RIFF", 4);
+    writeLE(file, 36 + dataSize, 4);
+    file.write("WAVEfmt ", 8);
+    writeLE(file, 16, 4);
+    writeLE(file, 1, 2); // PCM
+    writeLE(file, 1, 2); // mono
+    writeLE(file, kSampleRate, 4);
+    writeLE(file, kSampleRate * 2, 4);
+    writeLE(file, 2, 2);
+    writeLE(file, 16, 2);
+    file.write("data", 4);
+    writeLE(file, dataSize, 4);
+
+    for (int i = 0; i < numFrames; ++i) {
+        const double phase = 2 * M_PI * frequency * i / kSampleRate;
+        writeLE(file, static_cast<uint16_t>(static_cast<int16_t>(16000 * std::sin(phase))), 2);
+    }
+}
+
+/**
+ * Writes WAV files in a temporary directory as they are needed, and one SFZ
+ * file per instrument size with a region for each of its samples. Sample i
+ * plays on key i % 128 at velocity 1 + i / 128. The files are removed at exit.
+ */
+class SyntheticInstruments {
+public:
+    explicit SyntheticInstruments(const std::string& name)
+        : directory(fs::temp_directory_path() / name)
+    {
+        fs::create_directories(directory);
+    }
+
+    ~SyntheticInstruments()
+    {
+        std::error_code ec;
+        fs::remove_all(directory, ec);
+    }
+
+    fs::path instrument(int numSamples)
+    {
+        for (; numWritten < numSamples; ++numWritten)
+            writeWav(directory / samplePath(numWritten), 100.0f + numWritten);
+
+        const fs::path path = directory / ("instrument" + std::to_string(numSamples) + ".sfz");
+        if (!fs::exists(path)) {
+            std::ofstream file(path);
+            for (int i = 0; i < numSamples; ++i) {
+                file << "<region> sample=" << samplePath(i)
+                     << " key=" << i % 128 << " lovel=" << 1 + i / 128 % 127
+                     << " hivel=" << 1 + i / 128 % 127 << '\n';
+            }
+        }
+        return path;
+    }
+
+private:
+    static std::string samplePath(int index)
+    {
+        return "sample" + std::to_string(index) + ".wav";
+    }
+
+    fs::path directory;
+    int numWritten { 0 };
+};
+
+/**
+ * The instruments of a benchmark, in a temporary directory of the given name
+ * which lives until exit.
+ */
+inline SyntheticInstruments& syntheticInstruments(const std::string& name)
+{
+    static std::map<std::string, SyntheticInstruments> instruments;
+    return instruments.try_emplace(name, name).first->second;
+}
+
+/**
+ * A number from /proc/self/status, such as "Threads:" or "RssAnon:" in kB,
+ * or 0 where it is not known.
+ */
+inline long procStatus(const std::string& field)
+{
+#if defined(__linux__)
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    while (status >> key) {
+        if (key == field) {
+            long value = 0;
+            status >> value;
+            return value;
+        }
+        status.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+#endif
+    return 0;
+}
+
+/**
+ * The number of threads of the process, or 0 where it is not known.
+ */
+inline int threadCount()
+{
+    return static_cast<int>(procStatus("Threads:"));
+}
@@ -0,0 +1,73 @@
+// Load time of an instrument made of wavetable regions, whose mipmaps are
+// computed on the loading threads when the cache directory is empty (cold),
+// or read back from the files written by an earlier load (warm).
+
+#include "sfizz/Synth.h"
+#include "synthetic_instruments.h"
+#include <benchmark/benchmark.h>
+#include <fstream>
+#include <string>
+
+constexpr int kMaxWaves { 64 };
+
+/**
+ * An SFZ file next to the synthetic samples, which plays the first numWaves
+ * of them as wavetables.
+ */
+static fs::path wavetableInstrument(int numWaves)
+{
+    const fs::path samples = syntheticInstruments("sfizz_wavetable_benchmark").instrument(numWaves);
+    const fs::path path = samples.parent_path() / ("wavetables" + std::to_string(numWaves) + ".sfz");
+    if (!fs::exists(path)) {
+        std::ofstream file(path);
+        for (int i = 0; i < numWaves; ++i)
+            file << "<region> sample=sample" << i << ".wav oscillator=on key=" << i << '\n';
+    }
+    return path;
+}
+
+/**
+ * Arguments: the number of wavetable regions, and whether the cache is
+ * filled before the timed load (1) or emptied (0).
+ */
+static void LoadWavetables(benchmark::State& state)
+{
+    const int numWaves = static_cast<int>(state.range(0));
+    const bool warm = state.range(1) != 0;
+    const fs::path path = wavetableInstrument(numWaves);
+    const fs::path cacheDirectory = path.parent_path() / "cache";
+
+    bool allLoaded = false;
+    for (auto _ : state) {
+        state.PauseTiming();
+        fs::remove_all(cacheDirectory);
+        fs::create_directories(cacheDirectory);
+        if (warm) {
+            sfz::Synth synth;
+            synth.setInstrumentCacheDirectory(cacheDirectory);
+            synth.loadSfzFile(path);
+        }
+        {
+            sfz::Synth synth;
+            synth.setInstrumentCacheDirectory(cacheDirectory);
+            state.ResumeTiming();
+            synth.loadSfzFile(path);
+            state.PauseTiming();
+            allLoaded = synth.getNumRegions() == numWaves;
+        }
+        state.ResumeTiming();
+
+        if (!allLoaded) {
+            state.SkipWithError("Some wavetable regions were not loaded");
+            break;
+        }
+    }
+
+    state.counters["waves"] = numWaves;
+}
+
+BENCHMARK(LoadWavetables)
+    ->Args({ 8, 0 })->Args({ 8, 1 })->Args({ kMaxWaves, 0 })->Args({ kMaxWaves, 1 })
+    ->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,18 @@
+// Stands in for the NDK's log.h, so that Android engine code which logs can be
+// benchmarked on the host. Messages go to stderr.
+
+#pragma once
+#include <cstdio>
+
+enum {
+    ANDROID_LOG_INFO = 4,
+    ANDROID_LOG_ERROR = 6,
+};
+
+template <typename... Args>
+inline int __android_log_print(int /*priority*/, const char* tag, const char* format, Args... args)
+{
+    std::fprintf(stderr, "%s: ", tag);
+    std::fprintf(stderr, format, args...);
+    return std::fputc('\n', stderr);
+}
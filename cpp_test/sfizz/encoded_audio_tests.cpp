@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "EncodedAudio.h"
+
+using namespace sfz;
+
+// A mono span over samples encoded in one of the 16-bit storages
+EncodedAudioSpan monoSpan(const std::vector<uint16_t>& encoded, SampleStorage storage) {
+    EncodedAudioSpan span;
+    span.format = storage == SampleStorage::Float16 ? SampleFormat::Float16 : SampleFormat::Int16;
+    span.numChannels = 1;
+    span.numFrames = encoded.size();
+    span.frameStride = sizeof(uint16_t);
+    span.channels[0] = reinterpret_cast<const uint8_t*>(encoded.data());
+    return span;
+}
+
+std::vector<uint16_t> encode(SampleStorage storage, const std::vector<float>& input) {
+    std::vector<uint16_t> encoded(input.size());
+    encodeSamples(storage, input, absl::MakeSpan(encoded));
+    return encoded;
+}
+
+const std::vector<float> kSamples = { 0.0f, 0.5f, -0.5f, 0.25f, -1.0f, 0.999f, 0.001f, -0.125f };
+
+TEST(EncodedAudioTest, Int16RoundTrip) {
+    auto encoded = encode(SampleStorage::Int16, kSamples);
+    auto span = monoSpan(encoded, SampleStorage::Int16);
+
+    std::vector<float> output(kSamples.size());
+    span.read(0, 0, absl::MakeSpan(output));
+
+    for (size_t i = 0; i < kSamples.size(); i++) {
+        EXPECT_NEAR(output[i], kSamples[i], 0.5f / 32768.0f);
+    }
+}
+
+TEST(EncodedAudioTest, Int16Saturates) {
+    auto encoded = encode(SampleStorage::Int16, { 1.0f, 2.0f, -2.0f });
+    auto span = monoSpan(encoded, SampleStorage::Int16);
+
+    std::vector<float> output(3);
+    span.read(0, 0, absl::MakeSpan(output));
+
+    EXPECT_FLOAT_EQ(output[0], 32767.0f / 32768.0f);
+    EXPECT_FLOAT_EQ(output[1], 32767.0f / 32768.0f);
+    EXPECT_FLOAT_EQ(output[2], -1.0f);
+}
+
+TEST(EncodedAudioTest, Float16RoundTrip) {
+    auto encoded = encode(SampleStorage::Float16, kSamples);
+    auto span = monoSpan(encoded, SampleStorage::Float16);
+
+    std::vector<float> output(kSamples.size());
+    span.read(0, 0, absl::MakeSpan(output));
+
+    // Halves keep 11 significant bits
+    for (size_t i = 0; i < kSamples.size(); i++) {
+        EXPECT_NEAR(output[i], kSamples[i], std::abs(kSamples[i]) / 2048.0f);
+    }
+}
+
+TEST(EncodedAudioTest, Float16KeepsQuietSamples) {
+    const std::vector<float> quiet = { 1e-5f, -3e-6f, 6e-8f };
+    auto encoded = encode(SampleStorage::Float16, quiet);
+    auto span = monoSpan(encoded, SampleStorage::Float16);
+
+    std::vector<float> output(quiet.size());
+    span.read(0, 0, absl::MakeSpan(output));
+
+    // Subnormal halves are in units of 2^-24
+    for (size_t i = 0; i < quiet.size(); i++) {
+        EXPECT_NEAR(output[i], quiet[i], 0.5f / 16777216.0f);
+    }
+}
+
+TEST(EncodedAudioTest, ReadsFromAFrameOn) {
+    auto encoded = encode(SampleStorage::Int16, kSamples);
+    auto span = monoSpan(encoded, SampleStorage::Int16);
+
+    std::vector<float> output(3);
+    span.read(0, 2, absl::MakeSpan(output));
+
+    EXPECT_FLOAT_EQ(output[0], -0.5f);
+    EXPECT_FLOAT_EQ(output[1], 0.25f);
+    EXPECT_FLOAT_EQ(output[2], -1.0f);
+}
+
+TEST(EncodedAudioTest, PadsAroundTheSpan) {
+    auto encoded = encode(SampleStorage::Int16, { 0.5f, 0.25f });
+    auto span = monoSpan(encoded, SampleStorage::Int16);
+
+    std::vector<float> output(6, 1.0f);
+    span.read(0, -2, absl::MakeSpan(output));
+
+    EXPECT_EQ(output, std::vector<float>({ 0.0f, 0.0f, 0.5f, 0.25f, 0.0f, 0.0f }));
+}
+
+// The output is a window into a larger buffer, whose guards must stay untouched
+class EncodedAudioReadTest : public ::testing::Test {
+protected:
+    static constexpr size_t kGuard = 64;
+    static constexpr size_t kOutputSize = 10;
+    static constexpr float kGuardValue = 7.0f;
+
+    EncodedAudioReadTest()
+        : encoded(encode(SampleStorage::Int16, kSamples)),
+          span(monoSpan(encoded, SampleStorage::Int16)),
+          buffer(kGuard + kOutputSize + kGuard, kGuardValue) {}
+
+    absl::Span<float> output() {
+        return absl::MakeSpan(buffer.data() + kGuard, kOutputSize);
+    }
+
+    void expectGuardsUntouched() {
+        for (size_t i = 0; i < kGuard; i++) {
+            EXPECT_EQ(buffer[i], kGuardValue);
+            EXPECT_EQ(buffer[kGuard + kOutputSize + i], kGuardValue);
+        }
+    }
+
+    void expectOutputSilent() {
+        for (float sample : output()) {
+            EXPECT_EQ(sample, 0.0f);
+        }
+    }
+
+    std::vector<uint16_t> encoded;
+    EncodedAudioSpan span;
+    std::vector<float> buffer;
+};
+
+TEST_F(EncodedAudioReadTest, OutputBeforeTheSpan) {
+    span.read(0, -100, output());
+
+    expectOutputSilent();
+    expectGuardsUntouched();
+}
+
+TEST_F(EncodedAudioReadTest, OutputAfterTheSpan) {
+    span.read(0, static_cast<int64_t>(kSamples.size()) + 20, output());
+
+    expectOutputSilent();
+    expectGuardsUntouched();
+}
+
+TEST_F(EncodedAudioReadTest, OutputRightAfterTheSpan) {
+    span.read(0, static_cast<int64_t>(kSamples.size()), output());
+
+    expectOutputSilent();
+    expectGuardsUntouched();
+}
+
+TEST_F(EncodedAudioReadTest, OutputLargerThanTheSpan) {
+    span.read(0, -1, output());
+
+    EXPECT_EQ(output()[0], 0.0f);
+    for (size_t i = 0; i < kSamples.size(); i++) {
+        EXPECT_NEAR(output()[i + 1], kSamples[i], 0.5f / 32768.0f);
+    }
+    EXPECT_EQ(output()[kOutputSize - 1], 0.0f);
+    expectGuardsUntouched();
+}
+
+TEST_F(EncodedAudioReadTest, MissingChannel) {
+    span.read(1, 0, output());
+
+    expectOutputSilent();
+    expectGuardsUntouched();
+}
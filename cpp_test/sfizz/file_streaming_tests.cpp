@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AudioReader.h"
+#include "FilePool.h"
+
+using namespace sfz;
+
+// Not a multiple of the streaming chunk size, so that the last chunk is short
+constexpr int kFileFrames { 5000 };
+
+const AudioReaderType kReaderTypes[] = {
+    AudioReaderType::Forward, AudioReaderType::Reverse, AudioReaderType::NoSeekReverse
+};
+
+using Channels = std::vector<std::vector<float>>;
+
+// Writes 16-bit PCM files whose frames all differ, then compares what the
+// loading threads stream with a full decode of the file from its first frame
+class FileStreamingTest : public ::testing::Test {
+protected:
+    FileStreamingTest() {
+        directory = fs::temp_directory_path() / ("file_streaming_test_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed())
+            + "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        fs::remove_all(directory);
+        fs::create_directories(directory);
+
+        writeWav("mono.wav", 1, 0);
+        writeWav("stereo.wav", 2, 1);
+    }
+
+    ~FileStreamingTest() override {
+        fs::remove_all(directory);
+    }
+
+    void writeWav(const std::string& name, int channels, int seed) {
+        std::ofstream file((directory / name).string(), std::ios::binary | std::ios::trunc);
+        auto write = [&file](uint32_t value, int bytes) {
+            for (int i = 0; i < bytes; ++i)
+                file.put(static_cast<char>((value >> (8 * i)) & 0xff));
+        };
+
+        const uint32_t dataSize = kFileFrames * channels * 2;
+        file.write("RIFF", 4);
+        write(36 + dataSize, 4);
+        file.write("WAVEfmt ", 8);
+        write(16, 4);
+        write(1, 2); // PCM
+        write(channels, 2);
+        write(48000, 4);
+        write(48000 * channels * 2, 4);
+        write(channels * 2, 2);
+        write(16, 2);
+        file.write("data", 4);
+        write(dataSize, 4);
+
+        for (int i = 0; i < kFileFrames; ++i) {
+            for (int c = 0; c < channels; ++c)
+                write(static_cast<uint16_t>((i * 7 + c * 1000 + seed * 333) % 30000 - 15000), 2);
+        }
+    }
+
+    AudioReaderPtr reader(const std::string& name, AudioReaderType type) {
+        std::error_code ec;
+        AudioReaderPtr reader = createExplicitAudioReader(directory / name, type, &ec);
+        EXPECT_FALSE(ec);
+        return reader;
+    }
+
+    // All the frames of the file, read at once from the first one
+    Channels fullDecode(const std::string& name, AudioReaderType type) {
+        AudioReaderPtr fileReader = reader(name, type);
+        const unsigned numChannels = fileReader->channels();
+        std::vector<float> interleaved(kFileFrames * numChannels);
+        EXPECT_EQ(fileReader->readNextBlock(interleaved.data(), kFileFrames), static_cast<size_t>(kFileFrames));
+
+        Channels channels(numChannels, std::vector<float>(kFileFrames));
+        for (int i = 0; i < kFileFrames; ++i) {
+            for (unsigned c = 0; c < numChannels; ++c)
+                channels[c][i] = interleaved[i * numChannels + c];
+        }
+        return channels;
+    }
+
+    // Streams a file after preloading frames from another one, the same way
+    // the pool does it with two readers
+    Channels stream(const std::string& name, AudioReaderType type, uint32_t preloadFrames, const std::string& preloadName = {}) {
+        AudioReaderPtr preloadReader = reader(preloadName.empty() ? name : preloadName, type);
+        const FileAudioBuffer preloaded = readFromFile(*preloadReader, preloadFrames, Oversampling::x1);
+
+        AudioReaderPtr streamReader = reader(name, type);
+        FileAudioBuffer output;
+        std::atomic<size_t> filledFrames { 0 };
+        streamFromFile(*streamReader, preloaded, output, &filledFrames, Oversampling::x1);
+        EXPECT_EQ(filledFrames.load(), static_cast<size_t>(kFileFrames));
+        return channels(output);
+    }
+
+    static Channels channels(AudioSpan<const float> data) {
+        Channels channels;
+        for (size_t c = 0; c < data.getNumChannels(); ++c) {
+            const auto span = data.getConstSpan(c);
+            channels.emplace_back(span.begin(), span.end());
+        }
+        return channels;
+    }
+
+    fs::path directory;
+};
+
+TEST_F(FileStreamingTest, StreamedFramesEqualFullDecode) {
+    for (AudioReaderType type : kReaderTypes) {
+        SCOPED_TRACE(static_cast<int>(type));
+        const Channels expected = fullDecode("stereo.wav", type);
+        // Nothing preloaded, within the first chunk, on a chunk boundary, and further
+        for (uint32_t preloadFrames : { 0, 100, 1024, 3000 }) {
+            SCOPED_TRACE(preloadFrames);
+            EXPECT_EQ(stream("stereo.wav", type, preloadFrames), expected);
+        }
+    }
+}
+
+TEST_F(FileStreamingTest, MonoStreamedFramesEqualFullDecode) {
+    for (AudioReaderType type : kReaderTypes) {
+        SCOPED_TRACE(static_cast<int>(type));
+        EXPECT_EQ(stream("mono.wav", type, 1500), fullDecode("mono.wav", type));
+    }
+}
+
+TEST_F(FileStreamingTest, PreloadLongerThanFile) {
+    for (AudioReaderType type : kReaderTypes) {
+        SCOPED_TRACE(static_cast<int>(type));
+        EXPECT_EQ(stream("stereo.wav", type, kFileFrames), fullDecode("stereo.wav", type));
+        EXPECT_EQ(stream("stereo.wav", type, kFileFrames + 500), fullDecode("stereo.wav", type));
+    }
+}
+
+TEST_F(FileStreamingTest, ChannelMismatchStreamsFromStart) {
+    // The mono frames differ from the stereo ones, so copying them would show
+    for (AudioReaderType type : kReaderTypes) {
+        SCOPED_TRACE(static_cast<int>(type));
+        EXPECT_EQ(stream("stereo.wav", type, 2000, "mono.wav"), fullDecode("stereo.wav", type));
+    }
+}
+
+TEST_F(FileStreamingTest, CompactStreamedFramesEqualFullDecode) {
+    for (AudioReaderType type : { AudioReaderType::Forward, AudioReaderType::Reverse }) {
+        SCOPED_TRACE(static_cast<int>(type));
+        AudioReaderPtr preloadReader = reader("stereo.wav", type);
+        const CompactAudioBuffer preloaded = compactFromFile(*preloadReader, 1500, SampleStorage::Int16);
+
+        AudioReaderPtr streamReader = reader("stereo.wav", type);
+        CompactAudioBuffer output;
+        std::atomic<size_t> filledFrames { 0 };
+        streamFromFile(*streamReader, preloaded, output, &filledFrames, SampleStorage::Int16);
+        ASSERT_EQ(filledFrames.load(), static_cast<size_t>(kFileFrames));
+
+        const Channels expected = fullDecode("stereo.wav", type);
+        for (size_t c = 0; c < expected.size(); ++c) {
+            std::vector<uint16_t> encoded(kFileFrames);
+            encodeSamples(SampleStorage::Int16, expected[c], absl::MakeSpan(encoded));
+            const auto streamed = output.getConstSpan(c);
+            EXPECT_EQ(std::vector<uint16_t>(streamed.begin(), streamed.end()), encoded);
+        }
+    }
+}
+
+TEST_F(FileStreamingTest, PoolStreamsPastPreloadedFrames) {
+    FilePool pool;
+    pool.setRootDirectory(directory);
+    pool.setPreloadSize(1000);
+
+    for (bool reverse : { false, true }) {
+        SCOPED_TRACE(reverse);
+        auto fileId = std::make_shared<FileId>("stereo.wav", reverse);
+        ASSERT_TRUE(pool.preloadFile(*fileId, 0));
+
+        FileDataHolder holder = pool.getFilePromise(fileId);
+        ASSERT_TRUE(holder);
+        pool.waitForBackgroundLoading();
+
+        const auto data = holder->getData();
+        ASSERT_EQ(data.getNumFrames(), static_cast<size_t>(kFileFrames));
+        EXPECT_EQ(channels(data),
+            fullDecode("stereo.wav", reverse ? AudioReaderType::Reverse : AudioReaderType::Forward));
+    }
+}
@@ -0,0 +1,351 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "AudioBuffer.h"
+#include "Config.h"
+#include "FilterBatch.h"
+#include "SfzFilter.h"
+#include "Synth.h"
+
+using namespace sfz;
+
+constexpr double kSampleRate = 48000.0;
+constexpr unsigned kBlockSize = 256;
+constexpr unsigned kNumBlocks = 8;
+
+const FilterType kBatchedTypes[] = {
+    kFilterLpf2p, kFilterLpf4p, kFilterLpf6p,
+    kFilterHpf2p, kFilterHpf4p, kFilterHpf6p,
+    kFilterBpf2p, kFilterBpf4p, kFilterBpf6p,
+    kFilterBrf2p, kFilterPeq, kFilterLsh, kFilterHsh,
+    kFilterLpf2pSv, kFilterHpf2pSv, kFilterBpf2pSv, kFilterBrf2pSv,
+};
+
+// The values at the start of each control interval, as the batch takes them
+std::vector<float> perInterval(const std::vector<float>& values)
+{
+    std::vector<float> controls;
+    for (size_t i = 0; i < values.size(); i += config::filterControlInterval)
+        controls.push_back(values[i]);
+    return controls;
+}
+
+// Parameters of one voice over a block, which sweep when modulated
+struct VoiceParameters {
+    std::vector<float> cutoff;
+    std::vector<float> q;
+    std::vector<float> pksh;
+    std::vector<float> cutoffControls;
+    std::vector<float> qControls;
+    std::vector<float> pkshControls;
+
+    VoiceParameters(unsigned voice, unsigned block, bool modulated)
+        : cutoff(kBlockSize), q(kBlockSize), pksh(kBlockSize)
+    {
+        for (unsigned i = 0; i < kBlockSize; ++i) {
+            const float t = modulated ? float(block * kBlockSize + i) / (kNumBlocks * kBlockSize) : 0.0f;
+            cutoff[i] = (200.0f + 100.0f * voice) * std::exp2(3.0f * t);
+            q[i] = -3.0f + 0.5f * voice + 6.0f * t;
+            pksh[i] = -6.0f + 1.5f * voice - 10.0f * t;
+        }
+        cutoffControls = perInterval(cutoff);
+        qControls = perInterval(q);
+        pkshControls = perInterval(pksh);
+    }
+};
+
+// A different noisy input per voice and channel
+std::vector<float> makeInput(unsigned seed)
+{
+    std::vector<float> input(kBlockSize * kNumBlocks);
+    uint32_t state = 0x9e3779b9u * (seed + 1);
+    for (float& x : input) {
+        state = state * 1664525u + 1013904223u;
+        x = float(int32_t(state)) / 2147483648.0f;
+    }
+    return input;
+}
+
+/**
+ * Runs numVoices filters of a type through a FilterBatch and through one
+ * Filter each, and returns the largest difference between their outputs.
+ */
+float maxBatchError(FilterType type, unsigned channels, unsigned numVoices, bool modulated, unsigned maxLaneWidth)
+{
+    FilterBatch batch { maxLaneWidth };
+    batch.init(kSampleRate);
+    batch.reserve(type, numVoices * channels);
+
+    std::vector<std::unique_ptr<Filter>> filters;
+    std::vector<int> ids;
+    std::vector<std::vector<float>> inputs;
+    for (unsigned v = 0; v < numVoices; ++v) {
+        const VoiceParameters first { v, 0, modulated };
+        filters.emplace_back(new Filter);
+        Filter& filter = *filters.back();
+        filter.init(kSampleRate);
+        filter.setType(type);
+        filter.setChannels(channels);
+        filter.prepare(first.cutoff[0], first.q[0], first.pksh[0]);
+
+        ids.push_back(batch.addFilter(type, channels));
+        EXPECT_GE(ids.back(), 0);
+        for (unsigned c = 0; c < channels; ++c)
+            inputs.push_back(makeInput(v * 2 + c));
+    }
+
+    float maxError = 0.0f;
+    std::vector<float> expected(kBlockSize * 2);
+    std::vector<std::vector<float>> outputs(numVoices, std::vector<float>(kBlockSize * 2));
+    std::vector<VoiceParameters> parameters;
+
+    for (unsigned b = 0; b < kNumBlocks; ++b) {
+        parameters.clear();
+        for (unsigned v = 0; v < numVoices; ++v) {
+            parameters.emplace_back(v, b, modulated);
+            const VoiceParameters& p = parameters.back();
+            const float* in[2] = { inputs[v * channels].data() + b * kBlockSize,
+                inputs[v * channels + channels - 1].data() + b * kBlockSize };
+            float* out[2] = { outputs[v].data(), outputs[v].data() + kBlockSize };
+            batch.setBuffers(ids[v], in, out);
+            if (modulated)
+                batch.setModulatedParameters(ids[v], p.cutoffControls.data(), p.qControls.data(), p.pkshControls.data());
+            else
+                batch.setParameters(ids[v], p.cutoff[0], p.q[0], p.pksh[0]);
+        }
+
+        batch.process(kBlockSize);
+
+        for (unsigned v = 0; v < numVoices; ++v) {
+            const VoiceParameters& p = parameters[v];
+            const float* in[2] = { inputs[v * channels].data() + b * kBlockSize,
+                inputs[v * channels + channels - 1].data() + b * kBlockSize };
+            float* out[2] = { expected.data(), expected.data() + kBlockSize };
+            filters[v]->processModulated(in, out, p.cutoff.data(), p.q.data(), p.pksh.data(), kBlockSize);
+            for (unsigned i = 0; i < kBlockSize * channels; ++i)
+                maxError = std::max(maxError, std::abs(outputs[v][i] - expected[i]));
+        }
+    }
+
+    return maxError;
+}
+
+// The batch runs in single precision where the faust filters use double, and
+// the resonant and cascaded filters build up the rounding over the recursion,
+// so allow -60 dB on unit level noise
+constexpr float kTolerance = 1e-3f;
+
+TEST(FilterBatchTest, SupportsBiquadsAndStateVariableFilters) {
+    for (FilterType type : kBatchedTypes)
+        EXPECT_TRUE(FilterBatch::supportsType(type)) << type;
+    EXPECT_FALSE(FilterBatch::supportsType(kFilterNone));
+    EXPECT_FALSE(FilterBatch::supportsType(kFilterLpf1p));
+    EXPECT_FALSE(FilterBatch::supportsType(kFilterApf1p));
+    EXPECT_FALSE(FilterBatch::supportsType(kFilterPink));
+
+    FilterBatch batch;
+    batch.reserve(kFilterLpf1p, 1);
+    EXPECT_EQ(batch.addFilter(kFilterLpf1p, 1), -1);
+    EXPECT_EQ(batch.numFilters(), 0u);
+}
+
+TEST(FilterBatchTest, AddsFiltersInTheReservedLanesOnly) {
+    FilterBatch batch;
+    batch.init(kSampleRate);
+    EXPECT_EQ(batch.addFilter(kFilterLpf2p, 1), -1);
+
+    batch.reserve(kFilterLpf2p, 3);
+    const int stereo = batch.addFilter(kFilterLpf2p, 2);
+    EXPECT_GE(stereo, 0);
+    EXPECT_EQ(batch.addFilter(kFilterLpf2p, 2), -1);
+    EXPECT_GE(batch.addFilter(kFilterLpf2p, 1), 0);
+    EXPECT_EQ(batch.addFilter(kFilterLpf2p, 1), -1);
+    EXPECT_EQ(batch.addFilter(kFilterHpf2p, 1), -1);
+
+    // The lanes of a removed filter are free again, and a reserve never shrinks
+    batch.removeFilter(stereo);
+    batch.reserve(kFilterLpf2p, 1);
+    EXPECT_GE(batch.addFilter(kFilterLpf2p, 2), 0);
+    EXPECT_EQ(batch.numFilters(), 2u);
+}
+
+TEST(FilterBatchTest, MatchesFilterWithConstantParameters) {
+    for (unsigned width : { 4u, 8u }) {
+        for (FilterType type : kBatchedTypes) {
+            EXPECT_LT(maxBatchError(type, 1, 5, false, width), kTolerance) << "type " << type << " width " << width;
+            EXPECT_LT(maxBatchError(type, 2, 5, false, width), kTolerance) << "type " << type << " width " << width;
+        }
+    }
+}
+
+TEST(FilterBatchTest, MatchesFilterWithModulatedParameters) {
+    for (unsigned width : { 4u, 8u }) {
+        for (FilterType type : kBatchedTypes) {
+            EXPECT_LT(maxBatchError(type, 1, 9, true, width), kTolerance) << "type " << type << " width " << width;
+            EXPECT_LT(maxBatchError(type, 2, 9, true, width), kTolerance) << "type " << type << " width " << width;
+        }
+    }
+}
+
+TEST(FilterBatchTest, KeepsStateWhenOtherFiltersAreRemoved) {
+    FilterBatch batch { 4 };
+    batch.init(kSampleRate);
+    batch.reserve(kFilterLpf2p, 9);
+
+    Filter reference;
+    reference.init(kSampleRate);
+    reference.setType(kFilterLpf2p);
+    reference.setChannels(2);
+    reference.prepare(800.0f, 3.0f, 0.0f);
+
+    // Fill the first lanes so that the filter under test moves on removal
+    std::vector<int> others;
+    for (unsigned i = 0; i < 5; ++i)
+        others.push_back(batch.addFilter(kFilterLpf2p, 1));
+    const int id = batch.addFilter(kFilterLpf2p, 2);
+
+    const std::vector<float> left = makeInput(0);
+    const std::vector<float> right = makeInput(1);
+    std::vector<float> output(kBlockSize * 2);
+    std::vector<float> expected(kBlockSize * 2);
+
+    float maxError = 0.0f;
+    for (unsigned b = 0; b < kNumBlocks; ++b) {
+        if (b == 2) {
+            batch.removeFilter(others[0]);
+            batch.removeFilter(others[3]);
+        }
+        if (b == 4)
+            others.push_back(batch.addFilter(kFilterLpf2p, 2));
+
+        const float* in[2] = { left.data() + b * kBlockSize, right.data() + b * kBlockSize };
+        float* out[2] = { output.data(), output.data() + kBlockSize };
+        batch.setBuffers(id, in, out);
+        batch.setParameters(id, 800.0f, 3.0f, 0.0f);
+        for (int other : others)
+            batch.setParameters(other, 5000.0f, 0.0f, 0.0f);
+        batch.process(kBlockSize);
+
+        float* ref[2] = { expected.data(), expected.data() + kBlockSize };
+        reference.process(in, ref, 800.0f, 3.0f, 0.0f, kBlockSize);
+        for (unsigned i = 0; i < kBlockSize * 2; ++i)
+            maxError = std::max(maxError, std::abs(output[i] - expected[i]));
+    }
+
+    EXPECT_LT(maxError, kTolerance);
+    EXPECT_EQ(batch.numFilters(), 5u);
+}
+
+TEST(FilterBatchTest, ClearResetsTheFilter) {
+    FilterBatch batch;
+    batch.init(kSampleRate);
+    batch.reserve(kFilterLpf2pSv, 1);
+    const int id = batch.addFilter(kFilterLpf2pSv, 1);
+
+    const std::vector<float> input = makeInput(0);
+    std::vector<float> first(kBlockSize);
+    std::vector<float> second(kBlockSize);
+
+    const float* in[1] = { input.data() };
+    float* out[1] = { first.data() };
+    batch.setBuffers(id, in, out);
+    batch.setParameters(id, 1000.0f, 0.0f, 0.0f);
+    batch.process(kBlockSize);
+
+    batch.clear(id);
+    out[0] = second.data();
+    batch.setBuffers(id, in, out);
+    batch.setParameters(id, 1000.0f, 0.0f, 0.0f);
+    batch.process(kBlockSize);
+
+    for (unsigned i = 0; i < kBlockSize; ++i)
+        EXPECT_EQ(first[i], second[i]);
+}
+
+TEST(FilterBatchTest, MatchesFilterOnUnevenBlocks) {
+    FilterBatch batch;
+    batch.init(kSampleRate);
+
+    Filter reference;
+    reference.init(kSampleRate);
+    reference.setType(kFilterBpf4p);
+    reference.setChannels(1);
+    reference.prepare(1200.0f, 6.0f, 0.0f);
+
+    // Fewer lanes than a lane set, so some lanes have no buffers
+    batch.reserve(kFilterBpf4p, 3);
+    const int id = batch.addFilter(kFilterBpf4p, 1);
+    batch.addFilter(kFilterBpf4p, 2);
+
+    const std::vector<float> input = makeInput(0);
+    std::vector<float> output(input.size());
+    std::vector<float> expected(input.size());
+
+    unsigned frame = 0;
+    for (unsigned nframes : { 1u, 37u, 3u, 16u, 250u, 17u }) {
+        const float* in[1] = { input.data() + frame };
+        float* out[1] = { output.data() + frame };
+        batch.setBuffers(id, in, out);
+        batch.setParameters(id, 1200.0f, 6.0f, 0.0f);
+        batch.process(nframes);
+
+        float* ref[1] = { expected.data() + frame };
+        reference.process(in, ref, 1200.0f, 6.0f, 0.0f, nframes);
+        frame += nframes;
+    }
+
+    float maxError = 0.0f;
+    for (unsigned i = 0; i < frame; ++i)
+        maxError = std::max(maxError, std::abs(output[i] - expected[i]));
+    EXPECT_LT(maxError, kTolerance);
+}
+
+// Renders notes with modulated filters, cutoffs and pans on every voice
+std::vector<float> renderFilteredVoices(bool filterBatching, const std::string& filter)
+{
+    Synth synth;
+    synth.setSampleRate(float(kSampleRate));
+    synth.setSamplesPerBlock(kBlockSize);
+    synth.setFilterBatching(filterBatching);
+    synth.loadSfzString("/filters.sfz", R"(
+        <region> sample=*saw key=60 ampeg_sustain=100 )" + filter + R"(
+            fileg_attack=0.01 fileg_decay=0.02 fileg_depth=2400
+            lfo1_freq=3 lfo1_cutoff2=600 lfo1_pan=40
+        <region> sample=*saw key=62 ampeg_sustain=100 )" + filter + R"(
+            fil2_type=hpf_2p cutoff2=300 lfo1_freq=5 lfo1_cutoff=-1200
+    )");
+
+    AudioBuffer<float> buffer { 2, kBlockSize };
+    std::vector<float> output;
+    for (unsigned b = 0; b < kNumBlocks; ++b) {
+        if (b == 0 || b == 3) {
+            synth.noteOn(0, 60, 100);
+            synth.noteOn(0, 62, 80);
+        }
+        if (b == 5)
+            synth.noteOff(0, 60, 0);
+        synth.renderBlock(buffer);
+        for (unsigned c = 0; c < 2; ++c)
+            output.insert(output.end(), buffer.getSpan(c).begin(), buffer.getSpan(c).end());
+    }
+    return output;
+}
+
+TEST(FilterBatchTest, SynthOutputMatchesPerVoiceFilters) {
+    for (const std::string filter : { "fil_type=lpf_2p cutoff=800 resonance=6",
+             "fil_type=bpf_2p_sv cutoff=1200 resonance=3" }) {
+        const std::vector<float> batched = renderFilteredVoices(true, filter);
+        const std::vector<float> perVoice = renderFilteredVoices(false, filter);
+        ASSERT_EQ(batched.size(), perVoice.size());
+
+        float maxError = 0.0f;
+        float maxLevel = 0.0f;
+        for (size_t i = 0; i < batched.size(); ++i) {
+            maxError = std::max(maxError, std::abs(batched[i] - perVoice[i]));
+            maxLevel = std::max(maxLevel, std::abs(perVoice[i]));
+        }
+        EXPECT_GT(maxLevel, 0.01f) << filter;
+        EXPECT_LT(maxError, kTolerance) << filter;
+    }
+}
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "modulations/ModGenerator.h"
+#include "modulations/ModId.h"
+#include "modulations/ModKey.h"
+#include "modulations/ModMatrix.h"
+
+using namespace sfz;
+
+constexpr unsigned kNumFrames = 16;
+const NumericId<Region> kRegion { 0 };
+
+// Fills the cycle with `value` plus the voice number, or with a ramp from
+// there when `ramp` is set, and counts the generated cycles
+class TestGenerator : public ModGenerator {
+public:
+    explicit TestGenerator(float value, bool ramp = false)
+        : value(value), ramp(ramp) {}
+
+    void init(const ModKey&, NumericId<Voice>, unsigned) override {}
+
+    void generate(const ModKey&, NumericId<Voice> voiceId, absl::Span<float> buffer) override
+    {
+        const float start = value + (voiceId.valid() ? voiceId.number() : 0);
+        for (size_t i = 0; i < buffer.size(); ++i)
+            buffer[i] = ramp ? start + i : start;
+        generated++;
+    }
+
+    float value;
+    bool ramp;
+    int generated = 0;
+};
+
+class ModMatrixTest : public ::testing::Test {
+protected:
+    ModMatrixTest()
+    {
+        matrix.setSamplesPerBlock(kNumFrames);
+    }
+
+    ModMatrix::SourceId voiceSource(TestGenerator& gen, uint8_t number)
+    {
+        return matrix.registerSource(ModKey::createNXYZ(ModId::Envelope, kRegion, number), gen);
+    }
+
+    ModMatrix::SourceId globalSource(TestGenerator& gen, uint16_t cc)
+    {
+        return matrix.registerSource(ModKey::createCC(cc, 0, 0, 0.0f), gen);
+    }
+
+    ModMatrix::TargetId target(ModId id)
+    {
+        return matrix.registerTarget(ModKey::createNXYZ(id, kRegion));
+    }
+
+    std::vector<float> modulation(ModMatrix::TargetId id)
+    {
+        const float* data = matrix.getModulation(id);
+        return data ? std::vector<float>(data, data + kNumFrames) : std::vector<float>();
+    }
+
+    static std::vector<float> constant(float value)
+    {
+        return std::vector<float>(kNumFrames, value);
+    }
+
+    static std::vector<float> ramp(float start, float depth = 1.0f)
+    {
+        std::vector<float> values(kNumFrames);
+        for (unsigned i = 0; i < kNumFrames; ++i)
+            values[i] = depth * (start + i);
+        return values;
+    }
+
+    ModMatrix matrix;
+};
+
+TEST_F(ModMatrixTest, ConstantAndRampedSourcesAcrossCyclesAndVoices)
+{
+    TestGenerator constantGen { 10.0f };
+    TestGenerator rampGen { 100.0f, true };
+    const auto pitch = target(ModId::Pitch);
+    const auto volume = target(ModId::Volume);
+    ASSERT_TRUE(matrix.connect(voiceSource(constantGen, 1), pitch, 2.0f, {}, 0.0f));
+    ASSERT_TRUE(matrix.connect(voiceSource(rampGen, 2), volume, 1.0f, {}, 0.0f));
+    matrix.init();
+
+    for (int cycle = 0; cycle < 2; ++cycle) {
+        // The generators give new values on each cycle, which the matrix
+        // must not hide behind the buffers of the previous one
+        constantGen.value = 10.0f + 1000.0f * cycle;
+        rampGen.value = 100.0f + 1000.0f * cycle;
+
+        matrix.beginCycle(kNumFrames);
+        for (int voice = 0; voice < 2; ++voice) {
+            const NumericId<Voice> voiceId { voice };
+            matrix.beginVoice(voiceId, kRegion, 0.0f);
+
+            EXPECT_EQ(modulation(pitch), constant(2.0f * (constantGen.value + voice)));
+            EXPECT_TRUE(matrix.isModulationConstant(pitch));
+            EXPECT_EQ(modulation(volume), ramp(rampGen.value + voice));
+            EXPECT_FALSE(matrix.isModulationConstant(volume));
+
+            // Asking again in the same voice reuses the buffers
+            EXPECT_EQ(modulation(pitch), constant(2.0f * (constantGen.value + voice)));
+            matrix.endVoice();
+        }
+        matrix.endCycle();
+    }
+
+    EXPECT_EQ(constantGen.generated, 4);
+    EXPECT_EQ(rampGen.generated, 4);
+}
+
+TEST_F(ModMatrixTest, PerVoiceTargetMixesGlobalAndPerVoiceSources)
+{
+    TestGenerator globalGen { 3.0f, true };
+    TestGenerator voiceGen { 20.0f };
+    const auto pitch = target(ModId::Pitch);
+    ASSERT_TRUE(matrix.connect(globalSource(globalGen, 7), pitch, 1.0f, {}, 0.0f));
+    ASSERT_TRUE(matrix.connect(voiceSource(voiceGen, 1), pitch, 0.5f, {}, 0.0f));
+    matrix.init();
+
+    for (int cycle = 0; cycle < 2; ++cycle) {
+        globalGen.value = 3.0f + 100.0f * cycle;
+        matrix.beginCycle(kNumFrames);
+        for (int voice = 0; voice < 2; ++voice) {
+            matrix.beginVoice(NumericId<Voice> { voice }, kRegion, 0.0f);
+
+            std::vector<float> expected = ramp(globalGen.value);
+            for (float& value : expected)
+                value += 0.5f * (voiceGen.value + voice);
+            EXPECT_EQ(modulation(pitch), expected);
+            EXPECT_FALSE(matrix.isModulationConstant(pitch));
+            matrix.endVoice();
+        }
+        matrix.endCycle();
+    }
+
+    // The global source runs once per cycle, whatever the number of voices
+    EXPECT_EQ(globalGen.generated, 2);
+    EXPECT_EQ(voiceGen.generated, 4);
+}
+
+TEST_F(ModMatrixTest, ConstantSourceWithModulatedDepthIsNotConstant)
+{
+    TestGenerator constantGen { 4.0f };
+    TestGenerator depthGen { 1.0f, true };
+    const auto pitch = target(ModId::Pitch);
+    const ModKey depthKey = ModKey::createNXYZ(ModId::PitchEGDepth, kRegion);
+    ASSERT_TRUE(matrix.connect(voiceSource(constantGen, 1), pitch, 2.0f, depthKey, 0.0f));
+    ASSERT_TRUE(matrix.connect(voiceSource(depthGen, 2), matrix.findTarget(depthKey), 1.0f, {}, 0.0f));
+    matrix.init();
+
+    matrix.beginCycle(kNumFrames);
+    matrix.beginVoice(NumericId<Voice> { 0 }, kRegion, 0.0f);
+
+    std::vector<float> expected(kNumFrames);
+    for (unsigned i = 0; i < kNumFrames; ++i)
+        expected[i] = (2.0f + (1.0f + i)) * 4.0f;
+    EXPECT_EQ(modulation(pitch), expected);
+    EXPECT_FALSE(matrix.isModulationConstant(pitch));
+    EXPECT_FALSE(matrix.isModulationConstant(matrix.findTarget(depthKey)));
+
+    matrix.endVoice();
+    matrix.endCycle();
+}
+
+TEST_F(ModMatrixTest, ConstantIsKnownOnlyAfterGetModulation)
+{
+    TestGenerator constantGen { 5.0f };
+    const auto pitch = target(ModId::Pitch);
+    ASSERT_TRUE(matrix.connect(voiceSource(constantGen, 1), pitch, 1.0f, {}, 0.0f));
+    matrix.init();
+
+    matrix.beginCycle(kNumFrames);
+    matrix.beginVoice(NumericId<Voice> { 0 }, kRegion, 0.0f);
+    EXPECT_FALSE(matrix.isModulationConstant(pitch));
+    EXPECT_EQ(modulation(pitch), constant(5.0f));
+    EXPECT_TRUE(matrix.isModulationConstant(pitch));
+    matrix.endVoice();
+
+    // A new voice invalidates the result of the previous one
+    matrix.beginVoice(NumericId<Voice> { 1 }, kRegion, 0.0f);
+    EXPECT_FALSE(matrix.isModulationConstant(pitch));
+    EXPECT_EQ(modulation(pitch), constant(6.0f));
+    EXPECT_TRUE(matrix.isModulationConstant(pitch));
+    matrix.endVoice();
+    matrix.endCycle();
+
+    // And so does a new cycle
+    matrix.beginCycle(kNumFrames);
+    matrix.beginVoice(NumericId<Voice> { 1 }, kRegion, 0.0f);
+    EXPECT_FALSE(matrix.isModulationConstant(pitch));
+    matrix.endVoice();
+    matrix.endCycle();
+
+    EXPECT_FALSE(matrix.isModulationConstant(ModMatrix::TargetId {}));
+}
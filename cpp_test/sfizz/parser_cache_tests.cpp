@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Opcode.h"
+#include "parser/Parser.h"
+#include "parser/ParserListener.h"
+
+using namespace sfz;
+
+// Records the blocks a parse delivers, and whether the file was actually parsed: a replayed cache
+// only delivers full blocks.
+class BlockRecorder : public ParserListener {
+public:
+    void onParseOpcode(const SourceRange&, const SourceRange&, const std::string&, const std::string&) override {
+        parsedOpcodes++;
+    }
+
+    void onParseFullBlock(const std::string& header, const std::vector<Opcode>& opcodes) override {
+        std::vector<std::pair<std::string, std::string>> pairs;
+        for (const auto& opcode : opcodes) {
+            pairs.emplace_back(opcode.name, opcode.value);
+        }
+        blocks.emplace_back(header, pairs);
+    }
+
+    int parsedOpcodes = 0;
+    std::vector<std::pair<std::string, std::vector<std::pair<std::string, std::string>>>> blocks;
+};
+
+class ParserCacheTest : public ::testing::Test {
+protected:
+    ParserCacheTest() {
+        directory = fs::temp_directory_path() / ("parser_cache_test_" + std::to_string(::testing::UnitTest::GetInstance()->random_seed())
+            + "_" + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+        fs::remove_all(directory);
+        fs::create_directories(directory / "cache");
+
+        writeFile("main.sfz", "#define $KEY 60\n<region> sample=a.wav key=$KEY\n#include \"more.sfz\"\n");
+        writeFile("more.sfz", "<region> sample=b.wav key=62\n");
+    }
+
+    ~ParserCacheTest() override {
+        fs::remove_all(directory);
+    }
+
+    void writeFile(const std::string& name, const std::string& contents) {
+        std::ofstream stream((directory / name).string(), std::ios::binary | std::ios::trunc);
+        stream << contents;
+    }
+
+    // Parses main.sfz with a fresh parser, as a new instrument would
+    BlockRecorder parse(const std::vector<std::pair<std::string, std::string>>& definitions = {}) {
+        BlockRecorder recorder;
+        Parser parser;
+        parser.setListener(&recorder);
+        parser.setCacheDirectory(directory / "cache");
+
+        for (const auto& definition : definitions) {
+            parser.addExternalDefinition(definition.first, definition.second);
+        }
+
+        parser.parseFile(directory / "main.sfz");
+        includedFiles = parser.getIncludedFiles();
+        defines = parser.getDefines();
+        return recorder;
+    }
+
+    fs::path directory;
+    Parser::IncludeFileSet includedFiles;
+    Parser::DefinitionSet defines;
+};
+
+TEST_F(ParserCacheTest, ReplaysUnchangedFile) {
+    auto parsed = parse();
+    auto parsedIncludedFiles = includedFiles;
+    auto parsedDefines = defines;
+
+    ASSERT_GT(parsed.parsedOpcodes, 0);
+    ASSERT_EQ(parsed.blocks.size(), 2);
+    EXPECT_EQ(parsed.blocks[0].second, (std::vector<std::pair<std::string, std::string>>{ { "sample", "a.wav" }, { "key", "60" } }));
+
+    auto replayed = parse();
+
+    EXPECT_EQ(replayed.parsedOpcodes, 0);
+    EXPECT_EQ(replayed.blocks, parsed.blocks);
+    EXPECT_EQ(includedFiles, parsedIncludedFiles);
+    EXPECT_EQ(defines, parsedDefines);
+}
+
+TEST_F(ParserCacheTest, ParsesAgainWhenAnIncludeChanges) {
+    parse();
+    writeFile("more.sfz", "<region> sample=b.wav key=64\n");
+
+    auto reparsed = parse();
+
+    EXPECT_GT(reparsed.parsedOpcodes, 0);
+    ASSERT_EQ(reparsed.blocks.size(), 2);
+    EXPECT_EQ(reparsed.blocks[1].second, (std::vector<std::pair<std::string, std::string>>{ { "sample", "b.wav" }, { "key", "64" } }));
+
+    // The new contents are cached in turn
+    EXPECT_EQ(parse().parsedOpcodes, 0);
+}
+
+TEST_F(ParserCacheTest, ParsesAgainWithNewDefinitions) {
+    parse();
+
+    auto defined = parse({ { "$VELOCITY", "100" } });
+    EXPECT_GT(defined.parsedOpcodes, 0);
+
+    // Each set of definitions has its own cache
+    EXPECT_EQ(parse({ { "$VELOCITY", "100" } }).parsedOpcodes, 0);
+    EXPECT_GT(parse({ { "$VELOCITY", "90" } }).parsedOpcodes, 0);
+    EXPECT_EQ(parse().parsedOpcodes, 0);
+}
+
+TEST_F(ParserCacheTest, DoesNotCacheFilesWithErrors) {
+    writeFile("main.sfz", "<region> sample=a.wav\n#include \"missing.sfz\"\n");
+
+    parse();
+
+    EXPECT_GT(parse().parsedOpcodes, 0);
+}
@@ -116,3 +116,22 @@ TEST_F(BufferTest, ClearAfter) {
     buffer.clearAfter(0);
     EXPECT_EQ(buffer.count(), 0);
 }
+
+TEST_F(BufferTest, PeekAt) {
+    SmallBuffer buffer = SmallBuffer();
+    SchedulerEvent event;
+
+    EXPECT_FALSE(buffer.peekAt(0, event));
+
+    addNEvents(&buffer, 10, 111, 0);
+    removeNEvents(&buffer, 3);
+
+    EXPECT_TRUE(buffer.peekAt(0, event));
+    EXPECT_EQ(event.frame, 30);
+
+    EXPECT_TRUE(buffer.peekAt(6, event));
+    EXPECT_EQ(event.frame, 90);
+
+    EXPECT_FALSE(buffer.peekAt(7, event));
+    EXPECT_EQ(buffer.count(), 7);
+}
@@ -0,0 +1,235 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "InstrumentLoader.h"
+
+using namespace std::chrono_literals;
+
+// Long enough for a loaded machine, short enough that a hang fails quickly
+const auto kTimeout = 5s;
+
+// A latch the tasks block on, so that the queue fills up before they run
+class Gate {
+public:
+    void open() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isOpen = true;
+        }
+        condition.notify_all();
+    }
+
+    bool wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        return condition.wait_for(lock, kTimeout, [this] { return isOpen; });
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool isOpen = false;
+};
+
+// Records which tasks ran and in which order, and waits for a count of them
+class RunLog {
+public:
+    void add(int value) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            values.push_back(value);
+        }
+        condition.notify_all();
+    }
+
+    bool waitFor(size_t count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return condition.wait_for(lock, kTimeout, [&] { return values.size() >= count; });
+    }
+
+    std::vector<int> get() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return values;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::vector<int> values;
+};
+
+class InstrumentLoaderTest : public ::testing::Test {
+protected:
+    // Occupies a loader thread until the gate opens
+    load_request_id_t enqueueBlocker(InstrumentLoader& loader) {
+        return loader.enqueue(1000, [this](const std::atomic<bool>&) {
+            blockerStarted.add(0);
+            gate.wait();
+        }, nullptr);
+    }
+
+    load_request_id_t enqueueLogged(InstrumentLoader& loader, int32_t priority, int value) {
+        return loader.enqueue(priority, [this, value](const std::atomic<bool>&) {
+            log.add(value);
+        }, [this, value] {
+            cancelled.add(value);
+        });
+    }
+
+    Gate gate;
+    RunLog blockerStarted;
+    RunLog log;
+    RunLog cancelled;
+};
+
+TEST_F(InstrumentLoaderTest, RunsHighestPriorityFirstAndEqualPrioritiesInOrder) {
+    InstrumentLoader loader(1);
+    enqueueBlocker(loader);
+    ASSERT_TRUE(blockerStarted.waitFor(1));
+
+    enqueueLogged(loader, 1, 10);
+    enqueueLogged(loader, 5, 50);
+    enqueueLogged(loader, 3, 30);
+    enqueueLogged(loader, 5, 51);
+    enqueueLogged(loader, 0, 0);
+    gate.open();
+
+    ASSERT_TRUE(log.waitFor(5));
+    EXPECT_EQ(log.get(), (std::vector<int> { 50, 51, 30, 10, 0 }));
+}
+
+TEST_F(InstrumentLoaderTest, SetPriorityReordersQueuedRequests) {
+    InstrumentLoader loader(1);
+    enqueueBlocker(loader);
+    ASSERT_TRUE(blockerStarted.waitFor(1));
+
+    enqueueLogged(loader, 1, 1);
+    const auto late = enqueueLogged(loader, 1, 2);
+    loader.setPriority(late, 10);
+    gate.open();
+
+    ASSERT_TRUE(log.waitFor(2));
+    EXPECT_EQ(log.get(), (std::vector<int> { 2, 1 }));
+}
+
+TEST_F(InstrumentLoaderTest, CancelledQueuedRequestNeverRuns) {
+    InstrumentLoader loader(1);
+    enqueueBlocker(loader);
+    ASSERT_TRUE(blockerStarted.waitFor(1));
+
+    enqueueLogged(loader, 0, 1);
+    const auto cancelledId = enqueueLogged(loader, 0, 2);
+    enqueueLogged(loader, 0, 3);
+
+    // The handler runs on the calling thread, before cancel returns
+    EXPECT_TRUE(loader.cancel(cancelledId));
+    EXPECT_EQ(cancelled.get(), std::vector<int> { 2 });
+    gate.open();
+
+    ASSERT_TRUE(log.waitFor(2));
+    std::this_thread::sleep_for(20ms);
+    EXPECT_EQ(log.get(), (std::vector<int> { 1, 3 }));
+    EXPECT_FALSE(loader.cancel(cancelledId));
+}
+
+TEST_F(InstrumentLoaderTest, CancelledRunningRequestDoesNotCommit) {
+    InstrumentLoader loader(1);
+    std::atomic<bool> sawCancellation { false };
+    std::atomic<bool> committed { false };
+
+    const auto id = loader.enqueue(0, [&](const std::atomic<bool>& isCancelled) {
+        blockerStarted.add(0);
+        gate.wait();
+        sawCancellation = isCancelled.load();
+        loader.commit(isCancelled, [&] { committed = true; });
+        log.add(0);
+    }, [this] { cancelled.add(0); });
+
+    ASSERT_TRUE(blockerStarted.waitFor(1));
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(loader.cancel(id));
+    // Cancelling a running request only raises its flag, it doesn't wait for the task
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 100ms);
+    gate.open();
+
+    ASSERT_TRUE(log.waitFor(1));
+    EXPECT_TRUE(sawCancellation);
+    EXPECT_FALSE(committed);
+    EXPECT_TRUE(cancelled.get().empty());
+}
+
+TEST_F(InstrumentLoaderTest, CommittedRequestCannotBeCancelled) {
+    InstrumentLoader loader(1);
+    Gate committedGate;
+    std::atomic<bool> committed { false };
+
+    const auto id = loader.enqueue(0, [&](const std::atomic<bool>& isCancelled) {
+        committed = loader.commit(isCancelled, [] {});
+        committedGate.open();
+        gate.wait();
+        log.add(0);
+    }, nullptr);
+
+    ASSERT_TRUE(committedGate.wait());
+    EXPECT_TRUE(committed);
+    EXPECT_FALSE(loader.cancel(id));
+    gate.open();
+    ASSERT_TRUE(log.waitFor(1));
+}
+
+TEST_F(InstrumentLoaderTest, RunsAtMostThreadCountRequestsAtOnce) {
+    constexpr int kThreads = 2;
+    constexpr int kRequests = 8;
+    const auto kTaskDuration = 20ms;
+
+    std::atomic<int> running { 0 };
+    std::atomic<int> maxRunning { 0 };
+    const auto start = std::chrono::steady_clock::now();
+    {
+        InstrumentLoader loader(kThreads);
+        for (int i = 0; i < kRequests; i++) {
+            loader.enqueue(0, [&, i](const std::atomic<bool>&) {
+                const int now = ++running;
+                int previous = maxRunning.load();
+                while (now > previous && !maxRunning.compare_exchange_weak(previous, now)) {}
+                std::this_thread::sleep_for(kTaskDuration);
+                --running;
+                log.add(i);
+            }, nullptr);
+        }
+        ASSERT_TRUE(log.waitFor(kRequests));
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(maxRunning.load(), kThreads);
+    // The requests ran in kRequests / kThreads rounds, not one after the other
+    EXPECT_GE(elapsed, kTaskDuration * (kRequests / kThreads));
+    EXPECT_LT(elapsed, kTaskDuration * kRequests);
+}
+
+TEST_F(InstrumentLoaderTest, DestructorCancelsQueuedRequests) {
+    std::thread opener;
+    {
+        InstrumentLoader loader(1);
+        enqueueBlocker(loader);
+        ASSERT_TRUE(blockerStarted.waitFor(1));
+        enqueueLogged(loader, 0, 1);
+        enqueueLogged(loader, 0, 2);
+
+        // Lets the running request finish while the destructor waits for it
+        opener = std::thread([this] {
+            std::this_thread::sleep_for(20ms);
+            gate.open();
+        });
+    }
+    opener.join();
+
+    EXPECT_TRUE(log.get().empty());
+    auto cancelledValues = cancelled.get();
+    std::sort(cancelledValues.begin(), cancelledValues.end());
+    EXPECT_EQ(cancelledValues, (std::vector<int> { 1, 2 }));
+}
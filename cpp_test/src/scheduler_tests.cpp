@@ -0,0 +1,488 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "BaseScheduler.h"
+#include "BatchCommand.h"
+
+class TestScheduler : public BaseScheduler {
+public:
+    void onRemoveTrack(track_index_t /*trackIndex*/) {}
+    void onResetTrack(track_index_t /*trackIndex*/) {}
+    void handleRenderAudioRange(track_index_t /*trackIndex*/, uint32_t /*offsetFrame*/, uint32_t /*numFramesToRender*/) {}
+
+    void handleEvent(track_index_t /*trackIndex*/, SchedulerEvent event, position_frame_t offsetFrame) {
+        handledEvents.push_back(event);
+        handledOffsets.push_back(offsetFrame);
+    }
+
+    void renderTrackAhead(track_index_t trackIndex, position_frame_t startFrame, uint32_t numFrames) {
+        renderTrack(trackIndex, *mBufferMap[trackIndex], startFrame, numFrames, true);
+    }
+
+    bool isBatchLockFree() {
+        std::unique_lock<SharedSpinLock> batchLock(mBatchLock, std::try_to_lock);
+        return batchLock.owns_lock();
+    }
+
+    std::vector<SchedulerEvent> handledEvents;
+    std::vector<position_frame_t> handledOffsets;
+};
+
+class SchedulerTest : public ::testing::Test {
+protected:
+    SchedulerTest(); // set up here
+    virtual ~SchedulerTest(); // clean up here
+};
+
+SchedulerTest::SchedulerTest() {}
+SchedulerTest::~SchedulerTest() {}
+
+void appendCommand(std::vector<uint8_t>& data, track_index_t trackIndex, uint32_t opcode, uint32_t argument) {
+    BatchCommandHeader header = { trackIndex, opcode, argument };
+    auto headerBytes = reinterpret_cast<const uint8_t*>(&header);
+
+    data.insert(data.end(), headerBytes, headerBytes + sizeof(header));
+}
+
+void appendScheduleCommand(std::vector<uint8_t>& data, track_index_t trackIndex, uint32_t count, u_int32_t frameOffset) {
+    appendCommand(data, trackIndex, BATCH_SCHEDULE_EVENTS, count);
+
+    for (uint32_t i = 0; i < count; i++) {
+        SchedulerEvent event = {};
+        event.frame = i * 10 + frameOffset;
+        event.type = MIDI_EVENT;
+
+        auto eventBytes = reinterpret_cast<const uint8_t*>(&event);
+        data.insert(data.end(), eventBytes, eventBytes + sizeof(event));
+    }
+}
+
+TEST_F(SchedulerTest, ApplyBatchAcrossTracks) {
+    TestScheduler scheduler;
+    auto trackA = scheduler.addTrack();
+    auto trackB = scheduler.addTrack();
+
+    std::vector<uint8_t> data;
+    appendCommand(data, trackA, BATCH_CLEAR_EVENTS, 0);
+    appendScheduleCommand(data, trackA, 5, 0);
+    appendCommand(data, trackB, BATCH_CLEAR_EVENTS, 0);
+    appendScheduleCommand(data, trackB, 3, 100);
+
+    uint32_t results[4];
+    auto applied = scheduler.applyBatch(data.data(), data.size(), results);
+
+    EXPECT_EQ(applied, 4);
+    EXPECT_EQ(results[1], 5);
+    EXPECT_EQ(results[3], 3);
+    EXPECT_EQ(scheduler.getBufferAvailableCount(trackA), 1024 - 5);
+    EXPECT_EQ(scheduler.getBufferAvailableCount(trackB), 1024 - 3);
+}
+
+TEST_F(SchedulerTest, ApplyBatchClearsBeforeScheduling) {
+    TestScheduler scheduler;
+    auto track = scheduler.addTrack();
+
+    std::vector<uint8_t> data;
+    appendScheduleCommand(data, track, 10, 0);
+    appendCommand(data, track, BATCH_CLEAR_EVENTS, 50);
+    appendScheduleCommand(data, track, 2, 50);
+
+    uint32_t results[3];
+    scheduler.applyBatch(data.data(), data.size(), results);
+
+    EXPECT_EQ(scheduler.getBufferAvailableCount(track), 1024 - 7);
+}
+
+TEST_F(SchedulerTest, ApplyBatchSetsVolume) {
+    TestScheduler scheduler;
+    auto track = scheduler.addTrack();
+
+    float volume = 0.5f;
+    uint32_t volumeBits;
+    memcpy(&volumeBits, &volume, sizeof(volumeBits));
+
+    std::vector<uint8_t> data;
+    appendCommand(data, track, BATCH_SET_VOLUME, volumeBits);
+
+    scheduler.applyBatch(data.data(), data.size(), nullptr);
+
+    // The volume is left for the audio thread, which only takes it in a block that holds the lock
+    EXPECT_TRUE(scheduler.handledEvents.empty());
+    scheduler.handleFrames(track, 128, false);
+    EXPECT_TRUE(scheduler.handledEvents.empty());
+
+    scheduler.handleFrames(track, 128);
+    ASSERT_EQ(scheduler.handledEvents.size(), 1);
+    EXPECT_EQ(scheduler.handledEvents[0].type, VOLUME_EVENT);
+    EXPECT_EQ(VolumeEventData(scheduler.handledEvents[0].data).volume, 0.5f);
+    EXPECT_EQ(scheduler.handledOffsets[0], 0);
+
+    // It is handed over once
+    scheduler.handleFrames(track, 128);
+    EXPECT_EQ(scheduler.handledEvents.size(), 1);
+}
+
+TEST_F(SchedulerTest, ApplyBatchStopsAtTruncatedCommand) {
+    TestScheduler scheduler;
+    auto track = scheduler.addTrack();
+
+    std::vector<uint8_t> data;
+    appendCommand(data, track, BATCH_CLEAR_EVENTS, 0);
+    appendScheduleCommand(data, track, 4, 0);
+    data.resize(data.size() - 1);
+
+    uint32_t results[2];
+    auto applied = scheduler.applyBatch(data.data(), data.size(), results);
+
+    EXPECT_EQ(applied, 1);
+    EXPECT_EQ(scheduler.getBufferAvailableCount(track), 1024);
+}
+
+TEST_F(SchedulerTest, ApplyBatchIgnoresMissingTrack) {
+    TestScheduler scheduler;
+
+    std::vector<uint8_t> data;
+    appendScheduleCommand(data, 7, 4, 0);
+
+    uint32_t results[1];
+    auto applied = scheduler.applyBatch(data.data(), data.size(), results);
+
+    EXPECT_EQ(applied, 1);
+    EXPECT_EQ(results[0], 0);
+}
+
+TEST_F(SchedulerTest, HoldsBatchLockForWholeBlock) {
+    TestScheduler scheduler;
+    auto trackA = scheduler.addTrack();
+    auto trackB = scheduler.addTrack();
+
+    // Track B is only seen once A has rendered, so blocks go from B to A after this
+    scheduler.play();
+    scheduler.handleFrames(trackA, 128);
+    EXPECT_TRUE(scheduler.isBatchLockFree());
+
+    // A batch can't land between the tracks of a block
+    scheduler.handleFrames(trackB, 128);
+    EXPECT_FALSE(scheduler.isBatchLockFree());
+    scheduler.handleFrames(trackA, 128);
+    EXPECT_TRUE(scheduler.isBatchLockFree());
+
+    // A track rendering twice starts over, and the lock still goes with the end of the block
+    scheduler.handleFrames(trackB, 128);
+    scheduler.handleFrames(trackB, 128);
+    EXPECT_FALSE(scheduler.isBatchLockFree());
+    scheduler.handleFrames(trackA, 128);
+    EXPECT_TRUE(scheduler.isBatchLockFree());
+}
+
+TEST_F(SchedulerTest, SharedBatchLockLetsRenderersShare) {
+    SharedSpinLock lock;
+
+    EXPECT_TRUE(lock.try_lock_shared());
+    EXPECT_TRUE(lock.try_lock_shared());
+    EXPECT_FALSE(lock.try_lock());
+
+    lock.unlock_shared();
+    lock.unlock_shared();
+    EXPECT_TRUE(lock.try_lock());
+    EXPECT_FALSE(lock.try_lock_shared());
+    lock.unlock();
+}
+
+TEST_F(SchedulerTest, SharedBatchLockTurnsRenderersAwayFromWaitingBatch) {
+    SharedSpinLock lock;
+    std::atomic<bool> didLock { false };
+
+    ASSERT_TRUE(lock.try_lock_shared());
+    std::thread writer([&]() {
+        lock.lock();
+        didLock.store(true);
+        lock.unlock();
+    });
+
+    // Once the writer waits, no new reader gets in, so it can't be kept out for good
+    while (lock.try_lock_shared()) {
+        lock.unlock_shared();
+        std::this_thread::yield();
+    }
+    EXPECT_FALSE(didLock.load());
+
+    lock.unlock_shared();
+    writer.join();
+    EXPECT_TRUE(didLock.load());
+    EXPECT_TRUE(lock.try_lock_shared());
+    lock.unlock_shared();
+}
+
+TEST_F(SchedulerTest, ParsesEffectEventData) {
+    SchedulerEvent event = {};
+    event.type = EFFECT_PARAM_EVENT;
+    event.data[0] = MASTER_CHAIN;
+    event.data[1] = 2;
+    event.data[2] = 3;
+
+    float value = 0.25f;
+    memcpy(event.data + 4, &value, sizeof(value));
+
+    auto paramEvent = EffectParamEventData(event.data);
+    EXPECT_EQ(paramEvent.chain, MASTER_CHAIN);
+    EXPECT_EQ(paramEvent.slot, 2);
+    EXPECT_EQ(paramEvent.parameter, 3);
+    EXPECT_EQ(paramEvent.value, 0.25f);
+
+    auto sendEvent = SendLevelEventData(event.data);
+    EXPECT_EQ(sendEvent.bus, MASTER_CHAIN);
+    EXPECT_EQ(sendEvent.level, 0.25f);
+}
+
+TEST_F(SchedulerTest, ParsesSeekEventData) {
+    SchedulerEvent event = {};
+    event.type = SEEK_EVENT;
+
+    position_frame_t frame = 441000;
+    memcpy(event.data, &frame, sizeof(frame));
+
+    EXPECT_EQ(SeekEventData(event.data).frame, 441000);
+}
+
+TEST_F(SchedulerTest, RenderTrackLeavesPositionAlone) {
+    TestScheduler scheduler;
+    auto track = scheduler.addTrack();
+
+    std::vector<uint8_t> data;
+    appendScheduleCommand(data, track, 4, 1000);
+    scheduler.applyBatch(data.data(), data.size(), nullptr);
+
+    scheduler.renderTrackAhead(track, 1005, 20);
+
+    // The event at 1000 is late, so it is handled at the start
+    ASSERT_EQ(scheduler.handledEvents.size(), 3);
+    EXPECT_EQ(scheduler.handledOffsets[0], 0);
+    EXPECT_EQ(scheduler.handledOffsets[1], 5);
+    EXPECT_EQ(scheduler.handledOffsets[2], 15);
+    EXPECT_EQ(scheduler.getPosition(), 0);
+    EXPECT_EQ(scheduler.getBufferAvailableCount(track), 1024 - 1);
+}
+
+SchedulerEvent makeMidiEvent(position_frame_t frame, uint8_t status, uint8_t data1, uint8_t data2) {
+    SchedulerEvent event = {};
+    event.frame = frame;
+    event.type = MIDI_EVENT;
+    event.data[0] = status;
+    event.data[1] = data1;
+    event.data[2] = data2;
+
+    return event;
+}
+
+SchedulerEvent makeSeekEvent(position_frame_t frame, position_frame_t sequenceFrame) {
+    SchedulerEvent event = {};
+    event.frame = frame;
+    event.type = SEEK_EVENT;
+    memcpy(event.data, &sequenceFrame, sizeof(sequenceFrame));
+
+    return event;
+}
+
+TEST_F(SchedulerTest, ChasesControllersAfterSeek) {
+    TestScheduler scheduler;
+    auto track = scheduler.addTrack();
+
+    std::vector<SchedulerEvent> timeline = {
+        makeMidiEvent(100, 0xB0, 7, 20),
+        makeMidiEvent(200, 0xC0, 5, 0),
+        makeMidiEvent(300, 0xB1, 1, 90),
+        makeMidiEvent(400, 0xB0, 7, 30),
+    };
+    // CC 7 and the program on channel 1, CC 1 on channel 2
+    EXPECT_EQ(scheduler.setControllerTimeline(track, timeline.data(), timeline.size()), 3);
+
+    std::vector<SchedulerEvent> events = {
+        makeSeekEvent(5000, 250),
+        makeMidiEvent(5010, 0x90, 60, 100),
+    };
+    EXPECT_EQ(scheduler.scheduleEvents(track, events.data(), events.size()), 2);
+    EXPECT_EQ(scheduler.getBufferAvailableCount(track), 1024 - 2 - 3);
+
+    scheduler.renderTrackAhead(track, 5000, 20);
+
+    // The program change comes first, and CC 1 is back at its default since it changes later
+    ASSERT_EQ(scheduler.handledEvents.size(), 5);
+    EXPECT_EQ(scheduler.handledEvents[0].type, SEEK_EVENT);
+    EXPECT_EQ(scheduler.handledEvents[1].data[0], 0xC0);
+    EXPECT_EQ(scheduler.handledEvents[1].data[1], 5);
+    EXPECT_EQ(scheduler.handledEvents[2].data[0], 0xB0);
+    EXPECT_EQ(scheduler.handledEvents[2].data[1], 7);
+    EXPECT_EQ(scheduler.handledEvents[2].data[2], 20);
+    EXPECT_EQ(scheduler.handledEvents[3].data[0], 0xB1);
+    EXPECT_EQ(scheduler.handledEvents[3].data[1], 1);
+    EXPECT_EQ(scheduler.handledEvents[3].data[2], 0);
+    EXPECT_EQ(scheduler.handledEvents[4].data[0], 0x90);
+    EXPECT_EQ(scheduler.handledOffsets[3], 0);
+    EXPECT_EQ(scheduler.handledOffsets[4], 10);
+}
+
+TEST_F(SchedulerTest, DoesNotChaseWithoutTimeline) {
+    TestScheduler scheduler;
+    auto track = scheduler.addTrack();
+
+    std::vector<SchedulerEvent> timeline = { makeMidiEvent(100, 0xB0, 7, 20) };
+    scheduler.setControllerTimeline(track, timeline.data(), timeline.size());
+    scheduler.setControllerTimeline(track, nullptr, 0);
+
+    auto seekEvent = makeSeekEvent(0, 250);
+    scheduler.scheduleEvents(track, &seekEvent, 1);
+
+    EXPECT_EQ(scheduler.getBufferAvailableCount(track), 1024 - 1);
+}
+
+TEST_F(SchedulerTest, ControllerTimelineUsesCheckpoints) {
+    std::vector<SchedulerEvent> events;
+    for (uint32_t i = 0; i < 300; i++) {
+        events.push_back(makeMidiEvent(i * 10 + 10, 0xB2, 7, i % 100));
+        // Not chased
+        events.push_back(makeMidiEvent(i * 10 + 10, 0xB2, 6, 1));
+    }
+
+    ControllerTimeline timeline(events.data(), events.size());
+    ControllerState state;
+
+    timeline.getStateAt(0, state);
+    EXPECT_EQ(state[2].cc[7], 100);
+    EXPECT_EQ(state[2].cc[6], kUnsetController);
+    EXPECT_EQ(state[0].cc[7], kUnsetController);
+
+    // Changes on the frame itself are left to the scheduled events
+    timeline.getStateAt(1290, state);
+    EXPECT_EQ(state[2].cc[7], 27);
+    timeline.getStateAt(2015, state);
+    EXPECT_EQ(state[2].cc[7], 0);
+    timeline.getStateAt(100000, state);
+    EXPECT_EQ(state[2].cc[7], 99);
+}
+
+TEST_F(SchedulerTest, ExtrapolatesAudibleFrameFromLastBlock) {
+    TestScheduler scheduler;
+    auto track = scheduler.addTrack();
+
+    // Nothing has been rendered yet
+    EXPECT_EQ(scheduler.getAudibleFrame(), 0);
+
+    scheduler.setOutputLatency(64);
+    scheduler.play();
+    scheduler.handleFrames(track, 128);
+    scheduler.handleFrames(track, 128);
+
+    // The second block started at 128, and extrapolation stops at the end of it
+    auto audibleFrame = scheduler.getAudibleFrame();
+    EXPECT_GE(audibleFrame, 128 - 64);
+    EXPECT_LE(audibleFrame, 256 - 64);
+
+    // The position is the end of the block, so the render time is no later than that
+    timeval t;
+    gettimeofday(&t, NULL);
+    const uint64_t blockUs = 128 * 1000000 / 44100 + 1;
+    EXPECT_LE(scheduler.getLastRenderTimeUs(), t.tv_sec * uint64_t(1000000) + uint64_t(t.tv_usec) + blockUs);
+}
+
+TEST_F(SchedulerTest, RenderClockReadsWholeTimestamp) {
+    RenderClock clock;
+    RenderTimestamp timestamp;
+
+    EXPECT_FALSE(clock.read(timestamp));
+
+    clock.publish({ 1000, 128, 5000, 256 });
+    ASSERT_TRUE(clock.read(timestamp));
+    EXPECT_EQ(timestamp.frame, 1000);
+    EXPECT_EQ(timestamp.numFrames, 128);
+    EXPECT_EQ(timestamp.hostTimeUs, 5000);
+    EXPECT_EQ(timestamp.outputLatencyFrames, 256);
+}
+
+TEST_F(SchedulerTest, PlacesLiveEventsOneBlockLater) {
+    TestScheduler scheduler;
+    auto track = scheduler.addTrack();
+
+    scheduler.play();
+    scheduler.handleFrames(track, 128);
+
+    auto event = makeMidiEvent(0, 0x90, 60, 100);
+    scheduler.handleEventsNow(track, &event, 1);
+
+    // Nothing is handled on the calling thread
+    EXPECT_TRUE(scheduler.handledEvents.empty());
+
+    // Live events don't wait for a batch to finish
+    scheduler.handleFrames(track, 128, false);
+
+    ASSERT_EQ(scheduler.handledEvents.size(), 1);
+    EXPECT_EQ(scheduler.handledEvents[0].data[0], 0x90);
+    EXPECT_LT(scheduler.handledOffsets[0], 128);
+}
+
+TEST_F(SchedulerTest, HandlesLiveEventsAtOnceWhilePaused) {
+    TestScheduler scheduler;
+    auto track = scheduler.addTrack();
+
+    auto event = makeMidiEvent(0, 0x90, 60, 100);
+    scheduler.handleEventsNow(track, &event, 1);
+    scheduler.handleFrames(track, 128);
+
+    ASSERT_EQ(scheduler.handledEvents.size(), 1);
+    EXPECT_EQ(scheduler.handledOffsets[0], 0);
+}
+
+TEST_F(SchedulerTest, LiveEventQueueDropsWhenFull) {
+    LiveEventQueue<4> queue;
+    SchedulerEvent event = {};
+
+    for (uint32_t i = 0; i < 4; i++) {
+        event.frame = i;
+        EXPECT_TRUE(queue.push(event));
+    }
+    EXPECT_FALSE(queue.push(event));
+
+    for (uint32_t i = 0; i < 4; i++) {
+        ASSERT_TRUE(queue.peek(event));
+        EXPECT_EQ(event.frame, i);
+        queue.removeTop();
+    }
+    EXPECT_FALSE(queue.peek(event));
+    EXPECT_TRUE(queue.push(event));
+}
+
+TEST_F(SchedulerTest, LiveEventQueueTakesConcurrentProducers) {
+    constexpr uint32_t kProducers = 4;
+    constexpr uint32_t kEventsPerProducer = 5000;
+    LiveEventQueue<256> queue;
+
+    std::vector<std::thread> producers;
+    for (uint32_t producer = 0; producer < kProducers; producer++) {
+        producers.emplace_back([&queue, producer] {
+            SchedulerEvent event = {};
+            event.data[0] = producer;
+
+            for (uint32_t i = 0; i < kEventsPerProducer; i++) {
+                event.frame = i;
+                while (!queue.push(event)) std::this_thread::yield();
+            }
+        });
+    }
+
+    // Each producer's events come out in the order it pushed them
+    std::vector<uint32_t> nextFrames(kProducers, 0);
+    uint32_t eventsPopped = 0;
+    SchedulerEvent event;
+
+    while (eventsPopped < kProducers * kEventsPerProducer) {
+        if (!queue.peek(event)) continue;
+        queue.removeTop();
+
+        ASSERT_EQ(event.frame, nextFrames[event.data[0]]);
+        nextFrames[event.data[0]]++;
+        eventsPopped++;
+    }
+
+    for (auto& producer : producers) producer.join();
+}
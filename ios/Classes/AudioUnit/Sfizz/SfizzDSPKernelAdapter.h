@@ -15,6 +15,8 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, readonly) AUAudioUnitBus *inputBus;
 @property (nonatomic, readonly) AUAudioUnitBus *outputBus;
 
+- (void)setOversamplingFactor:(int32_t)factor;
+
 - (bool)loadSfzFile:(const char *)path tuningPath:(const char * _Nullable)tuningPath;
 - (bool)loadSfzString:(const char *)sampleRoot sfzString:(const char *)sfzString tuningString:(const char * _Nullable)tuningString;
 
@@ -40,6 +40,10 @@ AUInternalRenderBlock sfizz_adapter_get_internal_render_block(SfizzDSPKernelAdap
     return [adapter internalRenderBlock];
 }
 
+void sfizz_adapter_set_oversampling_factor(SfizzDSPKernelAdapter* adapter, int32_t factor) {
+    [adapter setOversamplingFactor:factor];
+}
+
 bool sfizz_adapter_load_sfz_file(SfizzDSPKernelAdapter* adapter, const char* path, const char* tuningPath) {
     return [adapter loadSfzFile:path tuningPath:tuningPath];
 }
@@ -189,6 +189,11 @@ public class CocoaEngine {
         
         // Start scheduler if available
         if let scheduler = scheduler {
+            // The route may have changed since the last play
+            let session = AVAudioSession.sharedInstance()
+            let latencySeconds = session.outputLatency + session.ioBufferDuration
+            SchedulerSetOutputLatency(scheduler, UInt32(latencySeconds * outputFormat.sampleRate))
+
             SchedulerPlay(scheduler)
             print("[DEBUG] Scheduler started")
         }
@@ -443,7 +448,7 @@ public class CocoaEngine {
         }
     }
     
-    func addTrackSfz(sfzPath: UnsafePointer<CChar>, tuningPath: UnsafePointer<CChar>, completion: @escaping (track_index_t) -> Void) {
+    func addTrackSfz(sfzPath: UnsafePointer<CChar>, tuningPath: UnsafePointer<CChar>, loadOptions: SfzLoadOptions, completion: @escaping (track_index_t) -> Void) {
         let sfzPathString = String(cString: sfzPath)
         NSLog("🎵 HIGH-PERF: Adding SFZ track: \(sfzPathString)")
         print("🎵 DIAGNOSTIC: Starting addTrackSfz for: \(sfzPathString)")
@@ -479,6 +484,8 @@ public class CocoaEngine {
                 if let sfizzAU = avAudioUnit.auAudioUnit as? SfizzAU {
                     print("✅ DIAGNOSTIC: Successfully cast to SfizzAU")
                     
+                    sfizzAU.applyLoadOptions(loadOptions)
+
                     // Load the SFZ file
                     let loadResult = sfizzAU.loadSfzFile(path: sfzPath, tuningPath: tuningPath)
                     
@@ -509,7 +516,7 @@ public class CocoaEngine {
         }
     }
     
-    func addTrackSfzString(sampleRoot: UnsafePointer<CChar>, sfzString: UnsafePointer<CChar>, tuningString: UnsafePointer<CChar>, completion: @escaping (track_index_t) -> Void) {
+    func addTrackSfzString(sampleRoot: UnsafePointer<CChar>, sfzString: UnsafePointer<CChar>, tuningString: UnsafePointer<CChar>, loadOptions: SfzLoadOptions, completion: @escaping (track_index_t) -> Void) {
         let sampleRootString = String(cString: sampleRoot)
         NSLog("🎵 HIGH-PERF: Adding SFZ string track with sample root: \(sampleRootString)")
         print("🎵 DIAGNOSTIC: Starting addTrackSfzString")
@@ -545,6 +552,8 @@ public class CocoaEngine {
                 if let sfizzAU = avAudioUnit.auAudioUnit as? SfizzAU {
                     print("✅ DIAGNOSTIC: Successfully cast to SfizzAU for string loading")
                     
+                    sfizzAU.applyLoadOptions(loadOptions)
+
                     // Load the SFZ string
                     let loadResult = sfizzAU.loadSfzString(sampleRoot: sampleRoot, sfzString: sfzString, tuningString: tuningString)
                     
@@ -24,6 +24,7 @@ OSStatus triggerMidiEvents(
 CocoaScheduler::CocoaScheduler(AudioUnit _Nonnull mixerAudioUnit, double sampleRate) {
     mMixerAudioUnit = mixerAudioUnit;
     mSampleRate = sampleRate;
+    setSampleRate(sampleRate);
 }
 
 CocoaScheduler::~CocoaScheduler() {
@@ -165,6 +166,14 @@ void SchedulerClearEvents(const void* scheduler, track_index_t trackIndex, posit
     return ((CocoaScheduler*)scheduler)->clearEvents(trackIndex, fromFrame);
 }
 
+UInt32 SchedulerSetControllerTimeline(const void* scheduler, track_index_t trackIndex, const SchedulerEvent* events, UInt32 eventsCount) {
+    return ((CocoaScheduler*)scheduler)->setControllerTimeline(trackIndex, events, eventsCount);
+}
+
+UInt32 SchedulerApplyBatch(const void* scheduler, const UInt8* commandData, UInt32 commandDataSize, UInt32* results) {
+    return ((CocoaScheduler*)scheduler)->applyBatch(commandData, commandDataSize, results);
+}
+
 void SchedulerPlay(const void* scheduler) {
     return ((CocoaScheduler*)scheduler)->play();
 }
@@ -185,6 +194,14 @@ UInt64 SchedulerGetLastRenderTimeUs(const void* scheduler) {
     return ((CocoaScheduler*)scheduler)->getLastRenderTimeUs();
 }
 
+UInt32 SchedulerGetAudibleFrame(const void* scheduler) {
+    return ((CocoaScheduler*)scheduler)->getAudibleFrame();
+}
+
+void SchedulerSetOutputLatency(const void* scheduler, UInt32 latencyFrames) {
+    ((CocoaScheduler*)scheduler)->setOutputLatency(latencyFrames);
+}
+
 Float32 SchedulerGetTrackVolume(const void* scheduler, track_index_t trackIndex) {
     return ((CocoaScheduler*)scheduler)->getTrackVolume(trackIndex);
 }
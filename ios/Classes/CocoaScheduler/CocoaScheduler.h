@@ -55,11 +55,15 @@ UInt32 SchedulerGetBufferAvailableCount(const void* _Nonnull scheduler, track_in
 void SchedulerHandleEventsNow(const void* _Nonnull engine, track_index_t trackIndex, const struct SchedulerEvent* _Nonnull events, UInt32 eventsCount);
 UInt32 SchedulerAddEvents(const void* _Nonnull engine, track_index_t trackIndex, const struct SchedulerEvent* _Nonnull events, UInt32 eventsCount);
 void SchedulerClearEvents(const void* _Nonnull engine, track_index_t trackIndex, position_frame_t fromFrame);
+UInt32 SchedulerSetControllerTimeline(const void* _Nonnull engine, track_index_t trackIndex, const struct SchedulerEvent* _Nonnull events, UInt32 eventsCount);
+UInt32 SchedulerApplyBatch(const void* _Nonnull engine, const UInt8* _Nonnull commandData, UInt32 commandDataSize, UInt32* _Nullable results);
 void SchedulerPlay(const void* _Nonnull engine);
 void SchedulerPause(const void* _Nonnull engine);
 void SchedulerResetTrack(const void* _Nonnull engine, track_index_t trackIndex);
 UInt32 SchedulerGetPosition(const void* _Nonnull engine);
 UInt64 SchedulerGetLastRenderTimeUs(const void* _Nonnull engine);
+UInt32 SchedulerGetAudibleFrame(const void* _Nonnull engine);
+void SchedulerSetOutputLatency(const void* _Nonnull engine, UInt32 latencyFrames);
 Float32 SchedulerGetTrackVolume(const void* _Nonnull engine, track_index_t trackIndex);
 #ifdef __cplusplus
 }
@@ -21,6 +21,17 @@
 #include <cstdint>
 #include "IRenderableAudio.h"
 
+// How much quality an instrument gives up to save CPU time when the audio callback runs over
+// budget. Each stage includes the ones before it.
+// Remember to keep lib/models/load_governor.dart in sync.
+enum LoadStage {
+    LOAD_STAGE_NORMAL = 0,
+    LOAD_STAGE_REDUCED_QUALITY = 1,
+    LOAD_STAGE_CAPPED_POLYPHONY = 2,
+    LOAD_STAGE_NEAREST_INTERPOLATION = 3,
+    LOAD_STAGE_SHED_VOICES = 4,
+};
+
 class IInstrument: public IRenderableAudio {
 
 public:
@@ -30,6 +41,14 @@ public:
     // reset() should reset any state. It does not need to shut off all the MIDI notes, since
     // BaseScheduler handles that.
     virtual void reset() = 0;
+
+    // Called for SEEK_EVENT. Only instruments that play back audio rendered ahead of time, like a
+    // frozen track, need to know which frame of it comes next.
+    virtual void seekToFrame(uint32_t /*frame*/) {}
+
+    // Called on the audio thread between blocks, so it must not allocate or block. Instruments
+    // that have nothing to give up can ignore it.
+    virtual void setLoadStage(LoadStage /*stage*/) {}
 };
 
 #endif
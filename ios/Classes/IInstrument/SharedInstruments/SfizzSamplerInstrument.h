@@ -2,6 +2,7 @@
 #define SFIZZ_SAMPLER_INSTRUMENT_H
 
 #ifdef __cplusplus
+#include <algorithm>
 #include "IInstrument.h"
 #include "sfizz.hpp"
 
@@ -9,6 +10,9 @@ class SfizzSamplerInstrument : public IInstrument {
 public:
     SfizzSamplerInstrument() {
         mSampler = std::make_unique<sfz::Sfizz>();
+
+        mSampleQuality = mSampler->getSampleQuality(sfz::Sfizz::ProcessLive);
+        mOscillatorQuality = mSampler->getOscillatorQuality(sfz::Sfizz::ProcessLive);
     }
 
     bool setOutputFormat(int32_t sampleRate, bool isStereo) override {
@@ -22,6 +26,12 @@ public:
         mSampler->setSamplesPerBlock(samplesPerBlock);
     }
 
+    // Must be called before loading. Samples are upsampled by 1, 2, 4 or 8 as they are loaded,
+    // which takes that many times the memory. Other factors are ignored.
+    void setOversamplingFactor(int32_t factor) {
+        mSampler->setOversamplingFactor(factor);
+    }
+
     bool loadSfzString(const char* sampleRoot, const char* sfzString, const char* tuningString) {
         auto loadResult = mSampler->loadSfzString(sampleRoot, sfzString);
         auto loadTuningResult = true;
@@ -75,6 +85,8 @@ public:
 
         if (statusCode == 0x9) {
             // Note On
+            if (data2 > 0 && isOverVoiceCap()) return;
+
             mSampler->noteOn(0, data1, data2);
         } else if (statusCode == 0x8) {
             // Note Off
@@ -93,8 +105,41 @@ public:
     void reset() override {
     }
 
+    void setLoadStage(LoadStage stage) override {
+        mLoadStage = stage;
+
+        // Both setters are meant for the audio thread. Nearest sample interpolation is quality 0,
+        // and linear is 1.
+        int sampleQuality = mSampleQuality;
+        if (stage >= LOAD_STAGE_NEAREST_INTERPOLATION) {
+            sampleQuality = 0;
+        } else if (stage >= LOAD_STAGE_REDUCED_QUALITY) {
+            sampleQuality = std::min(mSampleQuality, 1);
+        }
+
+        mSampler->setSampleQuality(sfz::Sfizz::ProcessLive, sampleQuality);
+        mSampler->setOscillatorQuality(sfz::Sfizz::ProcessLive,
+                                       stage >= LOAD_STAGE_REDUCED_QUALITY ? 0 : mOscillatorQuality);
+    }
+
 private:
+    // setNumVoices() reallocates and can't run alongside rendering, so polyphony is capped by
+    // turning away new notes instead. sfizz can't end single voices from outside, so shedding
+    // voices lowers the cap further and lets the playing notes die out.
+    static constexpr int kCappedVoices = 32;
+    static constexpr int kShedVoices = 16;
+
+    bool isOverVoiceCap() const {
+        if (mLoadStage < LOAD_STAGE_CAPPED_POLYPHONY) return false;
+
+        const int cap = mLoadStage >= LOAD_STAGE_SHED_VOICES ? kShedVoices : kCappedVoices;
+        return mSampler->getNumActiveVoices() >= cap;
+    }
+
     bool mIsStereo;
+    LoadStage mLoadStage = LOAD_STAGE_NORMAL;
+    int mSampleQuality;
+    int mOscillatorQuality;
     std::unique_ptr<sfz::Sfizz> mSampler;
 };
 
@@ -1,6 +1,9 @@
 #include "BaseScheduler.h"
 
+#include <algorithm>
+#include <cstring>
 #include <limits>
+#include <mutex>
 #include "SchedulerEvent.h"
 
 track_index_t BaseScheduler::addTrack() {
@@ -11,6 +14,8 @@ track_index_t BaseScheduler::addTrack() {
             auto buffer = std::make_shared<Buffer<>>();
             
             mBufferMap[trackIndex] = buffer;
+            mLiveEventQueueMap[trackIndex] = std::make_shared<LiveEventQueue<>>();
+            mPendingVolumeMap[trackIndex] = std::make_shared<std::atomic<float>>(kNoPendingVolume);
             
             return trackIndex;
         }
@@ -21,18 +26,34 @@ track_index_t BaseScheduler::addTrack() {
 
 void BaseScheduler::removeTrack(track_index_t trackIndex) {
     mBufferMap.erase(trackIndex);
+    mLiveEventQueueMap.erase(trackIndex);
+    mPendingVolumeMap.erase(trackIndex);
+    mControllerTimelineMap.erase(trackIndex);
 
     onRemoveTrack(trackIndex);
 }
 
 void BaseScheduler::handleEventsNow(track_index_t trackIndex, const SchedulerEvent* events, uint32_t eventsCount) {
-    // Safety check
-    if (mBufferMap.find(trackIndex) == mBufferMap.end()) {
-        return;
+    auto queue = getLiveEventQueue(trackIndex);
+    if (queue == nullptr) return;
+
+    // The frame being rendered now, going by when the last block started. An event that arrives
+    // while a block renders still lands in the next one, since the latency is one block.
+    position_frame_t frame = 0;
+    RenderTimestamp timestamp;
+
+    if (mRenderClock.read(timestamp)) {
+        const uint64_t elapsedUs = RenderClock::nowUs() - timestamp.hostTimeUs;
+        const uint64_t elapsedFrames = std::min<uint64_t>(elapsedUs * mSampleRate / 1000000.0, timestamp.numFrames);
+
+        frame = timestamp.frame + static_cast<position_frame_t>(elapsedFrames) + timestamp.numFrames;
     }
-    
+
     for (uint32_t i = 0; i < eventsCount; i++) {
-        handleEvent(trackIndex, events[i], 0);
+        auto event = events[i];
+        event.frame = frame;
+
+        queue->push(event);
     }
 }
 
@@ -43,7 +64,7 @@ uint32_t BaseScheduler::scheduleEvents(track_index_t trackIndex, const Scheduler
     }
     
     // Events must come after anything already in the buffer and be sorted by frame, ascending.
-    return mBufferMap[trackIndex]->add(events, eventsCount);
+    return addEvents(trackIndex, *mBufferMap[trackIndex], events, eventsCount);
 };
 
 void BaseScheduler::clearEvents(track_index_t trackIndex, position_frame_t fromFrame) {
@@ -51,10 +72,91 @@ void BaseScheduler::clearEvents(track_index_t trackIndex, position_frame_t fromF
     if (mBufferMap.find(trackIndex) == mBufferMap.end()) {
         return;
     }
-    
+
+    onClearEvents(trackIndex, fromFrame);
     mBufferMap[trackIndex]->clearAfter(fromFrame);
 };
 
+uint32_t BaseScheduler::setControllerTimeline(track_index_t trackIndex, const SchedulerEvent* events, uint32_t eventsCount) {
+    // Safety check
+    if (mBufferMap.find(trackIndex) == mBufferMap.end()) {
+        return 0;
+    }
+
+    if (eventsCount == 0) {
+        mControllerTimelineMap.erase(trackIndex);
+        return 0;
+    }
+
+    auto timeline = std::make_unique<ControllerTimeline>(events, eventsCount);
+    auto chaseEventCount = timeline->getChaseEventCount();
+    mControllerTimelineMap[trackIndex] = std::move(timeline);
+
+    // So that chasing doesn't allocate while a batch holds the lock
+    mChaseEvents.reserve(ControllerTimeline::kMaxChaseEvents);
+
+    return chaseEventCount;
+}
+
+uint32_t BaseScheduler::applyBatch(const uint8_t* commandData, uint32_t commandDataSize, uint32_t* results) {
+    // Events are converted in chunks on the stack so a batch never allocates.
+    constexpr uint32_t kChunkSize = 64;
+    SchedulerEvent chunk[kChunkSize];
+
+    std::lock_guard<SharedSpinLock> batchLock(mBatchLock);
+
+    uint32_t offset = 0;
+    uint32_t commandsApplied = 0;
+
+    while (offset + sizeof(BatchCommandHeader) <= commandDataSize) {
+        BatchCommandHeader header;
+        memcpy(&header, commandData + offset, sizeof(BatchCommandHeader));
+        offset += sizeof(BatchCommandHeader);
+
+        uint32_t result = 0;
+        auto search = mBufferMap.find(header.trackIndex);
+        auto buffer = search != mBufferMap.end() ? search->second : nullptr;
+
+        if (header.opcode == BATCH_CLEAR_EVENTS) {
+            if (buffer != nullptr) {
+                onClearEvents(header.trackIndex, header.argument);
+                buffer->clearAfter(header.argument);
+            }
+        } else if (header.opcode == BATCH_SCHEDULE_EVENTS) {
+            auto payloadSize = header.argument * sizeof(SchedulerEvent);
+            if (offset + payloadSize > commandDataSize) break;
+
+            for (uint32_t i = 0; buffer != nullptr && i < header.argument; i += kChunkSize) {
+                auto chunkCount = std::min(kChunkSize, header.argument - i);
+                rawEventDataToEvents(commandData + offset + i * sizeof(SchedulerEvent), chunkCount, chunk);
+
+                auto added = addEvents(header.trackIndex, *buffer, chunk, chunkCount);
+                result += added;
+                if (added < chunkCount) break;
+            }
+
+            offset += payloadSize;
+        } else if (header.opcode == BATCH_SET_VOLUME) {
+            // The audio thread hands it to handleEvent in the first block that sees the batch
+            auto pendingVolume = mPendingVolumeMap.find(header.trackIndex);
+            if (pendingVolume != mPendingVolumeMap.end()) {
+                float volume;
+                memcpy(&volume, &header.argument, sizeof(volume));
+                pendingVolume->second->store(volume, std::memory_order_relaxed);
+            }
+        } else {
+            break;
+        }
+
+        if (results != nullptr) {
+            results[commandsApplied] = result;
+        }
+        commandsApplied++;
+    }
+
+    return commandsApplied;
+}
+
 void BaseScheduler::play() {
     if (mIsPlaying) return;
 
@@ -96,35 +198,205 @@ position_frame_t BaseScheduler::getPosition() {
     return mPositionFrames;
 }
 
+bool BaseScheduler::getIsPlaying() {
+    return mIsPlaying;
+}
+
 uint64_t BaseScheduler::getLastRenderTimeUs() {
     timeval t;
     gettimeofday(&t, NULL);
-    return t.tv_sec*uint64_t(1000000) + uint64_t(t.tv_usec);
+    const uint64_t wallTimeUs = t.tv_sec*uint64_t(1000000) + uint64_t(t.tv_usec);
+
+    RenderTimestamp timestamp;
+    if (!mRenderClock.read(timestamp)) return wallTimeUs;
+
+    // The position is the end of the last block, so this is when its audio runs out. The wall
+    // clock can jump, so the distance to that is measured on the monotonic clock.
+    const uint64_t blockEndUs = timestamp.hostTimeUs + static_cast<uint64_t>(timestamp.numFrames * 1000000.0 / mSampleRate);
+    const uint64_t nowUs = RenderClock::nowUs();
+
+    if (blockEndUs > nowUs) return wallTimeUs + (blockEndUs - nowUs);
+    return wallTimeUs - std::min(nowUs - blockEndUs, wallTimeUs);
+}
+
+position_frame_t BaseScheduler::getAudibleFrame() {
+    RenderTimestamp timestamp;
+    if (!mRenderClock.read(timestamp)) return 0;
+
+    const uint64_t elapsedUs = RenderClock::nowUs() - timestamp.hostTimeUs;
+    const uint64_t elapsedFrames = std::min<uint64_t>(elapsedUs * mSampleRate / 1000000.0, timestamp.numFrames);
+    const position_frame_t renderedFrame = timestamp.frame + static_cast<position_frame_t>(elapsedFrames);
+
+    return renderedFrame > timestamp.outputLatencyFrames ? renderedFrame - timestamp.outputLatencyFrames : 0;
+}
+
+void BaseScheduler::setOutputLatency(uint32_t latencyFrames) {
+    mOutputLatencyFrames.store(latencyFrames, std::memory_order_relaxed);
+}
+
+void BaseScheduler::setSampleRate(double sampleRate) {
+    mSampleRate = sampleRate;
 }
 
 void BaseScheduler::handleFrames(track_index_t trackIndex, uint32_t numFramesToRender) {
-    if (!mIsPlaying) return;
+    // A track that renders again before the block is over means some track has stopped rendering,
+    // so the block won't be finished by it
+    auto hasRendered = mHasRenderedMap.find(trackIndex);
+    if (hasRendered != mHasRenderedMap.end() && hasRendered->second) releaseBlockBatchLock();
+
+    if (!mHasTriedBlockBatchLock) {
+        mBlockBatchLock.try_lock();
+        mHasTriedBlockBatchLock = true;
+    }
+
+    handleFrames(trackIndex, numFramesToRender, mBlockBatchLock.owns_lock());
+
+    // Either the block is over or the position isn't moving
+    if (mBlockHostTimeUs == 0) releaseBlockBatchLock();
+}
+
+void BaseScheduler::releaseBlockBatchLock() {
+    if (mBlockBatchLock.owns_lock()) mBlockBatchLock.unlock();
+    mHasTriedBlockBatchLock = false;
+}
+
+void BaseScheduler::handleFrames(track_index_t trackIndex, uint32_t numFramesToRender, bool canHandleEvents) {
+    if (canHandleEvents) handlePendingVolume(trackIndex);
+
+    if (!mIsPlaying) {
+        handleLiveEvents(trackIndex);
+        return;
+    }
     
     auto buffer = mBufferMap[trackIndex];
-    auto originalPositionFrames = mPositionFrames; // so we can check if setPosition was called
     auto startFrame = mPositionFrames;
+    if (mBlockHostTimeUs == 0) mBlockHostTimeUs = RenderClock::nowUs();
+
+    renderTrack(trackIndex, *buffer, startFrame, numFramesToRender, canHandleEvents, getLiveEventQueue(trackIndex));
+
+    mHasRenderedMap[trackIndex] = true;
+    bool allTracksHaveRendered = true;
+    
+    for (auto pair : mHasRenderedMap) {
+        if (pair.second == false) {
+            allTracksHaveRendered = false;
+            break;
+        }
+    }
+    
+    if (allTracksHaveRendered) {
+        advancePosition(startFrame, numFramesToRender, mBlockHostTimeUs);
+        mBlockHostTimeUs = 0;
+        
+        for (auto pair : mHasRenderedMap) {
+            mHasRenderedMap[pair.first] = false;
+        }
+    }
+}
+
+void BaseScheduler::advancePosition(position_frame_t startFrame, uint32_t numFramesRendered, uint64_t hostTimeUs) {
+    // Don't update the position if setPosition was called during the block
+    if (mPositionFrames == startFrame) {
+        mPositionFrames = startFrame + numFramesRendered;
+    }
+
+    mRenderClock.publish({ startFrame, numFramesRendered, hostTimeUs, mOutputLatencyFrames.load(std::memory_order_relaxed) });
+}
+
+void BaseScheduler::handleLiveEvents(track_index_t trackIndex) {
+    auto liveEvents = getLiveEventQueue(trackIndex);
+    if (liveEvents == nullptr) return;
+
+    SchedulerEvent event;
+
+    while (liveEvents->peek(event)) {
+        handleEvent(trackIndex, event, 0);
+        liveEvents->removeTop();
+    }
+}
+
+void BaseScheduler::handlePendingVolume(track_index_t trackIndex) {
+    auto search = mPendingVolumeMap.find(trackIndex);
+    if (search == mPendingVolumeMap.end()) return;
+
+    // The batch lock orders this with the store in applyBatch
+    const float volume = search->second->exchange(kNoPendingVolume, std::memory_order_relaxed);
+    if (volume == kNoPendingVolume) return;
+
+    SchedulerEvent volumeEvent = {};
+    volumeEvent.type = VOLUME_EVENT;
+    memcpy(volumeEvent.data, &volume, sizeof(volume));
+    handleEvent(trackIndex, volumeEvent, 0);
+}
+
+LiveEventQueue<>* BaseScheduler::getLiveEventQueue(track_index_t trackIndex) {
+    auto search = mLiveEventQueueMap.find(trackIndex);
+
+    return search != mLiveEventQueueMap.end() ? search->second.get() : nullptr;
+}
+
+uint32_t BaseScheduler::addEvents(track_index_t trackIndex, Buffer<>& buffer, const SchedulerEvent* events, uint32_t eventsCount) {
+    auto search = mControllerTimelineMap.find(trackIndex);
+    if (search == mControllerTimelineMap.end()) {
+        return buffer.add(events, eventsCount);
+    }
+
+    ControllerState state;
+    uint32_t eventsAdded = 0;
+
+    while (eventsAdded < eventsCount) {
+        // Up to and including the next seek
+        uint32_t runEnd = eventsAdded;
+        while (runEnd < eventsCount && events[runEnd].type != SEEK_EVENT) runEnd++;
+
+        const bool isSeek = runEnd < eventsCount;
+        if (isSeek) runEnd++;
+
+        eventsAdded += buffer.add(events + eventsAdded, runEnd - eventsAdded);
+        if (eventsAdded < runEnd) break;
+
+        if (isSeek) {
+            auto& seekEvent = events[runEnd - 1];
+            auto seekFrame = SeekEventData(const_cast<uint8_t*>(seekEvent.data)).frame;
+
+            search->second->getStateAt(seekFrame, state);
+
+            mChaseEvents.clear();
+            ControllerTimeline::appendChaseEvents(state, seekEvent.frame, mChaseEvents);
+
+            // If they don't all fit, the buffer is full and the events after the seek won't either
+            buffer.add(mChaseEvents.data(), static_cast<uint32_t>(mChaseEvents.size()));
+        }
+    }
+
+    return eventsAdded;
+}
+
+void BaseScheduler::renderTrack(track_index_t trackIndex, Buffer<>& buffer, position_frame_t startFrame, uint32_t numFramesToRender, bool canHandleEvents, LiveEventQueue<>* liveEvents) {
     auto lastFrameRendered = startFrame;
     uint32_t framesRendered = 0;
 
-    SchedulerEvent nextEvent;
+    SchedulerEvent scheduledEvent;
+    SchedulerEvent liveEvent;
+
+    while (true) {
+        const bool hasScheduledEvent = canHandleEvents && buffer.peek(scheduledEvent);
+        const bool hasLiveEvent = liveEvents != nullptr && liveEvents->peek(liveEvent);
+        if (!hasScheduledEvent && !hasLiveEvent) break;
 
-    while (buffer->peek(nextEvent)) {
+        const bool isLive = hasLiveEvent && (!hasScheduledEvent || liveEvent.frame <= scheduledEvent.frame);
+        const auto& nextEvent = isLive ? liveEvent : scheduledEvent;
         auto eventFrame = nextEvent.frame;
         
-        if (eventFrame < startFrame) {
-            // Skip events that are more than 1024 frames the past
-            if (eventFrame + 1024 < startFrame) {
+        if (eventFrame < lastFrameRendered) {
+            // Skip events that are more than 1024 frames the past. Live events are never skipped.
+            if (!isLive && eventFrame + 1024 < startFrame) {
                 // printf("Track %i: Skipping event with frame %i, which is less than start frame %i\n", trackIndex, eventFrame, startFrame);
-                buffer->removeTop();
+                buffer.removeTop();
                 continue;
             } else {
                 // printf("Track %i: Accepting late event with frame %i, which is less than start frame %i\n", trackIndex, eventFrame, startFrame);
-                eventFrame = startFrame;
+                eventFrame = lastFrameRendered;
             }
         }
 
@@ -139,33 +411,13 @@ void BaseScheduler::handleFrames(track_index_t trackIndex, uint32_t numFramesToR
         lastFrameRendered = eventFrame;
         
         handleEvent(trackIndex, nextEvent, framesRendered);
-        buffer->removeTop();
-    }
-    
-    handleRenderAudioRange(trackIndex, framesRendered, numFramesToRender - framesRendered);
-    
 
-    mHasRenderedMap[trackIndex] = true;
-    bool allTracksHaveRendered = true;
-    
-    for (auto pair : mHasRenderedMap) {
-        if (pair.second == false) {
-            allTracksHaveRendered = false;
-            break;
+        if (isLive) {
+            liveEvents->removeTop();
+        } else {
+            buffer.removeTop();
         }
     }
     
-    if (allTracksHaveRendered) {
-        // Don't update the position if setPosition was called during this function
-        if (mPositionFrames == originalPositionFrames) {
-            mPositionFrames = startFrame + numFramesToRender;
-            // printf("Track %i: Updated position to %i\n", trackIndex, mPositionFrames);
-        // } else {
-            // printf("Track %i: Not updating position since it changed during render\n", trackIndex);
-        }
-        
-        for (auto pair : mHasRenderedMap) {
-            mHasRenderedMap[pair.first] = false;
-        }
-    }
+    handleRenderAudioRange(trackIndex, framesRendered, numFramesToRender - framesRendered);
 }
@@ -5,12 +5,20 @@
 typedef int32_t track_index_t;
 
 #ifdef __cplusplus
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <sys/time.h>
+#include <vector>
 #include <Buffer.h>
 #include <CallbackManager.h>
+#include <ControllerTimeline.h>
+#include <LiveEventQueue.h>
+#include <RenderClock.h>
 #include <SchedulerEvent.h>
+#include <SpinLock.h>
+#include <BatchCommand.h>
 
 class BaseScheduler {
 public:
@@ -18,27 +26,96 @@ public:
     void removeTrack(track_index_t trackIndex);
     virtual void onRemoveTrack(track_index_t trackIndex) = 0; // Will be called at the end of removeTrack.
 
+    // Queues events from any thread for the audio thread to handle. Each one is placed in the block
+    // a fixed latency after it arrived, at the matching frame, so live playing doesn't jitter with
+    // the block boundaries. Events that don't fit in the queue are dropped.
     void handleEventsNow(track_index_t trackIndex, const SchedulerEvent* events, uint32_t eventsCount);
     uint32_t scheduleEvents(track_index_t trackIndex, const SchedulerEvent* events, uint32_t eventsCount);
     void clearEvents(track_index_t trackIndex, position_frame_t fromFrame);
+    // Replaces the controller changes of a track, which are chased after each SEEK_EVENT that is
+    // scheduled on it. With no events, the track isn't chased anymore. Returns how many events
+    // each seek adds to the buffer on top of itself, so callers can leave room for them.
+    uint32_t setControllerTimeline(track_index_t trackIndex, const SchedulerEvent* events, uint32_t eventsCount);
+    // Will be called before events from fromFrame on are cleared, by clearEvents or a batch.
+    virtual void onClearEvents(track_index_t /*trackIndex*/, position_frame_t /*fromFrame*/) {}
+
+    // Applies a packed stream of BatchCommands. The audio thread will either see all of them or
+    // none of them. Writes one result per command (the scheduled count for BATCH_SCHEDULE_EVENTS,
+    // 0 otherwise) and returns the number of commands that were applied.
+    uint32_t applyBatch(const uint8_t* commandData, uint32_t commandDataSize, uint32_t* results);
     void play();
     void pause();
     void resetTrack(track_index_t trackIndex);
     virtual void onResetTrack(track_index_t trackIndex) = 0;
 
+    // For platforms that render each track on its own call. The batch lock is tried by the first
+    // track of a block and held until the last one has rendered, so a batch never lands between
+    // two tracks of the same block.
     void handleFrames(track_index_t trackIndex, uint32_t numFramesToRender);
+    // If canHandleEvents is false, the track is rendered without consuming its buffer. Late events
+    // are still accepted on the next call, so nothing is lost.
+    void handleFrames(track_index_t trackIndex, uint32_t numFramesToRender, bool canHandleEvents);
     virtual void handleRenderAudioRange(track_index_t trackIndex, uint32_t offsetFrame, uint32_t numFramesToRender) = 0;
     virtual void handleEvent(track_index_t trackIndex, SchedulerEvent event, position_frame_t offsetFrame) = 0;
 
     uint32_t getBufferAvailableCount(track_index_t trackIndex);
     position_frame_t getPosition();
+    bool getIsPlaying();
+    // Wall clock time, as microseconds since the epoch, when the audio of the last block runs out,
+    // which is when getPosition() is the frame being rendered. It can be a little in the future.
     uint64_t getLastRenderTimeUs();
+    // The frame that is coming out of the speaker now, extrapolated from the last block and the
+    // output latency. It never runs past the audio that has been rendered, so it stops when the
+    // audio thread does.
+    position_frame_t getAudibleFrame();
+    // Set by the platform engine whenever the output route or buffer size changes
+    void setOutputLatency(uint32_t latencyFrames);
+    // The rate positions are counted at. Must not be called while rendering.
+    void setSampleRate(double sampleRate);
 protected:
+    // Renders a track from startFrame, handling the events in its buffer on the way. Unlike
+    // handleFrames it doesn't touch the position, so a track can be rendered ahead of it.
+    // liveEvents are merged in by frame, whether or not canHandleEvents is set. Only the thread that
+    // renders the track's current block may pass them.
+    void renderTrack(track_index_t trackIndex, Buffer<>& buffer, position_frame_t startFrame, uint32_t numFramesToRender, bool canHandleEvents, LiveEventQueue<>* liveEvents = nullptr);
+    // Handles all of a track's live events at once, for when the position isn't moving
+    void handleLiveEvents(track_index_t trackIndex);
+    // Hands the volume the last batch set, if any, to handleEvent. Renderers that hold the batch
+    // lock call it for each track before rendering, so the volume changes in the same block as
+    // the batch's events. handleFrames does this itself.
+    void handlePendingVolume(track_index_t trackIndex);
+    LiveEventQueue<>* getLiveEventQueue(track_index_t trackIndex);
+    // Moves the position on to the end of a block that started at startFrame, and publishes when
+    // it started rendering. hostTimeUs is from RenderClock::nowUs().
+    void advancePosition(position_frame_t startFrame, uint32_t numFramesRendered, uint64_t hostTimeUs);
+    // Adds events to a track's buffer, each SEEK_EVENT followed by the controller changes that
+    // chase the track to the frame it seeks to. Returns how many of the given events were added.
+    uint32_t addEvents(track_index_t trackIndex, Buffer<>& buffer, const SchedulerEvent* events, uint32_t eventsCount);
+    void releaseBlockBatchLock();
+
     std::unordered_map<track_index_t, std::shared_ptr<Buffer<>>> mBufferMap = {};
     std::unordered_map<track_index_t, bool> mHasRenderedMap = {};
+    std::unordered_map<track_index_t, std::shared_ptr<LiveEventQueue<>>> mLiveEventQueueMap = {};
+    // Volumes set by batches, for the audio thread to pick up. kNoPendingVolume if there is none.
+    std::unordered_map<track_index_t, std::shared_ptr<std::atomic<float>>> mPendingVolumeMap = {};
+    static constexpr float kNoPendingVolume = -1.0f;
+    // Held while a batch is applied. Renderers may only try_lock it, or try_lock_shared it when
+    // several threads render tracks at once.
+    SharedSpinLock mBatchLock;
+    // Owned from the first track of a block to the last one when the try_lock succeeded
+    std::unique_lock<SharedSpinLock> mBlockBatchLock { mBatchLock, std::defer_lock };
+    bool mHasTriedBlockBatchLock = false;
 private:
+    // Only used off the audio thread, when events are scheduled
+    std::unordered_map<track_index_t, std::unique_ptr<ControllerTimeline>> mControllerTimelineMap = {};
+    std::vector<SchedulerEvent> mChaseEvents;
     bool mIsPlaying = false;
     position_frame_t mPositionFrames = 0;
+    RenderClock mRenderClock;
+    double mSampleRate = 44100.0;
+    std::atomic<uint32_t> mOutputLatencyFrames { 0 };
+    // When the first track of the current block was handled, 0 before that
+    uint64_t mBlockHostTimeUs = 0;
 };
 
 #endif
@@ -0,0 +1,22 @@
+#ifndef BatchCommand_h
+#define BatchCommand_h
+
+#include <stdint.h>
+
+// Remember to keep lib/models/command_batch.dart in sync with this file.
+
+// A batch is a packed stream of commands. Each command starts with a header, and
+// BATCH_SCHEDULE_EVENTS headers are followed by `argument` raw SchedulerEvents.
+struct BatchCommandHeader {
+    int32_t trackIndex;
+    uint32_t opcode;
+    uint32_t argument; // fromFrame, event count, or the bits of a float volume, depending on opcode
+};
+
+enum BatchOpcode {
+    BATCH_CLEAR_EVENTS = 0,
+    BATCH_SCHEDULE_EVENTS = 1,
+    BATCH_SET_VOLUME = 2,
+};
+
+#endif /* BatchCommand_h */
@@ -53,6 +53,18 @@ public:
         }
     }
 
+    // Reads the event index places after the top, without removing anything. If other threads add
+    // or remove events meanwhile, the event may already be gone, so only use it as a hint.
+    bool peekAt(buffer_index_t index, SchedulerEvent& event) {
+        buffer_index_t readPosition = mReadPosition;
+        if (static_cast<buffer_index_t>(mWritePosition - readPosition) <= index) {
+            return false;
+        } else {
+            event = mEvents[mask(readPosition + index)];
+            return true;
+        }
+    }
+
     bool removeTop() {
         if (isEmpty()) {
             return false;
@@ -0,0 +1,154 @@
+#include "ControllerTimeline.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    const uint8_t kControlChange = 0xB0;
+    const uint8_t kProgramChange = 0xC0;
+    const uint8_t kPitchBend = 0xE0;
+
+    const uint8_t kBankSelectMsb = 0;
+    const uint8_t kBankSelectLsb = 32;
+
+    uint8_t getDefaultCCValue(uint8_t ccNumber) {
+        switch (ccNumber) {
+            case 7: return 100;  // Volume
+            case 8: return 64;   // Balance
+            case 10: return 64;  // Pan
+            case 11: return 127; // Expression
+            default: return 0;
+        }
+    }
+}
+
+ControllerTimeline::ControllerTimeline(const SchedulerEvent* events, uint32_t eventsCount) {
+    ControllerState state;
+    memset(state.data(), kUnsetController, sizeof(ControllerState));
+
+    for (uint32_t i = 0; i < eventsCount; i++) {
+        if (events[i].type != MIDI_EVENT) continue;
+
+        const auto& data = events[i].data;
+        if (!isChased(data[0], data[1])) continue;
+
+        mChanges.push_back({ events[i].frame, data[0], data[1], data[2] });
+
+        // Whatever the track uses starts out at its default
+        auto& channel = state[data[0] & 0x0F];
+        const uint8_t statusCode = data[0] & 0xF0;
+
+        if (statusCode == kControlChange) {
+            channel.cc[data[1]] = getDefaultCCValue(data[1]);
+        } else if (statusCode == kProgramChange) {
+            channel.program = 0;
+        } else {
+            // Centred, as a 14-bit value with the LSB in data1
+            channel.pitchBend[0] = 0;
+            channel.pitchBend[1] = 64;
+        }
+    }
+
+    // Every controller the track uses is set from the start, so each seek takes as many events
+    std::vector<SchedulerEvent> chaseEvents;
+    appendChaseEvents(state, 0, chaseEvents);
+    mChaseEventCount = static_cast<uint32_t>(chaseEvents.size());
+
+    // Events with the same frame keep their order
+    std::stable_sort(mChanges.begin(), mChanges.end(), [](const ControllerChange& a, const ControllerChange& b) {
+        return a.frame < b.frame;
+    });
+
+    mCheckpoints.reserve(mChanges.size() / kCheckpointInterval + 1);
+
+    for (size_t i = 0; i < mChanges.size(); i++) {
+        if (i % kCheckpointInterval == 0) mCheckpoints.push_back(state);
+
+        applyChange(mChanges[i], state);
+    }
+
+    if (mChanges.size() % kCheckpointInterval == 0) mCheckpoints.push_back(state);
+}
+
+void ControllerTimeline::getStateAt(position_frame_t frame, ControllerState& state) const {
+    auto end = std::lower_bound(mChanges.begin(), mChanges.end(), frame, [](const ControllerChange& change, position_frame_t frame) {
+        return change.frame < frame;
+    });
+    const size_t changeCount = end - mChanges.begin();
+    const size_t checkpoint = changeCount / kCheckpointInterval;
+
+    state = mCheckpoints[checkpoint];
+
+    for (size_t i = checkpoint * kCheckpointInterval; i < changeCount; i++) {
+        applyChange(mChanges[i], state);
+    }
+}
+
+void ControllerTimeline::appendChaseEvents(const ControllerState& state, position_frame_t eventFrame, std::vector<SchedulerEvent>& events) {
+    auto append = [&](uint8_t status, uint8_t data1, uint8_t data2) {
+        SchedulerEvent event = {};
+        event.frame = eventFrame;
+        event.type = MIDI_EVENT;
+        event.data[0] = status;
+        event.data[1] = data1;
+        event.data[2] = data2;
+
+        events.push_back(event);
+    };
+
+    for (uint8_t channelIndex = 0; channelIndex < 16; channelIndex++) {
+        const auto& channel = state[channelIndex];
+
+        for (uint8_t ccNumber : { kBankSelectMsb, kBankSelectLsb }) {
+            if (channel.cc[ccNumber] != kUnsetController) {
+                append(kControlChange | channelIndex, ccNumber, channel.cc[ccNumber]);
+            }
+        }
+
+        if (channel.program != kUnsetController) {
+            append(kProgramChange | channelIndex, channel.program, 0);
+        }
+
+        for (uint8_t ccNumber = 0; ccNumber < 120; ccNumber++) {
+            if (ccNumber == kBankSelectMsb || ccNumber == kBankSelectLsb) continue;
+
+            if (channel.cc[ccNumber] != kUnsetController) {
+                append(kControlChange | channelIndex, ccNumber, channel.cc[ccNumber]);
+            }
+        }
+
+        if (channel.pitchBend[0] != kUnsetController) {
+            append(kPitchBend | channelIndex, channel.pitchBend[0], channel.pitchBend[1]);
+        }
+    }
+}
+
+bool ControllerTimeline::isChased(uint8_t status, uint8_t data1) {
+    const uint8_t statusCode = status & 0xF0;
+
+    if (statusCode == kProgramChange || statusCode == kPitchBend) return true;
+    if (statusCode != kControlChange) return false;
+
+    // Data entry (6, 38), data increment and decrement (96, 97), NRPN and RPN (98-101), and the
+    // channel mode messages (120-127)
+    switch (data1) {
+        case 6: case 38: case 96: case 97: case 98: case 99: case 100: case 101:
+            return false;
+        default:
+            return data1 < 120;
+    }
+}
+
+void ControllerTimeline::applyChange(const ControllerChange& change, ControllerState& state) {
+    auto& channel = state[change.status & 0x0F];
+    const uint8_t statusCode = change.status & 0xF0;
+
+    if (statusCode == kControlChange) {
+        channel.cc[change.data1] = change.data2;
+    } else if (statusCode == kProgramChange) {
+        channel.program = change.data1;
+    } else {
+        channel.pitchBend[0] = change.data1;
+        channel.pitchBend[1] = change.data2;
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef ControllerTimeline_h
+#define ControllerTimeline_h
+
+#ifdef __cplusplus
+#include <array>
+#include <vector>
+#include "SchedulerEvent.h"
+
+// The controllers of one MIDI channel. Sustain is CC 64.
+struct ChannelControllerState {
+    // kUnsetController where the track never sets the controller
+    uint8_t cc[128];
+    uint8_t program;
+    // data1 and data2 of the last pitch bend, as they were scheduled
+    uint8_t pitchBend[2];
+};
+
+typedef std::array<ChannelControllerState, 16> ControllerState;
+
+const uint8_t kUnsetController = 0xFF;
+
+/**
+ * The controller changes of a track (CCs, program changes and pitch bends) along the sequence,
+ * with a full ControllerState checkpoint every kCheckpointInterval changes. The state at any
+ * frame is the nearest checkpoint before it plus at most kCheckpointInterval - 1 changes, so
+ * chasing it costs the same wherever the frame is in the song.
+ *
+ * Controllers the track uses start out at their MIDI defaults, so seeking to before the first
+ * change puts them back. Controllers it never uses are left alone. Channel mode messages and
+ * RPN/NRPN data entry aren't chased, since replaying them out of order would do damage.
+ */
+class ControllerTimeline {
+public:
+    static constexpr uint32_t kCheckpointInterval = 128;
+    // The 112 chased CCs, a program change and a pitch bend, on every channel
+    static constexpr uint32_t kMaxChaseEvents = 16 * 114;
+
+    // events are the track's MIDI events sorted by frame, with frames relative to the start of
+    // the sequence. Anything that isn't a controller change is skipped.
+    ControllerTimeline(const SchedulerEvent* events, uint32_t eventsCount);
+
+    // The state just before frame, so changes on frame itself are left to the scheduled events
+    void getStateAt(position_frame_t frame, ControllerState& state) const;
+
+    // How many events chase the track after each seek, the same wherever it seeks to
+    uint32_t getChaseEventCount() const { return mChaseEventCount; }
+
+    // Appends the MIDI events that bring the instruments to state, on eventFrame. Bank select
+    // comes before the program change, and the program change before the other controllers.
+    static void appendChaseEvents(const ControllerState& state, position_frame_t eventFrame, std::vector<SchedulerEvent>& events);
+
+private:
+    struct ControllerChange {
+        position_frame_t frame;
+        uint8_t status;
+        uint8_t data1;
+        uint8_t data2;
+    };
+
+    static bool isChased(uint8_t status, uint8_t data1);
+    static void applyChange(const ControllerChange& change, ControllerState& state);
+
+    std::vector<ControllerChange> mChanges;
+    // mCheckpoints[i] is the state after the first i * kCheckpointInterval changes
+    std::vector<ControllerState> mCheckpoints;
+    uint32_t mChaseEventCount = 0;
+};
+
+#endif
+#endif /* ControllerTimeline_h */
@@ -0,0 +1,83 @@
+#ifndef LiveEventQueue_h
+#define LiveEventQueue_h
+
+#ifdef __cplusplus
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "SchedulerEvent.h"
+
+/**
+ * A bounded queue of live events for one track, which any number of threads can push to and the
+ * audio thread pops from without locking. Each cell has a sequence number that says whether it is
+ * free for the push at a given position or holds the event for the pop at that position, so a
+ * producer only has to claim a position with one compare-and-swap, and never waits on the audio
+ * thread.
+ *
+ * peek() and removeTop() follow Buffer, and must only be called from one thread at a time.
+ */
+template <uint32_t Capacity = 256>
+class LiveEventQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    LiveEventQueue() {
+        for (uint32_t i = 0; i < Capacity; i++) {
+            mCells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns false, dropping the event, if the queue is full
+    bool push(const SchedulerEvent& event) {
+        auto position = mPushPosition.load(std::memory_order_relaxed);
+
+        while (true) {
+            auto& cell = mCells[position & kMask];
+            const auto sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<int32_t>(sequence - position);
+
+            if (difference == 0) {
+                if (mPushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.event = event;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                // The cell still holds the event from a lap ago
+                return false;
+            } else {
+                position = mPushPosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool peek(SchedulerEvent& event) const {
+        const auto& cell = mCells[mPopPosition & kMask];
+        if (cell.sequence.load(std::memory_order_acquire) != mPopPosition + 1) return false;
+
+        event = cell.event;
+        return true;
+    }
+
+    // Only after peek() returned true
+    void removeTop() {
+        mCells[mPopPosition & kMask].sequence.store(mPopPosition + Capacity, std::memory_order_release);
+        mPopPosition++;
+    }
+
+private:
+    static constexpr uint32_t kMask = Capacity - 1;
+
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        SchedulerEvent event;
+    };
+
+    std::array<Cell, Capacity> mCells;
+    // Apart, so producers and the audio thread don't write to the same cache line
+    alignas(64) std::atomic<uint32_t> mPushPosition { 0 };
+    alignas(64) uint32_t mPopPosition = 0;
+};
+#endif
+
+#endif /* LiveEventQueue_h */
@@ -0,0 +1,80 @@
+#ifndef RenderClock_h
+#define RenderClock_h
+
+#ifdef __cplusplus
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "SchedulerEvent.h"
+
+// When the last block was rendered, as published by the audio thread
+struct RenderTimestamp {
+    // The first frame of the block
+    position_frame_t frame;
+    uint32_t numFrames;
+    // Monotonic time when the block started rendering, from RenderClock::nowUs()
+    uint64_t hostTimeUs;
+    // How long a frame takes to reach the speaker once it is rendered
+    uint32_t outputLatencyFrames;
+};
+
+/**
+ * Lets the audio thread publish a RenderTimestamp that any other thread can read without locking
+ * it. This is a seqlock: the writer makes the sequence odd while it writes, and a reader retries
+ * until it reads the same even sequence before and after the fields, so it never sees half of one
+ * block and half of another. The writer never waits.
+ *
+ * publish() must only be called from one thread at a time.
+ */
+class RenderClock {
+public:
+    static uint64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void publish(const RenderTimestamp& timestamp) {
+        const auto sequence = mSequence.load(std::memory_order_relaxed);
+
+        mSequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        mFrame.store(timestamp.frame, std::memory_order_relaxed);
+        mNumFrames.store(timestamp.numFrames, std::memory_order_relaxed);
+        mHostTimeUs.store(timestamp.hostTimeUs, std::memory_order_relaxed);
+        mOutputLatencyFrames.store(timestamp.outputLatencyFrames, std::memory_order_relaxed);
+
+        mSequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Returns false if nothing has been published yet
+    bool read(RenderTimestamp& timestamp) const {
+        uint32_t sequenceBefore;
+        uint32_t sequenceAfter;
+
+        do {
+            sequenceBefore = mSequence.load(std::memory_order_acquire);
+            if (sequenceBefore & 1) continue;
+
+            timestamp.frame = mFrame.load(std::memory_order_relaxed);
+            timestamp.numFrames = mNumFrames.load(std::memory_order_relaxed);
+            timestamp.hostTimeUs = mHostTimeUs.load(std::memory_order_relaxed);
+            timestamp.outputLatencyFrames = mOutputLatencyFrames.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            sequenceAfter = mSequence.load(std::memory_order_relaxed);
+        } while ((sequenceBefore & 1) || sequenceBefore != sequenceAfter);
+
+        return sequenceBefore != 0;
+    }
+
+private:
+    std::atomic<uint32_t> mSequence { 0 };
+    std::atomic<position_frame_t> mFrame { 0 };
+    std::atomic<uint32_t> mNumFrames { 0 };
+    std::atomic<uint64_t> mHostTimeUs { 0 };
+    std::atomic<uint32_t> mOutputLatencyFrames { 0 };
+};
+#endif
+
+#endif /* RenderClock_h */
@@ -15,6 +15,22 @@ VolumeEventData::VolumeEventData(uint8_t* data) {
     this->volume = *(float*)data;
 }
 
+EffectParamEventData::EffectParamEventData(uint8_t* data) {
+    this->chain = *data;
+    this->slot = *(data + 1);
+    this->parameter = *(data + 2);
+    this->value = *(float*)(data + 4);
+}
+
+SendLevelEventData::SendLevelEventData(uint8_t* data) {
+    this->bus = *data;
+    this->level = *(float*)(data + 4);
+}
+
+SeekEventData::SeekEventData(uint8_t* data) {
+    this->frame = *(position_frame_t*)data;
+}
+
 void rawEventDataToEvents(const uint8_t* rawEventData, uint32_t eventsCount, struct SchedulerEvent* events) {
     for (int32_t i = 0; i < eventsCount; i++) {
         const uint8_t* nextEventPtr = rawEventData + (i * sizeof(SchedulerEvent));
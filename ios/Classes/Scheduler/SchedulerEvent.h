@@ -16,8 +16,15 @@ struct SchedulerEvent {
 enum EventType {
     MIDI_EVENT = 0,
     VOLUME_EVENT = 1,
+    EFFECT_PARAM_EVENT = 2,
+    SEND_LEVEL_EVENT = 3,
+    SEEK_EVENT = 4,
 };
 
+// Effect chain ids used by EFFECT_PARAM_EVENT. Ids 1 to 254 select aux bus (id - 1).
+const uint8_t TRACK_INSERT_CHAIN = 0;
+const uint8_t MASTER_CHAIN = 255;
+
 #ifdef __cplusplus
 class MidiEventData {
 public:
@@ -35,6 +42,34 @@ public:
     
     float volume;
 };
+
+class EffectParamEventData {
+public:
+    EffectParamEventData(uint8_t* data);
+
+    uint8_t chain;
+    uint8_t slot;
+    uint8_t parameter;
+    float value;
+};
+
+class SendLevelEventData {
+public:
+    SendLevelEventData(uint8_t* data);
+
+    uint8_t bus;
+    float level;
+};
+
+// Marks a jump in the sequence: frame is where the sequence continues from. An instrument that
+// plays back rendered audio plays that frame of it next, and the scheduler chases the track's
+// controllers there.
+class SeekEventData {
+public:
+    SeekEventData(uint8_t* data);
+
+    position_frame_t frame;
+};
 #endif
 
 #ifdef __cplusplus
@@ -0,0 +1,77 @@
+#ifndef SpinLock_h
+#define SpinLock_h
+
+#ifdef __cplusplus
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// A minimal lock for short sections. The audio thread must only use try_lock(), so it never waits
+// on a non-realtime thread. It may hold the lock for up to a block, so lock() yields while it waits.
+class SpinLock {
+public:
+    void lock() {
+        while (mFlag.test_and_set(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    bool try_lock() {
+        return !mFlag.test_and_set(std::memory_order_acquire);
+    }
+
+    void unlock() {
+        mFlag.clear(std::memory_order_release);
+    }
+
+private:
+    std::atomic_flag mFlag = ATOMIC_FLAG_INIT;
+};
+
+// A SpinLock that readers can share. Readers only use try_lock_shared(), which fails as soon as a
+// writer is waiting, so a writer gets in once the readers that are already in have left.
+class SharedSpinLock {
+public:
+    void lock() {
+        while (mState.fetch_or(kWriter, std::memory_order_acquire) & kWriter) {
+            std::this_thread::yield();
+        }
+
+        while (mState.load(std::memory_order_acquire) != kWriter) {
+            std::this_thread::yield();
+        }
+    }
+
+    bool try_lock() {
+        uint32_t expected = 0;
+        return mState.compare_exchange_strong(expected, kWriter, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock() {
+        mState.store(0, std::memory_order_release);
+    }
+
+    bool try_lock_shared() {
+        auto state = mState.load(std::memory_order_relaxed);
+
+        while (!(state & kWriter)) {
+            if (mState.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void unlock_shared() {
+        mState.fetch_sub(1, std::memory_order_release);
+    }
+
+private:
+    // The writer's bit, above the count of readers
+    static constexpr uint32_t kWriter = 0x80000000;
+    std::atomic<uint32_t> mState { 0 };
+};
+#endif
+
+#endif /* SpinLock_h */
@@ -38,6 +38,9 @@ func sfizz_adapter_deallocate_render_resources(_ adapter: SfizzDSPKernelAdapter)
 @_silgen_name("sfizz_adapter_get_internal_render_block")
 func sfizz_adapter_get_internal_render_block(_ adapter: SfizzDSPKernelAdapter) -> AUInternalRenderBlock
 
+@_silgen_name("sfizz_adapter_set_oversampling_factor")
+func sfizz_adapter_set_oversampling_factor(_ adapter: SfizzDSPKernelAdapter, _ factor: Int32)
+
 @_silgen_name("sfizz_adapter_load_sfz_file")
 func sfizz_adapter_load_sfz_file(_ adapter: SfizzDSPKernelAdapter, _ path: UnsafePointer<CChar>, _ tuningPath: UnsafePointer<CChar>) -> Bool
 
@@ -75,6 +78,12 @@ func SchedulerGetTrackVolume(_ scheduler: UnsafeMutableRawPointer, _ trackIndex:
 @_silgen_name("SchedulerGetLastRenderTimeUs")
 func SchedulerGetLastRenderTimeUs(_ scheduler: UnsafeMutableRawPointer) -> UInt64
 
+@_silgen_name("SchedulerGetAudibleFrame")
+func SchedulerGetAudibleFrame(_ scheduler: UnsafeMutableRawPointer) -> UInt32
+
+@_silgen_name("SchedulerSetOutputLatency")
+func SchedulerSetOutputLatency(_ scheduler: UnsafeMutableRawPointer, _ latencyFrames: UInt32)
+
 @_silgen_name("SchedulerGetBufferAvailableCount")
 func SchedulerGetBufferAvailableCount(_ scheduler: UnsafeMutableRawPointer, _ trackIndex: track_index_t) -> UInt32
 
@@ -87,6 +96,12 @@ func SchedulerAddEvents(_ scheduler: UnsafeMutableRawPointer, _ trackIndex: trac
 @_silgen_name("SchedulerClearEvents")
 func SchedulerClearEvents(_ scheduler: UnsafeMutableRawPointer, _ trackIndex: track_index_t, _ fromFrame: position_frame_t)
 
+@_silgen_name("SchedulerSetControllerTimeline")
+func SchedulerSetControllerTimeline(_ scheduler: UnsafeMutableRawPointer, _ trackIndex: track_index_t, _ events: UnsafePointer<SchedulerEvent>, _ numEvents: UInt32)
+
+@_silgen_name("SchedulerApplyBatch")
+func SchedulerApplyBatch(_ scheduler: UnsafeMutableRawPointer, _ commandData: UnsafePointer<UInt8>, _ commandDataSize: UInt32, _ results: UnsafeMutablePointer<UInt32>?) -> UInt32
+
 @_silgen_name("SchedulerGetPosition")
 func SchedulerGetPosition(_ scheduler: UnsafeMutableRawPointer) -> UInt32
 
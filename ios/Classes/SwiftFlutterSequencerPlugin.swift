@@ -220,25 +220,29 @@ func destroyEngine() {
 }
 
 @_cdecl("add_track_sfz")
-func addTrackSfz(sfzPath: UnsafePointer<CChar>, tuningPath: UnsafePointer<CChar>, callbackPort: Dart_Port) {
+func addTrackSfz(sfzPath: UnsafePointer<CChar>, tuningPath: UnsafePointer<CChar>, oversamplingFactor: Int32, callbackPort: Dart_Port) {
     guard let engine = plugin.engine else {
         print("[DEBUG] Engine not available, returning error track index")
         callbackToDartInt32(callbackPort, -1)
         return
     }
-    engine.addTrackSfz(sfzPath: sfzPath, tuningPath: tuningPath) { trackIndex in
+    var loadOptions = SfzLoadOptions()
+    loadOptions.oversamplingFactor = oversamplingFactor
+    engine.addTrackSfz(sfzPath: sfzPath, tuningPath: tuningPath, loadOptions: loadOptions) { trackIndex in
         callbackToDartInt32(callbackPort, Int32(trackIndex))
     }
 }
 
 @_cdecl("add_track_sfz_string")
-func addTrackSfzString(sampleRoot: UnsafePointer<CChar>, sfzString: UnsafePointer<CChar>, tuningString: UnsafePointer<CChar>, callbackPort: Dart_Port) {
+func addTrackSfzString(sampleRoot: UnsafePointer<CChar>, sfzString: UnsafePointer<CChar>, tuningString: UnsafePointer<CChar>, oversamplingFactor: Int32, callbackPort: Dart_Port) {
     guard let engine = plugin.engine else {
         print("[DEBUG] Engine not available, returning error track index")
         callbackToDartInt32(callbackPort, -1)
         return
     }
-    engine.addTrackSfzString(sampleRoot: sampleRoot, sfzString: sfzString, tuningString: tuningString) { trackIndex in
+    var loadOptions = SfzLoadOptions()
+    loadOptions.oversamplingFactor = oversamplingFactor
+    engine.addTrackSfzString(sampleRoot: sampleRoot, sfzString: sfzString, tuningString: tuningString, loadOptions: loadOptions) { trackIndex in
         callbackToDartInt32(callbackPort, Int32(trackIndex))
     }
 }
@@ -319,6 +323,20 @@ func getTrackVolume(trackIndex: track_index_t) -> Float32 {
     return SchedulerGetTrackVolume(scheduler, trackIndex)
 }
 
+@_cdecl("get_audible_frame")
+func getAudibleFrame() -> position_frame_t {
+    guard let engine = plugin.engine else {
+        print("[DEBUG] Engine not available, returning 0")
+        return 0
+    }
+
+    // Without the scheduler there are no render timestamps, so this is the engine's own position
+    guard let scheduler = engine.scheduler else {
+        return position_frame_t(engine.getPosition())
+    }
+    return SchedulerGetAudibleFrame(scheduler)
+}
+
 @_cdecl("get_last_render_time_us")
 func getLastRenderTimeUs() -> UInt64 {
     guard let engine = plugin.engine, let scheduler = engine.scheduler else {
@@ -440,6 +458,32 @@ func clearEvents(trackIndex: track_index_t, fromFrame: position_frame_t) {
     SchedulerClearEvents(scheduler, trackIndex, fromFrame)
 }
 
+@_cdecl("set_controller_timeline")
+func setControllerTimeline(trackIndex: track_index_t, eventData: UnsafePointer<UInt8>, eventsCount: UInt32) -> UInt32 {
+    guard let engine = plugin.engine, let scheduler = engine.scheduler else {
+        print("[DEBUG] Scheduler not available, skipping controller timeline")
+        return 0
+    }
+
+    let events = UnsafeMutablePointer<SchedulerEvent>.allocate(capacity: Int(eventsCount))
+
+    rawEventDataToEvents(eventData, eventsCount, events)
+
+    let chaseEventCount = SchedulerSetControllerTimeline(scheduler, trackIndex, UnsafePointer(events), eventsCount)
+
+    events.deallocate()
+    return chaseEventCount
+}
+
+@_cdecl("apply_batch")
+func applyBatch(commandData: UnsafePointer<UInt8>, commandDataSize: UInt32, results: UnsafeMutablePointer<UInt32>?) -> UInt32 {
+    guard let engine = plugin.engine, let scheduler = engine.scheduler else {
+        print("[DEBUG] Scheduler not available, returning 0")
+        return 0
+    }
+    return SchedulerApplyBatch(scheduler, commandData, commandDataSize, results)
+}
+
 @_cdecl("engine_play")
 func enginePlay() {
     guard let engine = plugin.engine else {
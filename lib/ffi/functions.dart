@@ -12,11 +12,11 @@ typedef DestroyEngineFunction = void Function();
 typedef AddTrackSf2Native = Void Function(Pointer<Utf8> path, Bool isAsset, Int32 presetIndex, Int64 callbackPort);
 typedef AddTrackSf2Function = void Function(Pointer<Utf8> path, bool isAsset, int presetIndex, int callbackPort);
 
-typedef AddTrackSfzNative = Void Function(Pointer<Utf8> sfzPath, Pointer<Utf8> tuningPath, Int64 callbackPort);
-typedef AddTrackSfzFunction = void Function(Pointer<Utf8> sfzPath, Pointer<Utf8> tuningPath, int callbackPort);
+typedef AddTrackSfzNative = Void Function(Pointer<Utf8> sfzPath, Pointer<Utf8> tuningPath, Int32 oversamplingFactor, Int64 callbackPort);
+typedef AddTrackSfzFunction = void Function(Pointer<Utf8> sfzPath, Pointer<Utf8> tuningPath, int oversamplingFactor, int callbackPort);
 
-typedef AddTrackSfzStringNative = Void Function(Pointer<Utf8> sampleRoot, Pointer<Utf8> sfzString, Pointer<Utf8> tuningString, Int64 callbackPort);
-typedef AddTrackSfzStringFunction = void Function(Pointer<Utf8> sampleRoot, Pointer<Utf8> sfzString, Pointer<Utf8> tuningString, int callbackPort);
+typedef AddTrackSfzStringNative = Void Function(Pointer<Utf8> sampleRoot, Pointer<Utf8> sfzString, Pointer<Utf8> tuningString, Int32 oversamplingFactor, Int64 callbackPort);
+typedef AddTrackSfzStringFunction = void Function(Pointer<Utf8> sampleRoot, Pointer<Utf8> sfzString, Pointer<Utf8> tuningString, int oversamplingFactor, int callbackPort);
 
 typedef RemoveTrackNative = Void Function(Uint32 trackIndex);
 typedef RemoveTrackFunction = void Function(int trackIndex);
@@ -49,4 +49,101 @@ typedef EnginePlayNative = Void Function();
 typedef EnginePlayFunction = void Function();
 
 typedef EnginePauseNative = Void Function();
-typedef EnginePauseFunction = void Function();
\ No newline at end of file
+typedef EnginePauseFunction = void Function();
+
+typedef ApplyBatchNative = Uint32 Function(Pointer<Uint8> commandData, Uint32 commandDataSize, Pointer<Uint32> results);
+typedef ApplyBatchFunction = int Function(Pointer<Uint8> commandData, int commandDataSize, Pointer<Uint32> results);
+
+typedef LoadTrackSf2Native = Int32 Function(Pointer<Utf8> filename, Bool isAsset, Int32 presetIndex, Int32 priority, Int64 callbackPort, Int64 progressPort);
+typedef LoadTrackSf2Function = int Function(Pointer<Utf8> filename, bool isAsset, int presetIndex, int priority, int callbackPort, int progressPort);
+
+typedef LoadTrackAudioClipNative = Int32 Function(Pointer<Utf8> filename, Float gain, Uint32 fadeInFrames, Uint32 fadeOutFrames, Int32 priority, Int64 callbackPort, Int64 progressPort);
+typedef LoadTrackAudioClipFunction = int Function(Pointer<Utf8> filename, double gain, int fadeInFrames, int fadeOutFrames, int priority, int callbackPort, int progressPort);
+
+typedef LoadTrackSfzNative = Int32 Function(Pointer<Utf8> filename, Pointer<Utf8> tuningFilename, Int32 oversamplingFactor, Int32 priority, Int64 callbackPort, Int64 progressPort);
+typedef LoadTrackSfzFunction = int Function(Pointer<Utf8> filename, Pointer<Utf8> tuningFilename, int oversamplingFactor, int priority, int callbackPort, int progressPort);
+
+typedef LoadTrackSfzStringNative = Int32 Function(Pointer<Utf8> sampleRoot, Pointer<Utf8> sfzString, Pointer<Utf8> tuningString, Int32 oversamplingFactor, Int32 priority, Int64 callbackPort, Int64 progressPort);
+typedef LoadTrackSfzStringFunction = int Function(Pointer<Utf8> sampleRoot, Pointer<Utf8> sfzString, Pointer<Utf8> tuningString, int oversamplingFactor, int priority, int callbackPort, int progressPort);
+
+typedef CancelTrackLoadNative = Bool Function(Int32 requestId);
+typedef CancelTrackLoadFunction = bool Function(int requestId);
+
+typedef SetTrackLoadPriorityNative = Void Function(Int32 requestId, Int32 priority);
+typedef SetTrackLoadPriorityFunction = void Function(int requestId, int priority);
+
+typedef AddEffectNative = Int32 Function(Uint32 trackIndex, Uint8 chain, Int32 effectType);
+typedef AddEffectFunction = int Function(int trackIndex, int chain, int effectType);
+
+typedef RemoveEffectNative = Void Function(Uint32 trackIndex, Uint8 chain, Int32 slot);
+typedef RemoveEffectFunction = void Function(int trackIndex, int chain, int slot);
+
+typedef SetBusReturnLevelNative = Void Function(Uint8 bus, Float level);
+typedef SetBusReturnLevelFunction = void Function(int bus, double level);
+
+typedef SetRenderAheadEnabledNative = Void Function(Bool isEnabled);
+typedef SetRenderAheadEnabledFunction = void Function(bool isEnabled);
+
+typedef FreezeTrackNative = Int32 Function(Uint32 trackIndex, Pointer<Uint8> eventData, Uint32 eventsCount, Uint32 numFrames, Pointer<Utf8> cachePath, Int32 priority, Int64 callbackPort);
+typedef FreezeTrackFunction = int Function(int trackIndex, Pointer<Uint8> eventData, int eventsCount, int numFrames, Pointer<Utf8> cachePath, int priority, int callbackPort);
+
+typedef UnfreezeTrackNative = Bool Function(Uint32 trackIndex);
+typedef UnfreezeTrackFunction = bool Function(int trackIndex);
+
+typedef SetControllerTimelineNative = Uint32 Function(Uint32 trackIndex, Pointer<Uint8> eventData, Uint32 eventsCount);
+typedef SetControllerTimelineFunction = int Function(int trackIndex, Pointer<Uint8> eventData, int eventsCount);
+
+typedef GetAudibleFrameNative = Uint32 Function();
+typedef GetAudibleFrameFunction = int Function();
+
+typedef SetLoadGovernorEnabledNative = Void Function(Bool isEnabled);
+typedef SetLoadGovernorEnabledFunction = void Function(bool isEnabled);
+
+typedef SetLoadGovernorThresholdsNative = Void Function(Float degradeLoad, Float recoverLoad);
+typedef SetLoadGovernorThresholdsFunction = void Function(double degradeLoad, double recoverLoad);
+
+// Matches LoadGovernorStatus in LoadGovernor.h
+final class LoadGovernorStatusStruct extends Struct {
+  @Float()
+  external double load;
+  @Float()
+  external double peakLoad;
+  @Float()
+  external double degradeLoad;
+  @Float()
+  external double recoverLoad;
+  @Int32()
+  external int stage;
+  @Uint32()
+  external int stageChanges;
+}
+
+typedef GetLoadGovernorStatusNative = Bool Function(Pointer<LoadGovernorStatusStruct> status);
+typedef GetLoadGovernorStatusFunction = bool Function(Pointer<LoadGovernorStatusStruct> status);
+
+typedef SetMeteringEnabledNative = Void Function(Bool isEnabled);
+typedef SetMeteringEnabledFunction = void Function(bool isEnabled);
+
+typedef SetSpectrumEnabledNative = Void Function(Bool isEnabled);
+typedef SetSpectrumEnabledFunction = void Function(bool isEnabled);
+
+// Matches MeterReadout in Metering.h
+final class MeterReadoutStruct extends Struct {
+  @Uint32()
+  external int updateCount;
+  @Uint32()
+  external int isSpectrumEnabled;
+  @Array(2)
+  external Array<Float> masterPeak;
+  @Array(2)
+  external Array<Float> masterRms;
+  @Array(64)
+  external Array<Float> trackPeak;
+  @Array(64)
+  external Array<Float> trackRms;
+  @Array(48)
+  external Array<Float> spectrum;
+}
+
+typedef GetMeterReadoutNative = Pointer<MeterReadoutStruct> Function();
+typedef GetMeterReadoutFunction = Pointer<MeterReadoutStruct> Function();
@@ -1,6 +1,11 @@
 import 'dart:async';
 
 import 'constants.dart';
+import 'models/command_batch.dart';
+import 'models/effects.dart';
+import 'models/load_governor.dart';
+import 'models/meter_readout.dart';
+import 'models/sfz.dart';
 import 'native_bridge.dart';
 import 'sequence.dart';
 import 'track.dart';
@@ -24,6 +29,7 @@ class GlobalState {
   int? sampleRate;
   var isEngineReady = false;
   Timer? _topOffTimer;
+  MeterReadout? _meterReadout;
   int lastTickInBuffer = 0;
   final onEngineReadyCallbacks = <Function()>[];
   
@@ -144,6 +150,80 @@ class GlobalState {
   }
 
   /// {@macro flutter_sequencer_library_private}
+  /// Adds an effect to an aux bus and returns its slot, or -1 if it could not
+  /// be added. Tracks reach the bus through their send levels.
+  int addBusEffect(int bus, int effectType) {
+    return NativeBridge.addEffect(0, EffectChain.auxBus(bus), effectType);
+  }
+
+  void removeBusEffect(int bus, int slot) {
+    NativeBridge.removeEffect(0, EffectChain.auxBus(bus), slot);
+  }
+
+  /// Sets how much of an aux bus is mixed back into the output.
+  void setBusReturnLevel(int bus, double level) {
+    NativeBridge.setBusReturnLevel(bus, level);
+  }
+
+  /// Adds an effect to the master output and returns its slot, or -1 if it
+  /// could not be added.
+  int addMasterEffect(int effectType) {
+    return NativeBridge.addEffect(0, EffectChain.MASTER, effectType);
+  }
+
+  void removeMasterEffect(int slot) {
+    NativeBridge.removeEffect(0, EffectChain.MASTER, slot);
+  }
+
+  /// Lets tracks that only play scheduled events be rendered ahead of time on
+  /// background threads, so more tracks can play at once. A track goes back to
+  /// rendering just in time while it gets live input from
+  /// [Track.startNoteNow] and friends. Does nothing where unsupported.
+  void setRenderAheadEnabled(bool isEnabled) {
+    NativeBridge.setRenderAheadEnabled(isEnabled);
+  }
+
+  /// When the audio callback runs over budget, the engine lowers the sound
+  /// quality step by step (see [LoadStage]) instead of dropping buffers, and
+  /// restores it once the load has stayed low for a while. On by default.
+  /// Does nothing where unsupported.
+  void setLoadGovernorEnabled(bool isEnabled) {
+    NativeBridge.setLoadGovernorEnabled(isEnabled);
+  }
+
+  /// Sets the load, as a fraction of the buffer duration, above which quality
+  /// is lowered and below which it is restored. recoverLoad is kept below
+  /// degradeLoad.
+  void setLoadGovernorThresholds({double degradeLoad = 0.8, double recoverLoad = 0.5}) {
+    NativeBridge.setLoadGovernorThresholds(degradeLoad, recoverLoad);
+  }
+
+  /// Returns the load governor's current load and stage, or null where
+  /// unsupported.
+  LoadGovernorStatus? getLoadGovernorStatus() {
+    return NativeBridge.getLoadGovernorStatus();
+  }
+
+  /// Starts or stops metering the level of each track and of the output.
+  /// Metering costs one pass over each buffer on the audio thread, plus a
+  /// background thread that updates the [MeterReadout] about 60 times a
+  /// second. Off by default. Does nothing where unsupported.
+  void setMeteringEnabled(bool isEnabled) {
+    NativeBridge.setMeteringEnabled(isEnabled);
+  }
+
+  /// Adds a spectrum of the output to the [MeterReadout], while metering is
+  /// enabled. Off by default.
+  void setSpectrumEnabled(bool isEnabled) {
+    NativeBridge.setSpectrumEnabled(isEnabled);
+  }
+
+  /// Returns the meters, which update in place, or null where unsupported.
+  /// Hold on to it and read it from a ticker or animation frame.
+  MeterReadout? getMeterReadout() {
+    return _meterReadout ??= NativeBridge.getMeterReadout();
+  }
+
   int usToFrames(int us) {
     if (sampleRate == null) return 0;
     return (us * SECONDS_PER_US * sampleRate!).round();
@@ -220,15 +300,25 @@ class GlobalState {
 
   /// Refills the underlying sequencer engine's event buffer to full capacity.
   void _topOffAllBuffers() {
-    _getAllTracks().forEach((track) {
-      track.topOffBuffer();
-    });
+    final batch = CommandBatch();
+    final position = NativeBridge.getPosition();
+
+    for (final track in _getAllTracks()) {
+      track.topOffBufferInto(batch, position);
+    }
+
+    NativeBridge.applyBatch(batch);
   }
 
   void _syncAllBuffers(
       [int? absoluteStartFrame, int maxEventsToSync = BUFFER_SIZE]) {
-    _getAllTracks().forEach((track) {
-      track.syncBuffer(absoluteStartFrame, maxEventsToSync);
-    });
+    final batch = CommandBatch();
+    final position = NativeBridge.getPosition();
+
+    for (final track in _getAllTracks()) {
+      track.syncBufferInto(batch, position, absoluteStartFrame, maxEventsToSync);
+    }
+
+    NativeBridge.applyBatch(batch);
   }
 }
@@ -0,0 +1,126 @@
+import 'dart:typed_data';
+
+import 'events.dart';
+
+const BATCH_COMMAND_HEADER_SIZE = 12;
+
+/// Remember to keep BatchCommand.h in sync with this file.
+
+/// A command that will be applied to one track as part of a [CommandBatch].
+class BatchCommand {
+  static const CLEAR_EVENTS = 0;
+  static const SCHEDULE_EVENTS = 1;
+  static const SET_VOLUME = 2;
+
+  BatchCommand._({
+    required this.trackIndex,
+    required this.opcode,
+    this.fromFrame = 0,
+    this.events = const [],
+    this.sampleRate = 0,
+    this.tempo = 0,
+    this.volume = 0,
+    this.onResult,
+  });
+
+  final int trackIndex;
+  final int opcode;
+  final int fromFrame;
+  final List<SchedulerEvent> events;
+  final int sampleRate;
+  final double tempo;
+  final double volume;
+
+  /// Called with the number of events that were scheduled, once the batch has
+  /// been applied. For commands other than SCHEDULE_EVENTS it is called with 0.
+  final void Function(int result)? onResult;
+
+  int get byteLength =>
+      BATCH_COMMAND_HEADER_SIZE + events.length * SCHEDULER_EVENT_SIZE;
+
+  void serializeInto(ByteData data, int offset) {
+    data.setInt32(offset, trackIndex, Endian.host);
+    data.setUint32(offset + 4, opcode, Endian.host);
+
+    switch (opcode) {
+      case CLEAR_EVENTS:
+        data.setUint32(offset + 8, fromFrame, Endian.host);
+        break;
+      case SCHEDULE_EVENTS:
+        data.setUint32(offset + 8, events.length, Endian.host);
+        break;
+      case SET_VOLUME:
+        data.setFloat32(offset + 8, volume, Endian.host);
+        break;
+    }
+
+    var eventOffset = offset + BATCH_COMMAND_HEADER_SIZE;
+
+    for (final event in events) {
+      final eventBytes = event.serializeBytes(sampleRate, tempo, 0);
+
+      for (var i = 0; i < SCHEDULER_EVENT_SIZE; i++) {
+        data.setUint8(eventOffset + i, eventBytes.getUint8(i));
+      }
+      eventOffset += SCHEDULER_EVENT_SIZE;
+    }
+  }
+}
+
+/// Collects clear, schedule and volume commands for any number of tracks so
+/// that the native engine can apply them in one call. The audio thread sees
+/// either all of the commands or none of them.
+class CommandBatch {
+  final commands = <BatchCommand>[];
+
+  bool get isEmpty => commands.isEmpty;
+
+  int get byteLength =>
+      commands.fold(0, (length, command) => length + command.byteLength);
+
+  /// Clears a track's scheduled events at or after fromFrame.
+  void clearEvents(int trackIndex, int fromFrame) {
+    commands.add(BatchCommand._(
+      trackIndex: trackIndex,
+      opcode: BatchCommand.CLEAR_EVENTS,
+      fromFrame: fromFrame,
+    ));
+  }
+
+  /// Schedules events on a track. onResult receives the number of events that
+  /// fit in the track's buffer.
+  void scheduleEvents(int trackIndex, List<SchedulerEvent> events,
+      int sampleRate, double tempo,
+      [void Function(int scheduledCount)? onResult]) {
+    commands.add(BatchCommand._(
+      trackIndex: trackIndex,
+      opcode: BatchCommand.SCHEDULE_EVENTS,
+      events: events,
+      sampleRate: sampleRate,
+      tempo: tempo,
+      onResult: onResult,
+    ));
+  }
+
+  /// Sets a track's volume as soon as the batch is applied.
+  void setVolume(int trackIndex, double volume) {
+    commands.add(BatchCommand._(
+      trackIndex: trackIndex,
+      opcode: BatchCommand.SET_VOLUME,
+      volume: volume,
+    ));
+  }
+
+  Uint8List serialize() {
+    final bytes = Uint8List(byteLength);
+    final data = ByteData.sublistView(bytes);
+    var offset = 0;
+
+    for (final command in commands) {
+      command.serializeInto(data, offset);
+      offset += command.byteLength;
+    }
+
+    return bytes;
+  }
+}
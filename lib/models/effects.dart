@@ -0,0 +1,69 @@
+/// Remember to keep android/src/main/cpp/AndroidEffects in sync with this file.
+
+/// The number of aux buses that tracks can send to.
+const MAX_AUX_BUSES = 4;
+
+/// The number of effects each track, aux bus and the master output can hold.
+const MAX_EFFECTS_PER_CHAIN = 4;
+
+/// The effects that can be added to a track, an aux bus or the master output.
+class EffectType {
+  static const REVERB = 0;
+  static const COMPRESSOR = 1;
+  static const EQ = 2;
+  static const LIMITER = 3;
+}
+
+/// Identifies an effect chain in an [EffectParamEvent].
+class EffectChain {
+  /// The insert effects of the track the event is on.
+  static const TRACK_INSERTS = 0;
+  static const MASTER = 255;
+
+  static int auxBus(int bus) {
+    if (bus < 0 || bus >= MAX_AUX_BUSES) {
+      throw 'bus must be in range 0-${MAX_AUX_BUSES - 1}';
+    }
+
+    return bus + 1;
+  }
+}
+
+/// Parameters of [EffectType.REVERB]. All of them range from 0 to 1.
+class ReverbParam {
+  static const ROOM_SIZE = 0;
+  static const DAMPING = 1;
+  static const WET = 2;
+  static const DRY = 3;
+  static const WIDTH = 4;
+}
+
+/// Parameters of [EffectType.COMPRESSOR].
+class CompressorParam {
+  static const THRESHOLD_DB = 0;
+  static const RATIO = 1;
+  static const ATTACK_MS = 2;
+  static const RELEASE_MS = 3;
+  static const MAKEUP_DB = 4;
+}
+
+/// Parameters of [EffectType.EQ]. SHAPE is one of the EqShape values.
+class EqParam {
+  static const FREQUENCY = 0;
+  static const GAIN_DB = 1;
+  static const Q = 2;
+  static const SHAPE = 3;
+}
+
+/// Parameters of [EffectType.LIMITER]. The master output always ends with a
+/// limiter, so this is only needed to limit a track or bus on its own.
+class LimiterParam {
+  static const CEILING_DB = 0;
+  static const RELEASE_MS = 1;
+}
+
+class EqShape {
+  static const PEAK = 0;
+  static const LOW_SHELF = 1;
+  static const HIGH_SHELF = 2;
+}
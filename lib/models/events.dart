@@ -12,6 +12,9 @@ const MIDI_STATUS_NOTE_OFF = 128;
 abstract class SchedulerEvent {
   static const MIDI_EVENT = 0;
   static const VOLUME_EVENT = 1;
+  static const EFFECT_PARAM_EVENT = 2;
+  static const SEND_LEVEL_EVENT = 3;
+  static const SEEK_EVENT = 4;
 
   SchedulerEvent({
     required this.beat,
@@ -46,6 +49,14 @@ class MidiEvent extends SchedulerEvent {
   final int midiData1;
   final int midiData2;
 
+  /// Whether this is a control change, program change or pitch bend, which the
+  /// engine chases when the track seeks.
+  bool get isControllerChange {
+    final statusCode = midiStatus & 0xF0;
+
+    return statusCode == 0xB0 || statusCode == 0xC0 || statusCode == 0xE0;
+  }
+
   @override
   ByteData serializeBytes(int sampleRate, double tempo, int correctionFrames) {
     final data = super.serializeBytes(sampleRate, tempo, correctionFrames);
@@ -151,3 +162,81 @@ class VolumeEvent extends SchedulerEvent {
     return data;
   }
 }
+
+/// Describes an event that will change a parameter of an effect. See
+/// models/effects.dart for the chains, effect types and their parameters.
+class EffectParamEvent extends SchedulerEvent {
+  EffectParamEvent({
+    required super.beat,
+    required this.chain,
+    required this.slot,
+    required this.parameter,
+    required this.value,
+  }) : super(type: SchedulerEvent.EFFECT_PARAM_EVENT);
+
+  final int chain;
+  final int slot;
+  final int parameter;
+  final double value;
+
+  @override
+  ByteData serializeBytes(int sampleRate, double tempo, int correctionFrames) {
+    final data = super.serializeBytes(sampleRate, tempo, correctionFrames);
+
+    data.setUint8(SCHEDULER_EVENT_DATA_OFFSET, chain);
+    data.setUint8(SCHEDULER_EVENT_DATA_OFFSET + 1, slot);
+    data.setUint8(SCHEDULER_EVENT_DATA_OFFSET + 2, parameter);
+    data.setFloat32(SCHEDULER_EVENT_DATA_OFFSET + 4, value, Endian.host);
+
+    return data;
+  }
+}
+
+/// Describes an event that will change how much of a track is sent to an aux
+/// bus. The send is post-fader.
+class SendLevelEvent extends SchedulerEvent {
+  SendLevelEvent({
+    required super.beat,
+    required this.bus,
+    required this.level,
+  }) : super(type: SchedulerEvent.SEND_LEVEL_EVENT);
+
+  final int bus;
+  final double level;
+
+  @override
+  ByteData serializeBytes(int sampleRate, double tempo, int correctionFrames) {
+    final data = super.serializeBytes(sampleRate, tempo, correctionFrames);
+
+    data.setUint8(SCHEDULER_EVENT_DATA_OFFSET, bus);
+    data.setFloat32(SCHEDULER_EVENT_DATA_OFFSET + 4, level, Endian.host);
+
+    return data;
+  }
+}
+
+/// Marks a jump in the sequence to this beat. A frozen track plays the frame
+/// of its rendered audio at the beat next, and a track with controller changes
+/// gets its controllers put back to what they are at the beat. That is the
+/// frame of the beat itself, without the correction that places the event in
+/// a later loop, so loops play the same audio every time.
+///
+/// An audio clip track plays the frame of its file at the beat instead, which
+/// is counted from [clipStartFrame], and is negative before the clip starts.
+class SeekEvent extends SchedulerEvent {
+  SeekEvent({required super.beat, this.clipStartFrame = 0})
+      : super(type: SchedulerEvent.SEEK_EVENT);
+
+  final int clipStartFrame;
+
+  @override
+  ByteData serializeBytes(int sampleRate, double tempo, int correctionFrames) {
+    final data = super.serializeBytes(sampleRate, tempo, correctionFrames);
+    final frame =
+        data.getUint32(0, Endian.host) - correctionFrames - clipStartFrame;
+
+    data.setInt32(SCHEDULER_EVENT_DATA_OFFSET, frame, Endian.host);
+
+    return data;
+  }
+}
@@ -23,7 +23,16 @@ abstract class Instrument {
 class SfzInstrument extends Instrument {
   final String? tuningPath;
 
-  SfzInstrument({required String path, required bool isAsset, this.tuningPath})
+  /// How many times the samples are upsampled as they load: 1, 2, 4 or 8.
+  /// Higher factors keep pitched-up samples cleaner, at that many times the
+  /// sample memory. Applies where sfizz plays the SFZ.
+  final int oversamplingFactor;
+
+  SfzInstrument(
+      {required String path,
+      required bool isAsset,
+      this.tuningPath,
+      this.oversamplingFactor = 1})
       : super(path, isAsset);
 }
 
@@ -40,12 +49,16 @@ class RuntimeSfzInstrument extends Instrument {
   final Sfz sfz;
   final String? tuningString;
 
+  /// See [SfzInstrument.oversamplingFactor].
+  final int oversamplingFactor;
+
   RuntimeSfzInstrument(
       {required String id,
       required bool isAsset,
       required this.sampleRoot,
       required this.sfz,
-      this.tuningString})
+      this.tuningString,
+      this.oversamplingFactor = 1})
       : super(id, isAsset);
 }
 
@@ -59,6 +72,28 @@ class Sf2Instrument extends Instrument {
       : super(path, isAsset, presetIndex: presetIndex);
 }
 
+/// Describes an audio file, such as a vocal or backing track stem, that plays
+/// in time with the sequence from [startBeat]. The file is streamed as it
+/// plays, so it can be as long as needed, and it is resampled to the engine's
+/// sample rate. [gain] is linear, and the clip fades in over [fadeInSeconds]
+/// at its start and out over [fadeOutSeconds] at its end. Anything the
+/// device's media codecs can decode works, such as WAV, MP3, AAC, FLAC and
+/// Ogg Vorbis. Android only.
+class AudioClipInstrument extends Instrument {
+  final double startBeat;
+  final double gain;
+  final double fadeInSeconds;
+  final double fadeOutSeconds;
+
+  AudioClipInstrument(
+      {required String path,
+      this.startBeat = 0.0,
+      this.gain = 1.0,
+      this.fadeInSeconds = 0.0,
+      this.fadeOutSeconds = 0.0})
+      : super(path, false);
+}
+
 /// Describes an AudioUnit instrument (Apple platforms only.)
 class AudioUnitInstrument extends Instrument {
   AudioUnitInstrument(
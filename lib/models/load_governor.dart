@@ -0,0 +1,51 @@
+/// Remember to keep android/src/main/cpp/AndroidEngine/LoadGovernor.h and
+/// ios/Classes/IInstrument/IInstrument.h in sync with this file.
+
+/// How much quality the instruments give up to keep the audio callback within
+/// its time budget. Each stage includes the ones before it.
+class LoadStage {
+  static const NORMAL = 0;
+
+  /// Cheaper resampling and oscillators in sfizz instruments.
+  static const REDUCED_QUALITY = 1;
+
+  /// New notes steal or are turned away once an instrument plays many voices.
+  static const CAPPED_POLYPHONY = 2;
+
+  /// Samples are played back without interpolation.
+  static const NEAREST_INTERPOLATION = 3;
+
+  /// The quietest voices are ended until few enough are left.
+  static const SHED_VOICES = 4;
+}
+
+/// A snapshot of the engine's load governor, for telemetry.
+class LoadGovernorStatus {
+  LoadGovernorStatus({
+    required this.load,
+    required this.peakLoad,
+    required this.degradeLoad,
+    required this.recoverLoad,
+    required this.stage,
+    required this.stageChanges,
+  });
+
+  /// Smoothed render time as a fraction of the buffer duration. Above 1.0 the
+  /// output underruns.
+  final double load;
+
+  /// The highest load of a single buffer since the previous snapshot.
+  final double peakLoad;
+
+  /// The governor lowers the stage while [load] stays above this.
+  final double degradeLoad;
+
+  /// The governor raises the stage again once [load] stays below this.
+  final double recoverLoad;
+
+  /// One of [LoadStage].
+  final int stage;
+
+  /// How many times the stage has changed since the engine started.
+  final int stageChanges;
+}
@@ -0,0 +1,62 @@
+import 'dart:ffi';
+
+import '../ffi/functions.dart';
+
+/// Remember to keep android/src/main/cpp/AndroidInstruments/Metering.h in
+/// sync with this file.
+const MAX_METERED_TRACKS = 64;
+const SPECTRUM_BANDS = 48;
+const SPECTRUM_FLOOR_DB = -120.0;
+
+/// The engine's meters, read straight from native memory. Every getter returns
+/// the current value, so nothing is copied or allocated to poll them. Levels
+/// are linear, where 1.0 is full scale.
+///
+/// The engine updates the meters about 60 times a second while metering is
+/// enabled, see [updateCount]. Values aren't updated together, so two reads
+/// may come from neighbouring updates.
+class MeterReadout {
+  MeterReadout(this._pointer);
+
+  final Pointer<MeterReadoutStruct> _pointer;
+
+  /// Goes up every time the meters are updated, so a UI can skip redrawing
+  /// when it hasn't changed.
+  int get updateCount => _pointer.ref.updateCount;
+
+  /// Peak level of the output's left (0) or right (1) channel. Peaks hold the
+  /// loudest sample and fall at 20 dB per second.
+  double masterPeak(int channel) => _pointer.ref.masterPeak[channel];
+
+  /// RMS level of the output's left (0) or right (1) channel, averaged over
+  /// about 300 ms.
+  double masterRms(int channel) => _pointer.ref.masterRms[channel];
+
+  /// Peak level of a track after its effects and volume. Tracks that are
+  /// muted or removed read 0.
+  double trackPeak(int trackIndex) =>
+      _isMeteredTrack(trackIndex) ? _pointer.ref.trackPeak[trackIndex] : 0.0;
+
+  /// RMS level of a track after its effects and volume.
+  double trackRms(int trackIndex) =>
+      _isMeteredTrack(trackIndex) ? _pointer.ref.trackRms[trackIndex] : 0.0;
+
+  bool get isSpectrumEnabled => _pointer.ref.isSpectrumEnabled != 0;
+
+  /// Level in dBFS of one of [SPECTRUM_BANDS] bands of the output, spaced
+  /// logarithmically from 20 Hz up to half the sample rate. Each band reads
+  /// its loudest frequency, so a full scale sine reads about 0 dB.
+  double spectrumBand(int band) => _pointer.ref.spectrum[band];
+
+  /// Copies the whole spectrum into bands, which must hold [SPECTRUM_BANDS]
+  /// values.
+  void readSpectrum(List<double> bands) {
+    final spectrum = _pointer.ref.spectrum;
+    for (var band = 0; band < SPECTRUM_BANDS; band++) {
+      bands[band] = spectrum[band];
+    }
+  }
+
+  bool _isMeteredTrack(int trackIndex) =>
+      trackIndex >= 0 && trackIndex < MAX_METERED_TRACKS;
+}
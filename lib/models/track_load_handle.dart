@@ -0,0 +1,57 @@
+import '../native_bridge.dart';
+
+/// Remember to keep InstrumentLoader.h in sync with these values.
+const LOAD_PROGRESS_STARTED = 0;
+const LOAD_PROGRESS_PARSED = 50;
+const LOAD_PROGRESS_READY = 100;
+
+/// Lets the caller prioritize, follow or cancel an instrument load while it
+/// waits in, or runs on, the native loader pool. Loads with a higher priority
+/// start first, so visible tracks can be given a higher priority than hidden
+/// ones.
+class TrackLoadHandle {
+  TrackLoadHandle({int priority = 0, this.onProgress}) : _priority = priority;
+
+  /// Called with the load's progress in percent. See LOAD_PROGRESS_*.
+  final void Function(int percent)? onProgress;
+
+  int _priority;
+  int? _requestId;
+  bool _isCancelled = false;
+  bool _isDone = false;
+
+  int get priority => _priority;
+
+  set priority(int value) {
+    _priority = value;
+
+    final requestId = _requestId;
+    if (requestId != null && !_isDone) {
+      NativeBridge.setTrackLoadPriority(requestId, value);
+    }
+  }
+
+  bool get isCancelled => _isCancelled;
+
+  /// Cancels the load. If the instrument has not been added yet, the load
+  /// fails with -1 instead of adding a track.
+  void cancel() {
+    if (_isCancelled) return;
+    _isCancelled = true;
+
+    final requestId = _requestId;
+    if (requestId != null && !_isDone) {
+      NativeBridge.cancelTrackLoad(requestId);
+    }
+  }
+
+  /// Binds this handle to a native load request. Called by [NativeBridge].
+  void bind(int requestId) {
+    _requestId = requestId;
+  }
+
+  /// Marks the load as finished. Called by [NativeBridge].
+  void complete() {
+    _isDone = true;
+  }
+}
@@ -4,9 +4,14 @@ import 'dart:isolate';
 import 'dart:io';
 
 import 'package:ffi/ffi.dart';
+import 'package:flutter/foundation.dart' show visibleForTesting;
 import 'package:flutter/services.dart';
 
+import 'models/command_batch.dart';
 import 'models/events.dart';
+import 'models/load_governor.dart';
+import 'models/meter_readout.dart';
+import 'models/track_load_handle.dart';
 import 'ffi/functions.dart';
 
 /// FFI bridge to native audio engine - the actual working system
@@ -17,8 +22,8 @@ class NativeBridge {
   static late final Pointer<NativeFunction<Void Function(Int64)>> _setupEngine;
   static late final Pointer<NativeFunction<Void Function()>> _destroyEngine;
   static late final Pointer<NativeFunction<Void Function(Pointer<Utf8>, Bool, Int32, Int64)>> _addTrackSf2;
-  static late final Pointer<NativeFunction<Void Function(Pointer<Utf8>, Pointer<Utf8>, Int64)>> _addTrackSfz;
-  static late final Pointer<NativeFunction<Void Function(Pointer<Utf8>, Pointer<Utf8>, Pointer<Utf8>, Int64)>> _addTrackSfzString;
+  static late final Pointer<NativeFunction<AddTrackSfzNative>> _addTrackSfz;
+  static late final Pointer<NativeFunction<AddTrackSfzStringNative>> _addTrackSfzString;
   static late final Pointer<NativeFunction<Void Function(Uint32)>> _removeTrack;
   static late final Pointer<NativeFunction<Void Function(Uint32)>> _resetTrack;
   static late final Pointer<NativeFunction<Uint32 Function()>> _getPosition;
@@ -31,6 +36,27 @@ class NativeBridge {
   static late final Pointer<NativeFunction<Void Function()>> _enginePlay;
   static late final Pointer<NativeFunction<Void Function()>> _enginePause;
   static late final Pointer<NativeFunction<Void Function()>> _engineStop;
+  static Pointer<NativeFunction<ApplyBatchNative>>? _applyBatch;
+  static Pointer<NativeFunction<LoadTrackSf2Native>>? _loadTrackSf2;
+  static Pointer<NativeFunction<LoadTrackSfzNative>>? _loadTrackSfz;
+  static Pointer<NativeFunction<LoadTrackAudioClipNative>>? _loadTrackAudioClip;
+  static Pointer<NativeFunction<LoadTrackSfzStringNative>>? _loadTrackSfzString;
+  static Pointer<NativeFunction<CancelTrackLoadNative>>? _cancelTrackLoad;
+  static Pointer<NativeFunction<SetTrackLoadPriorityNative>>? _setTrackLoadPriority;
+  static Pointer<NativeFunction<AddEffectNative>>? _addEffect;
+  static Pointer<NativeFunction<RemoveEffectNative>>? _removeEffect;
+  static Pointer<NativeFunction<SetBusReturnLevelNative>>? _setBusReturnLevel;
+  static Pointer<NativeFunction<SetRenderAheadEnabledNative>>? _setRenderAheadEnabled;
+  static Pointer<NativeFunction<FreezeTrackNative>>? _freezeTrack;
+  static Pointer<NativeFunction<UnfreezeTrackNative>>? _unfreezeTrack;
+  static Pointer<NativeFunction<SetControllerTimelineNative>>? _setControllerTimeline;
+  static Pointer<NativeFunction<GetAudibleFrameNative>>? _getAudibleFrame;
+  static Pointer<NativeFunction<SetLoadGovernorEnabledNative>>? _setLoadGovernorEnabled;
+  static Pointer<NativeFunction<SetLoadGovernorThresholdsNative>>? _setLoadGovernorThresholds;
+  static Pointer<NativeFunction<GetLoadGovernorStatusNative>>? _getLoadGovernorStatus;
+  static Pointer<NativeFunction<SetMeteringEnabledNative>>? _setMeteringEnabled;
+  static Pointer<NativeFunction<SetSpectrumEnabledNative>>? _setSpectrumEnabled;
+  static Pointer<NativeFunction<GetMeterReadoutNative>>? _getMeterReadout;
 
   static void _registerDartPostCObject() {
     try {
@@ -68,8 +94,8 @@ class NativeBridge {
     _setupEngine = _lib!.lookup<NativeFunction<Void Function(Int64)>>('setup_engine');
     _destroyEngine = _lib!.lookup<NativeFunction<Void Function()>>('destroy_engine');
     _addTrackSf2 = _lib!.lookup<NativeFunction<Void Function(Pointer<Utf8>, Bool, Int32, Int64)>>('add_track_sf2');
-    _addTrackSfz = _lib!.lookup<NativeFunction<Void Function(Pointer<Utf8>, Pointer<Utf8>, Int64)>>('add_track_sfz');
-    _addTrackSfzString = _lib!.lookup<NativeFunction<Void Function(Pointer<Utf8>, Pointer<Utf8>, Pointer<Utf8>, Int64)>>('add_track_sfz_string');
+    _addTrackSfz = _lib!.lookup<NativeFunction<AddTrackSfzNative>>('add_track_sfz');
+    _addTrackSfzString = _lib!.lookup<NativeFunction<AddTrackSfzStringNative>>('add_track_sfz_string');
     _removeTrack = _lib!.lookup<NativeFunction<Void Function(Uint32)>>('remove_track');
     _resetTrack = _lib!.lookup<NativeFunction<Void Function(Uint32)>>('reset_track');
     _getPosition = _lib!.lookup<NativeFunction<Uint32 Function()>>('get_position');
@@ -95,6 +121,107 @@ class NativeBridge {
       _engineStop = _enginePause; // Fallback to pause for older implementations
     }
 
+    // apply_batch is optional; without it batches are applied one command at a time
+    try {
+      _applyBatch = _lib!.lookup<NativeFunction<ApplyBatchNative>>('apply_batch');
+    } catch (e) {
+      print('[DEBUG] NativeBridge: apply_batch not found, batches will use individual calls');
+      _applyBatch = null;
+    }
+
+    // The load_track_* functions are optional; without them tracks are added
+    // through add_track_* and can't be prioritized or cancelled
+    try {
+      _loadTrackSf2 = _lib!.lookup<NativeFunction<LoadTrackSf2Native>>('load_track_sf2');
+      _loadTrackSfz = _lib!.lookup<NativeFunction<LoadTrackSfzNative>>('load_track_sfz');
+      _loadTrackSfzString = _lib!.lookup<NativeFunction<LoadTrackSfzStringNative>>('load_track_sfz_string');
+      _cancelTrackLoad = _lib!.lookup<NativeFunction<CancelTrackLoadNative>>('cancel_track_load');
+      _setTrackLoadPriority = _lib!.lookup<NativeFunction<SetTrackLoadPriorityNative>>('set_track_load_priority');
+    } catch (e) {
+      print('[DEBUG] NativeBridge: load_track_* not found, using add_track_* for track loads');
+      _loadTrackSf2 = null;
+      _loadTrackSfz = null;
+      _loadTrackSfzString = null;
+      _cancelTrackLoad = null;
+      _setTrackLoadPriority = null;
+    }
+
+    // The native mixer effects are only available on Android
+    try {
+      _addEffect = _lib!.lookup<NativeFunction<AddEffectNative>>('add_effect');
+      _removeEffect = _lib!.lookup<NativeFunction<RemoveEffectNative>>('remove_effect');
+      _setBusReturnLevel = _lib!.lookup<NativeFunction<SetBusReturnLevelNative>>('set_bus_return_level');
+    } catch (e) {
+      print('[DEBUG] NativeBridge: add_effect not found, mixer effects are unavailable');
+      _addEffect = null;
+      _removeEffect = null;
+      _setBusReturnLevel = null;
+    }
+
+    // Render-ahead is only available on Android
+    try {
+      _setRenderAheadEnabled = _lib!.lookup<NativeFunction<SetRenderAheadEnabledNative>>('set_render_ahead_enabled');
+    } catch (e) {
+      print('[DEBUG] NativeBridge: set_render_ahead_enabled not found, tracks always render just in time');
+      _setRenderAheadEnabled = null;
+    }
+
+    // Track freezing is only available on Android
+    try {
+      _freezeTrack = _lib!.lookup<NativeFunction<FreezeTrackNative>>('freeze_track');
+      _unfreezeTrack = _lib!.lookup<NativeFunction<UnfreezeTrackNative>>('unfreeze_track');
+    } catch (e) {
+      print('[DEBUG] NativeBridge: freeze_track not found, tracks can\'t be frozen');
+      _freezeTrack = null;
+      _unfreezeTrack = null;
+    }
+
+    try {
+      _setControllerTimeline = _lib!.lookup<NativeFunction<SetControllerTimelineNative>>('set_controller_timeline');
+    } catch (e) {
+      print('[DEBUG] NativeBridge: set_controller_timeline not found, controllers aren\'t chased on seek');
+      _setControllerTimeline = null;
+    }
+
+    try {
+      _getAudibleFrame = _lib!.lookup<NativeFunction<GetAudibleFrameNative>>('get_audible_frame');
+    } catch (e) {
+      print('[DEBUG] NativeBridge: get_audible_frame not found, the position is estimated from the last render time');
+      _getAudibleFrame = null;
+    }
+
+    // The load governor is only available on Android
+    try {
+      _setLoadGovernorEnabled = _lib!.lookup<NativeFunction<SetLoadGovernorEnabledNative>>('set_load_governor_enabled');
+      _setLoadGovernorThresholds = _lib!.lookup<NativeFunction<SetLoadGovernorThresholdsNative>>('set_load_governor_thresholds');
+      _getLoadGovernorStatus = _lib!.lookup<NativeFunction<GetLoadGovernorStatusNative>>('get_load_governor_status');
+    } catch (e) {
+      print('[DEBUG] NativeBridge: get_load_governor_status not found, quality is never reduced under load');
+      _setLoadGovernorEnabled = null;
+      _setLoadGovernorThresholds = null;
+      _getLoadGovernorStatus = null;
+    }
+
+    // Metering is only available on Android
+    try {
+      _setMeteringEnabled = _lib!.lookup<NativeFunction<SetMeteringEnabledNative>>('set_metering_enabled');
+      _setSpectrumEnabled = _lib!.lookup<NativeFunction<SetSpectrumEnabledNative>>('set_spectrum_enabled');
+      _getMeterReadout = _lib!.lookup<NativeFunction<GetMeterReadoutNative>>('get_meter_readout');
+    } catch (e) {
+      print('[DEBUG] NativeBridge: get_meter_readout not found, there are no meters');
+      _setMeteringEnabled = null;
+      _setSpectrumEnabled = null;
+      _getMeterReadout = null;
+    }
+
+    // Audio clips are only available on Android
+    try {
+      _loadTrackAudioClip = _lib!.lookup<NativeFunction<LoadTrackAudioClipNative>>('load_track_audio_clip');
+    } catch (e) {
+      print('[DEBUG] NativeBridge: load_track_audio_clip not found, audio clips can\'t be played');
+      _loadTrackAudioClip = null;
+    }
+
     // CRITICAL: Register Dart's PostCObject function to enable FFI callbacks
     // This allows native code to send messages back to Dart
     _registerDartPostCObject();
@@ -164,10 +291,31 @@ class NativeBridge {
   }
 
 
-  static Future<int> addTrackSf2(String filename, bool isAsset, int patchNumber) async {
+  static Future<int> addTrackSf2(String filename, bool isAsset, int patchNumber,
+      [TrackLoadHandle? loadHandle]) async {
     _ensureInitialized();
     print('[DEBUG] NativeBridge: Adding SF2 track: $filename');
 
+    final loadTrackSf2 = _loadTrackSf2;
+    if (loadTrackSf2 != null) {
+      if (loadHandle?.isCancelled ?? false) return -1;
+
+      final receivePort = ReceivePort();
+      final progressPort = ReceivePort();
+      final pathPointer = filename.toNativeUtf8();
+
+      final requestId = loadTrackSf2.asFunction<LoadTrackSf2Function>()(
+          pathPointer, isAsset, patchNumber, loadHandle?.priority ?? 0,
+          receivePort.sendPort.nativePort, progressPort.sendPort.nativePort);
+      // The loader keeps its own copy of the path
+      malloc.free(pathPointer);
+
+      final trackIndex = await _awaitTrackLoad(
+          requestId, receivePort, progressPort, loadHandle, 'SF2 track: $filename');
+      print('[DEBUG] NativeBridge: SF2 track load finished: $filename -> $trackIndex');
+      return trackIndex;
+    }
+
     final receivePort = ReceivePort();
     final pathPointer = filename.toNativeUtf8();
     final addTrackSf2 = _addTrackSf2.asFunction<void Function(Pointer<Utf8>, bool, int, int)>();
@@ -197,15 +345,61 @@ class NativeBridge {
     }
   }
 
-  static Future<int> addTrackSfz(String sfzPath, String? tuningPath) async {
+  /// Returns -1 if the file can't be read, or where audio clips are
+  /// unsupported.
+  static Future<int> addTrackAudioClip(String path, double gain,
+      int fadeInFrames, int fadeOutFrames, [TrackLoadHandle? loadHandle]) async {
     _ensureInitialized();
 
+    final loadTrackAudioClip = _loadTrackAudioClip;
+    if (loadTrackAudioClip == null) return -1;
+    if (loadHandle?.isCancelled ?? false) return -1;
+
+    final receivePort = ReceivePort();
+    final progressPort = ReceivePort();
+    final pathPointer = path.toNativeUtf8();
+
+    final requestId = loadTrackAudioClip.asFunction<LoadTrackAudioClipFunction>()(
+        pathPointer, gain, fadeInFrames, fadeOutFrames, loadHandle?.priority ?? 0,
+        receivePort.sendPort.nativePort, progressPort.sendPort.nativePort);
+    // The loader keeps its own copy of the path
+    malloc.free(pathPointer);
+
+    return _awaitTrackLoad(
+        requestId, receivePort, progressPort, loadHandle, 'audio clip track: $path');
+  }
+
+  static Future<int> addTrackSfz(String sfzPath, String? tuningPath,
+      [TrackLoadHandle? loadHandle, int oversamplingFactor = 1]) async {
+    _ensureInitialized();
+
+    final loadTrackSfz = _loadTrackSfz;
+    if (loadTrackSfz != null) {
+      if (loadHandle?.isCancelled ?? false) return -1;
+
+      final receivePort = ReceivePort();
+      final progressPort = ReceivePort();
+      final sfzPathPointer = sfzPath.toNativeUtf8();
+      final tuningPathPointer = (tuningPath ?? "").toNativeUtf8();
+
+      final requestId = loadTrackSfz.asFunction<LoadTrackSfzFunction>()(
+          sfzPathPointer, tuningPathPointer, oversamplingFactor,
+          loadHandle?.priority ?? 0, receivePort.sendPort.nativePort,
+          progressPort.sendPort.nativePort);
+      // The loader keeps its own copies of the strings
+      malloc.free(sfzPathPointer);
+      malloc.free(tuningPathPointer);
+
+      return _awaitTrackLoad(
+          requestId, receivePort, progressPort, loadHandle, 'SFZ track: $sfzPath');
+    }
+
     final receivePort = ReceivePort();
     final sfzPathPointer = sfzPath.toNativeUtf8();
     final tuningPathPointer = (tuningPath ?? "").toNativeUtf8();
-    final addTrackSfz = _addTrackSfz.asFunction<void Function(Pointer<Utf8>, Pointer<Utf8>, int)>();
+    final addTrackSfz = _addTrackSfz.asFunction<AddTrackSfzFunction>();
 
-    addTrackSfz(sfzPathPointer, tuningPathPointer, receivePort.sendPort.nativePort);
+    addTrackSfz(sfzPathPointer, tuningPathPointer, oversamplingFactor, receivePort.sendPort.nativePort);
 
     try {
       final trackIndex = await receivePort.first.timeout(
@@ -230,16 +424,40 @@ class NativeBridge {
   }
 
   static Future<int> addTrackSfzString(
-      String sampleRoot, String sfzContent, String? tuningString) async {
+      String sampleRoot, String sfzContent, String? tuningString,
+      [TrackLoadHandle? loadHandle, int oversamplingFactor = 1]) async {
     _ensureInitialized();
 
+    final loadTrackSfzString = _loadTrackSfzString;
+    if (loadTrackSfzString != null) {
+      if (loadHandle?.isCancelled ?? false) return -1;
+
+      final receivePort = ReceivePort();
+      final progressPort = ReceivePort();
+      final sampleRootPointer = sampleRoot.toNativeUtf8();
+      final sfzContentPointer = sfzContent.toNativeUtf8();
+      final tuningStringPointer = (tuningString ?? "").toNativeUtf8();
+
+      final requestId = loadTrackSfzString.asFunction<LoadTrackSfzStringFunction>()(
+          sampleRootPointer, sfzContentPointer, tuningStringPointer,
+          oversamplingFactor, loadHandle?.priority ?? 0, receivePort.sendPort.nativePort,
+          progressPort.sendPort.nativePort);
+      // The loader keeps its own copies of the strings
+      malloc.free(sampleRootPointer);
+      malloc.free(sfzContentPointer);
+      malloc.free(tuningStringPointer);
+
+      return _awaitTrackLoad(
+          requestId, receivePort, progressPort, loadHandle, 'SFZ string track');
+    }
+
     final receivePort = ReceivePort();
     final sampleRootPointer = sampleRoot.toNativeUtf8();
     final sfzContentPointer = sfzContent.toNativeUtf8();
     final tuningStringPointer = (tuningString ?? "").toNativeUtf8();
-    final addTrackSfzString = _addTrackSfzString.asFunction<void Function(Pointer<Utf8>, Pointer<Utf8>, Pointer<Utf8>, int)>();
+    final addTrackSfzString = _addTrackSfzString.asFunction<AddTrackSfzStringFunction>();
 
-    addTrackSfzString(sampleRootPointer, sfzContentPointer, tuningStringPointer, receivePort.sendPort.nativePort);
+    addTrackSfzString(sampleRootPointer, sfzContentPointer, tuningStringPointer, oversamplingFactor, receivePort.sendPort.nativePort);
 
     try {
       final trackIndex = await receivePort.first.timeout(
@@ -265,6 +483,59 @@ class NativeBridge {
     }
   }
 
+  /// Waits for a load request on the native loader pool to finish. The timeout
+  /// only starts once a loader thread picks the request up, so loads that are
+  /// queued behind others don't time out.
+  static Future<int> _awaitTrackLoad(int requestId, ReceivePort receivePort,
+      ReceivePort progressPort, TrackLoadHandle? loadHandle, String description) async {
+    final result = Completer<int>();
+    Timer? timeout;
+
+    loadHandle?.bind(requestId);
+
+    receivePort.listen((trackIndex) {
+      if (!result.isCompleted) result.complete(trackIndex as int);
+    });
+
+    progressPort.listen((progress) {
+      timeout ??= Timer(Duration(seconds: 10), () {
+        print('[ERROR] NativeBridge: Timeout adding $description');
+        // A load that already added its track still reports it, so the track
+        // isn't lost
+        if (cancelTrackLoad(requestId) && !result.isCompleted) result.complete(-1);
+      });
+
+      loadHandle?.onProgress?.call(progress as int);
+    });
+
+    final trackIndex = await result.future;
+
+    timeout?.cancel();
+    receivePort.close();
+    progressPort.close();
+    loadHandle?.complete();
+
+    return trackIndex;
+  }
+
+  /// Returns whether the load was cancelled. It can't be once it has added
+  /// its track.
+  static bool cancelTrackLoad(int requestId) {
+    _ensureInitialized();
+    final cancelTrackLoad = _cancelTrackLoad;
+    if (cancelTrackLoad == null) return false;
+
+    return cancelTrackLoad.asFunction<CancelTrackLoadFunction>()(requestId);
+  }
+
+  static void setTrackLoadPriority(int requestId, int priority) {
+    _ensureInitialized();
+    final setTrackLoadPriority = _setTrackLoadPriority;
+    if (setTrackLoadPriority == null) return;
+
+    setTrackLoadPriority.asFunction<SetTrackLoadPriorityFunction>()(requestId, priority);
+  }
+
   static Future<int> addTrackAudioUnit(String audioUnitId) async {
     print('[DEBUG] NativeBridge: Adding AudioUnit track: $audioUnitId');
     
@@ -306,6 +577,18 @@ class NativeBridge {
     return getPosition();
   }
 
+  /// The engine frame that is coming out of the speaker now, or null where
+  /// the engine can't tell. Unlike [getPosition], which only moves once per
+  /// render callback, this is extrapolated from when the last callback ran
+  /// and accounts for the output latency.
+  static int? getAudibleFrame() {
+    _ensureInitialized();
+    final getAudibleFrame = _getAudibleFrame;
+    if (getAudibleFrame == null) return null;
+
+    return getAudibleFrame.asFunction<GetAudibleFrameFunction>()();
+  }
+
   static double getTrackVolume(int trackIndex) {
     _ensureInitialized();
     final getTrackVolume = _getTrackVolume.asFunction<double Function(int)>();
@@ -362,6 +645,229 @@ class NativeBridge {
     clearEvents(trackIndex, fromTick);
   }
 
+  /// Adds an effect to a chain (see EffectChain) and returns its slot, or -1
+  /// if the chain is full or effects are unavailable on this platform.
+  /// trackIndex is only used for EffectChain.TRACK_INSERTS.
+  static int addEffect(int trackIndex, int chain, int effectType) {
+    _ensureInitialized();
+    final addEffect = _addEffect;
+    if (addEffect == null) return -1;
+
+    return addEffect.asFunction<AddEffectFunction>()(trackIndex, chain, effectType);
+  }
+
+  static void removeEffect(int trackIndex, int chain, int slot) {
+    _ensureInitialized();
+    final removeEffect = _removeEffect;
+    if (removeEffect == null) return;
+
+    removeEffect.asFunction<RemoveEffectFunction>()(trackIndex, chain, slot);
+  }
+
+  static void setBusReturnLevel(int bus, double level) {
+    _ensureInitialized();
+    final setBusReturnLevel = _setBusReturnLevel;
+    if (setBusReturnLevel == null) return;
+
+    setBusReturnLevel.asFunction<SetBusReturnLevelFunction>()(bus, level);
+  }
+
+  static void setRenderAheadEnabled(bool isEnabled) {
+    _ensureInitialized();
+    final setRenderAheadEnabled = _setRenderAheadEnabled;
+    if (setRenderAheadEnabled == null) return;
+
+    setRenderAheadEnabled.asFunction<SetRenderAheadEnabledFunction>()(isEnabled);
+  }
+
+  /// Renders the track's MIDI events to cachePath on the loader pool and then
+  /// plays the file back instead of the instrument. loadHandle can prioritize
+  /// or cancel the freeze like an instrument load. Returns false if the track
+  /// could not be frozen.
+  static Future<bool> freezeTrack(int trackIndex, List<SchedulerEvent> events,
+      int sampleRate, double tempo, int numFrames, String cachePath,
+      [TrackLoadHandle? loadHandle]) async {
+    _ensureInitialized();
+    final freezeTrack = _freezeTrack;
+    if (freezeTrack == null || (loadHandle?.isCancelled ?? false)) return false;
+
+    final receivePort = ReceivePort();
+    final serializedData = _serializeEvents(events, sampleRate, tempo);
+    final pathPointer = cachePath.toNativeUtf8();
+
+    final requestId = freezeTrack.asFunction<FreezeTrackFunction>()(
+        trackIndex, serializedData.rawData, serializedData.eventCount,
+        numFrames, pathPointer, loadHandle?.priority ?? 0,
+        receivePort.sendPort.nativePort);
+    // The freeze keeps its own copies of the events and the path
+    malloc.free(serializedData.rawData);
+    malloc.free(pathPointer);
+
+    loadHandle?.bind(requestId);
+    final result = await receivePort.first as int;
+    receivePort.close();
+    loadHandle?.complete();
+
+    return result == trackIndex;
+  }
+
+  static bool unfreezeTrack(int trackIndex) {
+    _ensureInitialized();
+    final unfreezeTrack = _unfreezeTrack;
+    if (unfreezeTrack == null) return false;
+
+    return unfreezeTrack.asFunction<UnfreezeTrackFunction>()(trackIndex);
+  }
+
+  /// Gives the engine a track's controller changes, so it can restore the
+  /// controllers wherever the track seeks to. Replaces the previous ones; an
+  /// empty list stops the chasing. Returns how many events the engine adds to
+  /// the track's buffer after each seek to chase them.
+  static int setControllerTimeline(int trackIndex, List<SchedulerEvent> events,
+      int sampleRate, double tempo) {
+    _ensureInitialized();
+    final setControllerTimeline = _setControllerTimeline;
+    if (setControllerTimeline == null) return 0;
+
+    final serializedData = _serializeEvents(events, sampleRate, tempo);
+
+    try {
+      return setControllerTimeline.asFunction<SetControllerTimelineFunction>()(
+          trackIndex, serializedData.rawData, serializedData.eventCount);
+    } finally {
+      malloc.free(serializedData.rawData);
+    }
+  }
+
+  static void setLoadGovernorEnabled(bool isEnabled) {
+    _ensureInitialized();
+    final setLoadGovernorEnabled = _setLoadGovernorEnabled;
+    if (setLoadGovernorEnabled == null) return;
+
+    setLoadGovernorEnabled.asFunction<SetLoadGovernorEnabledFunction>()(isEnabled);
+  }
+
+  static void setLoadGovernorThresholds(double degradeLoad, double recoverLoad) {
+    _ensureInitialized();
+    final setLoadGovernorThresholds = _setLoadGovernorThresholds;
+    if (setLoadGovernorThresholds == null) return;
+
+    setLoadGovernorThresholds.asFunction<SetLoadGovernorThresholdsFunction>()(degradeLoad, recoverLoad);
+  }
+
+  /// Returns null where there is no load governor.
+  static LoadGovernorStatus? getLoadGovernorStatus() {
+    _ensureInitialized();
+    final getLoadGovernorStatus = _getLoadGovernorStatus;
+    if (getLoadGovernorStatus == null) return null;
+
+    final statusPointer = calloc<LoadGovernorStatusStruct>();
+
+    try {
+      if (!getLoadGovernorStatus.asFunction<GetLoadGovernorStatusFunction>()(statusPointer)) {
+        return null;
+      }
+
+      final status = statusPointer.ref;
+      return LoadGovernorStatus(
+        load: status.load,
+        peakLoad: status.peakLoad,
+        degradeLoad: status.degradeLoad,
+        recoverLoad: status.recoverLoad,
+        stage: status.stage,
+        stageChanges: status.stageChanges,
+      );
+    } finally {
+      calloc.free(statusPointer);
+    }
+  }
+
+  static void setMeteringEnabled(bool isEnabled) {
+    _ensureInitialized();
+    final setMeteringEnabled = _setMeteringEnabled;
+    if (setMeteringEnabled == null) return;
+
+    setMeteringEnabled.asFunction<SetMeteringEnabledFunction>()(isEnabled);
+  }
+
+  static void setSpectrumEnabled(bool isEnabled) {
+    _ensureInitialized();
+    final setSpectrumEnabled = _setSpectrumEnabled;
+    if (setSpectrumEnabled == null) return;
+
+    setSpectrumEnabled.asFunction<SetSpectrumEnabledFunction>()(isEnabled);
+  }
+
+  /// Returns null where there are no meters. The readout is read in place, so
+  /// this only has to be called once per engine.
+  static MeterReadout? getMeterReadout() {
+    _ensureInitialized();
+    final getMeterReadout = _getMeterReadout;
+    if (getMeterReadout == null) return null;
+
+    final readoutPointer = getMeterReadout.asFunction<GetMeterReadoutFunction>()();
+    if (readoutPointer == nullptr) return null;
+
+    return MeterReadout(readoutPointer);
+  }
+
+  /// Applies every command in the batch with a single native call. Each
+  /// command's onResult callback is invoked afterwards, in order.
+  static void applyBatch(CommandBatch batch) {
+    if (batch.isEmpty) return;
+
+    _ensureInitialized();
+
+    if (_applyBatch == null) {
+      _applyBatchCommandByCommand(batch);
+      return;
+    }
+
+    final bytes = batch.serialize();
+    final commandCount = batch.commands.length;
+    final commandData = malloc.allocate<Uint8>(bytes.length);
+    final results = malloc.allocate<Uint32>(commandCount * sizeOf<Uint32>());
+    final applyBatch = _applyBatch!.asFunction<ApplyBatchFunction>();
+
+    try {
+      commandData.asTypedList(bytes.length).setAll(0, bytes);
+
+      final appliedCount = applyBatch(commandData, bytes.length, results);
+
+      for (int i = 0; i < appliedCount && i < commandCount; i++) {
+        batch.commands[i].onResult?.call(results[i]);
+      }
+    } finally {
+      malloc.free(commandData);
+      malloc.free(results);
+    }
+  }
+
+  static void _applyBatchCommandByCommand(CommandBatch batch) {
+    for (final command in batch.commands) {
+      var result = 0;
+
+      switch (command.opcode) {
+        case BatchCommand.CLEAR_EVENTS:
+          clearEvents(command.trackIndex, command.fromFrame);
+          break;
+        case BatchCommand.SCHEDULE_EVENTS:
+          result = scheduleEvents(command.trackIndex, command.events,
+              command.sampleRate, command.tempo, 0);
+          break;
+        case BatchCommand.SET_VOLUME:
+          handleEventsNow(
+              command.trackIndex,
+              [VolumeEvent(beat: 0, volume: command.volume)],
+              command.sampleRate,
+              1);
+          break;
+      }
+
+      command.onResult?.call(result);
+    }
+  }
+
   static void play() {
     _ensureInitialized();
     final enginePlay = _enginePlay.asFunction<void Function()>();
@@ -380,6 +886,15 @@ class NativeBridge {
     engineStop();
   }
 
+  /// Serializes events into native memory the way [scheduleEvents] passes
+  /// them to the engine, and frees it again. Only used to time the per-track
+  /// calls against [CommandBatch.serialize].
+  @visibleForTesting
+  static void serializeEventsForTesting(
+      List<SchedulerEvent> events, int sampleRate, double tempo) {
+    malloc.free(_serializeEvents(events, sampleRate, tempo).rawData);
+  }
+
   static _SerializedEventData _serializeEvents(List<SchedulerEvent> events,
       int sampleRate, double tempo) {
     final eventCount = events.length;
@@ -3,8 +3,10 @@ import 'dart:math';
 
 import 'constants.dart';
 import 'global_state.dart';
+import 'models/command_batch.dart';
 import 'models/instrument.dart';
 import 'models/instrument_error.dart';
+import 'models/track_load_handle.dart';
 import 'native_bridge.dart';
 import 'track.dart';
 
@@ -30,6 +32,9 @@ class Sequence {
   /// Call this to remove this sequence and its tracks from the global sequencer
   /// engine.
   void destroy() {
+    for (var loadHandle in _pendingLoads.toList()) {
+      loadHandle.cancel();
+    }
     for (var track in _tracks.values) {
       deleteTrack(track);
     }
@@ -37,6 +42,7 @@ class Sequence {
   }
 
   final _tracks = <int, Track>{};
+  final _pendingLoads = <TrackLoadHandle>{};
   late int id;
 
   // Sequencer state
@@ -54,21 +60,26 @@ class Sequence {
     return _tracks.values.toList();
   }
 
-  /// Creates tracks in the underlying sequencer engine.
-  Future<List<Track>> createTracks(List<Instrument> instruments) async {
-    final result = await createTracksWithErrorInfo(instruments);
+  /// Creates tracks in the underlying sequencer engine. Instruments with a
+  /// higher [priority] start loading before those of other calls.
+  Future<List<Track>> createTracks(List<Instrument> instruments,
+      {int priority = 0}) async {
+    final result =
+        await createTracksWithErrorInfo(instruments, priority: priority);
     return result.tracks.cast<Track>();
   }
 
   /// Creates tracks with detailed error information for each instrument.
-  Future<TracksCreationResult> createTracksWithErrorInfo(List<Instrument> instruments) async {
+  Future<TracksCreationResult> createTracksWithErrorInfo(
+      List<Instrument> instruments,
+      {int priority = 0}) async {
     if (globalState.isEngineReady) {
-      return _createTracksWithErrorInfo(instruments);
+      return _createTracksWithErrorInfo(instruments, priority);
     } else {
       final completer = Completer<TracksCreationResult>.sync();
 
       globalState.onEngineReady(() async {
-        final result = await _createTracksWithErrorInfo(instruments);
+        final result = await _createTracksWithErrorInfo(instruments, priority);
         completer.complete(result);
       });
 
@@ -139,9 +150,7 @@ class Sequence {
 
     tempo = nextTempo;
 
-    getTracks().forEach((track) {
-      track.syncBuffer();
-    });
+    _syncAllTracks();
   }
 
   /// Enables looping.
@@ -169,7 +178,7 @@ class Sequence {
     this.loopStartBeat = loopStartBeat;
     this.loopEndBeat = loopEndBeat;
 
-    getTracks().forEach((track) => track.syncBuffer());
+    _syncAllTracks();
   }
 
   /// Disables looping for the sequence.
@@ -184,7 +193,7 @@ class Sequence {
     loopEndBeat = 0;
     loopState = LoopState.Off;
 
-    getTracks().forEach((track) => track.syncBuffer());
+    _syncAllTracks();
   }
 
   /// Sets the beat at which the sequence will end. Events after the end beat
@@ -207,9 +216,7 @@ class Sequence {
     engineStartFrame = NativeBridge.getPosition() - frame;
     pauseBeat = beat;
 
-    getTracks().forEach((track) {
-      track.syncBuffer(engineStartFrame);
-    });
+    _syncAllTracks(engineStartFrame);
 
     if (loopState != LoopState.Off) {
       final loopEndFrame = beatToFrames(loopEndBeat);
@@ -316,8 +323,9 @@ class Sequence {
     if (!globalState.isEngineReady) return 0;
 
     if (isPlaying) {
-      final frame = _getFramesRendered() +
-          (estimateFramesSinceLastRender ? _getFramesSinceLastRender() : 0);
+      final frame = estimateFramesSinceLastRender
+          ? _getFramesAudible()
+          : _getFramesRendered();
       final loopedFrame =
           loopState == LoopState.Off ? frame : getLoopedFrame(frame);
 
@@ -327,8 +335,32 @@ class Sequence {
     }
   }
 
-  /// Returns the number of frames elapsed since the last audio render callback
-  /// was called.
+  /// Resyncs every track with a single native batch.
+  void _syncAllTracks([int? absoluteStartFrame]) {
+    final batch = CommandBatch();
+    final position = NativeBridge.getPosition();
+
+    for (final track in getTracks()) {
+      track.syncBufferInto(batch, position, absoluteStartFrame);
+    }
+
+    NativeBridge.applyBatch(batch);
+  }
+
+  /// Like [_getFramesRendered], but for the frame that is being heard now,
+  /// which is between render callbacks and behind by the output latency.
+  int _getFramesAudible() {
+    final audibleFrame = NativeBridge.getAudibleFrame();
+
+    if (audibleFrame == null) {
+      return _getFramesRendered() + _getFramesSinceLastRender();
+    }
+
+    return audibleFrame - engineStartFrame - LEAD_FRAMES;
+  }
+
+  /// Returns the number of frames elapsed since the audio of the last render
+  /// callback ran out, which is when the engine was at [_getFramesRendered].
   int _getFramesSinceLastRender() {
     final microsecondsSinceLastRender = max(
         0,
@@ -338,19 +370,27 @@ class Sequence {
     return globalState.usToFrames(microsecondsSinceLastRender);
   }
 
-  Future<InstrumentLoadResult<Track>> _createTrackWithErrorInfo(Instrument instrument) async {
+  Future<InstrumentLoadResult<Track>> _createTrackWithErrorInfo(
+      Instrument instrument, int priority) async {
+    final loadHandle = TrackLoadHandle(priority: priority);
+    _pendingLoads.add(loadHandle);
+
     try {
-      // Add timeout to prevent infinite hanging on track creation
-      final result = await Track.buildWithErrorInfo(sequence: this, instrument: instrument)
-        .timeout(Duration(seconds: 15), onTimeout: () {
-          print('[TIMEOUT] Track creation timed out for instrument: ${instrument.displayName}');
-          return InstrumentLoadResult.error(
-            InstrumentError.invalidFormat(
-              instrument.displayName,
-              'Track creation timed out after 15 seconds. This may indicate a native bridge issue.',
-            ),
-          );
-        });
+      // Each native load times out on its own once it has started, so loads
+      // that are queued behind others aren't failed here
+      final result = await Track.buildWithErrorInfo(
+          sequence: this, instrument: instrument, loadHandle: loadHandle);
+
+      // The sequence was destroyed after the instrument was added
+      if (result.isSuccess && loadHandle.isCancelled) {
+        NativeBridge.removeTrack(result.data!.id);
+        return InstrumentLoadResult.error(
+          InstrumentError.invalidFormat(
+            instrument.displayName,
+            'Track creation was cancelled.',
+          ),
+        );
+      }
 
       if (result.isSuccess) {
         _tracks.putIfAbsent(result.data!.id, () => result.data!);
@@ -365,17 +405,20 @@ class Sequence {
           'Track creation failed: $e',
         ),
       );
+    } finally {
+      _pendingLoads.remove(loadHandle);
     }
   }
 
   Future<Track?> _createTrack(Instrument instrument) async {
-    final result = await _createTrackWithErrorInfo(instrument);
+    final result = await _createTrackWithErrorInfo(instrument, 0);
     return result.data;
   }
 
-  Future<TracksCreationResult> _createTracksWithErrorInfo(List<Instrument> instruments) async {
-    final results = await Future.wait(
-        instruments.map((instrument) => _createTrackWithErrorInfo(instrument)));
+  Future<TracksCreationResult> _createTracksWithErrorInfo(
+      List<Instrument> instruments, int priority) async {
+    final results = await Future.wait(instruments
+        .map((instrument) => _createTrackWithErrorInfo(instrument, priority)));
     
     final tracks = <Track>[];
     final errors = <InstrumentError>[];
@@ -392,7 +435,7 @@ class Sequence {
   }
 
   Future<List<Track>> _createTracks(List<Instrument> instruments) async {
-    final result = await _createTracksWithErrorInfo(instruments);
+    final result = await _createTracksWithErrorInfo(instruments, 0);
     return result.tracks.cast<Track>();
   }
 }
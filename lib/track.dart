@@ -5,9 +5,12 @@ import 'dart:async';
 import 'package:path/path.dart' as p;
 
 import 'constants.dart';
+import 'models/command_batch.dart';
+import 'models/effects.dart';
 import 'models/instrument.dart';
 import 'models/events.dart';
 import 'models/instrument_error.dart';
+import 'models/track_load_handle.dart';
 import 'native_bridge.dart';
 import 'sequence.dart';
 
@@ -19,6 +22,12 @@ class Track {
   final Instrument instrument;
   final events = <SchedulerEvent>[];
   int lastFrameSynced = 0;
+  bool _isFrozen = false;
+  bool _isControllerTimelineDirty = true;
+  bool _hasControllerTimeline = false;
+  // How many events the engine adds after each seek to chase the controllers
+  int _chaseEventCount = 0;
+  double? _controllerTimelineTempo;
 
   Track._withId(
       {required this.sequence, required this.id, required this.instrument});
@@ -30,15 +39,18 @@ class Track {
     return result.data;
   }
 
-  /// Creates a track with detailed error information.
+  /// Creates a track with detailed error information. [loadHandle] can be used
+  /// to prioritize, follow or cancel the instrument load.
   static Future<InstrumentLoadResult<Track>> buildWithErrorInfo(
-      {required Sequence sequence, required Instrument instrument}) async {
+      {required Sequence sequence,
+      required Instrument instrument,
+      TrackLoadHandle? loadHandle}) async {
     int? id;
 
     try {
       if (instrument is Sf2Instrument) {
-        id = await NativeBridge.addTrackSf2(
-            instrument.idOrPath, instrument.isAsset, instrument.presetIndex);
+        id = await NativeBridge.addTrackSf2(instrument.idOrPath,
+            instrument.isAsset, instrument.presetIndex, loadHandle);
         
         if (id == -1) {
           return InstrumentLoadResult.error(
@@ -71,8 +83,8 @@ class Track {
           normalizedSfzPath = sfzFile.path;
         }
 
-        id = await NativeBridge.addTrackSfz(
-            normalizedSfzPath, instrument.tuningPath);
+        id = await NativeBridge.addTrackSfz(normalizedSfzPath,
+            instrument.tuningPath, loadHandle, instrument.oversamplingFactor);
             
         if (id == -1) {
           return InstrumentLoadResult.error(
@@ -108,8 +120,8 @@ class Track {
         // Sfizz uses the parent path of this (line 73 of Parser.cpp)
         final fakeSfzDir = '$normalizedSampleRoot/does_not_exist.sfz';
 
-        id = await NativeBridge.addTrackSfzString(
-            fakeSfzDir, sfzContent, instrument.tuningString);
+        id = await NativeBridge.addTrackSfzString(fakeSfzDir, sfzContent,
+            instrument.tuningString, loadHandle, instrument.oversamplingFactor);
             
         if (id == -1) {
           return InstrumentLoadResult.error(
@@ -119,6 +131,29 @@ class Track {
             ),
           );
         }
+      } else if (instrument is AudioClipInstrument) {
+        if (!File(instrument.idOrPath).existsSync()) {
+          return InstrumentLoadResult.error(
+            InstrumentError.fileNotFound(instrument.idOrPath),
+          );
+        }
+
+        final sampleRate = Sequence.globalState.sampleRate!;
+        id = await NativeBridge.addTrackAudioClip(
+            instrument.idOrPath,
+            instrument.gain,
+            (instrument.fadeInSeconds * sampleRate).round(),
+            (instrument.fadeOutSeconds * sampleRate).round(),
+            loadHandle);
+
+        if (id == -1) {
+          return InstrumentLoadResult.error(
+            InstrumentError.invalidFormat(
+              instrument.idOrPath,
+              'Audio clip could not be loaded. Check debug console for technical details.',
+            ),
+          );
+        }
       } else if (instrument is AudioUnitInstrument) {
         id = await NativeBridge.addTrackAudioUnit(instrument.idOrPath);
         
@@ -135,7 +170,7 @@ class Track {
           InstrumentError(
             type: InstrumentErrorType.unknown,
             message: 'Instrument type not recognized',
-            technicalDetails: 'Supported types: SfzInstrument, Sf2Instrument, RuntimeSfzInstrument, AudioUnitInstrument',
+            technicalDetails: 'Supported types: SfzInstrument, Sf2Instrument, RuntimeSfzInstrument, AudioClipInstrument, AudioUnitInstrument',
           ),
         );
       }
@@ -261,6 +296,48 @@ class Track {
         id, [event], Sequence.globalState.sampleRate!, sequence.tempo);
   }
 
+  /// Handles an effect parameter change on this track immediately. [chain]
+  /// can also select an aux bus or the master output, see [EffectChain].
+  /// The event will not be added to this track's events.
+  void changeEffectParamNow(
+      {int chain = EffectChain.TRACK_INSERTS,
+      required int slot,
+      required int parameter,
+      required double value}) {
+    final nextBeat = sequence.getBeat();
+    final event = EffectParamEvent(
+        beat: nextBeat,
+        chain: chain,
+        slot: slot,
+        parameter: parameter,
+        value: value);
+
+    NativeBridge.handleEventsNow(
+        id, [event], Sequence.globalState.sampleRate!, sequence.tempo);
+  }
+
+  /// Handles an aux bus send level change on this track immediately.
+  /// The event will not be added to this track's events.
+  void changeSendLevelNow({required int bus, required double level}) {
+    final nextBeat = sequence.getBeat();
+    final event = SendLevelEvent(beat: nextBeat, bus: bus, level: level);
+
+    NativeBridge.handleEventsNow(
+        id, [event], Sequence.globalState.sampleRate!, sequence.tempo);
+  }
+
+  /// Adds an insert effect to this track and returns its slot, or -1 if the
+  /// track already has MAX_EFFECTS_PER_CHAIN effects or effects are not
+  /// supported on this platform.
+  int addInsertEffect(int effectType) {
+    return NativeBridge.addEffect(id, EffectChain.TRACK_INSERTS, effectType);
+  }
+
+  /// Removes the insert effect in the given slot.
+  void removeInsertEffect(int slot) {
+    NativeBridge.removeEffect(id, EffectChain.TRACK_INSERTS, slot);
+  }
+
   /// Adds a Note On and Note Off event to this track.
   /// This does not sync the events to the backend.
   void addNote(
@@ -335,6 +412,87 @@ class Track {
     _addEvent(volumeChangeEvent);
   }
 
+  /// Adds an effect parameter change to this track. [chain] can also select
+  /// an aux bus or the master output, see [EffectChain].
+  /// This does not sync the events to the backend.
+  void addEffectParamChange(
+      {int chain = EffectChain.TRACK_INSERTS,
+      required int slot,
+      required int parameter,
+      required double value,
+      required double beat}) {
+    final paramChangeEvent = EffectParamEvent(
+        beat: beat,
+        chain: chain,
+        slot: slot,
+        parameter: parameter,
+        value: value);
+
+    _addEvent(paramChangeEvent);
+  }
+
+  /// Adds an aux bus send level change to this track.
+  /// This does not sync the events to the backend.
+  void addSendLevelChange(
+      {required int bus, required double level, required double beat}) {
+    final sendLevelEvent = SendLevelEvent(beat: beat, bus: bus, level: level);
+
+    _addEvent(sendLevelEvent);
+  }
+
+  /// Whether the track plays back a rendering of its notes instead of its
+  /// instrument. See [freeze].
+  bool get isFrozen => _isFrozen;
+
+  /// Renders this track's notes from the start of the sequence to its end,
+  /// plus [tailSeconds] for notes to ring out, to a file at [cachePath], and
+  /// plays the file back instead of the instrument, which costs much less CPU.
+  /// The track is silent while it is being frozen. Volume, effect and send
+  /// changes still apply to a frozen track, but notes added after freezing are
+  /// not heard until the track is frozen again. The same goes for tempo
+  /// changes. [loadHandle] can prioritize or cancel the freeze.
+  /// Returns false if the track could not be frozen, or where unsupported.
+  Future<bool> freeze(
+      {required String cachePath,
+      double tailSeconds = 2.0,
+      TrackLoadHandle? loadHandle}) async {
+    if (_isFrozen) return true;
+
+    final sampleRate = Sequence.globalState.sampleRate!;
+    final numFrames = sequence.beatToFrames(sequence.endBeat) +
+        (tailSeconds * sampleRate).round();
+
+    final didFreeze = await NativeBridge.freezeTrack(
+        id,
+        events.whereType<MidiEvent>().toList(),
+        sampleRate,
+        sequence.tempo,
+        numFrames,
+        cachePath,
+        loadHandle);
+
+    if (didFreeze) {
+      _isFrozen = true;
+      _isControllerTimelineDirty = true;
+      syncBuffer();
+    }
+
+    return didFreeze;
+  }
+
+  /// Puts the instrument back and deletes the file the track was frozen to.
+  /// Returns false if the track is not frozen, or is still being frozen.
+  bool unfreeze() {
+    if (!_isFrozen) return false;
+    if (!NativeBridge.unfreezeTrack(id)) return false;
+
+    _isFrozen = false;
+    _isControllerTimelineDirty = true;
+    syncBuffer();
+
+    return true;
+  }
+
   /// Gets the current volume of the track.
   double getVolume() {
     return NativeBridge.getTrackVolume(id);
@@ -344,38 +502,90 @@ class Track {
   /// This does not sync the events to the backend.
   void clearEvents() {
     events.clear();
+    _isControllerTimelineDirty = true;
   }
 
   /// Syncs events to the backend. This should be called after making changes to
   /// track events to ensure that the changes are synced immediately.
   void syncBuffer(
       [int? absoluteStartFrame, int maxEventsToSync = BUFFER_SIZE]) {
-    final position = NativeBridge.getPosition();
+    final batch = CommandBatch();
+
+    syncBufferInto(batch, NativeBridge.getPosition(), absoluteStartFrame,
+        maxEventsToSync);
+    NativeBridge.applyBatch(batch);
+  }
+
+  /// {@macro flutter_sequencer_library_private}
+  /// Adds the commands that sync this track to a batch, so that many tracks
+  /// can be synced with one native call. position is the engine position,
+  /// which only needs to be read once per batch.
+  void syncBufferInto(CommandBatch batch, int position,
+      [int? absoluteStartFrame, int maxEventsToSync = BUFFER_SIZE]) {
+    _syncBufferInto(batch, position, absoluteStartFrame, maxEventsToSync, true);
+  }
 
+  /// seekAtStart is false for a top-off, which continues right after the last
+  /// synced event, so a frozen track doesn't need to seek there.
+  void _syncBufferInto(CommandBatch batch, int position,
+      int? absoluteStartFrame, int maxEventsToSync, bool seekAtStart) {
     if (absoluteStartFrame == null) {
       absoluteStartFrame = position;
     } else {
       absoluteStartFrame = max(absoluteStartFrame, position);
     }
 
-    NativeBridge.clearEvents(id, absoluteStartFrame);
+    batch.clearEvents(id, absoluteStartFrame);
+    if (seekAtStart) _syncControllerTimeline();
 
     if (sequence.isPlaying) {
       final relativeStartFrame = absoluteStartFrame - sequence.engineStartFrame;
-      _scheduleEvents(relativeStartFrame, maxEventsToSync);
+      _scheduleEvents(batch, relativeStartFrame, maxEventsToSync, seekAtStart);
     } else {
       lastFrameSynced = 0;
     }
   }
 
+  /// Gives the engine this track's controller changes when they, or the tempo
+  /// that places them, have changed since the last sync. The engine uses them
+  /// to put the controllers back wherever a [SeekEvent] lands. A frozen track
+  /// or an audio clip doesn't play its MIDI, so it has nothing to chase.
+  void _syncControllerTimeline() {
+    if (!_isControllerTimelineDirty &&
+        _controllerTimelineTempo == sequence.tempo) return;
+
+    final controllerEvents = _isFrozen || instrument is AudioClipInstrument
+        ? <SchedulerEvent>[]
+        : events
+            .where((e) => e is MidiEvent && e.isControllerChange)
+            .toList();
+
+    _chaseEventCount = NativeBridge.setControllerTimeline(id, controllerEvents,
+        Sequence.globalState.sampleRate!, sequence.tempo);
+
+    _isControllerTimelineDirty = false;
+    _hasControllerTimeline = controllerEvents.isNotEmpty;
+    _controllerTimelineTempo = sequence.tempo;
+  }
+
   /// {@macro flutter_sequencer_library_private}
   /// Triggers a sync that will fill any available space in the buffer with
   /// any un-synced events.
   void topOffBuffer() {
+    final batch = CommandBatch();
+
+    topOffBufferInto(batch, NativeBridge.getPosition());
+    NativeBridge.applyBatch(batch);
+  }
+
+  /// {@macro flutter_sequencer_library_private}
+  /// Adds the commands that top off this track's buffer to a batch.
+  void topOffBufferInto(CommandBatch batch, int position) {
     final bufferAvailableCount = NativeBridge.getBufferAvailableCount(id);
 
     if (bufferAvailableCount > 0) {
-      syncBuffer(lastFrameSynced + 1, bufferAvailableCount);
+      _syncBufferInto(
+          batch, position, lastFrameSynced + 1, bufferAvailableCount, false);
     }
   }
 
@@ -404,11 +614,16 @@ class Track {
     }
 
     events.insert(index, eventToAdd);
+
+    if (eventToAdd is MidiEvent && eventToAdd.isControllerChange) {
+      _isControllerTimelineDirty = true;
+    }
   }
 
   /// Builds events that can be scheduled in the sequencer engine's event buffer
-  /// and adds them to eventsList.
-  void _scheduleEvents(int startFrame, [int maxEventsToSync = BUFFER_SIZE]) {
+  /// and adds them to the batch.
+  void _scheduleEvents(CommandBatch batch, int startFrame,
+      [int maxEventsToSync = BUFFER_SIZE, bool seekAtStart = true]) {
     final isBeforeLoopEnd = sequence.loopState == LoopState.BeforeLoopEnd;
     final loopLength = sequence.getLoopLengthFrames();
     final loopsElapsed = sequence.loopState == LoopState.Off
@@ -416,11 +631,13 @@ class Track {
         : sequence.getLoopsElapsed(startFrame);
 
     var eventsSyncedCount = _scheduleEventsInRange(
+        batch,
         maxEventsToSync,
         isBeforeLoopEnd ? sequence.getLoopedFrame(startFrame) : startFrame,
         sequence.beatToFrames(
             isBeforeLoopEnd ? sequence.loopEndBeat : sequence.endBeat),
-        loopLength * loopsElapsed);
+        loopLength * loopsElapsed,
+        seekAtStart);
 
     if (isBeforeLoopEnd) {
       var loopIndex = loopsElapsed + 1;
@@ -431,10 +648,12 @@ class Track {
       while (eventsSyncedCount < maxEventsToSync) {
         // Schedule all events in one loop range
         lastBatchCount = _scheduleEventsInRange(
+            batch,
             maxEventsToSync - eventsSyncedCount,
             loopStartFrame,
             loopEndFrame,
-            loopLength * loopIndex);
+            loopLength * loopIndex,
+            true);
 
         eventsSyncedCount += lastBatchCount;
         if (lastBatchCount == 0) break;
@@ -445,36 +664,66 @@ class Track {
 
   /// Schedules this track's events that start on or after startBeat and end
   /// on or before endBeat. Adds frameOffset to every scheduled event.
-  int _scheduleEventsInRange(
-      int maxEventsToSync, int startFrame, int? endFrame, int frameOffset) {
+  /// Returns how much of the buffer the events take up, counting the events
+  /// that chase the controllers after a seek; lastFrameSynced is updated once
+  /// the batch is applied and the scheduled count is known.
+  /// A frozen track gets a [SeekEvent] instead of its notes, at the start of
+  /// the range if seekAtStart is set. So does a track with controller changes,
+  /// so the engine can chase them there, and an audio clip, which seeks to
+  /// its own frame.
+  int _scheduleEventsInRange(CommandBatch batch, int maxEventsToSync,
+      int startFrame, int? endFrame, int frameOffset, bool seekAtStart) {
     final eventsToSync = <SchedulerEvent>[];
+    final clip = instrument;
+    var bufferCount = 0;
+
+    if ((_isFrozen || _hasControllerTimeline || clip is AudioClipInstrument) &&
+        seekAtStart &&
+        maxEventsToSync > 0) {
+      // The engine adds the chase events right after the seek. If they don't
+      // fit yet, the range waits for a top-off, unless the buffer is empty
+      // and they never will.
+      final seekCount = 1 + (_hasControllerTimeline ? _chaseEventCount : 0);
+      if (seekCount > maxEventsToSync && maxEventsToSync < BUFFER_SIZE) {
+        return 0;
+      }
+
+      eventsToSync.add(SeekEvent(
+          beat: sequence.framesToBeat(startFrame),
+          clipStartFrame: clip is AudioClipInstrument
+              ? sequence.beatToFrames(clip.startBeat)
+              : 0));
+      bufferCount += seekCount;
+    }
 
     for (var eventIndex = 0; eventIndex < events.length; eventIndex++) {
-      if (eventsToSync.length == maxEventsToSync) break;
+      if (bufferCount >= maxEventsToSync) break;
 
       final event = events[eventIndex];
       final eventFrame = sequence.beatToFrames(event.beat);
 
       if (eventFrame < startFrame) continue;
       if (endFrame != null && eventFrame > endFrame) break;
+      if (_isFrozen && event is MidiEvent) continue;
 
       eventsToSync.add(event);
+      bufferCount++;
     }
 
-    final eventsSyncedCount = NativeBridge.scheduleEvents(
-        id,
-        eventsToSync,
-        Sequence.globalState.sampleRate!,
-        sequence.tempo,
-        sequence.engineStartFrame + frameOffset);
+    if (eventsToSync.isEmpty) return 0;
 
-    if (eventsSyncedCount > 0) {
-      lastFrameSynced = sequence.engineStartFrame +
-          sequence.beatToFrames(eventsToSync[eventsSyncedCount - 1].beat) +
-          frameOffset;
-    }
+    final engineStartFrame = sequence.engineStartFrame;
+
+    batch.scheduleEvents(id, eventsToSync, Sequence.globalState.sampleRate!,
+        sequence.tempo, (eventsSyncedCount) {
+      if (eventsSyncedCount > 0) {
+        lastFrameSynced = engineStartFrame +
+            sequence.beatToFrames(eventsToSync[eventsSyncedCount - 1].beat) +
+            frameOffset;
+      }
+    });
 
-    return eventsSyncedCount;
+    return bufferCount;
   }
 
   /// Used for ordering events.
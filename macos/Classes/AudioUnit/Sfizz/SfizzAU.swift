@@ -10,6 +10,14 @@ import AudioToolbox
 import AVFoundation
 import CoreAudioKit
 
+/// Sampler settings that SfizzAU applies before it loads an instrument
+public struct SfzLoadOptions {
+    /// How many times samples are upsampled as they load: 1, 2, 4 or 8
+    public var oversamplingFactor: Int32 = 1
+
+    public init() {}
+}
+
 public class SfizzAU: AUAudioUnit {
 
     private let kernelAdapter: SfizzDSPKernelAdapter
@@ -80,6 +88,11 @@ public class SfizzAU: AUAudioUnit {
         return true
     }
     
+    // Must be called before loading
+    public func applyLoadOptions(_ options: SfzLoadOptions) {
+        kernelAdapter.setOversamplingFactor(options.oversamplingFactor)
+    }
+
     public func loadSfzFile(path: UnsafePointer<CChar>, tuningPath: UnsafePointer<CChar>) -> Bool {
         return kernelAdapter.loadSfzFile(path, tuningPath: tuningPath)
     }
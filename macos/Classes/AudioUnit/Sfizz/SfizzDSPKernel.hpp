@@ -45,6 +45,11 @@ public:
         outBufferListPtr = outBufferList;
     }
     
+    // Load options, applied to the instruments loaded afterwards
+    void setOversamplingFactor(int32_t factor) {
+        mInstrument->setOversamplingFactor(factor);
+    }
+
     bool loadFile(const char* sfzPath, const char* tuningPath) {
         return mInstrument->loadSfzFile(sfzPath, tuningPath);
     }
@@ -36,6 +36,10 @@ Adapter object providing a Swift-accessible interface to the filter's underlying
     return _inputBus.bus;
 }
 
+- (void)setOversamplingFactor:(int32_t)factor {
+    _kernel.setOversamplingFactor(factor);
+}
+
 - (bool)loadSfzFile:(const char *)path tuningPath:(const char * _Nullable) tuningPath {
     return _kernel.loadFile(path, tuningPath);
 }
@@ -46,7 +46,7 @@ public class CocoaEngine {
         engine.pause()
     }
     
-    func addTrackSfz(sfzPath: UnsafePointer<CChar>, tuningPath: UnsafePointer<CChar>, completion: @escaping (track_index_t) -> Void) {
+    func addTrackSfz(sfzPath: UnsafePointer<CChar>, tuningPath: UnsafePointer<CChar>, loadOptions: SfzLoadOptions, completion: @escaping (track_index_t) -> Void) {
         AudioUnitUtils.instantiate(
             description: SfizzAU.componentDescription,
             sampleRate: self.outputFormat.sampleRate,
@@ -55,6 +55,8 @@ public class CocoaEngine {
             AudioUnitUtils.setSampleRate(avAudioUnit: avAudioUnit, sampleRate: self.outputFormat.sampleRate)
             let sfizzAU = avAudioUnit.auAudioUnit as! SfizzAU
             
+            sfizzAU.applyLoadOptions(loadOptions)
+
             if (sfizzAU.loadSfzFile(path: sfzPath, tuningPath: tuningPath)) {
                 let trackIndex = SchedulerAddTrack(self.scheduler)
                 self.setTrackAudioUnit(trackIndex: trackIndex, avAudioUnit: avAudioUnit)
@@ -65,7 +67,7 @@ public class CocoaEngine {
         }
     }
     
-    func addTrackSfzString(sampleRoot: UnsafePointer<CChar>, sfzString: UnsafePointer<CChar>, tuningString: UnsafePointer<CChar>, completion: @escaping (track_index_t) -> Void) {
+    func addTrackSfzString(sampleRoot: UnsafePointer<CChar>, sfzString: UnsafePointer<CChar>, tuningString: UnsafePointer<CChar>, loadOptions: SfzLoadOptions, completion: @escaping (track_index_t) -> Void) {
         AudioUnitUtils.instantiate(
             description: SfizzAU.componentDescription,
             sampleRate: self.outputFormat.sampleRate,
@@ -74,6 +76,8 @@ public class CocoaEngine {
             AudioUnitUtils.setSampleRate(avAudioUnit: avAudioUnit, sampleRate: self.outputFormat.sampleRate)
             let sfizzAU = avAudioUnit.auAudioUnit as! SfizzAU
             
+            sfizzAU.applyLoadOptions(loadOptions)
+
             if (sfizzAU.loadSfzString(sampleRoot: sampleRoot, sfzString: sfzString, tuningString: tuningString)) {
                 let trackIndex = SchedulerAddTrack(self.scheduler)
                 self.setTrackAudioUnit(trackIndex: trackIndex, avAudioUnit: avAudioUnit)
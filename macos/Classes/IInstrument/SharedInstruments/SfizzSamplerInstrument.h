@@ -21,6 +21,12 @@ public:
         mSampler->setSamplesPerBlock(samplesPerBlock);
     }
 
+    // Must be called before loading. Samples are upsampled by 1, 2, 4 or 8 as they are loaded,
+    // which takes that many times the memory. Other factors are ignored.
+    void setOversamplingFactor(int32_t factor) {
+        mSampler->setOversamplingFactor(factor);
+    }
+
     bool loadSfzString(const char* sampleRoot, const char* sfzString, const char* tuningString) {
         auto loadResult = mSampler->loadSfzString(sampleRoot, sfzString);
         auto loadTuningResult = true;
@@ -88,15 +88,19 @@ func destroyEngine() {
 }
 
 @_cdecl("add_track_sfz")
-func addTrackSfz(sfzPath: UnsafePointer<CChar>, tuningPath: UnsafePointer<CChar>, callbackPort: Dart_Port) {
-    plugin.engine!.addTrackSfz(sfzPath: sfzPath, tuningPath: tuningPath) { trackIndex in
+func addTrackSfz(sfzPath: UnsafePointer<CChar>, tuningPath: UnsafePointer<CChar>, oversamplingFactor: Int32, callbackPort: Dart_Port) {
+    var loadOptions = SfzLoadOptions()
+    loadOptions.oversamplingFactor = oversamplingFactor
+    plugin.engine!.addTrackSfz(sfzPath: sfzPath, tuningPath: tuningPath, loadOptions: loadOptions) { trackIndex in
         callbackToDartInt32(callbackPort, trackIndex)
     }
 }
 
 @_cdecl("add_track_sfz_string")
-func addTrackSfzString(sampleRoot: UnsafePointer<CChar>, sfzString: UnsafePointer<CChar>, tuningString: UnsafePointer<CChar>, callbackPort: Dart_Port) {
-    plugin.engine!.addTrackSfzString(sampleRoot: sampleRoot, sfzString: sfzString, tuningString: tuningString) { trackIndex in
+func addTrackSfzString(sampleRoot: UnsafePointer<CChar>, sfzString: UnsafePointer<CChar>, tuningString: UnsafePointer<CChar>, oversamplingFactor: Int32, callbackPort: Dart_Port) {
+    var loadOptions = SfzLoadOptions()
+    loadOptions.oversamplingFactor = oversamplingFactor
+    plugin.engine!.addTrackSfzString(sampleRoot: sampleRoot, sfzString: sfzString, tuningString: tuningString, loadOptions: loadOptions) { trackIndex in
         callbackToDartInt32(callbackPort, trackIndex)
     }
 }
@@ -81,6 +81,15 @@ typedef enum {
     SFIZZ_PROCESS_FREEWHEELING,
 } sfizz_process_mode_t;
 
+/**
+ * @brief Format in which the samples are kept in memory
+ */
+typedef enum {
+    SFIZZ_SAMPLE_STORAGE_FLOAT32,
+    SFIZZ_SAMPLE_STORAGE_INT16,
+    SFIZZ_SAMPLE_STORAGE_FLOAT16,
+} sfizz_sample_storage_t;
+
 /**
  * @brief Creates a sfizz synth.
  *
@@ -367,6 +376,26 @@ SFIZZ_EXPORTED_API void sfizz_send_note_on(sfizz_synth_t* synth, int delay, int
  */
 SFIZZ_EXPORTED_API void sfizz_send_hd_note_on(sfizz_synth_t* synth, int delay, int note_number, float velocity);
 
+/**
+ * @brief Load the samples that a note on could play, ahead of it.
+ *
+ * Only the regions for the note's key and velocity are considered, without
+ * the rest of the synth state, so this may load a few samples that the note
+ * won't play. They are loaded whole in the background and kept in memory for
+ * at least the given time.
+ *
+ * @param synth        The synth.
+ * @param note_number  The MIDI note number, in domain 0 to 127.
+ * @param velocity     The normalized MIDI velocity, in domain 0 to 1.
+ * @param seconds      How long to keep the samples in memory at least.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function may be invoked from a thread other than the Real-time
+ *      thread, one at a time
+ * - @b OFF: the function cannot be invoked while an instrument is loading
+ */
+SFIZZ_EXPORTED_API void sfizz_prefetch_note(sfizz_synth_t* synth, int note_number, float velocity, float seconds);
+
 /**
  * @brief Send a note off event to the synth.
  * @since 0.2.0
@@ -755,9 +784,102 @@ SFIZZ_EXPORTED_API unsigned int sfizz_get_preload_size(sfizz_synth_t* synth);
 SFIZZ_EXPORTED_API void sfizz_set_preload_size(sfizz_synth_t* synth, unsigned int preload_size);
 
 /**
- * @brief Get the internal oversampling rate.
+ * @brief Share the preloaded samples with the other synths that do.
+ *
+ * Synths that load the same samples from the same paths then keep a single
+ * copy of them in memory. This takes effect when the next SFZ file is loaded.
+ *
+ * @param synth   The synth.
+ * @param shared  @true to share the samples.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_set_shared_sample_cache(sfizz_synth_t* synth, bool shared);
+
+/**
+ * @brief Return the memory used by the samples shared between synths, in
+ *        bytes, counting the preloaded data and what was streamed so far.
+ */
+SFIZZ_EXPORTED_API size_t sfizz_get_shared_sample_cache_memory(void);
+
+/**
+ * @brief Read uncompressed WAV and AIFF samples from the files mapped in
+ *        memory, rather than from float copies of them.
+ *
+ * The operating system then keeps in memory the parts of the files which are
+ * played. Reversed samples, and samples when oversampling, are still loaded
+ * as floats. Changing this resets all voices and reloads all samples.
+ *
+ * @param synth   The synth.
+ * @param mapped  @true to map the samples.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_set_sample_memory_mapping(sfizz_synth_t* synth, bool mapped);
+
+/**
+ * @brief Set the format in which the samples are kept in memory.
+ *
+ * The 16-bit formats take half the memory of floats, which leaves room to
+ * raise the preload size. 16-bit integers are exact for 16-bit files; half
+ * floats keep the precision of quiet passages better. Oversampled samples
+ * are kept as floats. Changing this resets all voices and reloads all
+ * samples.
+ *
+ * @param synth    The synth.
+ * @param storage  The sample storage.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_set_sample_storage(sfizz_synth_t* synth, sfizz_sample_storage_t storage);
+
+/**
+ * @brief Set whether the filters of the voices run together in SIMD lanes,
+ * rather than voice by voice.
+ *
+ * This applies to the regions whose filters are all biquads or state variable
+ * filters, and which have no equalizers. It is enabled by default. Changing
+ * this resets all voices.
+ *
+ * @param synth     The synth.
+ * @param batching  Whether to batch the filters.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_set_filter_batching(sfizz_synth_t* synth, bool batching);
+
+/**
+ * @brief Return the number of stream underruns.
+ *
+ * A stream underrun is a voice which played past the streamed part of its
+ * sample before the rest was loaded, and was cut short.
+ *
+ * @param synth  The synth.
+ */
+SFIZZ_EXPORTED_API size_t sfizz_get_stream_underruns(sfizz_synth_t* synth);
+
+/**
+ * @brief Cache the parsed SFZ files in a directory.
+ *
+ * Loading a file which, along with the files it includes and the external
+ * definitions, did not change since it was cached then skips the parsing.
+ * The wavetables computed from sample files are kept there as well.
+ * A null or empty path disables the cache, which is the default.
  *
- * As of 1.0, This is an inactive stub for future work on oversampling in the engine.
+ * @param synth      The synth.
+ * @param directory  The cache directory, created when needed.
+ *
+ * @par Thread-safety constraints
+ * - @b CT: the function must be invoked from the Control thread
+ */
+SFIZZ_EXPORTED_API void sfizz_set_instrument_cache_directory(sfizz_synth_t* synth, const char* directory);
+
+/**
+ * @brief Get the internal oversampling rate.
  *
  * @since 0.2.0
  *
@@ -768,7 +890,9 @@ SFIZZ_EXPORTED_API sfizz_oversampling_factor_t sfizz_get_oversampling_factor(sfi
 /**
  * @brief Set the internal oversampling rate.
  *
- * As of 1.0, This is an inactive stub for future work on oversampling in the engine.
+ * The samples are upsampled once, as they are preloaded and streamed, and
+ * take as many times more memory. This resets all voices and reloads all the
+ * samples, which can take a long time.
  * @since 0.2.0
  *
  * @param      synth         The synth.
@@ -103,6 +103,15 @@ public:
         ProcessFreewheeling,
     };
 
+    /**
+     * @brief Format in which the samples are kept in memory.
+     */
+    enum SampleStorage {
+        SampleStorageFloat32,
+        SampleStorageInt16,
+        SampleStorageFloat16,
+    };
+
     /**
      * @brief Empties the current regions and load a new SFZ file into the synth.
      *
@@ -425,6 +434,25 @@ public:
      */
     void hdNoteOn(int delay, int noteNumber, float velocity) noexcept;
 
+    /**
+     * @brief Load the samples that a note on could play, ahead of it.
+     *
+     * Only the regions for the note's key and velocity are considered, without
+     * the rest of the synth state, so this may load a few samples that the
+     * note won't play. They are loaded whole in the background and kept in
+     * memory for at least the given time.
+     *
+     * @param noteNumber the midi note number, in domain 0 to 127.
+     * @param velocity the normalized midi note velocity, in domain 0 to 1.
+     * @param seconds how long to keep the samples in memory at least.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function may be invoked from a thread other than the
+     *      Real-time thread, one at a time
+     * - @b OFF: the function cannot be invoked while an instrument is loading
+     */
+    void prefetchNote(int noteNumber, float velocity, float seconds) noexcept;
+
     /**
      * @brief Send a note off event to the synth.
      * @since 0.2.0
@@ -800,14 +828,17 @@ public:
     /**
      * @brief Set the oversampling factor to a new value.
      *
-     * As of 1.0, This is an inactive stub for future work on oversampling in the engine.
-     *
+     * The samples are upsampled by this factor once, as they are preloaded
+     * and streamed, so that pitching them up aliases less even with a cheap
+     * interpolator. The memory used by the samples grows by the same factor.
+     * Changing the factor resets all voices and reloads all the samples,
+     * which can take a long time.
      *
      * @since 0.2.0
      *
-     * @param factor The oversampling factor.
+     * @param factor The oversampling factor, one of 1, 2, 4 or 8.
      *
-     * @return @true if the factor did indeed change, @false otherwise.
+     * @return @true if the factor was valid, @false otherwise.
      *
      * @par Thread-safety constraints
      * - @b CT: the function must be invoked from the Control thread
@@ -818,9 +849,6 @@ public:
     /**
      * @brief Return the current oversampling factor.
      * @since 0.2.0
-     *
-     * As of 1.0, This is an inactive stub for future work on oversampling in the engine.
-     *
      */
     int getOversamplingFactor() const noexcept;
 
@@ -843,6 +871,100 @@ public:
      */
     uint32_t getPreloadSize() const noexcept;
 
+    /**
+     * @brief Share the preloaded samples with the other synths that do.
+     *
+     * Synths that load the same samples from the same paths then keep a
+     * single copy of them in memory, and all synths share the background
+     * threads that load them. This takes effect when the next SFZ file is
+     * loaded.
+     *
+     * @param shared @true to share the samples.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    void setSharedSampleCache(bool shared) noexcept;
+
+    /**
+     * @brief Return the memory used by the samples shared between synths, in
+     * bytes, counting the preloaded data and what was streamed so far.
+     */
+    static size_t getSharedSampleCacheMemory() noexcept;
+
+    /**
+     * @brief Read uncompressed WAV and AIFF samples from the files mapped in
+     * memory, rather than from float copies of them.
+     *
+     * The operating system then keeps in memory the parts of the files which
+     * are played, which saves memory on large libraries. Reversed samples,
+     * and samples when oversampling, are still loaded as floats. Changing
+     * this resets all voices and reloads all samples.
+     *
+     * @param mapped @true to map the samples.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    void setSampleMemoryMapping(bool mapped) noexcept;
+
+    /**
+     * @brief Set the format in which the samples are kept in memory.
+     *
+     * The 16-bit formats take half the memory of floats, which leaves room
+     * to raise the preload size. 16-bit integers are exact for 16-bit files;
+     * half floats keep the precision of quiet passages better. Oversampled
+     * samples are kept as floats. Changing this resets all voices and
+     * reloads all samples.
+     *
+     * @param storage the sample storage.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    void setSampleStorage(SampleStorage storage) noexcept;
+
+    /**
+     * @brief Set whether the filters of the voices run together in SIMD
+     * lanes, rather than voice by voice.
+     *
+     * This applies to the regions whose filters are all biquads or state
+     * variable filters, and which have no equalizers. It is enabled by
+     * default. Changing this resets all voices.
+     *
+     * @param batching whether to batch the filters.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    void setFilterBatching(bool batching) noexcept;
+
+    /**
+     * @brief Return the number of stream underruns.
+     *
+     * A stream underrun is a voice which played past the streamed part of
+     * its sample before the rest was loaded, and was cut short.
+     *
+     * @par Thread-safety constraints
+     * - @b TS: the function may be invoked from any thread
+     */
+    size_t getStreamUnderruns() const noexcept;
+
+    /**
+     * @brief Cache the parsed SFZ files in a directory.
+     *
+     * Loading a file which, along with the files it includes and the
+     * external definitions, did not change since it was cached then skips
+     * the parsing. The wavetables computed from sample files are kept there
+     * as well. An empty path disables the cache, which is the default.
+     *
+     * @param directory The cache directory, created when needed.
+     *
+     * @par Thread-safety constraints
+     * - @b CT: the function must be invoked from the Control thread
+     */
+    void setInstrumentCacheDirectory(const std::string& directory) noexcept;
+
     /**
      * @brief Return the number of allocated buffers.
      * @since 0.2.0
@@ -96,6 +96,7 @@ public:
     explicit ForwardReader(ST_AudioFile handle, std::unique_ptr<MetadataReader> mdReader);
     AudioReaderType type() const override;
     size_t readNextBlock(float* buffer, size_t frames) override;
+    bool seek(uint64_t frame) override;
 };
 
 ForwardReader::ForwardReader(ST_AudioFile handle, std::unique_ptr<MetadataReader> mdReader)
@@ -117,6 +118,11 @@ size_t ForwardReader::readNextBlock(float* buffer, size_t frames)
     return readFrames;
 }
 
+bool ForwardReader::seek(uint64_t frame)
+{
+    return handle_.seek(frame);
+}
+
 //------------------------------------------------------------------------------
 
 template <size_t N, class T = float>
@@ -165,6 +171,7 @@ public:
     explicit ReverseReader(ST_AudioFile handle, std::unique_ptr<MetadataReader> mdReader);
     AudioReaderType type() const override;
     size_t readNextBlock(float* buffer, size_t frames) override;
+    bool seek(uint64_t frame) override;
 
 private:
     uint64_t position_ {};
@@ -200,6 +207,13 @@ size_t ReverseReader::readNextBlock(float* buffer, size_t frames)
     return readFrames;
 }
 
+bool ReverseReader::seek(uint64_t frame)
+{
+    const uint64_t fileFrames = handle_.get_frame_count();
+    position_ = fileFrames - std::min(frame, fileFrames);
+    return true;
+}
+
 //------------------------------------------------------------------------------
 
 /**
@@ -210,12 +224,14 @@ public:
     explicit NoSeekReverseReader(ST_AudioFile handle, std::unique_ptr<MetadataReader> mdReader);
     AudioReaderType type() const override;
     size_t readNextBlock(float* buffer, size_t frames) override;
+    bool seek(uint64_t frame) override;
 
 private:
     void readWholeFile();
 
 private:
     std::unique_ptr<float[]> fileBuffer_;
+    uint64_t fileFrames_ { 0 };
     uint64_t fileFramesLeft_ { 0 };
 };
 
@@ -252,13 +268,23 @@ size_t NoSeekReverseReader::readNextBlock(float* buffer, size_t frames)
     return readFrames;
 }
 
+bool NoSeekReverseReader::seek(uint64_t frame)
+{
+    if (!fileBuffer_)
+        readWholeFile();
+
+    fileFramesLeft_ = fileFrames_ - std::min(frame, fileFrames_);
+    return true;
+}
+
 void NoSeekReverseReader::readWholeFile()
 {
     const uint64_t frames = handle_.get_frame_count();
     const unsigned channels = handle_.get_channels();
     float* fileBuffer = new float[channels * frames];
     fileBuffer_.reset(fileBuffer);
-    fileFramesLeft_ = handle_.read_f32(fileBuffer, frames);
+    fileFrames_ = handle_.read_f32(fileBuffer, frames);
+    fileFramesLeft_ = fileFrames_;
 }
 
 //------------------------------------------------------------------------------
@@ -316,6 +342,7 @@ public:
     unsigned channels() const override { return 1; }
     unsigned sampleRate() const override { return 44100; }
     size_t readNextBlock(float*, size_t) override { return 0; }
+    bool seek(uint64_t frame) override { return frame == 0; }
     bool getInstrumentInfo(InstrumentInfo& ) override { return false; }
 private:
     AudioReaderType type_ {};
@@ -399,6 +426,41 @@ AudioReaderPtr createAudioReader(const fs::path& path, bool reverse, std::error_
         absl::make_unique<FileMetadataReader>(path), reverse, ec);
 }
 
+AudioReaderPtr createExplicitAudioReader(const fs::path& path, AudioReaderType type, std::error_code* ec)
+{
+    ST_AudioFile handle;
+#if defined(_WIN32)
+    handle.open_file_w(path.wstring().c_str());
+#else
+    handle.open_file(path.c_str());
+#endif
+
+    if (ec)
+        ec->clear();
+
+    if (!handle) {
+        if (ec)
+            *ec = std::error_code(1, undetailed_category());
+        return AudioReaderPtr(new DummyAudioReader(type));
+    }
+
+    auto mdReader = absl::make_unique<FileMetadataReader>(path);
+    AudioReaderPtr reader;
+    switch (type) {
+    case AudioReaderType::Forward:
+        reader.reset(new ForwardReader(std::move(handle), std::move(mdReader)));
+        break;
+    case AudioReaderType::Reverse:
+        reader.reset(new ReverseReader(std::move(handle), std::move(mdReader)));
+        break;
+    case AudioReaderType::NoSeekReverse:
+        reader.reset(new NoSeekReverseReader(std::move(handle), std::move(mdReader)));
+        break;
+    }
+
+    return reader;
+}
+
 AudioReaderPtr createAudioReaderFromMemory(const void* memory, size_t length, bool reverse, std::error_code* ec)
 {
     ST_AudioFile handle;
@@ -40,6 +40,15 @@ public:
     virtual unsigned channels() const = 0;
     virtual unsigned sampleRate() const = 0;
     virtual size_t readNextBlock(float* buffer, size_t frames) = 0;
+    /**
+     * @brief Move to a frame, counted in the reading direction, so that the
+     * next block starts from there. Compressed files seek with the seek
+     * points of their decoder rather than decoding from the start.
+     *
+     * @param frame
+     * @return true if the reader moved to the frame
+     */
+    virtual bool seek(uint64_t frame) = 0;
     virtual bool getInstrumentInfo(InstrumentInfo&) { return false; };
     virtual bool getWavetableInfo(WavetableInfo&) { return false; };
 };
@@ -51,6 +60,11 @@ typedef std::unique_ptr<AudioReader> AudioReaderPtr;
  */
 AudioReaderPtr createAudioReader(const fs::path& path, bool reverse, std::error_code* ec = nullptr);
 
+/**
+ * @brief Create a file reader of explicit type.
+ */
+AudioReaderPtr createExplicitAudioReader(const fs::path& path, AudioReaderType type, std::error_code* ec = nullptr);
+
 /**
  * @brief Create a memory reader of detected type.
  */
@@ -62,6 +62,8 @@ namespace config {
     constexpr unsigned int defaultAlignment { 16 };
     constexpr int filtersInPool { maxVoices * 2 };
     constexpr int excessFileFrames { 64 };
+    // Frames of a mapped or compact sample which a voice decodes at once
+    constexpr int encodedWindowFrames { 1024 };
     constexpr int maxLFOSubs { 8 };
     constexpr int maxLFOSteps { 128 };
     /**
@@ -52,6 +52,28 @@ void sfz::EQHolder::process(const float** inputs, float** outputs, unsigned numF
     }
 
     ModMatrix& mm = resources.getModMatrix();
+    float* frequencyMod = mm.getModulation(frequencyTarget);
+    float* bandwidthMod = mm.getModulation(bandwidthTarget);
+    float* gainMod = mm.getModulation(gainTarget);
+
+    // Without modulation, or with constant modulations, the coefficients
+    // are computed once for the block
+    if ((!frequencyMod || mm.isModulationConstant(frequencyTarget))
+        && (!bandwidthMod || mm.isModulationConstant(bandwidthTarget))
+        && (!gainMod || mm.isModulationConstant(gainTarget))) {
+        const float frequency = baseFrequency + (frequencyMod ? frequencyMod[0] : 0.0f);
+        const float bandwidth = baseBandwidth + (bandwidthMod ? bandwidthMod[0] : 0.0f);
+        const float gain = baseGain + (gainMod ? gainMod[0] : 0.0f);
+
+        if (!prepared) {
+            eq->prepare(frequency, bandwidth, gain);
+            prepared = true;
+        }
+
+        eq->process(inputs, outputs, frequency, bandwidth, gain, numFrames);
+        return;
+    }
+
     BufferPool& bufferPool = resources.getBufferPool();
     auto frequencySpan = bufferPool.getBuffer(numFrames);
     auto bandwidthSpan = bufferPool.getBuffer(numFrames);
@@ -61,16 +83,16 @@ void sfz::EQHolder::process(const float** inputs, float** outputs, unsigned numF
         return;
 
     fill<float>(*frequencySpan, baseFrequency);
-    if (float* mod = mm.getModulation(frequencyTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *frequencySpan);
+    if (frequencyMod)
+        add<float>(absl::Span<float>(frequencyMod, numFrames), *frequencySpan);
 
     fill<float>(*bandwidthSpan, baseBandwidth);
-    if (float* mod = mm.getModulation(bandwidthTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *bandwidthSpan);
+    if (bandwidthMod)
+        add<float>(absl::Span<float>(bandwidthMod, numFrames), *bandwidthSpan);
 
     fill<float>(*gainSpan, baseGain);
-    if (float* mod = mm.getModulation(gainTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *gainSpan);
+    if (gainMod)
+        add<float>(absl::Span<float>(gainMod, numFrames), *gainSpan);
 
     if (!prepared) {
         eq->prepare(frequencySpan->front(), bandwidthSpan->front(), gainSpan->front());
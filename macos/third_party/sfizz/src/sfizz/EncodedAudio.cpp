@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "EncodedAudio.h"
+#include "MathHelpers.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace sfz {
+
+namespace {
+
+uint16_t u16le(const uint8_t* bytes)
+{
+    return bytes[0] | (bytes[1] << 8);
+}
+
+uint32_t u32le(const uint8_t* bytes)
+{
+    return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (uint32_t(bytes[3]) << 24);
+}
+
+uint16_t u16be(const uint8_t* bytes)
+{
+    return (bytes[0] << 8) | bytes[1];
+}
+
+uint32_t u32be(const uint8_t* bytes)
+{
+    return (uint32_t(bytes[0]) << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+}
+
+// Compact buffers are little-endian whatever the host, so that their views
+// read like the little-endian files
+void storeU16le(uint16_t value, uint16_t* output)
+{
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(output);
+    bytes[0] = value & 0xff;
+    bytes[1] = value >> 8;
+}
+
+float floatFromBits(uint32_t bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+float halfToFloat(uint16_t half)
+{
+    const uint32_t sign = uint32_t(half & 0x8000) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1f;
+    const uint32_t mantissa = half & 0x3ff;
+
+    if (exponent == 0) {
+        // Zero or subnormal, in units of 2^-24
+        const float value = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+        return sign ? -value : value;
+    }
+    if (exponent == 0x1f)
+        return floatFromBits(sign | 0x7f800000 | (mantissa << 13));
+
+    return floatFromBits(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    const uint32_t magnitude = bits & 0x7fffffff;
+
+    // Infinities and NaNs stay so, while what rounds above the largest half
+    // saturates rather than turning into an infinity
+    if (magnitude >= 0x7f800000)
+        return sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0);
+    if (magnitude >= 0x477ff000)
+        return sign | 0x7bff;
+
+    // Subnormal halves, rounded to nearest even in units of 2^-24; rounding
+    // up to 1024 gives the smallest normal half
+    if (magnitude < 0x38800000)
+        return sign | static_cast<uint16_t>(std::nearbyint(floatFromBits(magnitude) * 16777216.0f));
+
+    // Normal halves, rounded to nearest even; a carry out of the mantissa
+    // increments the exponent as it should
+    uint32_t half = ((magnitude >> 23) - 112) << 10 | ((magnitude >> 13) & 0x3ff);
+    const uint32_t remainder = magnitude & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        ++half;
+    return sign | static_cast<uint16_t>(half);
+}
+
+uint16_t floatToInt16(float value)
+{
+    const float scaled = std::nearbyint(value * 32768.0f);
+    return static_cast<uint16_t>(static_cast<int16_t>(clamp(scaled, -32768.0f, 32767.0f)));
+}
+
+template <SampleFormat Format, bool BigEndian>
+float readSample(const uint8_t* bytes);
+
+template <>
+float readSample<SampleFormat::Int16, false>(const uint8_t* bytes)
+{
+    return static_cast<int16_t>(u16le(bytes)) * (1.0f / 32768.0f);
+}
+
+template <>
+float readSample<SampleFormat::Int16, true>(const uint8_t* bytes)
+{
+    return static_cast<int16_t>(u16be(bytes)) * (1.0f / 32768.0f);
+}
+
+template <>
+float readSample<SampleFormat::Int24, false>(const uint8_t* bytes)
+{
+    const auto value = static_cast<int32_t>(
+        (uint32_t(bytes[0]) << 8) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[2]) << 24));
+    return (value >> 8) * (1.0f / 8388608.0f);
+}
+
+template <>
+float readSample<SampleFormat::Int24, true>(const uint8_t* bytes)
+{
+    const auto value = static_cast<int32_t>(
+        (uint32_t(bytes[2]) << 8) | (uint32_t(bytes[1]) << 16) | (uint32_t(bytes[0]) << 24));
+    return (value >> 8) * (1.0f / 8388608.0f);
+}
+
+template <>
+float readSample<SampleFormat::Int32, false>(const uint8_t* bytes)
+{
+    return static_cast<int32_t>(u32le(bytes)) * (1.0f / 2147483648.0f);
+}
+
+template <>
+float readSample<SampleFormat::Int32, true>(const uint8_t* bytes)
+{
+    return static_cast<int32_t>(u32be(bytes)) * (1.0f / 2147483648.0f);
+}
+
+template <>
+float readSample<SampleFormat::Float32, false>(const uint8_t* bytes)
+{
+    return floatFromBits(u32le(bytes));
+}
+
+template <>
+float readSample<SampleFormat::Float32, true>(const uint8_t* bytes)
+{
+    return floatFromBits(u32be(bytes));
+}
+
+template <>
+float readSample<SampleFormat::Float16, false>(const uint8_t* bytes)
+{
+    return halfToFloat(u16le(bytes));
+}
+
+template <>
+float readSample<SampleFormat::Float16, true>(const uint8_t* bytes)
+{
+    return halfToFloat(u16be(bytes));
+}
+
+template <SampleFormat Format, bool BigEndian>
+void readSamples(const uint8_t* input, size_t stride, float* output, size_t count)
+{
+    for (size_t i = 0; i < count; ++i, input += stride)
+        output[i] = readSample<Format, BigEndian>(input);
+}
+
+template <bool BigEndian>
+void readSamples(SampleFormat format, const uint8_t* input, size_t stride, float* output, size_t count)
+{
+    switch (format) {
+    case SampleFormat::Int16:
+        readSamples<SampleFormat::Int16, BigEndian>(input, stride, output, count);
+        break;
+    case SampleFormat::Int24:
+        readSamples<SampleFormat::Int24, BigEndian>(input, stride, output, count);
+        break;
+    case SampleFormat::Int32:
+        readSamples<SampleFormat::Int32, BigEndian>(input, stride, output, count);
+        break;
+    case SampleFormat::Float32:
+        readSamples<SampleFormat::Float32, BigEndian>(input, stride, output, count);
+        break;
+    case SampleFormat::Float16:
+        readSamples<SampleFormat::Float16, BigEndian>(input, stride, output, count);
+        break;
+    }
+}
+
+} // namespace
+
+void EncodedAudioSpan::read(size_t channel, int64_t firstFrame, absl::Span<float> output) const noexcept
+{
+    const int64_t outputSize = static_cast<int64_t>(output.size());
+    const int64_t readStart = clamp<int64_t>(firstFrame, 0, numFrames);
+    const int64_t readEnd = clamp<int64_t>(firstFrame + outputSize, readStart, numFrames);
+
+    // Where the frames of the span go in the output. When the output lies
+    // entirely before or after the span, this range is empty.
+    const int64_t outputStart = clamp<int64_t>(readStart - firstFrame, 0, outputSize);
+    const int64_t outputEnd = clamp<int64_t>(readEnd - firstFrame, outputStart, outputSize);
+
+    float* out = output.data();
+    std::fill(out, out + outputStart, 0.0f);
+    std::fill(out + outputEnd, out + outputSize, 0.0f);
+
+    if (outputStart == outputEnd)
+        return;
+
+    if (channel >= numChannels) {
+        std::fill(out + outputStart, out + outputEnd, 0.0f);
+        return;
+    }
+
+    const uint8_t* input = channels[channel] + (firstFrame + outputStart) * frameStride;
+    float* readOutput = out + outputStart;
+    const auto count = static_cast<size_t>(outputEnd - outputStart);
+    if (bigEndian)
+        readSamples<true>(format, input, frameStride, readOutput, count);
+    else
+        readSamples<false>(format, input, frameStride, readOutput, count);
+}
+
+void encodeSamples(SampleStorage storage, absl::Span<const float> input, absl::Span<uint16_t> output) noexcept
+{
+    ASSERT(output.size() >= input.size());
+    switch (storage) {
+    case SampleStorage::Int16:
+        for (size_t i = 0; i < input.size(); ++i)
+            storeU16le(floatToInt16(input[i]), &output[i]);
+        break;
+    case SampleStorage::Float16:
+        for (size_t i = 0; i < input.size(); ++i)
+            storeU16le(floatToHalf(input[i]), &output[i]);
+        break;
+    case SampleStorage::Float32:
+        ASSERTFALSE;
+        break;
+    }
+}
+
+EncodedAudioSpan compactAudioSpan(const CompactAudioBuffer& buffer, SampleStorage storage, size_t numFrames) noexcept
+{
+    ASSERT(storage != SampleStorage::Float32);
+    EncodedAudioSpan span;
+    span.format = (storage == SampleStorage::Float16) ? SampleFormat::Float16 : SampleFormat::Int16;
+    span.bigEndian = false;
+    span.numChannels = buffer.getNumChannels();
+    span.numFrames = std::min(numFrames, buffer.getNumFrames());
+    span.frameStride = sizeof(uint16_t);
+    for (size_t c = 0; c < span.numChannels; ++c)
+        span.channels[c] = reinterpret_cast<const uint8_t*>(buffer.getConstSpan(c).data());
+
+    return span;
+}
+
+} // namespace sfz
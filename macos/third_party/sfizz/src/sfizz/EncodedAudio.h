@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "AudioBuffer.h"
+#include <absl/types/span.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace sfz {
+
+/**
+ * @brief Formats of samples which are read where they are stored, rather
+ * than converted to floats in advance.
+ */
+enum class SampleFormat {
+    Int16,
+    Int24,
+    Int32,
+    Float32,
+    Float16,
+};
+
+/**
+ * @brief Formats in which the samples of files are kept in memory.
+ * The 16-bit formats take half the memory of floats; 16-bit integers are
+ * exact for 16-bit files, while half floats keep the precision of quiet
+ * passages at the expense of loud ones.
+ */
+enum class SampleStorage {
+    Float32,
+    Int16,
+    Float16,
+};
+
+/**
+ * @brief A view of samples in one of the sample formats, which are read as
+ * floats a range of frames at a time.
+ */
+struct EncodedAudioSpan {
+    SampleFormat format { SampleFormat::Int16 };
+    bool bigEndian { false };
+    size_t numChannels { 0 };
+    size_t numFrames { 0 };
+    // Bytes from a frame to the next one
+    size_t frameStride { 0 };
+    // The first sample of each channel
+    std::array<const uint8_t*, 2> channels {{ nullptr, nullptr }};
+
+    size_t getNumFrames() const noexcept { return numFrames; }
+    size_t getNumChannels() const noexcept { return numChannels; }
+
+    /**
+     * @brief Read the samples of a channel as floats, from a frame on.
+     * Frames out of the span read as zeros, like the padding of an audio
+     * buffer.
+     *
+     * @param channel
+     * @param firstFrame the frame read into the first output sample
+     * @param output
+     */
+    void read(size_t channel, int64_t firstFrame, absl::Span<float> output) const noexcept;
+};
+
+/**
+ * @brief Samples kept in one of the 16-bit sample storages, one buffer
+ * per channel.
+ */
+using CompactAudioBuffer = AudioBuffer<uint16_t, 2>;
+
+/**
+ * @brief Encode floats into one of the 16-bit sample storages.
+ *
+ * @param storage either SampleStorage::Int16 or SampleStorage::Float16
+ * @param input
+ * @param output as many samples as the input
+ */
+void encodeSamples(SampleStorage storage, absl::Span<const float> input, absl::Span<uint16_t> output) noexcept;
+
+/**
+ * @brief Get a view of the first frames of a compact buffer.
+ *
+ * @param buffer
+ * @param storage the storage the buffer was encoded in
+ * @param numFrames
+ */
+EncodedAudioSpan compactAudioSpan(const CompactAudioBuffer& buffer, SampleStorage storage, size_t numFrames) noexcept;
+
+} // namespace sfz
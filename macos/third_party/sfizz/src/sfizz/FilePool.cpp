@@ -29,6 +29,7 @@
 #include "AudioBuffer.h"
 #include "AudioSpan.h"
 #include "Config.h"
+#include "Oversampler.h"
 #include "utility/SwapAndPop.h"
 #include "utility/Debug.h"
 #include <ThreadPool.h>
@@ -36,8 +37,10 @@
 #include <absl/strings/match.h>
 #include <absl/memory/memory.h>
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <thread>
+#include <tuple>
 #include <system_error>
 #include <atomic_queue/defs.h>
 #if defined(_WIN32)
@@ -50,6 +53,12 @@ using namespace std::placeholders;
 static std::weak_ptr<ThreadPool> globalThreadPoolWeakPtr;
 static std::mutex globalThreadPoolMutex;
 
+static unsigned loaderThreadCount()
+{
+    unsigned numThreads = std::thread::hardware_concurrency();
+    return (numThreads > 2) ? (numThreads - 2) : 1;
+}
+
 static std::shared_ptr<ThreadPool> globalThreadPool()
 {
     std::shared_ptr<ThreadPool> threadPool;
@@ -63,13 +72,208 @@ static std::shared_ptr<ThreadPool> globalThreadPool()
     if (threadPool)
         return threadPool;
 
-    unsigned numThreads = std::thread::hardware_concurrency();
-    numThreads = (numThreads > 2) ? (numThreads - 2) : 1;
-    threadPool.reset(new ThreadPool(numThreads));
+    threadPool.reset(new ThreadPool(loaderThreadCount()));
     globalThreadPoolWeakPtr = threadPool;
     return threadPool;
 }
 
+/**
+ * @brief Runs the dispatching and the garbage collection of all the file
+ * pools, so that the number of background threads does not grow with the
+ * number of synths.
+ *
+ * The files to load are served earliest deadline first across all pools.
+ * Only as many loads as there are loader threads are handed to the thread
+ * pool at a time; the others wait here, where a load that is more urgent
+ * can still overtake them.
+ */
+class sfz::FilePoolThreads {
+public:
+    ~FilePoolThreads()
+    {
+        std::error_code ec;
+
+        garbageFlag = false;
+        semGarbageBarrier.post(ec);
+        garbageThread.join();
+
+        dispatchFlag = false;
+        dispatchBarrier.post(ec);
+        dispatchThread.join();
+    }
+
+    void addPool(FilePool* pool)
+    {
+        std::lock_guard<std::mutex> lock { poolsMutex };
+        pools.push_back(pool);
+    }
+
+    // Once this returns, the dispatching and garbage collection don't use
+    // the pool anymore; the loads it already started may still be running.
+    void removePool(FilePool* pool)
+    {
+        std::lock_guard<std::mutex> lock { poolsMutex };
+        pools.erase(std::remove(pools.begin(), pools.end(), pool), pools.end());
+
+        const auto end = std::remove_if(pendingLoads.begin(), pendingLoads.end(),
+            [pool](const PendingLoad& load) { return load.pool == pool; });
+        for (auto it = end; it != pendingLoads.end(); ++it)
+            pool->numLoads.fetch_sub(1);
+        pendingLoads.erase(end, pendingLoads.end());
+        std::make_heap(pendingLoads.begin(), pendingLoads.end(), laterDeadline);
+    }
+
+    void dispatch() noexcept
+    {
+        std::error_code ec;
+        dispatchBarrier.post(ec);
+        ASSERT(!ec);
+    }
+
+    void collectGarbage() noexcept
+    {
+        std::error_code ec;
+        semGarbageBarrier.post(ec);
+        ASSERT(!ec);
+    }
+
+private:
+    struct PendingLoad
+    {
+        FilePool* pool;
+        FilePool::QueuedFileData data;
+    };
+
+    static bool laterDeadline(const PendingLoad& lhs, const PendingLoad& rhs) noexcept
+    {
+        return lhs.data.deadline > rhs.data.deadline;
+    }
+
+    // Nobody waits for a load anymore once the region is gone, or when the
+    // voices which asked for it were stolen or ended and released the file
+    static bool isCancelled(const FilePool::QueuedFileData& data) noexcept
+    {
+        std::shared_ptr<FileId> id = data.id.lock();
+        if (!id)
+            return true;
+
+        return data.data->readerCount == 0 && data.data->status == FileData::Status::Preloaded;
+    }
+
+    void dispatchingJob() noexcept
+    {
+        while (dispatchBarrier.wait(), dispatchFlag) {
+            std::lock_guard<std::mutex> lock { poolsMutex };
+            for (FilePool* pool : pools) {
+                FilePool::QueuedFileData queuedData;
+                while (pool->filesToLoad->try_pop(queuedData)) {
+                    pendingLoads.push_back({ pool, std::move(queuedData) });
+                    std::push_heap(pendingLoads.begin(), pendingLoads.end(), laterDeadline);
+                }
+            }
+
+            startLoads();
+        }
+    }
+
+    void startLoads() noexcept
+    {
+        while (!pendingLoads.empty() && runningLoads < maxRunningLoads) {
+            std::pop_heap(pendingLoads.begin(), pendingLoads.end(), laterDeadline);
+            PendingLoad load = std::move(pendingLoads.back());
+            pendingLoads.pop_back();
+
+            if (isCancelled(load.data)) {
+                load.pool->numLoads.fetch_sub(1);
+                continue;
+            }
+
+            runningLoads.fetch_add(1);
+            threadPool->enqueue([this](const PendingLoad& load) {
+                load.pool->loadingJob(load.data);
+                runningLoads.fetch_sub(1);
+                dispatch();
+                // Last, since the pool may be destroyed as soon as it has
+                // no loads left
+                load.pool->numLoads.fetch_sub(1);
+            }, std::move(load));
+        }
+    }
+
+    void garbageJob() noexcept
+    {
+        while (semGarbageBarrier.wait(), garbageFlag) {
+            std::lock_guard<std::mutex> lock { poolsMutex };
+            for (FilePool* pool : pools)
+                pool->collectGarbage();
+        }
+    }
+
+    std::mutex poolsMutex;
+    std::vector<FilePool*> pools;
+
+    // A heap of the loads that are not started yet, earliest deadline on top
+    std::vector<PendingLoad> pendingLoads;
+    std::shared_ptr<ThreadPool> threadPool { globalThreadPool() };
+    const int maxRunningLoads { static_cast<int>(loaderThreadCount()) };
+    std::atomic<int> runningLoads { 0 };
+
+    // Signals
+    volatile bool dispatchFlag { true };
+    volatile bool garbageFlag { true };
+    RTSemaphore dispatchBarrier;
+    RTSemaphore semGarbageBarrier;
+
+    std::thread dispatchThread { &FilePoolThreads::dispatchingJob, this };
+    std::thread garbageThread { &FilePoolThreads::garbageJob, this };
+};
+
+static std::weak_ptr<sfz::FilePoolThreads> globalFilePoolThreadsWeakPtr;
+static std::mutex globalFilePoolThreadsMutex;
+
+static std::shared_ptr<sfz::FilePoolThreads> globalFilePoolThreads()
+{
+    std::lock_guard<std::mutex> lock(globalFilePoolThreadsMutex);
+    std::shared_ptr<sfz::FilePoolThreads> threads = globalFilePoolThreadsWeakPtr.lock();
+    if (threads)
+        return threads;
+
+    threads.reset(new sfz::FilePoolThreads);
+    globalFilePoolThreadsWeakPtr = threads;
+    return threads;
+}
+
+/**
+ * @brief The preloaded data of the pools with a shared cache, by absolute path,
+ * direction and oversampling factor. The cache does not keep the data alive,
+ * the pools that use it do.
+ */
+struct SharedFileCache {
+    // Path, reverse, oversampling factor, whether the file is mapped, and
+    // the sample storage
+    using Key = std::tuple<std::string, bool, int, bool, int>;
+    std::mutex mutex;
+    std::map<Key, std::weak_ptr<sfz::FileData>> files;
+
+    void removeExpiredFiles()
+    {
+        for (auto it = files.begin(); it != files.end(); ) {
+            if (it->second.expired())
+                it = files.erase(it);
+            else
+                ++it;
+        }
+    }
+};
+
+static SharedFileCache& sharedFileCache()
+{
+    static SharedFileCache cache;
+    return cache;
+}
+
+namespace sfz {
+
 void readBaseFile(sfz::AudioReader& reader, sfz::FileAudioBuffer& output, uint32_t numFrames)
 {
     output.reset();
@@ -85,33 +289,125 @@ void readBaseFile(sfz::AudioReader& reader, sfz::FileAudioBuffer& output, uint32
         output.addChannel();
         output.addChannel();
         output.clear();
+        // The SIMD deinterleaving reads past empty inputs
+        if (numFrames == 0)
+            return;
         sfz::Buffer<float> tempReadBuffer { 2 * numFrames };
         reader.readNextBlock(tempReadBuffer.data(), numFrames);
         sfz::readInterleaved(tempReadBuffer, output.getSpan(0), output.getSpan(1));
     }
 }
 
-sfz::FileAudioBuffer readFromFile(sfz::AudioReader& reader, uint32_t numFrames)
+sfz::FileAudioBuffer readFromFile(sfz::AudioReader& reader, uint32_t numFrames, sfz::Oversampling factor)
 {
     sfz::FileAudioBuffer baseBuffer;
     readBaseFile(reader, baseBuffer, numFrames);
-    return baseBuffer;
+    if (factor == sfz::Oversampling::x1)
+        return baseBuffer;
+
+    sfz::FileAudioBuffer outputBuffer { baseBuffer.getNumChannels(), numFrames * static_cast<int>(factor) };
+    sfz::Oversampler oversampler { factor };
+    oversampler.stream(baseBuffer, outputBuffer);
+    return outputBuffer;
 }
 
-void streamFromFile(sfz::AudioReader& reader, sfz::FileAudioBuffer& output, std::atomic<size_t>* filledFrames = nullptr)
+sfz::CompactAudioBuffer compactFromFile(sfz::AudioReader& reader, uint32_t numFrames, sfz::SampleStorage storage)
+{
+    sfz::FileAudioBuffer baseBuffer;
+    readBaseFile(reader, baseBuffer, numFrames);
+
+    sfz::CompactAudioBuffer outputBuffer { baseBuffer.getNumChannels(), baseBuffer.getNumFrames() };
+    for (size_t chanIdx = 0; chanIdx < baseBuffer.getNumChannels(); chanIdx++)
+        sfz::encodeSamples(storage, baseBuffer.getConstSpan(chanIdx), outputBuffer.getSpan(chanIdx));
+    return outputBuffer;
+}
+
+/**
+ * @brief Start streaming after the preloaded frames, which are copied rather
+ * than decoded again, if the reader can seek there.
+ *
+ * @return the number of frames copied
+ */
+template <class Buffer>
+size_t copyPreloadedFrames(sfz::AudioReader& reader, const Buffer& preloaded, Buffer& output, std::atomic<size_t>* filledFrames)
+{
+    const size_t numFrames = std::min(preloaded.getNumFrames(), output.getNumFrames());
+    if (numFrames == 0 || preloaded.getNumChannels() != output.getNumChannels() || !reader.seek(numFrames))
+        return 0;
+
+    for (size_t chanIdx = 0; chanIdx < output.getNumChannels(); chanIdx++) {
+        const auto input = preloaded.getConstSpan(chanIdx).first(numFrames);
+        std::copy(input.begin(), input.end(), output.getSpan(chanIdx).begin());
+    }
+
+    if (filledFrames != nullptr)
+        filledFrames->fetch_add(numFrames);
+
+    return numFrames;
+}
+
+void streamFromFile(sfz::AudioReader& reader, const sfz::CompactAudioBuffer& preloaded, sfz::CompactAudioBuffer& output, std::atomic<size_t>* filledFrames, sfz::SampleStorage storage)
 {
     const auto numFrames = static_cast<size_t>(reader.frames());
     const auto numChannels = reader.channels();
     const auto chunkSize = static_cast<size_t>(sfz::config::fileChunkSize);
 
+    // No need to clear, the voices only read the frames that are available
     output.reset();
     output.addChannels(reader.channels());
     output.resize(numFrames);
+
+    sfz::Buffer<float> fileBlock { chunkSize * numChannels };
+    sfz::Buffer<float> channelBlock { chunkSize };
+    size_t frameCounter = copyPreloadedFrames(reader, preloaded, output, filledFrames);
+
+    while (frameCounter < numFrames)
+    {
+        const auto thisChunkSize = std::min(chunkSize, numFrames - frameCounter);
+        const auto numFramesRead = static_cast<size_t>(
+            reader.readNextBlock(fileBlock.data(), thisChunkSize));
+        if (numFramesRead == 0)
+            break;
+
+        for (size_t chanIdx = 0; chanIdx < numChannels; chanIdx++) {
+            for (size_t i = 0; i < numFramesRead; ++i)
+                channelBlock[i] = fileBlock[i * numChannels + chanIdx];
+            sfz::encodeSamples(storage,
+                absl::MakeConstSpan(channelBlock.data(), numFramesRead),
+                output.getSpan(chanIdx).subspan(frameCounter, numFramesRead));
+        }
+        frameCounter += numFramesRead;
+
+        if (filledFrames != nullptr)
+            filledFrames->fetch_add(numFramesRead);
+
+        if (numFramesRead < thisChunkSize)
+            break;
+    }
+}
+
+void streamFromFile(sfz::AudioReader& reader, const sfz::FileAudioBuffer& preloaded, sfz::FileAudioBuffer& output, std::atomic<size_t>* filledFrames, sfz::Oversampling factor)
+{
+    const auto numFrames = static_cast<size_t>(reader.frames());
+    const auto numChannels = reader.channels();
+    const auto chunkSize = static_cast<size_t>(sfz::config::fileChunkSize);
+
+    output.reset();
+    output.addChannels(reader.channels());
+    output.resize(numFrames * static_cast<int>(factor));
     output.clear();
 
+    // The upsampler starts from the beginning of the file like it does for
+    // the preloaded data, so the streamed frames take over seamlessly
+    if (factor != sfz::Oversampling::x1) {
+        sfz::Oversampler oversampler { factor };
+        oversampler.stream(reader, output, filledFrames);
+        return;
+    }
+
     sfz::Buffer<float> fileBlock { chunkSize * numChannels };
-    size_t inputFrameCounter { 0 };
-    size_t outputFrameCounter { 0 };
+    size_t inputFrameCounter = copyPreloadedFrames(reader, preloaded, output, filledFrames);
+    size_t outputFrameCounter { inputFrameCounter };
     bool inputEof = false;
 
     while (!inputEof && inputFrameCounter < numFrames)
@@ -141,29 +437,39 @@ void streamFromFile(sfz::AudioReader& reader, sfz::FileAudioBuffer& output, std:
     }
 }
 
+} // namespace sfz
+
 sfz::FilePool::FilePool()
     : filesToLoad(alignedNew<FileQueue>()),
-      threadPool(globalThreadPool())
+      threadPool(globalThreadPool()),
+      backgroundThreads(globalFilePoolThreads())
 {
-    loadingJobs.reserve(config::maxVoices);
     lastUsedFiles.reserve(config::maxVoices);
     garbageToCollect.reserve(config::maxVoices);
+    compactGarbageToCollect.reserve(config::maxVoices);
+    prefetchedFiles.reserve(config::maxFilePromises);
+    backgroundThreads->addPool(this);
 }
 
 sfz::FilePool::~FilePool()
 {
-    std::error_code ec;
+    backgroundThreads->removePool(this);
 
-    garbageFlag = false;
-    semGarbageBarrier.post(ec);
-    garbageThread.join();
+    QueuedFileData queuedData;
+    while (filesToLoad->try_pop(queuedData))
+        numLoads.fetch_sub(1);
 
-    dispatchFlag = false;
-    dispatchBarrier.post(ec);
-    dispatchThread.join();
+    // The loads that were started still use the pool
+    while (numLoads > 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
 
-    for (auto& job : loadingJobs)
-        job.wait();
+    releasePrefetchedFiles();
+    preloadedFiles.clear();
+    if (sharedCache) {
+        auto& cache = sharedFileCache();
+        std::lock_guard<std::mutex> lock { cache.mutex };
+        cache.removeExpiredFiles();
+    }
 }
 
 bool sfz::FilePool::checkSample(std::string& filename) const noexcept
@@ -287,7 +593,7 @@ absl::optional<sfz::FileInformation> sfz::FilePool::checkExistingFileInformation
 
     const auto preloadedFile = preloadedFiles.find(fileId);
     if (preloadedFile != preloadedFiles.end())
-        return preloadedFile->second.information;
+        return preloadedFile->second.data->information;
 
     return {};
 }
@@ -319,44 +625,197 @@ bool sfz::FilePool::preloadFile(const FileId& fileId, uint32_t maxOffset) noexce
     if (!fileInformation)
         return false;
 
-    fileInformation->maxOffset = maxOffset;
-    const fs::path file { rootDirectory / fileId.filename() };
-    AudioReaderPtr reader = createAudioReader(file, fileId.isReverse());
+    const auto existingFile = preloadedFiles.find(fileId);
+    if (existingFile != preloadedFiles.end()) {
+        auto& preloadedFile = existingFile->second;
+        if (!preloadedFile.data->fullyLoaded && maxOffset > preloadedFile.data->information.maxOffset) {
+            fileInformation->maxOffset = maxOffset;
+            preloadedFile.data = loadPreloadedData(fileId, *fileInformation);
+        }
+        preloadedFile.preloadCallCount++;
+    } else {
+        fileInformation->maxOffset = maxOffset;
+        preloadedFiles.insert_or_assign(fileId, PreloadedFile { loadPreloadedData(fileId, *fileInformation), 1 });
+    }
 
-    const auto frames = static_cast<uint32_t>(reader->frames());
+    return true;
+}
+
+std::vector<absl::optional<sfz::FileInformation>> sfz::FilePool::probeFiles(std::vector<FileId>& fileIds) noexcept
+{
+    // The jobs only read the pool, which does not change until they are done
+    std::vector<std::future<absl::optional<FileInformation>>> jobs;
+    jobs.reserve(fileIds.size());
+    for (FileId& fileId : fileIds) {
+        jobs.push_back(threadPool->enqueue([this](FileId* fileId) -> absl::optional<FileInformation> {
+            if (!checkSampleId(*fileId))
+                return {};
+            return getFileInformation(*fileId);
+        }, &fileId));
+    }
+
+    std::vector<absl::optional<FileInformation>> fileInformation;
+    fileInformation.reserve(jobs.size());
+    for (auto& job : jobs)
+        fileInformation.push_back(job.get());
+
+    return fileInformation;
+}
+
+void sfz::FilePool::preloadFiles(const absl::flat_hash_map<FileId, FileInformation>& files) noexcept
+{
+    // Same as preloadFile, except that the data is read on the loading
+    // threads and then stored in the pool here
+    std::vector<std::pair<const FileId*, const FileInformation*>> filesToRead;
+    for (const auto& file : files) {
+        const FileId& fileId = file.first;
+        const FileInformation& information = file.second;
+
+        const auto loadedFile = loadedFiles.find(fileId);
+        if (loadedFile != loadedFiles.end()) {
+            loadedFile->second.preloadCallCount++;
+            continue;
+        }
+
+        const auto existingFile = preloadedFiles.find(fileId);
+        if (existingFile != preloadedFiles.end()) {
+            auto& preloadedFile = existingFile->second;
+            preloadedFile.preloadCallCount++;
+            if (preloadedFile.data->fullyLoaded || information.maxOffset <= preloadedFile.data->information.maxOffset)
+                continue;
+        }
+
+        filesToRead.emplace_back(&fileId, &information);
+    }
+
+    std::vector<std::future<std::shared_ptr<FileData>>> jobs;
+    jobs.reserve(filesToRead.size());
+    for (const auto& file : filesToRead) {
+        jobs.push_back(threadPool->enqueue([this](const FileId* fileId, const FileInformation* information) {
+            return loadPreloadedData(*fileId, *information);
+        }, file.first, file.second));
+    }
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const FileId& fileId = *filesToRead[i].first;
+        auto data = jobs[i].get();
+        const auto existingFile = preloadedFiles.find(fileId);
+        if (existingFile != preloadedFiles.end())
+            existingFile->second.data = std::move(data);
+        else
+            preloadedFiles.insert_or_assign(fileId, PreloadedFile { std::move(data), 1 });
+    }
+}
+
+void sfz::FilePool::runOnLoadingThreads(size_t numJobs, const std::function<void(size_t)>& job) noexcept
+{
+    std::vector<std::future<void>> jobs;
+    jobs.reserve(numJobs);
+    for (size_t i = 0; i < numJobs; ++i)
+        jobs.push_back(threadPool->enqueue([&job](size_t index) { job(index); }, i));
+
+    for (auto& pendingJob : jobs)
+        pendingJob.get();
+}
+
+std::shared_ptr<sfz::FileData> sfz::FilePool::loadPreloadedData(const FileId& fileId, const FileInformation& information) noexcept
+{
+    const auto frames = static_cast<uint32_t>(information.end + 1);
     const auto framesToLoad = [&]() {
         if (loadInRam)
             return frames;
         else
-            return min(frames, maxOffset + preloadSize);
+            return min(frames, static_cast<uint32_t>(information.maxOffset) + preloadSize);
     }();
+    const fs::path file { rootDirectory / fileId.filename() };
 
-    const auto existingFile = preloadedFiles.find(fileId);
-    if (existingFile != preloadedFiles.end()) {
-        auto& fileData = existingFile->second;
-        if (framesToLoad > fileData.preloadedData.getNumFrames()) {
-            fileData.information.maxOffset = maxOffset;
-            fileData.preloadedData = readFromFile(*reader, framesToLoad);
-            fileData.fullyLoaded = frames == framesToLoad;
+    // Another pool may have preloaded enough of the file already
+    auto& cache = sharedFileCache();
+    const std::string sharedPath = sharedCache ? file.lexically_normal().string() : std::string();
+    const auto isEnough = [&](const FileData& data) {
+        return data.fullyLoaded || data.getPreloadedFrames() >= framesToLoad * static_cast<int>(oversamplingFactor);
+    };
+    const auto findShared = [&](const SharedFileCache::Key& key) -> std::shared_ptr<FileData> {
+        std::lock_guard<std::mutex> lock { cache.mutex };
+        auto shared = cache.files[key].lock();
+        return (shared && isEnough(*shared)) ? shared : nullptr;
+    };
+    const auto share = [&](const SharedFileCache::Key& key, std::shared_ptr<FileData> data) {
+        // The file is read without holding the lock, so another pool may
+        // have been quicker
+        std::lock_guard<std::mutex> lock { cache.mutex };
+        auto& entry = cache.files[key];
+        auto shared = entry.lock();
+        if (shared && isEnough(*shared))
+            return shared;
+
+        entry = data;
+        return data;
+    };
+
+    if (memoryMapping && !fileId.isReverse() && oversamplingFactor == Oversampling::x1) {
+        const SharedFileCache::Key key { sharedPath, false, 1, true, 0 };
+        if (sharedCache) {
+            if (auto shared = findShared(key)) {
+                shared->mappedFile->touch(framesToLoad);
+                return shared;
+            }
         }
-        fileData.preloadCallCount++;
-    } else {
-        fileInformation->sampleRate = static_cast<double>(reader->sampleRate());
-        auto insertedPair = preloadedFiles.insert_or_assign(fileId, {
-            readFromFile(*reader, framesToLoad),
-            *fileInformation
-        });
 
-        insertedPair.first->second.preloadCallCount++;
-        insertedPair.first->second.status = FileData::Status::Preloaded;
-        insertedPair.first->second.fullyLoaded = framesToLoad == frames;
+        // Files that can't be mapped are loaded as usual
+        if (auto mappedFile = MappedAudioFile::map(file)) {
+            mappedFile->touch(framesToLoad);
+            auto data = std::make_shared<FileData>(FileAudioBuffer {}, information, oversamplingFactor);
+            data->mappedFile = std::move(mappedFile);
+            data->status = FileData::Status::Preloaded;
+            data->fullyLoaded = true;
+            return sharedCache ? share(key, std::move(data)) : data;
+        }
     }
 
-    return true;
+    // The compact storages hold the frames of the file as they are
+    const SampleStorage storage = (oversamplingFactor == Oversampling::x1) ? sampleStorage : SampleStorage::Float32;
+    const SharedFileCache::Key key { sharedPath, fileId.isReverse(), static_cast<int>(oversamplingFactor), false, static_cast<int>(storage) };
+    if (sharedCache) {
+        if (auto shared = findShared(key))
+            return shared;
+    }
+
+    AudioReaderPtr reader = createAudioReader(file, fileId.isReverse());
+    std::shared_ptr<FileData> data;
+    if (storage == SampleStorage::Float32) {
+        data = std::make_shared<FileData>(
+            readFromFile(*reader, framesToLoad, oversamplingFactor),
+            information,
+            oversamplingFactor
+        );
+    } else {
+        data = std::make_shared<FileData>(FileAudioBuffer {}, information, oversamplingFactor);
+        data->compactPreloadedData = compactFromFile(*reader, framesToLoad, storage);
+        data->storage = storage;
+    }
+    data->status = FileData::Status::Preloaded;
+    data->fullyLoaded = framesToLoad == frames;
+
+    return sharedCache ? share(key, std::move(data)) : data;
+}
+
+void sfz::FilePool::reloadPreloadedFiles() noexcept
+{
+    // The prefetched files may be replaced
+    releasePrefetchedFiles();
+
+    for (auto& preloadedFile : preloadedFiles) {
+        auto& data = preloadedFile.second.data;
+        data = loadPreloadedData(preloadedFile.first, data->information);
+    }
 }
 
 void sfz::FilePool::resetPreloadCallCounts() noexcept
 {
+    // Preloading again may replace the prefetched files
+    releasePrefetchedFiles();
+
     for (auto& preloadedFile: preloadedFiles)
         preloadedFile.second.preloadCallCount = 0;
 
@@ -366,6 +825,8 @@ void sfz::FilePool::resetPreloadCallCounts() noexcept
 
 void sfz::FilePool::removeUnusedPreloadedData() noexcept
 {
+    releasePrefetchedFiles();
+
     for (auto it = preloadedFiles.begin(), end = preloadedFiles.end(); it != end; ) {
         auto copyIt = it++;
         if (copyIt->second.preloadCallCount == 0) {
@@ -381,6 +842,12 @@ void sfz::FilePool::removeUnusedPreloadedData() noexcept
             loadedFiles.erase(copyIt);
         }
     }
+
+    if (sharedCache) {
+        auto& cache = sharedFileCache();
+        std::lock_guard<std::mutex> lock { cache.mutex };
+        cache.removeExpiredFiles();
+    }
 }
 
 sfz::FileDataHolder sfz::FilePool::loadFile(const FileId& fileId) noexcept
@@ -400,7 +867,7 @@ sfz::FileDataHolder sfz::FilePool::loadFile(const FileId& fileId) noexcept
 
     const auto frames = static_cast<uint32_t>(reader->frames());
     auto insertedPair = loadedFiles.insert_or_assign(fileId, {
-        readFromFile(*reader, frames),
+        readFromFile(*reader, frames, Oversampling::x1),
         *fileInformation
     });
     insertedPair.first->second.preloadCallCount++;
@@ -419,7 +886,7 @@ sfz::FileDataHolder sfz::FilePool::loadFromRam(const FileId& fileId, const std::
     auto fileInformation = getReaderInformation(reader.get());
     const auto frames = static_cast<uint32_t>(reader->frames());
     auto insertedPair = loadedFiles.insert_or_assign(fileId, {
-        readFromFile(*reader, frames),
+        readFromFile(*reader, frames, Oversampling::x1),
         *fileInformation
     });
     insertedPair.first->second.preloadCallCount++;
@@ -429,7 +896,7 @@ sfz::FileDataHolder sfz::FilePool::loadFromRam(const FileId& fileId, const std::
     return { &insertedPair.first->second };
 }
 
-sfz::FileDataHolder sfz::FilePool::getFilePromise(const std::shared_ptr<FileId>& fileId) noexcept
+sfz::FileDataHolder sfz::FilePool::getFilePromise(const std::shared_ptr<FileId>& fileId, TimePoint startTime, int64_t startFrame, float speed) noexcept
 {
     const auto loaded = loadedFiles.find(*fileId);
     if (loaded != loadedFiles.end())
@@ -441,20 +908,62 @@ sfz::FileDataHolder sfz::FilePool::getFilePromise(const std::shared_ptr<FileId>&
         return {};
     }
 
-    auto& fileData = preloaded->second;
+    auto& fileData = *preloaded->second.data;
+    // Held before the load is queued, so that it is not taken as cancelled
+    FileDataHolder holder { &fileData };
     if (!fileData.fullyLoaded) {
-        QueuedFileData queuedData { fileId, &fileData };
+        // The voice runs past the preloaded frames at the deadline
+        const double framesAhead = static_cast<double>(fileData.getPreloadedFrames())
+            / static_cast<int>(fileData.oversamplingFactor) - static_cast<double>(startFrame);
+        const double secondsAhead = max(framesAhead, 0.0) / (fileData.information.sampleRate * max(speed, 1e-3f));
+        const TimePoint deadline = startTime + std::chrono::duration_cast<TimePoint::duration>(Duration(secondsAhead));
+
+        QueuedFileData queuedData { fileId, &fileData, deadline };
+        numLoads.fetch_add(1);
         if (!filesToLoad->try_push(queuedData)) {
+            numLoads.fetch_sub(1);
             DBG("[sfizz] Could not enqueue the file to load for " << fileId << " (queue capacity " << filesToLoad->capacity() << ")");
             return {};
         }
 
-        std::error_code ec;
-        dispatchBarrier.post(ec);
-        ASSERT(!ec);
+        backgroundThreads->dispatch();
     }
 
-    return { &preloaded->second };
+    return holder;
+}
+
+bool sfz::FilePool::prefetch(const std::shared_ptr<FileId>& fileId, TimePoint deadline) noexcept
+{
+    std::lock_guard<SpinMutex> guard { prefetchMutex };
+
+    auto it = absl::c_find_if(prefetchedFiles, [&](const PrefetchedFile& file) {
+        return file.id == *fileId;
+    });
+    if (it != prefetchedFiles.end()) {
+        it->deadline = std::max(it->deadline, deadline);
+        return true;
+    }
+
+    if (prefetchedFiles.size() == prefetchedFiles.capacity()) {
+        DBG("[sfizz] Too many prefetched files to prefetch " << fileId->filename());
+        return false;
+    }
+
+    FileDataHolder data = getFilePromise(fileId);
+    if (!data)
+        return false;
+
+    if (data->isMapped())
+        data->mappedFile->adviseWillNeed();
+
+    prefetchedFiles.push_back({ *fileId, std::move(data), deadline });
+    return true;
+}
+
+void sfz::FilePool::releasePrefetchedFiles() noexcept
+{
+    std::lock_guard<SpinMutex> guard { prefetchMutex };
+    prefetchedFiles.clear();
 }
 
 void sfz::FilePool::setPreloadSize(uint32_t preloadSize) noexcept
@@ -464,17 +973,24 @@ void sfz::FilePool::setPreloadSize(uint32_t preloadSize) noexcept
         return;
 
     // Update all the preloaded sizes
-    for (auto& preloadedFile : preloadedFiles) {
-        auto& fileId = preloadedFile.first;
-        auto& fileData = preloadedFile.second;
-        const auto maxOffset = fileData.information.maxOffset;
-        fs::path file { rootDirectory / fileId.filename() };
-        AudioReaderPtr reader = createAudioReader(file, fileId.isReverse());
-        const auto frames = reader->frames();
-        const auto framesToLoad = min(frames, maxOffset + preloadSize);
-        fileData.preloadedData = readFromFile(*reader, static_cast<uint32_t>(framesToLoad));
-        fileData.fullyLoaded = frames == framesToLoad;
-    }
+    reloadPreloadedFiles();
+}
+
+void sfz::FilePool::setOversamplingFactor(Oversampling factor) noexcept
+{
+    if (factor == oversamplingFactor)
+        return;
+
+    oversamplingFactor = factor;
+
+    // Reload the preloaded data at the new rate; what was streamed at the old
+    // one goes with the old data, so it is streamed again on the next promise
+    reloadPreloadedFiles();
+}
+
+sfz::Oversampling sfz::FilePool::getOversamplingFactor() const noexcept
+{
+    return oversamplingFactor;
 }
 
 void sfz::FilePool::loadingJob(const QueuedFileData& data) noexcept
@@ -521,19 +1037,25 @@ void sfz::FilePool::loadingJob(const QueuedFileData& data) noexcept
             atomic_queue::spin_loop_pause();
             continue;
         }
-        // Already loading or loaded
+        // Already loaded, possibly by another pool that shares the file and
+        // may not collect it anymore, so this one collects it too
+        if (currentStatus == FileData::Status::Done)
+            break;
+        // Already loading
         if (currentStatus != FileData::Status::Preloaded)
             return;
 
         // go outside loop if this gets token
-        if (data.data->status.compare_exchange_strong(currentStatus, FileData::Status::Streaming))
+        if (data.data->status.compare_exchange_strong(currentStatus, FileData::Status::Streaming)) {
+            if (data.data->storage == SampleStorage::Float32)
+                streamFromFile(*reader, data.data->preloadedData, data.data->fileData, &data.data->availableFrames, data.data->oversamplingFactor);
+            else
+                streamFromFile(*reader, data.data->compactPreloadedData, data.data->compactFileData, &data.data->availableFrames, data.data->storage);
+            data.data->status = FileData::Status::Done;
             break;
+        }
     }
 
-    streamFromFile(*reader, data.data->fileData, &data.data->availableFrames);
-
-    data.data->status = FileData::Status::Done;
-
     std::lock_guard<SpinMutex> guard { garbageAndLastUsedMutex };
     if (absl::c_find(lastUsedFiles, *id) == lastUsedFiles.end())
         lastUsedFiles.push_back(*id);
@@ -541,12 +1063,21 @@ void sfz::FilePool::loadingJob(const QueuedFileData& data) noexcept
 
 void sfz::FilePool::clear()
 {
+    releasePrefetchedFiles();
+
     std::lock_guard<SpinMutex> guard { garbageAndLastUsedMutex };
     emptyFileLoadingQueues();
     garbageToCollect.clear();
+    compactGarbageToCollect.clear();
     lastUsedFiles.clear();
     preloadedFiles.clear();
     loadedFiles.clear();
+
+    if (sharedCache) {
+        auto& cache = sharedFileCache();
+        std::lock_guard<std::mutex> lock { cache.mutex };
+        cache.removeExpiredFiles();
+    }
 }
 
 uint32_t sfz::FilePool::getPreloadSize() const noexcept
@@ -554,50 +1085,19 @@ uint32_t sfz::FilePool::getPreloadSize() const noexcept
     return preloadSize;
 }
 
-template <typename R>
-bool is_ready(std::future<R> const& f)
+void sfz::FilePool::collectGarbage() noexcept
 {
-    return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
-}
-
-void sfz::FilePool::dispatchingJob() noexcept
-{
-    while (dispatchBarrier.wait(), dispatchFlag) {
-        std::lock_guard<std::mutex> guard { loadingJobsMutex };
-
-        QueuedFileData queuedData;
-        if (filesToLoad->try_pop(queuedData)) {
-            if (queuedData.id.expired()) {
-                // file ID was nulled, it means the region was deleted, ignore
-            }
-            else
-                loadingJobs.push_back(
-                    threadPool->enqueue([this](const QueuedFileData& data) { loadingJob(data); }, std::move(queuedData)));
-        }
-
-        // Clear finished jobs
-        swapAndPopAll(loadingJobs, [](std::future<void>& future) {
-            return is_ready(future);
-        });
-    }
-}
-
-void sfz::FilePool::garbageJob() noexcept
-{
-    while (semGarbageBarrier.wait(), garbageFlag) {
-        std::lock_guard<SpinMutex> guard { garbageAndLastUsedMutex };
-        garbageToCollect.clear();
-    }
+    std::lock_guard<SpinMutex> guard { garbageAndLastUsedMutex };
+    garbageToCollect.clear();
+    compactGarbageToCollect.clear();
 }
 
 void sfz::FilePool::waitForBackgroundLoading() noexcept
 {
-    std::lock_guard<std::mutex> guard { loadingJobsMutex };
-
-    for (auto& job : loadingJobs)
-        job.wait();
-
-    loadingJobs.clear();
+    // The queued files count as loads until they are loaded or cancelled
+    backgroundThreads->dispatch();
+    while (numLoads > 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
 }
 
 void sfz::FilePool::raiseCurrentThreadPriority() noexcept
@@ -637,30 +1137,65 @@ void sfz::FilePool::setRamLoading(bool loadInRam) noexcept
         return;
 
     this->loadInRam = loadInRam;
+    reloadPreloadedFiles();
+}
 
-    if (loadInRam) {
-        for (auto& preloadedFile : preloadedFiles) {
-            fs::path file { rootDirectory / preloadedFile.first.filename() };
-            AudioReaderPtr reader = createAudioReader(file, preloadedFile.first.isReverse());
-            auto& fileData = preloadedFile.second;
-            fileData.preloadedData = readFromFile(
-                *reader,
-                fileData.information.end
-            );
-            fileData.fullyLoaded = true;
-        }
-    } else {
-        setPreloadSize(preloadSize);
+void sfz::FilePool::setMemoryMapping(bool memoryMapping) noexcept
+{
+    if (memoryMapping == this->memoryMapping)
+        return;
+
+    this->memoryMapping = memoryMapping;
+    reloadPreloadedFiles();
+}
+
+void sfz::FilePool::setSampleStorage(SampleStorage storage) noexcept
+{
+    if (storage == sampleStorage)
+        return;
+
+    sampleStorage = storage;
+    reloadPreloadedFiles();
+}
+
+size_t sfz::FilePool::getSharedCacheMemory() noexcept
+{
+    auto& cache = sharedFileCache();
+    std::lock_guard<std::mutex> lock { cache.mutex };
+
+    size_t numBytes = 0;
+    for (const auto& file : cache.files) {
+        auto data = file.second.lock();
+        if (!data)
+            continue;
+
+        const size_t numFrames = data->getPreloadedFrames() + data->availableFrames;
+        if (data->storage == SampleStorage::Float32)
+            numBytes += numFrames * data->preloadedData.getNumChannels() * sizeof(float);
+        else
+            numBytes += numFrames * data->compactPreloadedData.getNumChannels() * sizeof(uint16_t);
     }
+
+    return numBytes;
 }
 
 void sfz::FilePool::triggerGarbageCollection() noexcept
 {
+    const auto now = std::chrono::high_resolution_clock::now();
+
+    // Prefetched files are let go of once their deadline is past, and then
+    // collected like any other file nobody reads
+    const std::unique_lock<SpinMutex> prefetchGuard { prefetchMutex, std::try_to_lock };
+    if (prefetchGuard.owns_lock()) {
+        swapAndPopAll(prefetchedFiles, [now](const PrefetchedFile& file) {
+            return file.deadline < now;
+        });
+    }
+
     const std::unique_lock<SpinMutex> guard { garbageAndLastUsedMutex, std::try_to_lock };
     if (!guard.owns_lock())
         return;
 
-    const auto now = std::chrono::high_resolution_clock::now();
     swapAndPopAll(lastUsedFiles, [&](const FileId& id) {
         if (garbageToCollect.size() == garbageToCollect.capacity())
            return false;
@@ -672,7 +1207,7 @@ void sfz::FilePool::triggerGarbageCollection() noexcept
             return true;
         }
 
-        sfz::FileData& data = it->second;
+        sfz::FileData& data = *it->second.data;
 
         if (data.readerCount != 0)
             return false;
@@ -699,6 +1234,7 @@ void sfz::FilePool::triggerGarbageCollection() noexcept
             if (readerCount == 0) {
                 data.availableFrames = 0;
                 garbageToCollect.push_back(std::move(data.fileData));
+                compactGarbageToCollect.push_back(std::move(data.compactFileData));
                 data.status = FileData::Status::Preloaded;
                 return true;
             }
@@ -707,7 +1243,5 @@ void sfz::FilePool::triggerGarbageCollection() noexcept
         return false;
     });
 
-    std::error_code ec;
-    semGarbageBarrier.post(ec);
-    ASSERT(!ec);
+    backgroundThreads->collectGarbage();
 }
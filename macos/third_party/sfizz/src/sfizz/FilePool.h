@@ -31,6 +31,8 @@
 #include "AudioSpan.h"
 #include "FileId.h"
 #include "FileMetadata.h"
+#include "MappedAudio.h"
+#include "Oversampler.h"
 #include "SIMDHelpers.h"
 #include "SpinMutex.h"
 #include "utility/Timing.h"
@@ -42,12 +44,15 @@
 #include <absl/strings/string_view.h>
 #include <atomic_queue/atomic_queue.h>
 #include <chrono>
+#include <functional>
 #include <thread>
 #include <future>
 #include <memory>
 class ThreadPool;
 
 namespace sfz {
+class AudioReader;
+class FilePoolThreads;
 using FileAudioBuffer = AudioBuffer<float, 2, config::defaultAlignment,
                                     sfz::config::excessFileFrames, sfz::config::excessFileFrames>;
 using FileAudioBufferPtr = std::shared_ptr<FileAudioBuffer>;
@@ -69,14 +74,15 @@ struct FileData
 {
     enum class Status { Invalid, Preloaded, Streaming, Done, GarbageCollecting };
     FileData() = default;
-    FileData(FileAudioBuffer preloaded, FileInformation info)
-    : preloadedData(std::move(preloaded)), information(std::move(info))
+    FileData(FileAudioBuffer preloaded, FileInformation info, Oversampling factor = Oversampling::x1)
+    : preloadedData(std::move(preloaded)), information(std::move(info)), oversamplingFactor(factor)
     {
 
     }
     AudioSpan<const float> getData()
     {
         ASSERT(readerCount > 0);
+        ASSERT(!isEncoded());
         if (status != Status::GarbageCollecting && availableFrames > preloadedData.getNumFrames())
             return AudioSpan<const float>(fileData).first(availableFrames);
         else
@@ -91,6 +97,11 @@ struct FileData
         information = std::move(other.information);
         preloadedData = std::move(other.preloadedData);
         fileData = std::move(other.fileData);
+        compactPreloadedData = std::move(other.compactPreloadedData);
+        compactFileData = std::move(other.compactFileData);
+        storage = other.storage;
+        mappedFile = std::move(other.mappedFile);
+        oversamplingFactor = other.oversamplingFactor;
         preloadCallCount = other.preloadCallCount;
         availableFrames = other.availableFrames.load();
         lastViewerLeftAt = other.lastViewerLeftAt;
@@ -102,6 +113,11 @@ struct FileData
         information = std::move(other.information);
         preloadedData = std::move(other.preloadedData);
         fileData = std::move(other.fileData);
+        compactPreloadedData = std::move(other.compactPreloadedData);
+        compactFileData = std::move(other.compactFileData);
+        storage = other.storage;
+        mappedFile = std::move(other.mappedFile);
+        oversamplingFactor = other.oversamplingFactor;
         preloadCallCount = other.preloadCallCount;
         availableFrames = other.availableFrames.load();
         lastViewerLeftAt = other.lastViewerLeftAt;
@@ -109,9 +125,44 @@ struct FileData
         return *this;
     }
 
+    /**
+     * @brief Whether the samples are read with getEncodedData() instead of
+     * getData(), because the file is mapped in memory or kept in one of the
+     * compact storages.
+     */
+    bool isEncoded() const noexcept { return isMapped() || storage != SampleStorage::Float32; }
+    bool isMapped() const noexcept { return mappedFile != nullptr; }
+    EncodedAudioSpan getEncodedData() const noexcept
+    {
+        ASSERT(readerCount > 0);
+        ASSERT(isEncoded());
+        if (isMapped())
+            return mappedFile->getSpan();
+        if (status != Status::GarbageCollecting && availableFrames > compactPreloadedData.getNumFrames())
+            return compactAudioSpan(compactFileData, storage, availableFrames);
+        else
+            return compactAudioSpan(compactPreloadedData, storage, compactPreloadedData.getNumFrames());
+    }
+    /**
+     * @brief Get the number of preloaded frames, in whichever storage.
+     */
+    size_t getPreloadedFrames() const noexcept
+    {
+        return storage == SampleStorage::Float32 ? preloadedData.getNumFrames() : compactPreloadedData.getNumFrames();
+    }
+
     FileAudioBuffer preloadedData;
     FileInformation information;
     FileAudioBuffer fileData {};
+    // Set instead of the float data when the samples are kept compact
+    CompactAudioBuffer compactPreloadedData;
+    CompactAudioBuffer compactFileData;
+    SampleStorage storage { SampleStorage::Float32 };
+    // Set instead of the audio data when the file is mapped in memory
+    std::unique_ptr<MappedAudioFile> mappedFile;
+    // The audio data holds this many frames for each frame of the file;
+    // the information is in frames of the file.
+    Oversampling oversamplingFactor { Oversampling::x1 };
     int preloadCallCount { 0 };
     std::atomic<Status> status { Status::Invalid };
     bool fullyLoaded { false };
@@ -168,6 +219,34 @@ private:
     LEAK_DETECTOR(FileDataHolder);
 };
 
+/**
+ * @brief Read the first frames of a file, upsampled by a factor, as the pool
+ * preloads them.
+ */
+FileAudioBuffer readFromFile(AudioReader& reader, uint32_t numFrames, Oversampling factor);
+/**
+ * @brief Read the first frames of a file in a compact storage, as the pool
+ * preloads them.
+ */
+CompactAudioBuffer compactFromFile(AudioReader& reader, uint32_t numFrames, SampleStorage storage);
+/**
+ * @brief Read a whole file as the loading threads stream it. The frames which
+ * were preloaded from the same reader are copied, and the reader seeks past
+ * them, unless their channels differ from the file's or the reader can't seek.
+ * Oversampled files are always read from the start.
+ *
+ * @param reader a reader at the start of the file
+ * @param preloaded the frames preloaded from the file
+ * @param output the whole file
+ * @param filledFrames counts the frames written to the output, if not null
+ * @param factor
+ */
+void streamFromFile(AudioReader& reader, const FileAudioBuffer& preloaded, FileAudioBuffer& output, std::atomic<size_t>* filledFrames, Oversampling factor);
+/**
+ * @brief Same as the other overload, in a compact storage.
+ */
+void streamFromFile(AudioReader& reader, const CompactAudioBuffer& preloaded, CompactAudioBuffer& output, std::atomic<size_t>* filledFrames, SampleStorage storage);
+
 /**
  * @brief This is a singleton-designed class that holds all the preloaded data
  * as well as functions to request new file data and collect the file handles to
@@ -185,6 +264,11 @@ private:
  * promise, which should decrease the  reference count to 1. A garbage
  * collection thread then runs regularly to clear the memory of all file handles
  * with a reference count of 1.
+ *
+ * The dispatching and garbage collection threads, as well as the thread pool
+ * that loads the files, are shared by all the file pools in the process. Pools
+ * can also share their preloaded data with the other pools that opt in, so
+ * that several synths playing the same samples only load them once.
  */
 
 
@@ -194,7 +278,8 @@ public:
      * @brief Construct a new File Pool object.
      *
      * This creates the background threads based on config::numBackgroundThreads
-     * as well as the garbage collection thread.
+     * as well as the garbage collection thread, unless another pool already
+     * did.
      */
     FilePool();
 
@@ -231,6 +316,37 @@ public:
      */
     bool preloadFile(const FileId& fileId, uint32_t maxOffset) noexcept;
 
+    /**
+     * @brief Check many samples and read their information at once, on the
+     * loading threads. This is checkSampleId then getFileInformation for
+     * each file.
+     *
+     * @param fileIds the sample file identifiers; may be updated by the method
+     * @return the information of each file in the same order, or nothing if
+     *         it was not found or can't be read
+     */
+    std::vector<absl::optional<FileInformation>> probeFiles(std::vector<FileId>& fileIds) noexcept;
+
+    /**
+     * @brief Preload many files at once, on the loading threads. This is
+     * preloadFile for each file, with the information that probeFiles or
+     * getFileInformation returned for it.
+     *
+     * @param files the files with their information, whose maxOffset is the
+     *              maximum offset to consider for preloading
+     */
+    void preloadFiles(const absl::flat_hash_map<FileId, FileInformation>& files) noexcept;
+
+    /**
+     * @brief Run a job for each index on the loading threads, and wait for
+     * all of them. The jobs are queued with the file loads, so that work done
+     * while loading does not start more threads than the pool has.
+     *
+     * @param numJobs the number of jobs
+     * @param job the job, called with each index from 0 to numJobs - 1
+     */
+    void runOnLoadingThreads(size_t numJobs, const std::function<void(size_t)>& job) noexcept;
+
     /**
      * @brief Load a file and return its information. The file pool will store this
      * data for future requests so use this function responsibly.
@@ -285,12 +401,31 @@ public:
     void removeUnusedPreloadedData() noexcept;
 
     /**
-     * @brief Get a handle on a file, which triggers background loading
+     * @brief Get a handle on a file, which triggers background loading.
+     * The loads are served earliest deadline first, the deadline being when
+     * the voice plays past the preloaded frames; the load is dropped if the
+     * handles are all released before it starts.
      *
      * @param fileId the file to preload
+     * @param startTime when the voice starts playing the file
+     * @param startFrame the frame of the file the voice starts from
+     * @param speed the frames of the file played per frame of its sample rate
      * @return FileDataHolder a file data handle
      */
-    FileDataHolder getFilePromise(const std::shared_ptr<FileId>& fileId) noexcept;
+    FileDataHolder getFilePromise(const std::shared_ptr<FileId>& fileId, TimePoint startTime = highResNow(), int64_t startFrame = 0, float speed = 1.0f) noexcept;
+    /**
+     * @brief Load a whole file in the background ahead of the voices that
+     * will play it, and keep it in memory at least until the deadline.
+     * Prefetching a file again moves its deadline. This may be called from
+     * another thread than the audio thread, one at a time, but not while
+     * samples are being loaded or the pool is cleared.
+     *
+     * @param fileId the file to prefetch
+     * @param deadline
+     * @return true if the file is loaded or queued for loading
+     * @return false if the file is not preloaded or too many are prefetched
+     */
+    bool prefetch(const std::shared_ptr<FileId>& fileId, TimePoint deadline) noexcept;
     /**
      * @brief Change the preloading size. This will trigger a full
      * reload of all samples, so don't call it on the audio thread.
@@ -304,6 +439,21 @@ public:
      * @return uint32_t
      */
     uint32_t getPreloadSize() const noexcept;
+    /**
+     * @brief Change the oversampling factor of the preloaded and streamed
+     * samples. This will trigger a full reload of all samples, so don't call
+     * it on the audio thread or while files are loading in the background.
+     * Files loaded whole with loadFile() or loadFromRam() keep their rate.
+     *
+     * @param factor
+     */
+    void setOversamplingFactor(Oversampling factor) noexcept;
+    /**
+     * @brief Get the current oversampling factor.
+     *
+     * @return Oversampling
+     */
+    Oversampling getOversamplingFactor() const noexcept;
     /**
      * @brief Empty the file loading queues without actually loading
      * the files. All promises will be unfulfilled. Don't call this
@@ -332,56 +482,141 @@ public:
      * @param loadInRam
      */
     void setRamLoading(bool loadInRam) noexcept;
+    /**
+     * @brief Change whether uncompressed WAV and AIFF files are mapped in
+     * memory and played from there, instead of being preloaded and streamed.
+     * The preloaded part of a mapped file is read ahead; beyond it, the
+     * operating system loads the file as it plays. Reversed and oversampled
+     * samples are loaded as usual. This will trigger a purge and reloading.
+     *
+     * @param memoryMapping
+     */
+    void setMemoryMapping(bool memoryMapping) noexcept;
+    /**
+     * @brief Get whether uncompressed files are mapped in memory.
+     */
+    bool getMemoryMapping() const noexcept { return memoryMapping; }
+    /**
+     * @brief Change the format in which the samples of files are kept in
+     * memory, both preloaded and streamed. The 16-bit storages halve the
+     * memory of the samples, so that more of them can be preloaded.
+     * Oversampled samples are kept as floats. This will trigger a purge and
+     * reloading.
+     *
+     * @param storage
+     */
+    void setSampleStorage(SampleStorage storage) noexcept;
+    /**
+     * @brief Get the format in which the samples of files are kept.
+     */
+    SampleStorage getSampleStorage() const noexcept { return sampleStorage; }
+    /**
+     * @brief Share the preloaded data with the other file pools that have
+     * this turned on. A file is shared when the pools load it from the same
+     * path, in the same direction and at the same oversampling factor. This
+     * applies to the files preloaded from then on.
+     *
+     * @param shared
+     */
+    void setSharedCache(bool shared) noexcept { sharedCache = shared; }
+    /**
+     * @brief Get whether the preloaded data is shared with other pools.
+     *
+     * @return bool
+     */
+    bool isSharedCache() const noexcept { return sharedCache; }
+    /**
+     * @brief Get the memory used by the preloaded and streamed data that is
+     * shared between the pools, in bytes. Don't call this on the audio thread.
+     *
+     * @return size_t
+     */
+    static size_t getSharedCacheMemory() noexcept;
     /**
      * @brief Prepares unused data to be freed on a background thread.
      * This should be called regularly by the Synth, otherwise memory
      * risk building up.
      */
     void triggerGarbageCollection() noexcept;
+    /**
+     * @brief Count a voice which played past the streamed frames of its file
+     * before they were loaded. This may be called on the audio thread.
+     */
+    void countStreamUnderrun() noexcept { streamUnderruns.fetch_add(1, std::memory_order_relaxed); }
+    /**
+     * @brief Get the number of stream underruns since the pool was created.
+     */
+    size_t getStreamUnderruns() const noexcept { return streamUnderruns.load(std::memory_order_relaxed); }
 private:
 
+    friend class FilePoolThreads;
+
     absl::optional<sfz::FileInformation> checkExistingFileInformation(const FileId& fileId) noexcept;
+    /**
+     * @brief Read the preloaded data of a file as the current settings ask
+     * for, or take it from another pool if the cache is shared.
+     */
+    std::shared_ptr<FileData> loadPreloadedData(const FileId& fileId, const FileInformation& information) noexcept;
+    void reloadPreloadedFiles() noexcept;
     fs::path rootDirectory;
 
     bool loadInRam { config::loadInRam };
     uint32_t preloadSize { config::preloadSize };
-
-    // Signals
-    volatile bool dispatchFlag { true };
-    volatile bool garbageFlag { true };
-    RTSemaphore dispatchBarrier;
-    RTSemaphore semGarbageBarrier;
+    Oversampling oversamplingFactor { Oversampling::x1 };
+    bool sharedCache { false };
+    bool memoryMapping { false };
+    SampleStorage sampleStorage { SampleStorage::Float32 };
 
     // Structures for the background loaders
     struct QueuedFileData
     {
         QueuedFileData() noexcept {}
-        QueuedFileData(std::weak_ptr<FileId> id, FileData* data) noexcept
-        : id(id), data(data) {}
+        QueuedFileData(std::weak_ptr<FileId> id, FileData* data, TimePoint deadline) noexcept
+        : id(id), data(data), deadline(deadline) {}
         std::weak_ptr<FileId> id;
         FileData* data { nullptr };
+        TimePoint deadline {};
     };
 
     using FileQueue = atomic_queue::AtomicQueue2<QueuedFileData, config::maxVoices>;
     aligned_unique_ptr<FileQueue> filesToLoad;
 
-    void dispatchingJob() noexcept;
-    void garbageJob() noexcept;
+    // Called on the shared background threads
+    void collectGarbage() noexcept;
     void loadingJob(const QueuedFileData& data) noexcept;
-    std::mutex loadingJobsMutex;
-    std::vector<std::future<void>> loadingJobs;
-    std::thread dispatchThread { &FilePool::dispatchingJob, this };
-    std::thread garbageThread { &FilePool::garbageJob, this };
+    // The loads queued or running for this pool
+    std::atomic<int> numLoads { 0 };
+    std::atomic<size_t> streamUnderruns { 0 };
 
     SpinMutex garbageAndLastUsedMutex;
     std::vector<FileId> lastUsedFiles;
     std::vector<FileAudioBuffer> garbageToCollect;
+    std::vector<CompactAudioBuffer> compactGarbageToCollect;
 
     std::shared_ptr<ThreadPool> threadPool;
+    std::shared_ptr<FilePoolThreads> backgroundThreads;
 
-    // Preloaded data
-    absl::flat_hash_map<FileId, FileData> preloadedFiles;
+    // Preloaded data. The data may be shared with other pools, so it is
+    // replaced rather than changed when the settings change.
+    struct PreloadedFile
+    {
+        std::shared_ptr<FileData> data;
+        int preloadCallCount;
+    };
+    absl::flat_hash_map<FileId, PreloadedFile> preloadedFiles;
     absl::flat_hash_map<FileId, FileData> loadedFiles;
+
+    // Handles held on prefetched files until their deadline. Declared after
+    // the files so that they are released first.
+    struct PrefetchedFile
+    {
+        FileId id;
+        FileDataHolder data;
+        TimePoint deadline;
+    };
+    SpinMutex prefetchMutex;
+    std::vector<PrefetchedFile> prefetchedFiles;
+    void releasePrefetchedFiles() noexcept;
     LEAK_DETECTOR(FilePool);
 };
 }
@@ -0,0 +1,584 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "FilterBatch.h"
+#include "FilterBatchKernels.hpp"
+#include "Buffer.h"
+#include "Config.h"
+#include "utility/Debug.h"
+#include "cpuid/cpuinfo.hpp"
+#include <simde/x86/sse.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+namespace sfz {
+
+namespace batch {
+
+struct SSEVector {
+    using Vec = simde__m128;
+    static constexpr unsigned width = 4;
+    static Vec load(const float* p) { return simde_mm_load_ps(p); }
+    static void store(float* p, Vec x) { simde_mm_store_ps(p, x); }
+    static Vec set1(float x) { return simde_mm_set1_ps(x); }
+    static Vec add(Vec a, Vec b) { return simde_mm_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b) { return simde_mm_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return simde_mm_mul_ps(a, b); }
+    static Vec div(Vec a, Vec b) { return simde_mm_div_ps(a, b); }
+};
+
+void processBiquadSSE(float* pack, float* frames, unsigned numFrames, unsigned numStages, float smooth)
+{
+    Kernels<SSEVector>::processBiquad(pack, frames, numFrames, numStages, smooth);
+}
+
+void processSvfSSE(float* pack, float* frames, unsigned numFrames, SvfOutput output, float smooth)
+{
+    Kernels<SSEVector>::processSvf(pack, frames, numFrames, output, smooth);
+}
+
+/**
+   Gather `numFrames` of the `width` channels of `in` into the lanes of
+   `frames`, by 4x4 transposes. `deinterleave` scatters them back.
+ */
+void interleave(const float* const in[], float* frames, unsigned width, unsigned numFrames)
+{
+    for (unsigned l = 0; l < width; l += 4) {
+        unsigned i = 0;
+        for (; i + 4 <= numFrames; i += 4) {
+            simde__m128 r0 = simde_mm_loadu_ps(in[l] + i);
+            simde__m128 r1 = simde_mm_loadu_ps(in[l + 1] + i);
+            simde__m128 r2 = simde_mm_loadu_ps(in[l + 2] + i);
+            simde__m128 r3 = simde_mm_loadu_ps(in[l + 3] + i);
+            SIMDE_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            simde_mm_store_ps(frames + i * width + l, r0);
+            simde_mm_store_ps(frames + (i + 1) * width + l, r1);
+            simde_mm_store_ps(frames + (i + 2) * width + l, r2);
+            simde_mm_store_ps(frames + (i + 3) * width + l, r3);
+        }
+        for (; i < numFrames; ++i) {
+            for (unsigned k = 0; k < 4; ++k)
+                frames[i * width + l + k] = in[l + k][i];
+        }
+    }
+}
+
+void deinterleave(const float* frames, float* const out[], unsigned width, unsigned numFrames)
+{
+    for (unsigned l = 0; l < width; l += 4) {
+        unsigned i = 0;
+        for (; i + 4 <= numFrames; i += 4) {
+            simde__m128 r0 = simde_mm_load_ps(frames + i * width + l);
+            simde__m128 r1 = simde_mm_load_ps(frames + (i + 1) * width + l);
+            simde__m128 r2 = simde_mm_load_ps(frames + (i + 2) * width + l);
+            simde__m128 r3 = simde_mm_load_ps(frames + (i + 3) * width + l);
+            SIMDE_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            simde_mm_storeu_ps(out[l] + i, r0);
+            simde_mm_storeu_ps(out[l + 1] + i, r1);
+            simde_mm_storeu_ps(out[l + 2] + i, r2);
+            simde_mm_storeu_ps(out[l + 3] + i, r3);
+        }
+        for (; i < numFrames; ++i) {
+            for (unsigned k = 0; k < 4; ++k)
+                out[l + k][i] = frames[i * width + l + k];
+        }
+    }
+}
+
+} // namespace batch
+
+//------------------------------------------------------------------------------
+
+namespace {
+
+enum class Kind { None, Biquad, Svf };
+
+struct TypeInfo {
+    Kind kind = Kind::None;
+    unsigned numStages = 0;
+    batch::SvfOutput svfOutput = batch::SvfOutput::Lowpass;
+};
+
+TypeInfo typeInfo(FilterType type) noexcept
+{
+    switch (type) {
+    case kFilterLpf2p: case kFilterHpf2p: case kFilterBpf2p:
+    case kFilterBrf2p: case kFilterPeq: case kFilterLsh: case kFilterHsh:
+        return { Kind::Biquad, 1 };
+    case kFilterLpf4p: case kFilterHpf4p: case kFilterBpf4p:
+        return { Kind::Biquad, 2 };
+    case kFilterLpf6p: case kFilterHpf6p: case kFilterBpf6p:
+        return { Kind::Biquad, 3 };
+    case kFilterLpf2pSv:
+        return { Kind::Svf, 0, batch::SvfOutput::Lowpass };
+    case kFilterHpf2pSv:
+        return { Kind::Svf, 0, batch::SvfOutput::Highpass };
+    case kFilterBpf2pSv:
+        return { Kind::Svf, 0, batch::SvfOutput::Bandpass };
+    case kFilterBrf2pSv:
+        return { Kind::Svf, 0, batch::SvfOutput::Bandstop };
+    default:
+        return {};
+    }
+}
+
+/**
+   Compute the coefficients the faust filters of gen/filters would target,
+   in the same order of operations: b0, b1, b2, a1, a2 for the biquads,
+   or g and k for the state variable filters.
+ */
+void computeCoefficients(FilterType type, double sampleRate, float cutoff, float q, float pksh, double c[5]) noexcept
+{
+    const double qLinear = std::pow(10.0, 0.05 * std::min(60.0, std::max(-60.0, double(q))));
+
+    if (typeInfo(type).kind == Kind::Svf) {
+        c[0] = std::tan((M_PI / sampleRate) * std::min(20000.0, std::max(1.0, double(cutoff))));
+        c[1] = 1.0 / qLinear;
+        return;
+    }
+
+    const double w = (2 * M_PI / sampleRate) * std::max(0.0, std::min(20000.0, std::max(1.0, double(cutoff))));
+    const double cosw = std::cos(w);
+    const double sinw = std::sin(w);
+    const double qClamped = std::max(0.001, qLinear);
+    const double gain = std::pow(10.0, 0.025 * std::min(60.0, std::max(-120.0, double(pksh))));
+    double& b0 = c[0];
+    double& b1 = c[1];
+    double& b2 = c[2];
+    double& a1 = c[3];
+    double& a2 = c[4];
+
+    switch (type) {
+    case kFilterLpf2p: case kFilterLpf4p: case kFilterLpf6p: {
+        const double alpha = 0.5 * (sinw / qClamped);
+        const double a0 = alpha + 1.0;
+        b1 = (1.0 - cosw) / a0;
+        b0 = b2 = 0.5 * b1;
+        a1 = -(2.0 * cosw) / a0;
+        a2 = (1.0 - alpha) / a0;
+        break;
+    }
+    case kFilterHpf2p: case kFilterHpf4p: case kFilterHpf6p: {
+        const double alpha = 0.5 * (sinw / qClamped);
+        const double a0 = alpha + 1.0;
+        b1 = (-1.0 - cosw) / a0;
+        b0 = b2 = 0.5 * ((cosw + 1.0) / a0);
+        a1 = -(2.0 * cosw) / a0;
+        a2 = (1.0 - alpha) / a0;
+        break;
+    }
+    case kFilterBpf2p: case kFilterBpf4p: case kFilterBpf6p: {
+        const double alpha = 0.5 * (sinw / qClamped);
+        const double a0 = alpha + 1.0;
+        b0 = 0.5 * (sinw / (qClamped * a0));
+        b1 = 0.0;
+        b2 = -b0;
+        a1 = -(2.0 * cosw) / a0;
+        a2 = (1.0 - alpha) / a0;
+        break;
+    }
+    case kFilterBrf2p: {
+        const double alpha = 0.5 * (sinw / qClamped);
+        const double a0 = alpha + 1.0;
+        b0 = b2 = 1.0 / a0;
+        b1 = a1 = -(2.0 * cosw) / a0;
+        a2 = (1.0 - alpha) / a0;
+        break;
+    }
+    case kFilterPeq: {
+        const double alpha = 0.5 * (sinw / (qClamped * gain));
+        const double a0 = alpha + 1.0;
+        const double alphaGain = 0.5 * ((gain * sinw) / qClamped);
+        b0 = (alphaGain + 1.0) / a0;
+        b1 = a1 = -(2.0 * cosw) / a0;
+        b2 = (1.0 - alphaGain) / a0;
+        a2 = (1.0 - alpha) / a0;
+        break;
+    }
+    case kFilterLsh: {
+        const double plusCos = (gain + 1.0) * cosw;
+        const double minusCos = (gain + -1.0) * cosw;
+        const double beta = (std::sqrt(gain) * sinw) / qClamped;
+        const double a0 = (gain + (minusCos + beta)) + 1.0;
+        b0 = (gain * ((gain + beta) + (1.0 - minusCos))) / a0;
+        b1 = 2.0 * ((gain * (gain + (-1.0 - plusCos))) / a0);
+        b2 = (gain * (gain + (1.0 - (minusCos + beta)))) / a0;
+        a1 = -(2.0 * ((gain + plusCos) + -1.0)) / a0;
+        a2 = ((gain + minusCos) + (1.0 - beta)) / a0;
+        break;
+    }
+    case kFilterHsh: {
+        const double plusCos = (gain + 1.0) * cosw;
+        const double beta = (std::sqrt(gain) * sinw) / qClamped;
+        const double minusCos = (gain + -1.0) * cosw;
+        const double a0 = (gain + beta) + (1.0 - minusCos);
+        b0 = (gain * ((gain + (minusCos + beta)) + 1.0)) / a0;
+        b1 = ((-(2.0 * gain)) * ((gain + plusCos) + -1.0)) / a0;
+        b2 = (gain * ((gain + minusCos) + (1.0 - beta))) / a0;
+        a1 = 2.0 * ((gain + (-1.0 - plusCos)) / a0);
+        a2 = (gain + (1.0 - (minusCos + beta))) / a0;
+        break;
+    }
+    default:
+        ASSERTFALSE;
+        break;
+    }
+}
+
+constexpr int kNumFilterTypes = kFilterPeq + 1;
+
+} // namespace
+
+struct FilterBatch::Impl {
+    double sampleRate = config::defaultSampleRate;
+    float smooth = 0.0f;
+    unsigned width = batch::SSEVector::width;
+    batch::BiquadProcess processBiquad = batch::processBiquadSSE;
+    batch::SvfProcess processSvf = batch::processSvfSSE;
+
+    struct Slot {
+        bool used = false;
+        bool prepared = false;
+        FilterType type = kFilterNone;
+        unsigned channels = 0;
+        unsigned lanes[2] {};
+        const float* in[2] {};
+        float* out[2] {};
+        float parameters[3] {};
+        const float* modulation[3] {};
+        float lastParameters[3] {};
+    };
+
+    struct Lane {
+        int filter;
+        unsigned channel;
+    };
+
+    struct Group {
+        std::vector<Lane> lanes;
+        unsigned reserved = 0;
+        Buffer<float, 32> packs;
+    };
+
+    std::vector<Slot> slots;
+    std::array<Group, kNumFilterTypes> groups;
+
+    float* laneVar(Group& group, unsigned lane, unsigned var)
+    {
+        const unsigned pack = lane / width;
+        return group.packs.data() + (pack * batch::kPackSize + var) * width + lane % width;
+    }
+
+    void reservePacks(Group& group, unsigned numLanes)
+    {
+        const unsigned numPacks = (numLanes + width - 1) / width;
+        const size_t size = size_t(numPacks) * batch::kPackSize * width;
+        if (group.packs.size() < size)
+            group.packs.resize(size);
+    }
+
+    void clearLane(Group& group, unsigned lane)
+    {
+        for (unsigned var = 0; var < batch::kPackSize; ++var)
+            *laneVar(group, lane, var) = 0.0f;
+    }
+
+    void removeLane(Group& group, unsigned lane)
+    {
+        const unsigned last = static_cast<unsigned>(group.lanes.size() - 1);
+        if (lane != last) {
+            for (unsigned var = 0; var < batch::kPackSize; ++var)
+                *laneVar(group, lane, var) = *laneVar(group, last, var);
+            const Lane moved = group.lanes[last];
+            group.lanes[lane] = moved;
+            slots[moved.filter].lanes[moved.channel] = lane;
+        }
+        clearLane(group, last);
+        group.lanes.pop_back();
+    }
+
+    void updateCoefficients(Slot& slot, unsigned frame)
+    {
+        const bool modulated = slot.modulation[0] || slot.modulation[1] || slot.modulation[2];
+        if (frame > 0 && !modulated)
+            return;
+
+        float parameters[3];
+        const unsigned interval = frame / config::filterControlInterval;
+        for (unsigned i = 0; i < 3; ++i)
+            parameters[i] = slot.modulation[i] ? slot.modulation[i][interval] : slot.parameters[i];
+
+        if (slot.prepared && std::equal(parameters, parameters + 3, slot.lastParameters))
+            return;
+
+        std::copy(parameters, parameters + 3, slot.lastParameters);
+
+        double c[5];
+        computeCoefficients(slot.type, sampleRate, parameters[0], parameters[1], parameters[2], c);
+
+        const double unsmooth = 1.0 - smooth;
+        Group& group = groups[slot.type];
+        for (unsigned ch = 0; ch < slot.channels; ++ch) {
+            const unsigned lane = slot.lanes[ch];
+
+            if (typeInfo(slot.type).kind == Kind::Svf) {
+                const double g = c[0];
+                const double k = c[1];
+                *laneVar(group, lane, batch::kTargetG) = float(g * unsmooth);
+                *laneVar(group, lane, batch::kK) = float(k);
+                if (!slot.prepared) {
+                    *laneVar(group, lane, batch::kG) = float(g);
+                    *laneVar(group, lane, batch::kH) = float(1.0 / (g * (k + g) + 1.0));
+                    *laneVar(group, lane, batch::kR) = float(k + g);
+                }
+                continue;
+            }
+
+            for (unsigned i = 0; i < 5; ++i) {
+                *laneVar(group, lane, batch::kTargetB0 + i) = float(c[i] * unsmooth);
+                if (!slot.prepared)
+                    *laneVar(group, lane, batch::kB0 + i) = float(c[i]);
+            }
+        }
+
+        slot.prepared = true;
+    }
+};
+
+FilterBatch::FilterBatch(unsigned maxLaneWidth)
+    : P { new Impl }
+{
+    Impl& impl = *P;
+
+#if SFIZZ_CPU_FAMILY_X86_64 || SFIZZ_CPU_FAMILY_I386
+    cpuid::cpuinfo cpuInfo;
+    if (maxLaneWidth >= 8 && cpuInfo.has_avx()) {
+        impl.width = 8;
+        impl.processBiquad = batch::processBiquadAVX;
+        impl.processSvf = batch::processSvfAVX;
+    }
+#else
+    (void)maxLaneWidth;
+#endif
+
+    init(config::defaultSampleRate);
+}
+
+FilterBatch::~FilterBatch()
+{
+}
+
+bool FilterBatch::supportsType(FilterType type) noexcept
+{
+    return typeInfo(type).kind != Kind::None;
+}
+
+unsigned FilterBatch::laneWidth() const noexcept
+{
+    return P->width;
+}
+
+void FilterBatch::init(double sampleRate)
+{
+    Impl& impl = *P;
+
+    // like the faust filters, which take an integer rate
+    impl.sampleRate = double(int(sampleRate));
+    impl.smooth = float(std::exp(-1000.0 / impl.sampleRate));
+
+    for (int id = 0, n = static_cast<int>(impl.slots.size()); id < n; ++id) {
+        if (impl.slots[id].used)
+            clear(id);
+    }
+}
+
+void FilterBatch::reserve(FilterType type, unsigned numChannels)
+{
+    Impl& impl = *P;
+
+    if (!supportsType(type))
+        return;
+
+    Impl::Group& group = impl.groups[type];
+    if (numChannels <= group.reserved)
+        return;
+
+    group.reserved = numChannels;
+    group.lanes.reserve(numChannels);
+    impl.reservePacks(group, numChannels);
+
+    // A filter takes at least one lane, so there are no more filters than
+    // reserved lanes
+    unsigned numSlots = 0;
+    for (const Impl::Group& other : impl.groups)
+        numSlots += other.reserved;
+    impl.slots.reserve(numSlots);
+}
+
+int FilterBatch::addFilter(FilterType type, unsigned channels)
+{
+    Impl& impl = *P;
+    ASSERT(channels == 1 || channels == 2);
+
+    if (!supportsType(type))
+        return -1;
+
+    Impl::Group& group = impl.groups[type];
+    if (group.lanes.size() + channels > group.reserved)
+        return -1;
+
+    auto it = std::find_if(impl.slots.begin(), impl.slots.end(),
+        [](const Impl::Slot& slot) { return !slot.used; });
+    if (it == impl.slots.end())
+        it = impl.slots.emplace(impl.slots.end());
+
+    const int id = static_cast<int>(it - impl.slots.begin());
+    Impl::Slot& slot = *it;
+    slot = Impl::Slot {};
+    slot.used = true;
+    slot.type = type;
+    slot.channels = channels;
+
+    for (unsigned ch = 0; ch < channels; ++ch) {
+        const unsigned lane = static_cast<unsigned>(group.lanes.size());
+        group.lanes.push_back({ id, ch });
+        slot.lanes[ch] = lane;
+    }
+
+    return id;
+}
+
+void FilterBatch::removeFilter(int id)
+{
+    Impl& impl = *P;
+    ASSERT(id >= 0 && id < static_cast<int>(impl.slots.size()) && impl.slots[id].used);
+
+    Impl::Slot& slot = impl.slots[id];
+    Impl::Group& group = impl.groups[slot.type];
+
+    // Take out the highest lane first, so the other one does not move
+    if (slot.channels == 2 && slot.lanes[1] > slot.lanes[0]) {
+        impl.removeLane(group, slot.lanes[1]);
+        impl.removeLane(group, slot.lanes[0]);
+    } else {
+        for (unsigned ch = 0; ch < slot.channels; ++ch)
+            impl.removeLane(group, slot.lanes[ch]);
+    }
+
+    slot = Impl::Slot {};
+}
+
+void FilterBatch::clear(int id)
+{
+    Impl& impl = *P;
+    ASSERT(id >= 0 && id < static_cast<int>(impl.slots.size()) && impl.slots[id].used);
+
+    Impl::Slot& slot = impl.slots[id];
+    Impl::Group& group = impl.groups[slot.type];
+    for (unsigned ch = 0; ch < slot.channels; ++ch)
+        impl.clearLane(group, slot.lanes[ch]);
+
+    slot.prepared = false;
+}
+
+void FilterBatch::setBuffers(int id, const float* const in[], float* const out[])
+{
+    Impl::Slot& slot = P->slots[id];
+    for (unsigned ch = 0; ch < slot.channels; ++ch) {
+        slot.in[ch] = in[ch];
+        slot.out[ch] = out[ch];
+    }
+}
+
+void FilterBatch::setParameters(int id, float cutoff, float q, float pksh)
+{
+    Impl::Slot& slot = P->slots[id];
+    slot.parameters[0] = cutoff;
+    slot.parameters[1] = q;
+    slot.parameters[2] = pksh;
+    std::fill(slot.modulation, slot.modulation + 3, nullptr);
+}
+
+void FilterBatch::setModulatedParameters(int id, const float* cutoff, const float* q, const float* pksh)
+{
+    Impl::Slot& slot = P->slots[id];
+    slot.modulation[0] = cutoff;
+    slot.modulation[1] = q;
+    slot.modulation[2] = pksh;
+}
+
+void FilterBatch::process(unsigned nframes)
+{
+    Impl& impl = *P;
+    const unsigned width = impl.width;
+    constexpr unsigned interval = config::filterControlInterval;
+    alignas(32) float frames[interval * 8];
+    // Stand-ins for the missing buffers, so that every lane moves by vectors
+    alignas(16) float silence[interval] {};
+    alignas(16) float discard[interval];
+
+    for (int type = 0; type < kNumFilterTypes; ++type) {
+        Impl::Group& group = impl.groups[type];
+        const unsigned numLanes = static_cast<unsigned>(group.lanes.size());
+        if (numLanes == 0)
+            continue;
+
+        const TypeInfo info = typeInfo(static_cast<FilterType>(type));
+        const unsigned numPacks = (numLanes + width - 1) / width;
+
+        for (unsigned frame = 0; frame < nframes; frame += interval) {
+            const unsigned current = std::min(interval, nframes - frame);
+
+            for (const Impl::Lane& lane : group.lanes) {
+                if (lane.channel == 0)
+                    impl.updateCoefficients(impl.slots[lane.filter], frame);
+            }
+
+            for (unsigned p = 0; p < numPacks; ++p) {
+                const float* in[8];
+                float* out[8];
+                for (unsigned l = 0; l < width; ++l) {
+                    const unsigned index = p * width + l;
+                    in[l] = silence;
+                    out[l] = discard;
+                    if (index < numLanes) {
+                        const Impl::Lane& lane = group.lanes[index];
+                        const Impl::Slot& slot = impl.slots[lane.filter];
+                        if (slot.in[lane.channel])
+                            in[l] = slot.in[lane.channel] + frame;
+                        if (slot.out[lane.channel])
+                            out[l] = slot.out[lane.channel] + frame;
+                    }
+                }
+
+                batch::interleave(in, frames, width, current);
+
+                float* pack = group.packs.data() + p * batch::kPackSize * width;
+                if (info.kind == Kind::Svf)
+                    impl.processSvf(pack, frames, current, info.svfOutput, impl.smooth);
+                else
+                    impl.processBiquad(pack, frames, current, info.numStages, impl.smooth);
+
+                batch::deinterleave(frames, out, width, current);
+            }
+        }
+    }
+
+    for (Impl::Slot& slot : impl.slots) {
+        std::fill(slot.in, slot.in + 2, nullptr);
+        std::fill(slot.out, slot.out + 2, nullptr);
+    }
+}
+
+unsigned FilterBatch::numFilters() const noexcept
+{
+    return static_cast<unsigned>(std::count_if(P->slots.begin(), P->slots.end(),
+        [](const Impl::Slot& slot) { return slot.used; }));
+}
+
+} // namespace sfz
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "SfzFilter.h"
+#include <memory>
+
+namespace sfz {
+
+/**
+   Filters of many voices, processed together in SIMD lanes.
+
+   The filters are grouped by type, and each channel of a filter takes a lane
+   in its group. The lanes are packed by 4 (SSE, or NEON through SIMDe) or by
+   8 (AVX, when the CPU has it), so one recursive step computes 4 or 8 voice
+   channels at once.
+
+   Supported are the biquads, alone or cascaded (lpf/hpf/bpf 2p, 4p and 6p,
+   brf_2p, peq, lsh, hsh), and the state variable filters (lpf/hpf/bpf/brf
+   2p_sv). Check `supportsType` before adding a filter; other types need
+   the per-voice `Filter`.
+
+   The coefficients are computed at the start of every
+   `config::filterControlInterval` frames when the parameters changed, and
+   smoothed per frame the same way `Filter` does. The output matches that of
+   a `Filter` with the same parameters within single-precision rounding.
+
+   Every filter of the batch is processed on each `process` call, so its
+   buffers and parameters must be set before. A filter without buffers for
+   the cycle is run on silence.
+ */
+class FilterBatch {
+public:
+    /**
+       Create an empty batch. The lanes are as wide as the CPU allows,
+       up to `maxLaneWidth`; give 4 to keep to the SSE or NEON kernels.
+     */
+    explicit FilterBatch(unsigned maxLaneWidth = 8);
+    ~FilterBatch();
+
+    /**
+       Whether filters of this type can be batched.
+     */
+    static bool supportsType(FilterType type) noexcept;
+
+    /**
+       Number of filter channels in a lane set: 4 or 8.
+     */
+    unsigned laneWidth() const noexcept;
+
+    /**
+       Set up the filter constants. Existing filters are cleared.
+     */
+    void init(double sampleRate);
+
+    /**
+       Allocate the lanes of this many filter channels of a supported type.
+       The reserve of a type only grows.
+     */
+    void reserve(FilterType type, unsigned numChannels);
+
+    /**
+       Add a filter of a supported type, with 1 or 2 channels, in the lanes
+       reserved for its type. This does not allocate.
+       Returns its id, or -1 if the type is not supported or its reserved
+       lanes are taken. The filter starts cleared.
+     */
+    int addFilter(FilterType type, unsigned channels);
+
+    /**
+       Remove a filter. Its id may be given again by `addFilter`.
+     */
+    void removeFilter(int id);
+
+    /**
+       Reinitialize the filter memory to zeros. On the next `process` call,
+       the coefficients are set to the first parameters without smoothing,
+       as `Filter::prepare` does.
+     */
+    void clear(int id);
+
+    /**
+       Set the buffers of a filter for the next `process` call.
+       `in[i]` and `out[i]` may refer to identical buffers.
+     */
+    void setBuffers(int id, const float* const in[], float* const out[]);
+
+    /**
+       Set the parameters of a filter for the next `process` call, constant
+       over the cycle. The units are those of `Filter::process`.
+     */
+    void setParameters(int id, float cutoff, float q, float pksh);
+
+    /**
+       Set the parameters of a filter for the next `process` call, varying
+       over the cycle. The arrays hold one value per
+       `config::filterControlInterval` frames of the cycle, which is where
+       `Filter::processModulated` reads its parameters.
+     */
+    void setModulatedParameters(int id, const float* cutoff, const float* q, const float* pksh);
+
+    /**
+       Process one cycle of all the filters, and forget their buffers.
+     */
+    void process(unsigned nframes);
+
+    /**
+       Number of filters in the batch.
+     */
+    unsigned numFilters() const noexcept;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> P;
+};
+
+} // namespace sfz
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "FilterBatchKernels.hpp"
+
+#if SFIZZ_CPU_FAMILY_X86_64 || SFIZZ_CPU_FAMILY_I386
+#include "immintrin.h"
+
+namespace sfz {
+namespace batch {
+
+struct AVXVector {
+    using Vec = __m256;
+    static constexpr unsigned width = 8;
+    static Vec load(const float* p) { return _mm256_load_ps(p); }
+    static void store(float* p, Vec x) { _mm256_store_ps(p, x); }
+    static Vec set1(float x) { return _mm256_set1_ps(x); }
+    static Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+    static Vec div(Vec a, Vec b) { return _mm256_div_ps(a, b); }
+};
+
+void processBiquadAVX(float* pack, float* frames, unsigned numFrames, unsigned numStages, float smooth)
+{
+    Kernels<AVXVector>::processBiquad(pack, frames, numFrames, numStages, smooth);
+}
+
+void processSvfAVX(float* pack, float* frames, unsigned numFrames, SvfOutput output, float smooth)
+{
+    Kernels<AVXVector>::processSvf(pack, frames, numFrames, output, smooth);
+}
+
+} // namespace batch
+} // namespace sfz
+#endif
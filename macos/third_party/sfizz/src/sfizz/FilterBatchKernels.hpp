@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "SIMDConfig.h"
+
+namespace sfz {
+namespace batch {
+
+/**
+   Layout of a lane set: each variable is a vector of lane width floats.
+
+   The biquads follow the form of the faust code in gen/filters, with each
+   coefficient smoothed as `c = smooth * c + target`, where the target is
+   premultiplied by `1 - smooth`:
+     y[n] = b0[n] x[n] + b1[n-1] x[n-1] + b2[n-2] x[n-2] - a1[n] y[n-1] - a2[n-1] y[n-2]
+   The 4 and 6 pole filters cascade the same biquad.
+
+   The state variable filters smooth `g`, then `h` and `r` from the smoothed `g`.
+ */
+// biquad coefficients, and their targets
+constexpr unsigned kB0 = 0, kB1 = 1, kB2 = 2, kA1 = 3, kA2 = 4;
+constexpr unsigned kTargetB0 = 5, kTargetB1 = 6, kTargetB2 = 7, kTargetA1 = 8, kTargetA2 = 9;
+// biquad memory, for each stage from kStageMemory
+constexpr unsigned kStageMemory = 10, kStageSize = 4, kMaxStages = 3;
+constexpr unsigned kV0 = 0, kV1 = 1, kV2 = 2, kY1 = 3;
+// state variable coefficients, targets and memory
+constexpr unsigned kG = 0, kH = 1, kR = 2, kTargetG = 3, kK = 4, kS1 = 5, kS2 = 6;
+
+constexpr unsigned kPackSize = kStageMemory + kStageSize * kMaxStages;
+
+enum class SvfOutput { Lowpass, Highpass, Bandpass, Bandstop };
+
+/**
+   Process the lane set in `pack` over the lane-interleaved `frames`, in place.
+ */
+using BiquadProcess = void (*)(float* pack, float* frames, unsigned numFrames, unsigned numStages, float smooth);
+using SvfProcess = void (*)(float* pack, float* frames, unsigned numFrames, SvfOutput output, float smooth);
+
+void processBiquadSSE(float* pack, float* frames, unsigned numFrames, unsigned numStages, float smooth);
+void processSvfSSE(float* pack, float* frames, unsigned numFrames, SvfOutput output, float smooth);
+#if SFIZZ_CPU_FAMILY_X86_64 || SFIZZ_CPU_FAMILY_I386
+void processBiquadAVX(float* pack, float* frames, unsigned numFrames, unsigned numStages, float smooth);
+void processSvfAVX(float* pack, float* frames, unsigned numFrames, SvfOutput output, float smooth);
+#endif
+
+/**
+   The kernels, for a vector type `V` which provides `width`, `Vec`, and
+   `load`, `store`, `set1`, `add`, `sub`, `mul` and `div`.
+ */
+template <class V>
+struct Kernels {
+    using Vec = typename V::Vec;
+
+    static Vec at(const float* pack, unsigned var)
+    {
+        return V::load(pack + var * V::width);
+    }
+
+    static void put(float* pack, unsigned var, Vec value)
+    {
+        V::store(pack + var * V::width, value);
+    }
+
+    template <unsigned NumStages>
+    static void biquad(float* pack, float* frames, unsigned numFrames, float smoothValue)
+    {
+        const Vec smooth = V::set1(smoothValue);
+        const Vec tb0 = at(pack, kTargetB0), tb1 = at(pack, kTargetB1), tb2 = at(pack, kTargetB2);
+        const Vec ta1 = at(pack, kTargetA1), ta2 = at(pack, kTargetA2);
+        Vec b0 = at(pack, kB0), b1 = at(pack, kB1), b2 = at(pack, kB2);
+        Vec a1 = at(pack, kA1), a2 = at(pack, kA2);
+
+        Vec v0[NumStages], v1[NumStages], v2[NumStages], y1[NumStages];
+        for (unsigned s = 0; s < NumStages; ++s) {
+            const unsigned base = kStageMemory + s * kStageSize;
+            v0[s] = at(pack, base + kV0);
+            v1[s] = at(pack, base + kV1);
+            v2[s] = at(pack, base + kV2);
+            y1[s] = at(pack, base + kY1);
+        }
+
+        for (unsigned i = 0; i < numFrames; ++i) {
+            b0 = V::add(V::mul(smooth, b0), tb0);
+            b1 = V::add(V::mul(smooth, b1), tb1);
+            b2 = V::add(V::mul(smooth, b2), tb2);
+            a1 = V::add(V::mul(smooth, a1), ta1);
+            a2 = V::add(V::mul(smooth, a2), ta2);
+
+            Vec x = V::load(frames + i * V::width);
+            for (unsigned s = 0; s < NumStages; ++s) {
+                const Vec nextV2 = V::sub(v1[s], V::mul(a2, y1[s]));
+                const Vec y = V::sub(
+                    V::add(V::add(v0[s], V::mul(b0, x)), v2[s]),
+                    V::mul(a1, y1[s]));
+                v0[s] = V::mul(b1, x);
+                v1[s] = V::mul(b2, x);
+                v2[s] = nextV2;
+                y1[s] = y;
+                x = y;
+            }
+            V::store(frames + i * V::width, x);
+        }
+
+        put(pack, kB0, b0);
+        put(pack, kB1, b1);
+        put(pack, kB2, b2);
+        put(pack, kA1, a1);
+        put(pack, kA2, a2);
+        for (unsigned s = 0; s < NumStages; ++s) {
+            const unsigned base = kStageMemory + s * kStageSize;
+            put(pack, base + kV0, v0[s]);
+            put(pack, base + kV1, v1[s]);
+            put(pack, base + kV2, v2[s]);
+            put(pack, base + kY1, y1[s]);
+        }
+    }
+
+    static void processBiquad(float* pack, float* frames, unsigned numFrames, unsigned numStages, float smooth)
+    {
+        switch (numStages) {
+        case 1: biquad<1>(pack, frames, numFrames, smooth); break;
+        case 2: biquad<2>(pack, frames, numFrames, smooth); break;
+        case 3: biquad<3>(pack, frames, numFrames, smooth); break;
+        }
+    }
+
+    template <SvfOutput Output>
+    static void svf(float* pack, float* frames, unsigned numFrames, float smoothValue)
+    {
+        const Vec smooth = V::set1(smoothValue);
+        const Vec unsmooth = V::set1(1.0f - smoothValue);
+        const Vec one = V::set1(1.0f);
+        const Vec two = V::set1(2.0f);
+        const Vec tg = at(pack, kTargetG), k = at(pack, kK);
+        Vec g = at(pack, kG), h = at(pack, kH), r = at(pack, kR);
+        Vec s1 = at(pack, kS1), s2 = at(pack, kS2);
+
+        for (unsigned i = 0; i < numFrames; ++i) {
+            g = V::add(V::mul(smooth, g), tg);
+            const Vec gk = V::add(k, g);
+            h = V::add(V::mul(smooth, h), V::div(unsmooth, V::add(V::mul(g, gk), one)));
+            r = V::add(V::mul(smooth, r), V::mul(unsmooth, gk));
+
+            const Vec x = V::load(frames + i * V::width);
+            const Vec hp = V::mul(h, V::sub(x, V::add(s1, V::mul(r, s2))));
+            const Vec t = V::mul(g, hp);
+            const Vec bp = V::add(s2, t);
+            const Vec nextS2 = V::add(bp, t);
+            const Vec lp = V::add(s1, V::mul(g, nextS2));
+            s1 = V::add(s1, V::mul(two, V::mul(g, bp)));
+            s2 = nextS2;
+
+            Vec y;
+            switch (Output) {
+            case SvfOutput::Lowpass: y = lp; break;
+            case SvfOutput::Highpass: y = hp; break;
+            case SvfOutput::Bandpass: y = bp; break;
+            case SvfOutput::Bandstop: y = V::add(lp, hp); break;
+            }
+            V::store(frames + i * V::width, y);
+        }
+
+        put(pack, kG, g);
+        put(pack, kH, h);
+        put(pack, kR, r);
+        put(pack, kS1, s1);
+        put(pack, kS2, s2);
+    }
+
+    static void processSvf(float* pack, float* frames, unsigned numFrames, SvfOutput output, float smooth)
+    {
+        switch (output) {
+        case SvfOutput::Lowpass: svf<SvfOutput::Lowpass>(pack, frames, numFrames, smooth); break;
+        case SvfOutput::Highpass: svf<SvfOutput::Highpass>(pack, frames, numFrames, smooth); break;
+        case SvfOutput::Bandpass: svf<SvfOutput::Bandpass>(pack, frames, numFrames, smooth); break;
+        case SvfOutput::Bandstop: svf<SvfOutput::Bandstop>(pack, frames, numFrames, smooth); break;
+        }
+    }
+};
+
+} // namespace batch
+} // namespace sfz
@@ -15,8 +15,33 @@ sfz::FilterHolder::FilterHolder(Resources& resources)
     filter->init(config::defaultSampleRate);
 }
 
+sfz::FilterHolder::FilterHolder(FilterHolder&& other) noexcept
+: resources(other.resources),
+  description(other.description),
+  filter(std::move(other.filter)),
+  batch(other.batch),
+  batchId(other.batchId),
+  batchParameters(std::move(other.batchParameters)),
+  baseCutoff(other.baseCutoff),
+  baseResonance(other.baseResonance),
+  baseGain(other.baseGain),
+  gainTarget(other.gainTarget),
+  cutoffTarget(other.cutoffTarget),
+  resonanceTarget(other.resonanceTarget),
+  prepared(other.prepared)
+{
+    other.batch = nullptr;
+    other.batchId = -1;
+}
+
+sfz::FilterHolder::~FilterHolder()
+{
+    leaveBatch();
+}
+
 void sfz::FilterHolder::reset()
 {
+    leaveBatch();
     filter->clear();
     prepared = false;
 }
@@ -26,6 +51,8 @@ void sfz::FilterHolder::setup(const Region& region, unsigned filterId, int noteN
     ASSERT(velocity >= 0.0f && velocity <= 1.0f);
     ASSERT(filterId < region.filters.size());
 
+    leaveBatch();
+
     this->description = &region.filters[filterId];
     filter->setType(description->type);
     filter->setChannels(region.isStereo() ? 2 : 1);
@@ -72,6 +99,29 @@ void sfz::FilterHolder::process(const float** inputs, float** outputs, unsigned
     }
 
     ModMatrix& mm = resources.getModMatrix();
+    float* cutoffMod = mm.getModulation(cutoffTarget);
+    float* resonanceMod = mm.getModulation(resonanceTarget);
+    float* gainMod = mm.getModulation(gainTarget);
+
+    // Without modulation, or with constant modulations, the coefficients
+    // are computed once for the block
+    if ((!cutoffMod || mm.isModulationConstant(cutoffTarget))
+        && (!resonanceMod || mm.isModulationConstant(resonanceTarget))
+        && (!gainMod || mm.isModulationConstant(gainTarget))) {
+        const float cutoff = cutoffMod ?
+            Default::filterCutoff.bounds.clamp(baseCutoff * centsFactor(cutoffMod[0])) : baseCutoff;
+        const float resonance = baseResonance + (resonanceMod ? resonanceMod[0] : 0.0f);
+        const float gain = baseGain + (gainMod ? gainMod[0] : 0.0f);
+
+        if (!prepared) {
+            filter->prepare(cutoff, resonance, gain);
+            prepared = true;
+        }
+
+        filter->process(inputs, outputs, cutoff, resonance, gain, numFrames);
+        return;
+    }
+
     BufferPool& bufferPool = resources.getBufferPool();
     auto cutoffSpan = bufferPool.getBuffer(numFrames);
     auto resonanceSpan = bufferPool.getBuffer(numFrames);
@@ -81,19 +131,19 @@ void sfz::FilterHolder::process(const float** inputs, float** outputs, unsigned
         return;
 
     fill<float>(*cutoffSpan, baseCutoff);
-    if (float* mod = mm.getModulation(cutoffTarget)) {
+    if (cutoffMod) {
         for (size_t i = 0; i < numFrames; ++i)
-            (*cutoffSpan)[i] *= centsFactor(mod[i]);
+            (*cutoffSpan)[i] *= centsFactor(cutoffMod[i]);
     }
     sfz::clampAll(*cutoffSpan, Default::filterCutoff.bounds);
 
     fill<float>(*resonanceSpan, baseResonance);
-    if (float* mod = mm.getModulation(resonanceTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *resonanceSpan);
+    if (resonanceMod)
+        add<float>(absl::Span<float>(resonanceMod, numFrames), *resonanceSpan);
 
     fill<float>(*gainSpan, baseGain);
-    if (float* mod = mm.getModulation(gainTarget))
-        add<float>(absl::Span<float>(mod, numFrames), *gainSpan);
+    if (gainMod)
+        add<float>(absl::Span<float>(gainMod, numFrames), *gainSpan);
 
     if (!prepared) {
         filter->prepare(cutoffSpan->front(), resonanceSpan->front(), gainSpan->front());
@@ -110,8 +160,121 @@ void sfz::FilterHolder::process(const float** inputs, float** outputs, unsigned
     );
 }
 
+bool sfz::FilterHolder::joinBatch(FilterBatch& newBatch) noexcept
+{
+    leaveBatch();
+    if (description == nullptr)
+        return false;
+
+    const int id = newBatch.addFilter(description->type, filter->channels());
+    if (id < 0)
+        return false;
+
+    batch = &newBatch;
+    batchId = id;
+    return true;
+}
+
+void sfz::FilterHolder::leaveBatch() noexcept
+{
+    if (batch == nullptr)
+        return;
+
+    batch->removeFilter(batchId);
+    batch = nullptr;
+    batchId = -1;
+}
+
+void sfz::FilterHolder::scheduleBatch(const float** inputs, float** outputs, unsigned numFrames)
+{
+    ASSERT(batch != nullptr);
+    batch->setBuffers(batchId, inputs, outputs);
+
+    ModMatrix& mm = resources.getModMatrix();
+    float* cutoffMod = mm.getModulation(cutoffTarget);
+    float* resonanceMod = mm.getModulation(resonanceTarget);
+    float* gainMod = mm.getModulation(gainTarget);
+
+    constexpr unsigned interval = config::filterControlInterval;
+    const size_t numIntervals = (numFrames + interval - 1) / interval;
+
+    // The batch reads the parameters once per control interval, so they
+    // are only computed there
+    if (((!cutoffMod || mm.isModulationConstant(cutoffTarget))
+        && (!resonanceMod || mm.isModulationConstant(resonanceTarget))
+        && (!gainMod || mm.isModulationConstant(gainTarget)))
+        || batchParameters.size() < 3 * numIntervals) {
+        const float cutoff = cutoffMod ?
+            Default::filterCutoff.bounds.clamp(baseCutoff * centsFactor(cutoffMod[0])) : baseCutoff;
+        const float resonance = baseResonance + (resonanceMod ? resonanceMod[0] : 0.0f);
+        const float gain = baseGain + (gainMod ? gainMod[0] : 0.0f);
+        batch->setParameters(batchId, cutoff, resonance, gain);
+        return;
+    }
+
+    float* cutoffs = batchParameters.data();
+    float* resonances = cutoffs + numIntervals;
+    float* gains = resonances + numIntervals;
+    for (size_t i = 0; i < numIntervals; ++i) {
+        const size_t frame = i * interval;
+        cutoffs[i] = cutoffMod ?
+            Default::filterCutoff.bounds.clamp(baseCutoff * centsFactor(cutoffMod[frame])) : baseCutoff;
+        resonances[i] = baseResonance + (resonanceMod ? resonanceMod[frame] : 0.0f);
+        gains[i] = baseGain + (gainMod ? gainMod[frame] : 0.0f);
+    }
+
+    batch->setModulatedParameters(batchId, cutoffs, resonances, gains);
+}
+
+void sfz::FilterHolder::setBatchBlockSize(int samplesPerBlock)
+{
+    constexpr int interval = config::filterControlInterval;
+    const size_t numIntervals = (samplesPerBlock + interval - 1) / interval;
+    batchParameters.resize(3 * numIntervals);
+    batchParameters.shrink_to_fit();
+}
 
 void sfz::FilterHolder::setSampleRate(float sampleRate)
 {
     filter->init(static_cast<double>(sampleRate));
 }
+
+bool sfz::FilterBatches::canBatch(const Region& region) noexcept
+{
+    if (region.filters.empty() || !region.equalizers.empty())
+        return false;
+
+    return absl::c_all_of(region.filters, [](const FilterDescription& description) {
+        return FilterBatch::supportsType(description.type);
+    });
+}
+
+void sfz::FilterBatches::reserve(const Region& region, unsigned numVoices)
+{
+    while (batches.size() < region.filters.size()) {
+        batches.emplace_back(absl::make_unique<FilterBatch>());
+        batches.back()->init(sampleRate);
+    }
+
+    // A stereo voice takes two lanes
+    for (unsigned i = 0; i < region.filters.size(); ++i)
+        batches[i]->reserve(region.filters[i].type, 2 * numVoices);
+}
+
+sfz::FilterBatch* sfz::FilterBatches::getBatch(unsigned position) noexcept
+{
+    return position < batches.size() ? batches[position].get() : nullptr;
+}
+
+void sfz::FilterBatches::process(unsigned numFrames) noexcept
+{
+    for (auto& batch : batches)
+        batch->process(numFrames);
+}
+
+void sfz::FilterBatches::setSampleRate(float sampleRate)
+{
+    this->sampleRate = sampleRate;
+    for (auto& batch : batches)
+        batch->init(sampleRate);
+}
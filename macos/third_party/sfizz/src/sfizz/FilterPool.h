@@ -1,5 +1,7 @@
 #pragma once
 #include "SfzFilter.h"
+#include "FilterBatch.h"
+#include "Config.h"
 #include "Defaults.h"
 #include "modulations/ModMatrix.h"
 #include <vector>
@@ -15,6 +17,8 @@ class FilterHolder
 public:
     FilterHolder() = delete;
     FilterHolder(Resources& resources);
+    FilterHolder(FilterHolder&& other) noexcept;
+    ~FilterHolder();
     /**
      * @brief Setup a new filter based on a filter description, and a triggering note parameters.
      *
@@ -32,6 +36,39 @@ public:
      * @param numFrames
      */
     void process(const float** inputs, float** outputs, unsigned numFrames);
+    /**
+     * @brief Move the filter set up last into a batch, which then processes
+     * it in place of this holder. Fails if the batch has no free lanes for it.
+     *
+     * @param batch
+     * @return true if the filter is in the batch
+     */
+    bool joinBatch(FilterBatch& batch) noexcept;
+    /**
+     * @brief Take the filter out of its batch, if it is in one.
+     */
+    void leaveBatch() noexcept;
+    /**
+     * @brief Is the filter processed in a batch?
+     */
+    bool isBatched() const noexcept { return batch != nullptr; }
+    /**
+     * @brief Give the batch the buffers and parameters of the filter for its
+     * next process call. Like process(), this reads the modulations of the
+     * current voice.
+     *
+     * @param inputs
+     * @param outputs
+     * @param numFrames
+     */
+    void scheduleBatch(const float** inputs, float** outputs, unsigned numFrames);
+    /**
+     * @brief Allocate the modulated parameters that the holder gives to a
+     * batch, for blocks of up to this many frames. 0 frees them.
+     *
+     * @param samplesPerBlock
+     */
+    void setBatchBlockSize(int samplesPerBlock);
     /**
      * @brief Set the sample rate for a filter
      *
@@ -46,6 +83,10 @@ private:
     Resources& resources;
     const FilterDescription* description;
     std::unique_ptr<Filter> filter;
+    FilterBatch* batch { nullptr };
+    int batchId { -1 };
+    // Cutoff, resonance and gain per control interval, given to the batch
+    std::vector<float> batchParameters;
     float baseCutoff { Default::filterCutoff };
     float baseResonance { Default::filterResonance };
     float baseGain { Default::filterGain };
@@ -55,4 +96,52 @@ private:
     bool prepared { false };
 };
 
+/**
+ * @brief The batches which process the filters of the voices together, one
+ * per filter position in a region, so that the filters of a voice run in the
+ * order of the region.
+ */
+class FilterBatches
+{
+public:
+    /**
+     * @brief Whether the filters of a region can run in batches: it has
+     * filters, all of a batched type, and no equalizers, which follow them.
+     *
+     * @param region
+     */
+    static bool canBatch(const Region& region) noexcept;
+    /**
+     * @brief Reserve the lanes for the filters of a region on every voice.
+     * The reserves only grow.
+     *
+     * @param region
+     * @param numVoices
+     */
+    void reserve(const Region& region, unsigned numVoices);
+    /**
+     * @brief Get the batch of a filter position, or nullptr if nothing was
+     * reserved in it.
+     *
+     * @param position
+     */
+    FilterBatch* getBatch(unsigned position) noexcept;
+    /**
+     * @brief Process the scheduled filters of all the batches, in the order
+     * of their positions.
+     *
+     * @param numFrames
+     */
+    void process(unsigned numFrames) noexcept;
+    /**
+     * @brief Set the sample rate of the batches. This clears their filters.
+     *
+     * @param sampleRate
+     */
+    void setSampleRate(float sampleRate);
+private:
+    float sampleRate { config::defaultSampleRate };
+    std::vector<std::unique_ptr<FilterBatch>> batches;
+};
+
 } // namespace sfz
@@ -0,0 +1,301 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "MappedAudio.h"
+#include "FileMetadata.h"
+#include <algorithm>
+#include <cstring>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sfz {
+
+namespace {
+
+// Touching one byte in each of these is enough to load all the pages
+constexpr size_t touchStride = 4096;
+
+uint16_t u16le(const uint8_t* bytes)
+{
+    return bytes[0] | (bytes[1] << 8);
+}
+
+uint16_t u16be(const uint8_t* bytes)
+{
+    return (bytes[0] << 8) | bytes[1];
+}
+
+uint32_t u32be(const uint8_t* bytes)
+{
+    return (uint32_t(bytes[0]) << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+}
+
+bool isLittleEndianHost()
+{
+    const uint16_t probe = 1;
+    uint8_t firstByte;
+    std::memcpy(&firstByte, &probe, 1);
+    return firstByte == 1;
+}
+
+bool sampleFormatFromBits(unsigned bits, bool isFloat, SampleFormat& format)
+{
+    if (isFloat) {
+        format = SampleFormat::Float32;
+        return bits == 32;
+    }
+
+    switch (bits) {
+    case 16:
+        format = SampleFormat::Int16;
+        return true;
+    case 24:
+        format = SampleFormat::Int24;
+        return true;
+    case 32:
+        format = SampleFormat::Int32;
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+std::unique_ptr<MappedAudioFile> MappedAudioFile::map(const fs::path& path) noexcept
+{
+    // The samples are reassembled from bytes, but reading them as floats
+    // relies on the host storing floats like the files do
+    if (!isLittleEndianHost())
+        return {};
+
+    std::unique_ptr<MappedAudioFile> file { new MappedAudioFile };
+    if (!file->mapWholeFile(path) || file->length_ < 12)
+        return {};
+
+    bool validLayout = false;
+    if (!std::memcmp(file->address_, "RIFF", 4) && !std::memcmp(file->address_ + 8, "WAVE", 4))
+        validLayout = file->readWavLayout();
+    else if (!std::memcmp(file->address_, "FORM", 4))
+        validLayout = file->readAiffLayout();
+
+    if (!validLayout)
+        return {};
+
+    return file;
+}
+
+bool MappedAudioFile::readWavLayout() noexcept
+{
+    MemoryMetadataReader reader { address_, length_ };
+    if (!reader.open())
+        return false;
+
+    const RiffChunkInfo* fmt = reader.riffChunkById(RiffChunkId {{ 'f', 'm', 't', ' ' }});
+    const RiffChunkInfo* data = reader.riffChunkById(RiffChunkId {{ 'd', 'a', 't', 'a' }});
+    if (!fmt || !data || fmt->length < 16 || static_cast<size_t>(fmt->fileOffset) + fmt->length > length_)
+        return false;
+
+    const uint8_t* fmtData = address_ + fmt->fileOffset;
+    unsigned formatTag = u16le(fmtData);
+    const unsigned numChannels = u16le(fmtData + 2);
+    const unsigned blockAlign = u16le(fmtData + 12);
+    const unsigned bitsPerSample = u16le(fmtData + 14);
+
+    // WAVE_FORMAT_EXTENSIBLE, whose sub-format GUID starts with the tag
+    if (formatTag == 0xFFFE && fmt->length >= 26)
+        formatTag = u16le(fmtData + 24);
+
+    // WAVE_FORMAT_PCM or WAVE_FORMAT_IEEE_FLOAT
+    if (formatTag != 1 && formatTag != 3)
+        return false;
+
+    SampleFormat format;
+    if (!sampleFormatFromBits(bitsPerSample, formatTag == 3, format))
+        return false;
+
+    if (numChannels < 1 || numChannels > 2 || blockAlign != numChannels * bitsPerSample / 8)
+        return false;
+
+    const auto dataOffset = static_cast<size_t>(data->fileOffset);
+    if (dataOffset > length_)
+        return false;
+
+    const size_t dataLength = std::min<size_t>(data->length, length_ - dataOffset);
+
+    span_.format = format;
+    span_.bigEndian = false;
+    span_.numChannels = numChannels;
+    span_.numFrames = dataLength / blockAlign;
+    span_.frameStride = blockAlign;
+    for (unsigned c = 0; c < numChannels; ++c)
+        span_.channels[c] = address_ + dataOffset + c * (bitsPerSample / 8);
+
+    return true;
+}
+
+bool MappedAudioFile::readAiffLayout() noexcept
+{
+    const bool isAifc = !std::memcmp(address_ + 8, "AIFC", 4);
+    if (!isAifc && std::memcmp(address_ + 8, "AIFF", 4))
+        return false;
+
+    MemoryMetadataReader reader { address_, length_ };
+    if (!reader.open())
+        return false;
+
+    const RiffChunkInfo* comm = reader.riffChunkById(RiffChunkId {{ 'C', 'O', 'M', 'M' }});
+    const RiffChunkInfo* ssnd = reader.riffChunkById(RiffChunkId {{ 'S', 'S', 'N', 'D' }});
+    const size_t commLength = isAifc ? 22 : 18;
+    if (!comm || !ssnd || comm->length < commLength || ssnd->length < 8
+        || static_cast<size_t>(comm->fileOffset) + commLength > length_
+        || static_cast<size_t>(ssnd->fileOffset) + 8 > length_)
+        return false;
+
+    const uint8_t* commData = address_ + comm->fileOffset;
+    const unsigned numChannels = u16be(commData);
+    const uint32_t numFrames = u32be(commData + 2);
+    const unsigned bitsPerSample = u16be(commData + 6);
+
+    // AIFC only holds samples that can be read in place without compression,
+    // either big-endian or little-endian
+    bool bigEndian = true;
+    bool isFloat = false;
+    if (isAifc) {
+        const uint8_t* compression = commData + 18;
+        if (!std::memcmp(compression, "sowt", 4))
+            bigEndian = false;
+        else if (!std::memcmp(compression, "fl32", 4) || !std::memcmp(compression, "FL32", 4))
+            isFloat = true;
+        else if (std::memcmp(compression, "NONE", 4))
+            return false;
+    }
+
+    SampleFormat format;
+    if (!sampleFormatFromBits(bitsPerSample, isFloat, format))
+        return false;
+
+    if (numChannels < 1 || numChannels > 2)
+        return false;
+
+    const uint8_t* ssndData = address_ + ssnd->fileOffset;
+    const size_t dataOffset = static_cast<size_t>(ssnd->fileOffset) + 8 + u32be(ssndData);
+    if (dataOffset > length_)
+        return false;
+
+    const size_t bytesPerSample = bitsPerSample / 8;
+    const size_t frameStride = numChannels * bytesPerSample;
+
+    span_.format = format;
+    span_.bigEndian = bigEndian;
+    span_.numChannels = numChannels;
+    span_.numFrames = std::min<size_t>(numFrames, (length_ - dataOffset) / frameStride);
+    span_.frameStride = frameStride;
+    for (unsigned c = 0; c < numChannels; ++c)
+        span_.channels[c] = address_ + dataOffset + c * bytesPerSample;
+
+    return true;
+}
+
+void MappedAudioFile::touch(size_t numFrames) const noexcept
+{
+    if (span_.numChannels == 0)
+        return;
+
+    const uint8_t* begin = span_.channels[0];
+    const uint8_t* end = begin + std::min(numFrames, span_.numFrames) * span_.frameStride;
+
+    volatile uint8_t sink = 0;
+    for (const uint8_t* page = begin; page < end; page += touchStride)
+        sink ^= *page;
+    (void)sink;
+}
+
+#if defined(_WIN32)
+bool MappedAudioFile::mapWholeFile(const fs::path& path) noexcept
+{
+    HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    // The view keeps the file and the mapping open
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return false;
+
+    void* address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!address)
+        return false;
+
+    address_ = static_cast<const uint8_t*>(address);
+    length_ = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+MappedAudioFile::~MappedAudioFile()
+{
+    if (address_)
+        UnmapViewOfFile(address_);
+}
+
+void MappedAudioFile::adviseWillNeed() const noexcept
+{
+    // Windows has no asynchronous hint for older versions, the pages are
+    // loaded when the samples are read
+}
+#else
+bool MappedAudioFile::mapWholeFile(const fs::path& path) noexcept
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // The mapping keeps the file open
+    void* address = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED)
+        return false;
+
+    address_ = static_cast<const uint8_t*>(address);
+    length_ = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+MappedAudioFile::~MappedAudioFile()
+{
+    if (address_)
+        munmap(const_cast<uint8_t*>(address_), length_);
+}
+
+void MappedAudioFile::adviseWillNeed() const noexcept
+{
+    if (address_)
+        madvise(const_cast<uint8_t*>(address_), length_, MADV_WILLNEED);
+}
+#endif
+
+} // namespace sfz
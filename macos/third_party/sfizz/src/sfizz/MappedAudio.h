@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#pragma once
+#include "EncodedAudio.h"
+#include <ghc/fs_std.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace sfz {
+
+/**
+ * @brief An uncompressed WAV or AIFF file mapped in memory. Its samples are
+ * read straight from the mapping, and the operating system loads and evicts
+ * the pages of the file as they are used.
+ */
+class MappedAudioFile {
+public:
+    /**
+     * @brief Map a file. This fails if the file can't be mapped, or if it is
+     * not a WAV or AIFF file with 1 or 2 channels of 16, 24 or 32-bit
+     * integers or 32-bit floats.
+     *
+     * @param path
+     * @return the mapped file, or nothing
+     */
+    static std::unique_ptr<MappedAudioFile> map(const fs::path& path) noexcept;
+    ~MappedAudioFile();
+
+    MappedAudioFile(const MappedAudioFile&) = delete;
+    MappedAudioFile& operator=(const MappedAudioFile&) = delete;
+
+    const EncodedAudioSpan& getSpan() const noexcept { return span_; }
+
+    /**
+     * @brief Read the pages which hold the first frames, so that they are in
+     * memory when this returns.
+     *
+     * @param numFrames
+     */
+    void touch(size_t numFrames) const noexcept;
+
+    /**
+     * @brief Let the operating system read all the pages of the samples
+     * ahead, without waiting for them.
+     */
+    void adviseWillNeed() const noexcept;
+
+private:
+    MappedAudioFile() = default;
+    bool mapWholeFile(const fs::path& path) noexcept;
+    bool readWavLayout() noexcept;
+    bool readAiffLayout() noexcept;
+
+    const uint8_t* address_ { nullptr };
+    size_t length_ { 0 };
+    EncodedAudioSpan span_;
+};
+
+} // namespace sfz
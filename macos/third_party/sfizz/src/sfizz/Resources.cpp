@@ -14,6 +14,7 @@
 #include "Tuning.h"
 #include "BeatClock.h"
 #include "Metronome.h"
+#include "FilterPool.h"
 #include "modulations/ModMatrix.h"
 
 namespace sfz {
@@ -30,6 +31,7 @@ struct Resources::Impl {
     ModMatrix modMatrix;
     BeatClock beatClock;
     Metronome metronome;
+    FilterBatches filterBatches;
 };
 
 Resources::Resources()
@@ -48,6 +50,7 @@ void Resources::setSampleRate(float samplerate)
     impl.modMatrix.setSampleRate(samplerate);
     impl.beatClock.setSampleRate(samplerate);
     impl.metronome.init(samplerate);
+    impl.filterBatches.setSampleRate(samplerate);
 }
 
 void Resources::setSamplesPerBlock(int samplesPerBlock)
@@ -133,4 +136,9 @@ const Metronome& Resources::getMetronome() const noexcept
     return impl_->metronome;
 }
 
+const FilterBatches& Resources::getFilterBatches() const noexcept
+{
+    return impl_->filterBatches;
+}
+
 } // namespace sfz
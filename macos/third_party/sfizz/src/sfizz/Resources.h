@@ -21,6 +21,7 @@ class StretchTuning;
 class ModMatrix;
 class BeatClock;
 class Metronome;
+class FilterBatches;
 
 class Resources
 {
@@ -57,6 +58,7 @@ public:
     ACCESSOR_RW(getModMatrix, ModMatrix);
     ACCESSOR_RW(getBeatClock, BeatClock);
     ACCESSOR_RW(getMetronome, Metronome);
+    ACCESSOR_RW(getFilterBatches, FilterBatches);
 
     #undef ACCESSOR_RW
 
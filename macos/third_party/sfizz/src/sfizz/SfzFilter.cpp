@@ -10,6 +10,7 @@
 #include "SIMDHelpers.h"
 #include "utility/StringViewHelpers.h"
 #include "utility/Debug.h"
+#include <algorithm>
 #include <cstring>
 
 namespace sfz {
@@ -130,6 +131,14 @@ void Filter::processModulated(const float *const in[], float *const out[], const
         if (current > config::filterControlInterval)
             current = config::filterControlInterval;
 
+        // Run the following intervals along if their parameters are the
+        // same, rather than computing the same coefficients again
+        while (frame + current < nframes
+               && cutoff[frame + current] == cutoff[frame]
+               && q[frame + current] == q[frame]
+               && pksh[frame + current] == pksh[frame])
+            current += std::min<unsigned>(config::filterControlInterval, nframes - frame - current);
+
         const float *current_in[Impl::maxChannels];
         float *current_out[Impl::maxChannels];
 
@@ -328,6 +337,14 @@ void FilterEq::processModulated(const float *const in[], float *const out[], con
         if (current > config::filterControlInterval)
             current = config::filterControlInterval;
 
+        // Run the following intervals along if their parameters are the
+        // same, rather than computing the same coefficients again
+        while (frame + current < nframes
+               && cutoff[frame + current] == cutoff[frame]
+               && bw[frame + current] == bw[frame]
+               && pksh[frame + current] == pksh[frame])
+            current += std::min<unsigned>(config::filterControlInterval, nframes - frame - current);
+
         const float *current_in[Impl::maxChannels];
         float *current_out[Impl::maxChannels];
 
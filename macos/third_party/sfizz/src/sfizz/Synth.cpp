@@ -30,6 +30,7 @@
 #include "utility/Timing.h"
 #include "utility/XmlHelpers.h"
 #include "Voice.h"
+#include "FilterPool.h"
 #include "Interpolators.h"
 #include "parser/Parser.h"
 #include <absl/algorithm/container.h>
@@ -41,6 +42,7 @@
 #include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <iterator>
 #include <random>
 #include <utility>
 
@@ -708,7 +710,7 @@ void Synth::Impl::finalizeSfzLoad()
     size_t currentRegionIndex = 0;
     size_t currentRegionCount = layers_.size();
 
-    absl::flat_hash_map<sfz::FileId, int64_t> filesToLoad;
+    absl::flat_hash_map<sfz::FileId, FileInformation> filesToLoad;
 
     auto removeCurrentRegion = [this, &currentRegionIndex, &currentRegionCount]() {
         const Region& region = layers_[currentRegionIndex]->getRegion();
@@ -729,6 +731,18 @@ void Synth::Impl::finalizeSfzLoad()
 
     FlexEGs::clearUnusedCurves();
 
+    // Check the samples and read their information on the loading threads
+    // first, once per file, and then go through the regions in order
+    std::vector<FileId> sampleIds;
+    absl::flat_hash_map<FileId, size_t> sampleIndices;
+    for (const LayerPtr& layer : layers_) {
+        const Region& region = layer->getRegion();
+        if (!region.isGenerator() && sampleIndices.emplace(*region.sampleId, sampleIds.size()).second)
+            sampleIds.push_back(*region.sampleId);
+    }
+
+    const auto sampleInformation = filePool.probeFiles(sampleIds);
+
     while (currentRegionIndex < currentRegionCount) {
         Layer& layer = *layers_[currentRegionIndex];
         Region& region = layer.getRegion();
@@ -736,17 +750,16 @@ void Synth::Impl::finalizeSfzLoad()
         absl::optional<FileInformation> fileInformation;
 
         if (!region.isGenerator()) {
-            if (!filePool.checkSampleId(*region.sampleId)) {
-                removeCurrentRegion();
-                continue;
-            }
-
-            fileInformation = filePool.getFileInformation(*region.sampleId);
+            const size_t sampleIndex = sampleIndices[*region.sampleId];
+            fileInformation = sampleInformation[sampleIndex];
             if (!fileInformation) {
                 removeCurrentRegion();
                 continue;
             }
 
+            if (*region.sampleId != sampleIds[sampleIndex])
+                region.sampleId.reset(new FileId(sampleIds[sampleIndex]));
+
             region.hasWavetableSample = fileInformation->wavetable.has_value();
 
             if (fileInformation->end < config::wavetableMaxFrames) {
@@ -803,8 +816,12 @@ void Synth::Impl::finalizeSfzLoad()
                 return Default::offsetMod.bounds.clamp(sumOffsetCC);
             }();
 
-            auto& toLoad = filesToLoad[*region.sampleId];
-            toLoad = max(toLoad, maxOffset);
+            // The sample may have been replaced by silence
+            if (!region.isGenerator()) {
+                auto inserted = filesToLoad.emplace(*region.sampleId, *fileInformation);
+                auto& toLoad = inserted.first->second;
+                toLoad.maxOffset = inserted.second ? maxOffset : max(toLoad.maxOffset, maxOffset);
+            }
         }
         else if (!region.isGenerator()) {
             if (!wavePool.createFileWave(filePool, std::string(region.sampleId->filename()))) {
@@ -893,8 +910,7 @@ void Synth::Impl::finalizeSfzLoad()
     if (reloading)
         filePool.resetPreloadCallCounts();
 
-    for (const auto& toLoad: filesToLoad)
-        filePool.preloadFile(toLoad.first, toLoad.second);
+    filePool.preloadFiles(filesToLoad);
 
     // Remove preloaded data with no linked regions
     if (reloading)
@@ -1161,32 +1177,57 @@ void Synth::renderBlock(AudioSpan<float> buffer) noexcept
     { // Main render block
         ScopedTiming logger { callbackBreakdown.renderMethod, ScopedTiming::Operation::addToDuration };
 
-        for (auto& voice : impl.voiceManager_) {
-            if (voice.isFree())
-                continue;
-
-            mm.beginVoice(voice.getId(), voice.getRegion()->getId(), voice.getTriggerEvent().value);
-
+        const auto mixVoice = [&](Voice& voice, AudioSpan<float> voiceSpan) {
             const Region* region = voice.getRegion();
             ASSERT(region != nullptr);
             const auto& effectBuses = impl.getEffectBusesForOutput(region->output);
 
-            voice.renderBlock(*tempSpan);
             for (size_t i = 0, n = effectBuses.size(); i < n; ++i) {
                 if (auto& bus = effectBuses[i]) {
                     float addGain = region->getGainToEffectBus(i);
-                    bus->addToInputs(*tempSpan, addGain, numFrames);
+                    bus->addToInputs(voiceSpan, addGain, numFrames);
                 }
             }
             callbackBreakdown.data += voice.getLastDataDuration();
             callbackBreakdown.amplitude += voice.getLastAmplitudeDuration();
             callbackBreakdown.filters += voice.getLastFilterDuration();
             callbackBreakdown.panning += voice.getLastPanningDuration();
+        };
+
+        auto& batchedVoices = impl.batchedVoices_;
+        batchedVoices.clear();
+
+        impl.voiceManager_.forEachActiveVoice([&](Voice& voice) {
+            mm.beginVoice(voice.getId(), voice.getRegion()->getId(), voice.getTriggerEvent().value);
+
+            // The voices with batched filters are mixed once the batches ran
+            if (voice.renderBlockBeforeFilterBatch(numFrames)) {
+                batchedVoices.push_back(&voice);
+                mm.endVoice();
+                return;
+            }
+
+            voice.renderBlock(*tempSpan);
+            mixVoice(voice, *tempSpan);
 
             mm.endVoice();
 
             if (voice.toBeCleanedUp())
                 voice.reset();
+        });
+
+        if (!batchedVoices.empty()) {
+            {
+                ScopedTiming logger { callbackBreakdown.filters, ScopedTiming::Operation::addToDuration };
+                impl.resources_.getFilterBatches().process(static_cast<unsigned>(numFrames));
+            }
+
+            for (Voice* voice : batchedVoices) {
+                mixVoice(*voice, voice->renderBlockAfterFilterBatch());
+
+                if (voice->toBeCleanedUp())
+                    voice->reset();
+            }
         }
     }
 
@@ -1268,6 +1309,32 @@ void Synth::hdNoteOn(int delay, int noteNumber, float normalizedVelocity) noexce
     impl.noteOnDispatch(delay, noteNumber, normalizedVelocity);
 }
 
+void Synth::prefetchNote(int noteNumber, float velocity, float seconds) noexcept
+{
+    ASSERT(noteNumber < 128);
+    ASSERT(noteNumber >= 0);
+    Impl& impl = *impl_;
+    FilePool& filePool = impl.resources_.getFilePool();
+
+    const auto deadline = highResNow() + std::chrono::duration_cast<TimePoint::duration>(Duration(seconds));
+
+    // Release regions are kept whatever the velocity, since they play on the
+    // note off with the velocity of either
+    for (const Layer* layer : impl.noteActivationLists_[noteNumber]) {
+        const Region& region = layer->getRegion();
+        if (region.isOscillator() || region.disabled())
+            continue;
+
+        if (!region.keyRange.containsWithEnd(noteNumber))
+            continue;
+
+        if (!region.isRelease() && !region.velocityRange.containsWithEnd(velocity))
+            continue;
+
+        filePool.prefetch(region.sampleId, deadline);
+    }
+}
+
 void Synth::noteOff(int delay, int noteNumber, int velocity) noexcept
 {
     const float normalizedVelocity = normalizeVelocity(velocity);
@@ -1291,8 +1358,9 @@ void Synth::hdNoteOff(int delay, int noteNumber, float normalizedVelocity) noexc
 
     const auto replacedVelocity = midiState.getNoteVelocity(noteNumber);
 
-    for (auto& voice : impl.voiceManager_)
+    impl.voiceManager_.forEachActiveVoice([&](Voice& voice) {
         voice.registerNoteOff(delay, noteNumber, replacedVelocity);
+    });
 
     impl.noteOffDispatch(delay, noteNumber, replacedVelocity);
 }
@@ -1309,17 +1377,19 @@ void Synth::Impl::startVoice(Layer* layer, int delay, const TriggerEvent& trigge
     selectedVoice->reset();
     if (selectedVoice->startVoice(layer, delay, triggerEvent))
         ring.addVoiceToRing(selectedVoice);
+    else
+        selectedVoice->reset(); // it never became active, so rendering won't clean it up
 }
 
 void Synth::Impl::checkOffGroups(const Region* region, int delay, int number, bool chokedByCC)
 {
-    for (auto& voice : voiceManager_) {
+    voiceManager_.forEachActiveVoice([&](Voice& voice) {
         if (voice.checkOffGroup(region, delay, number)) {
             const TriggerEvent& event = voice.getTriggerEvent();
             if (event.type == TriggerEventType::NoteOn && !chokedByCC)
                 noteOffDispatch(delay, event.number, event.value);
         }
-    }
+    });
 }
 
 void Synth::Impl::noteOffDispatch(int delay, int noteNumber, float velocity) noexcept
@@ -1496,8 +1566,9 @@ void Synth::Impl::performHdcc(int delay, int ccNumber, float normValue, bool asM
         }
     }
 
-    for (auto& voice : voiceManager_)
+    voiceManager_.forEachActiveVoice([&](Voice& voice) {
         voice.registerCC(delay, ccNumber, normValue);
+    });
 
     ccDispatch(delay, ccNumber, normValue, extendedArg);
     midiState.ccEvent(delay, ccNumber, normValue);
@@ -1543,9 +1614,9 @@ void Synth::hdPitchWheel(int delay, float normalizedPitch) noexcept
         layer->registerPitchWheel(normalizedPitch);
     }
 
-    for (auto& voice : impl.voiceManager_) {
+    impl.voiceManager_.forEachActiveVoice([&](Voice& voice) {
         voice.registerPitchWheel(delay, normalizedPitch);
-    }
+    });
 
     impl.performHdcc(delay, ExtendedCCs::pitchBend, normalizedPitch, false);
 }
@@ -1576,9 +1647,9 @@ void Synth::hdChannelAftertouch(int delay, float normAftertouch) noexcept
         layerPtr->registerAftertouch(normAftertouch);
     }
 
-    for (auto& voice : impl.voiceManager_) {
+    impl.voiceManager_.forEachActiveVoice([&](Voice& voice) {
         voice.registerAftertouch(delay, normAftertouch);
-    }
+    });
 
     impl.performHdcc(delay, ExtendedCCs::channelAftertouch, normAftertouch, false);
 }
@@ -1596,8 +1667,9 @@ void Synth::hdPolyAftertouch(int delay, int noteNumber, float normAftertouch) no
 
     impl.resources_.getMidiState().polyAftertouchEvent(delay, noteNumber, normAftertouch);
 
-    for (auto& voice : impl.voiceManager_)
+    impl.voiceManager_.forEachActiveVoice([&](Voice& voice) {
         voice.registerPolyAftertouch(delay, noteNumber, normAftertouch);
+    });
 
     impl.performHdcc(delay, ExtendedCCs::polyphonicAftertouch, normAftertouch, false, noteNumber);
 }
@@ -1987,6 +2059,24 @@ void Synth::Impl::resetCallbackBreakdown()
 
 void Synth::Impl::applySettingsPerVoice()
 {
+    const bool encodedSamples = haveEncodedSamples();
+
+    // Reserve lanes in the filter batches for every voice, for the regions
+    // which can run their filters there
+    const auto numVoices = static_cast<unsigned>(std::distance(voiceManager_.begin(), voiceManager_.end()));
+    bool filterBatching = false;
+    if (filterBatching_) {
+        FilterBatches& filterBatches = resources_.getFilterBatches();
+        for (const LayerPtr& layerPtr : layers_) {
+            const Region& region = layerPtr->getRegion();
+            if (FilterBatches::canBatch(region)) {
+                filterBatches.reserve(region, numVoices);
+                filterBatching = true;
+            }
+        }
+    }
+    batchedVoices_.reserve(numVoices);
+
     for (auto& voice : voiceManager_) {
         voice.setMaxFiltersPerVoice(settingsPerVoice_.maxFilters);
         voice.setMaxEQsPerVoice(settingsPerVoice_.maxEQs);
@@ -1997,9 +2087,17 @@ void Synth::Impl::applySettingsPerVoice()
         voice.setAmplitudeLFOEnabledPerVoice(settingsPerVoice_.haveAmplitudeLFO);
         voice.setPitchLFOEnabledPerVoice(settingsPerVoice_.havePitchLFO);
         voice.setFilterLFOEnabledPerVoice(settingsPerVoice_.haveFilterLFO);
+        voice.setEncodedSamplesEnabledPerVoice(encodedSamples);
+        voice.setFilterBatchingEnabledPerVoice(filterBatching);
     }
 }
 
+bool Synth::Impl::haveEncodedSamples() const noexcept
+{
+    const FilePool& filePool = resources_.getFilePool();
+    return filePool.getMemoryMapping() || filePool.getSampleStorage() != SampleStorage::Float32;
+}
+
 void Synth::Impl::setupModMatrix()
 {
     ModMatrix& mm = resources_.getModMatrix();
@@ -2089,6 +2187,11 @@ void Synth::setPreloadSize(uint32_t preloadSize) noexcept
     if (preloadSize == filePool.getPreloadSize())
         return;
 
+    // The voices hold on to the data that is reloaded
+    for (auto& voice : impl.voiceManager_)
+        voice.reset();
+
+    filePool.waitForBackgroundLoading();
     filePool.setPreloadSize(preloadSize);
 }
 
@@ -2098,6 +2201,116 @@ uint32_t Synth::getPreloadSize() const noexcept
     return impl.resources_.getFilePool().getPreloadSize();
 }
 
+void Synth::setOversamplingFactor(Oversampling factor) noexcept
+{
+    Impl& impl = *impl_;
+    FilePool& filePool = impl.resources_.getFilePool();
+
+    // fast path
+    if (factor == filePool.getOversamplingFactor())
+        return;
+
+    // The voices hold on to data at the old rate
+    for (auto& voice : impl.voiceManager_)
+        voice.reset();
+
+    filePool.waitForBackgroundLoading();
+    filePool.setOversamplingFactor(factor);
+}
+
+Oversampling Synth::getOversamplingFactor() const noexcept
+{
+    Impl& impl = *impl_;
+    return impl.resources_.getFilePool().getOversamplingFactor();
+}
+
+void Synth::setSharedSampleCache(bool shared) noexcept
+{
+    Impl& impl = *impl_;
+    impl.resources_.getFilePool().setSharedCache(shared);
+}
+
+size_t Synth::getSharedSampleCacheMemory() noexcept
+{
+    return FilePool::getSharedCacheMemory();
+}
+
+void Synth::setSampleMemoryMapping(bool mapped) noexcept
+{
+    Impl& impl = *impl_;
+    FilePool& filePool = impl.resources_.getFilePool();
+
+    if (mapped == filePool.getMemoryMapping())
+        return;
+
+    // The voices hold on to the data that is reloaded
+    for (auto& voice : impl.voiceManager_)
+        voice.reset();
+
+    filePool.waitForBackgroundLoading();
+    filePool.setMemoryMapping(mapped);
+    for (auto& voice : impl.voiceManager_)
+        voice.setEncodedSamplesEnabledPerVoice(impl.haveEncodedSamples());
+}
+
+void Synth::setSampleStorage(SampleStorage storage) noexcept
+{
+    Impl& impl = *impl_;
+    FilePool& filePool = impl.resources_.getFilePool();
+
+    if (storage == filePool.getSampleStorage())
+        return;
+
+    // The voices hold on to the data that is reloaded
+    for (auto& voice : impl.voiceManager_)
+        voice.reset();
+
+    filePool.waitForBackgroundLoading();
+    filePool.setSampleStorage(storage);
+    for (auto& voice : impl.voiceManager_)
+        voice.setEncodedSamplesEnabledPerVoice(impl.haveEncodedSamples());
+}
+
+SampleStorage Synth::getSampleStorage() const noexcept
+{
+    Impl& impl = *impl_;
+    return impl.resources_.getFilePool().getSampleStorage();
+}
+
+void Synth::setFilterBatching(bool batching) noexcept
+{
+    Impl& impl = *impl_;
+
+    if (batching == impl.filterBatching_)
+        return;
+
+    // The voices keep their filters where they started
+    for (auto& voice : impl.voiceManager_)
+        voice.reset();
+
+    impl.filterBatching_ = batching;
+    impl.applySettingsPerVoice();
+}
+
+bool Synth::getFilterBatching() const noexcept
+{
+    Impl& impl = *impl_;
+    return impl.filterBatching_;
+}
+
+size_t Synth::getStreamUnderruns() const noexcept
+{
+    Impl& impl = *impl_;
+    return impl.resources_.getFilePool().getStreamUnderruns();
+}
+
+void Synth::setInstrumentCacheDirectory(const fs::path& directory) noexcept
+{
+    Impl& impl = *impl_;
+    impl.parser_.setCacheDirectory(directory);
+    impl.resources_.getWavePool().setCacheDirectory(directory);
+}
+
 void Synth::enableFreeWheeling() noexcept
 {
     Impl& impl = *impl_;
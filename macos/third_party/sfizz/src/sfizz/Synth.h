@@ -6,6 +6,8 @@
 
 #pragma once
 #include "AudioSpan.h"
+#include "EncodedAudio.h"
+#include "Oversampler.h"
 #include "Resources.h"
 #include "Messaging.h"
 #include "utility/NumericId.h"
@@ -372,6 +374,18 @@ public:
      * @param velocity the normalized midi note velocity, in domain 0 to 1
      */
     void hdNoteOn(int delay, int noteNumber, float velocity) noexcept;
+    /**
+     * @brief Load the samples that a note on could play, ahead of it.
+     * Regions are only matched by key and velocity so that the synth state
+     * is left alone, which can load samples the note won't end up playing.
+     * This can be called from another thread than the audio thread, one at
+     * a time, but not while an instrument is loading.
+     *
+     * @param noteNumber the midi note number
+     * @param velocity the normalized midi note velocity, in domain 0 to 1
+     * @param seconds how long to keep the samples in memory at least
+     */
+    void prefetchNote(int noteNumber, float velocity, float seconds) noexcept;
     /**
      * @brief Send a note off event to the synth
      *
@@ -585,7 +599,8 @@ public:
      * This function takes a lock and disables the callback; prefer calling
      * it out of the RT thread. It can also take a long time to return.
      * If the new preload size is the same as the current one, it will
-     * release the lock immediately and exit.
+     * release the lock immediately and exit. Otherwise this resets all
+     * voices and reloads all samples.
      *
      * @param factor
      */
@@ -598,6 +613,101 @@ public:
      */
     uint32_t getPreloadSize() const noexcept;
 
+    /**
+     * @brief Set the oversampling factor of the samples.
+     * The samples are upsampled once as they are preloaded and streamed, so
+     * that pitching them up with a cheap interpolator aliases less. This
+     * resets all voices and reloads all samples; prefer calling it out of the
+     * RT thread. It can also take a long time to return.
+     *
+     * @param factor
+     */
+    void setOversamplingFactor(Oversampling factor) noexcept;
+
+    /**
+     * @brief get the current oversampling factor
+     *
+     * @return Oversampling
+     */
+    Oversampling getOversamplingFactor() const noexcept;
+
+    /**
+     * @brief Share the preloaded samples with the other synths that do.
+     * Synths that load the same samples from the same paths then keep a
+     * single copy of them in memory. This takes effect when the next SFZ
+     * file is loaded.
+     *
+     * @param shared
+     */
+    void setSharedSampleCache(bool shared) noexcept;
+
+    /**
+     * @brief Get the memory used by the samples shared between synths, in
+     * bytes. This counts the preloaded data and what was streamed so far.
+     *
+     * @return size_t
+     */
+    static size_t getSharedSampleCacheMemory() noexcept;
+
+    /**
+     * @brief Read uncompressed WAV and AIFF samples from the files mapped in
+     * memory, rather than from float copies of them. The operating system
+     * then keeps in memory the parts of the files which are played. Reversed
+     * samples, and samples when oversampling, are still loaded as floats.
+     *
+     * This resets all voices and reloads all samples if the setting changes.
+     *
+     * @param mapped
+     */
+    void setSampleMemoryMapping(bool mapped) noexcept;
+
+    /**
+     * @brief Set the format in which the samples are kept in memory, both
+     * preloaded and streamed. Oversampled samples are kept as floats.
+     *
+     * This resets all voices and reloads all samples if the setting changes.
+     *
+     * @param storage
+     */
+    void setSampleStorage(SampleStorage storage) noexcept;
+
+    /**
+     * @brief Get the format in which the samples are kept in memory.
+     */
+    SampleStorage getSampleStorage() const noexcept;
+
+    /**
+     * @brief Run the filters of the voices together in SIMD lanes, rather
+     * than voice by voice. This applies to the regions whose filters are all
+     * biquads or state variable filters, and which have no equalizers.
+     * Enabled by default.
+     *
+     * This resets all voices if the setting changes.
+     *
+     * @param batching
+     */
+    void setFilterBatching(bool batching) noexcept;
+
+    /**
+     * @brief Whether the filters of the voices run together in SIMD lanes.
+     */
+    bool getFilterBatching() const noexcept;
+
+    /**
+     * @brief Get the number of times a voice played past the streamed part
+     * of its sample before the rest was loaded.
+     */
+    size_t getStreamUnderruns() const noexcept;
+
+    /**
+     * @brief Cache the parsed SFZ files and the wavetables made from
+     * sample files in a directory, see Parser::setCacheDirectory and
+     * WavetablePool::setCacheDirectory. An empty path disables the cache.
+     *
+     * @param directory
+     */
+    void setInstrumentCacheDirectory(const fs::path& directory) noexcept;
+
     /**
      * @brief Gets the number of allocated buffers.
      *
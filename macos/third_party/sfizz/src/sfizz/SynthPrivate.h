@@ -113,6 +113,11 @@ struct Synth::Impl final: public Parser::Listener {
      * @brief Make the stored settings take effect in all the voices
      */
     void applySettingsPerVoice();
+    /**
+     * @brief Whether the voices may read samples which are encoded or mapped,
+     * according to the settings of the file pool
+     */
+    bool haveEncodedSamples() const noexcept;
 
     /**
      * @brief Establish all connections of the modulation matrix.
@@ -323,6 +328,9 @@ struct Synth::Impl final: public Parser::Listener {
     float sampleRate_ { config::defaultSampleRate };
     float volume_ { Default::globalVolume };
     int numVoices_ { config::numVoices };
+    bool filterBatching_ { true };
+    // The voices of the block which wait on the filter batches
+    VoiceViewVector batchedVoices_;
 
     // Distribution used to generate random value for the *rand opcodes
     std::uniform_real_distribution<float> randNoteDistribution_ { 0, 1 };
@@ -89,6 +89,23 @@ struct Voice::Impl
         absl::Span<const int> indices, absl::Span<const float> coeffs,
         absl::Span<const float> addingGains, int quality);
 
+    /**
+     * @brief Fill a destination with an interpolated source which is mapped
+     * in memory or kept compact. The source is decoded to floats a window
+     * at a time, which is then interpolated like a float source.
+     *
+     * @param source the source sample
+     * @param dest the destination buffer
+     * @param indices the integral parts of the source positions
+     * @param coeffs the fractional parts of the source positions
+     * @param quality the quality level 1-10
+     */
+    template <bool Adding>
+    void fillInterpolatedFromEncoded(
+        const EncodedAudioSpan& source, const AudioSpan<float>& dest,
+        absl::Span<const int> indices, absl::Span<const float> coeffs,
+        absl::Span<const float> addingGains, int quality) noexcept;
+
     /**
      * @brief Get a S-shaped curve that is applicable to loop crossfading.
      */
@@ -128,7 +145,14 @@ struct Voice::Impl
      * @param buffer
      */
     void panStageMono(AudioSpan<float> buffer) noexcept;
+    void panStageMono(AudioSpan<float> buffer, absl::Span<const float> panSpan) noexcept;
     void panStageStereo(AudioSpan<float> buffer) noexcept;
+    /**
+     * @brief Compute the pan of a mono source, as applied by the pan stage
+     *
+     * @param panSpan
+     */
+    void panEnvelope(absl::Span<float> panSpan) noexcept;
     /**
      * @brief Amplitude stage for a mono source
      *
@@ -136,6 +160,27 @@ struct Voice::Impl
      */
     void filterStageMono(AudioSpan<float> buffer) noexcept;
     void filterStageStereo(AudioSpan<float> buffer) noexcept;
+    /**
+     * @brief Schedule the filters of the voice in the filter batches, which
+     * process the buffer in place
+     *
+     * @param buffer
+     */
+    void filterStageBatched(AudioSpan<float> buffer) noexcept;
+    /**
+     * @brief Fill the buffer with the source data, and apply the stages
+     * before the filters
+     *
+     * @param buffer
+     */
+    void renderUpToFilters(AudioSpan<float> buffer) noexcept;
+    /**
+     * @brief Update the state, the power and the age of the voice at the end
+     * of a block
+     *
+     * @param buffer
+     */
+    void finishBlock(AudioSpan<float> buffer) noexcept;
     /**
      * @brief Compute the pitch envelope. This envelope is meant to multiply
      * the frequency parameter for each sample (which translates to floating
@@ -247,6 +292,8 @@ struct Voice::Impl
     uint32_t count_ { 1 };
     int sampleEnd_ { 0 };
     int sampleSize_ { 0 };
+    // Frames of the source data per frame of the file
+    int oversampling_ { 1 };
 
     struct {
         int start { 0 };
@@ -259,6 +306,16 @@ struct Voice::Impl
     } loop_;
 
     FileDataHolder currentPromise_;
+    // Decoded frames of the current window, when the sample is encoded;
+    // empty unless encoded samples are enabled on this voice
+    AudioBuffer<float, 2> decodedWindow_;
+
+    // The block and the pan of a mono source, kept while the filter batches
+    // run; empty unless filter batching is enabled on this voice
+    AudioBuffer<float, 2> batchBuffer_;
+    Buffer<float> batchPan_;
+    size_t batchFrames_ { 0 };
+    bool filtersBatched_ { false };
 
     int samplesPerBlock_ { config::defaultSamplesPerBlock };
     float sampleRate_ { config::defaultSampleRate };
@@ -442,6 +499,16 @@ bool Voice::startVoice(Layer* layer, int delay, const TriggerEvent& event) noexc
 
     impl.updateExtendedCCValues();
 
+    // do Scala retuning and reconvert the frequency into a 12TET key number
+    Tuning& tuning = resources.getTuning();
+    const float numberRetuned = tuning.getKeyFractional12TET(impl.triggerEvent_.number);
+
+    impl.pitchRatio_ = basePitchVariation(region, numberRetuned, impl.triggerEvent_.value, midiState, curveSet);
+
+    // apply stretch tuning if set
+    if (absl::optional<StretchTuning>& stretch = resources.getStretch())
+        impl.pitchRatio_ *= stretch->getRatioForFractionalKey(numberRetuned);
+
     if (region.isOscillator()) {
         WavetablePool& wavePool = resources.getWavePool();
         const WavetableMulti* wave = nullptr;
@@ -478,26 +545,23 @@ bool Voice::startVoice(Layer* layer, int delay, const TriggerEvent& event) noexc
         impl.setupOscillatorUnison();
     } else {
         FilePool& filePool = resources.getFilePool();
-        impl.currentPromise_ = filePool.getFilePromise(region.sampleId);
+        // The loads of the voices that run out of preloaded frames first are
+        // served first
+        const auto offset = static_cast<int64_t>(sampleOffset(region, midiState));
+        const TimePoint startTime = highResNow()
+            + std::chrono::duration_cast<TimePoint::duration>(Duration(impl.initialDelay_ / impl.sampleRate_));
+        impl.currentPromise_ = filePool.getFilePromise(region.sampleId, startTime, offset, impl.pitchRatio_);
         if (!impl.currentPromise_) {
             impl.switchState(State::cleanMeUp);
             return false;
         }
+        impl.oversampling_ = static_cast<int>(impl.currentPromise_->oversamplingFactor);
         impl.updateLoopInformation();
-        impl.speedRatio_ = static_cast<float>(impl.currentPromise_->information.sampleRate / impl.sampleRate_);
-        impl.sourcePosition_ = sampleOffset(region, midiState);
+        impl.speedRatio_ = static_cast<float>(
+            impl.oversampling_ * impl.currentPromise_->information.sampleRate / impl.sampleRate_);
+        impl.sourcePosition_ = impl.oversampling_ * static_cast<int>(sampleOffset(region, midiState));
     }
 
-    // do Scala retuning and reconvert the frequency into a 12TET key number
-    Tuning& tuning = resources.getTuning();
-    const float numberRetuned = tuning.getKeyFractional12TET(impl.triggerEvent_.number);
-
-    impl.pitchRatio_ = basePitchVariation(region, numberRetuned, impl.triggerEvent_.value, midiState, curveSet);
-
-    // apply stretch tuning if set
-    if (absl::optional<StretchTuning>& stretch = resources.getStretch())
-        impl.pitchRatio_ *= stretch->getRatioForFractionalKey(numberRetuned);
-
     impl.pitchKeycenter_ = region.pitchKeycenter;
     impl.baseVolumedB_ = baseVolumedB(region, midiState, impl.triggerEvent_.number);
     impl.baseGain_ = region.getBaseGain();
@@ -511,12 +575,24 @@ bool Voice::startVoice(Layer* layer, int delay, const TriggerEvent& event) noexc
         impl.filters_[i].setup(region, i, impl.triggerEvent_.number, impl.triggerEvent_.value);
     }
 
+    // The filters run in the batches if they all fit there, or all on the voice
+    impl.filtersBatched_ = !impl.batchBuffer_.empty() && FilterBatches::canBatch(region);
+    FilterBatches& filterBatches = resources.getFilterBatches();
+    for (unsigned i = 0; i < region.filters.size() && impl.filtersBatched_; ++i) {
+        FilterBatch* batch = filterBatches.getBatch(i);
+        impl.filtersBatched_ = batch && impl.filters_[i].joinBatch(*batch);
+    }
+    if (!impl.filtersBatched_) {
+        for (unsigned i = 0; i < region.filters.size(); ++i)
+            impl.filters_[i].leaveBatch();
+    }
+
     for (unsigned i = 0; i < region.equalizers.size(); ++i) {
         impl.equalizers_[i].setup(region, i, impl.triggerEvent_.value);
     }
 
     impl.baseFrequency_ = tuning.getFrequencyOfKey(impl.triggerEvent_.number);
-    impl.sampleEnd_ = int(sampleEnd(region, midiState));
+    impl.sampleEnd_ = impl.oversampling_ * int(sampleEnd(region, midiState));
     impl.sampleSize_ = impl.sampleEnd_- impl.sourcePosition_ - 1;
     impl.bendSmoother_.setSmoothing(region.bendSmooth, impl.sampleRate_);
     impl.bendSmoother_.reset(region.getBendInCents(midiState.getPitchBend()));
@@ -771,6 +847,13 @@ void Voice::setSamplesPerBlock(int samplesPerBlock) noexcept
     Impl& impl = *impl_;
     impl.samplesPerBlock_ = samplesPerBlock;
     impl.powerFollower_.setSamplesPerBlock(samplesPerBlock);
+
+    if (!impl.batchBuffer_.empty()) {
+        impl.batchBuffer_ = AudioBuffer<float, 2>(2, samplesPerBlock);
+        impl.batchPan_.resize(samplesPerBlock);
+        for (auto& filter : impl.filters_)
+            filter.setBatchBlockSize(samplesPerBlock);
+    }
 }
 
 void Voice::renderBlock(AudioSpan<float, 2> buffer) noexcept
@@ -783,52 +866,104 @@ void Voice::renderBlock(AudioSpan<float, 2> buffer) noexcept
     if (region == nullptr || region->disabled())
         return;
 
-    const auto delay = min(static_cast<size_t>(impl.initialDelay_), buffer.getNumFrames());
+    impl.renderUpToFilters(buffer);
+
+    if (region->isStereo()) {
+        impl.filterStageStereo(buffer);
+    } else {
+        impl.filterStageMono(buffer);
+        impl.panStageMono(buffer);
+    }
+
+    impl.finishBlock(buffer);
+
+#if 0
+    ASSERT(!hasNanInf(buffer.getConstSpan(0)));
+    ASSERT(!hasNanInf(buffer.getConstSpan(1)));
+    SFIZZ_CHECK(isReasonableAudio(buffer.getConstSpan(0)));
+    SFIZZ_CHECK(isReasonableAudio(buffer.getConstSpan(1)));
+#endif
+}
+
+bool Voice::renderBlockBeforeFilterBatch(size_t numFrames) noexcept
+{
+    Impl& impl = *impl_;
+    ASSERT(static_cast<int>(numFrames) <= impl.samplesPerBlock_);
+
+    const Region* region = impl.region_;
+    if (!impl.filtersBatched_ || region == nullptr || region->disabled())
+        return false;
+
+    auto buffer = AudioSpan<float>(impl.batchBuffer_).first(numFrames);
+    buffer.fill(0.0f);
+    impl.batchFrames_ = numFrames;
+
+    impl.renderUpToFilters(buffer);
+    impl.filterStageBatched(buffer);
+
+    // The pan follows the filters, but its modulation is only readable now
+    if (!region->isStereo())
+        impl.panEnvelope(absl::MakeSpan(impl.batchPan_).first(numFrames));
+
+    return true;
+}
+
+AudioSpan<float> Voice::renderBlockAfterFilterBatch() noexcept
+{
+    Impl& impl = *impl_;
+    ASSERT(impl.filtersBatched_);
+
+    const size_t numFrames = impl.batchFrames_;
+    auto buffer = AudioSpan<float>(impl.batchBuffer_).first(numFrames);
+
+    if (!impl.region_->isStereo())
+        impl.panStageMono(buffer, absl::MakeConstSpan(impl.batchPan_).first(numFrames));
+
+    impl.finishBlock(buffer);
+    return buffer;
+}
+
+void Voice::Impl::renderUpToFilters(AudioSpan<float> buffer) noexcept
+{
+    const auto delay = min(static_cast<size_t>(initialDelay_), buffer.getNumFrames());
     auto delayed_buffer = buffer.subspan(delay);
-    impl.initialDelay_ -= static_cast<int>(delay);
+    initialDelay_ -= static_cast<int>(delay);
 
     { // Fill buffer with raw data
-        ScopedTiming logger { impl.dataDuration_ };
-        if (region->isOscillator())
-            impl.fillWithGenerator(delayed_buffer);
+        ScopedTiming logger { dataDuration_ };
+        if (region_->isOscillator())
+            fillWithGenerator(delayed_buffer);
         else
-            impl.fillWithData(delayed_buffer);
+            fillWithData(delayed_buffer);
     }
 
-    if (region->isStereo()) {
-        impl.ampStageStereo(buffer);
-        impl.panStageStereo(buffer);
-        impl.filterStageStereo(buffer);
+    if (region_->isStereo()) {
+        ampStageStereo(buffer);
+        panStageStereo(buffer);
     } else {
-        impl.ampStageMono(buffer);
-        impl.filterStageMono(buffer);
-        impl.panStageMono(buffer);
+        ampStageMono(buffer);
     }
+}
 
-    if (!region->flexAmpEG) {
-        if (!impl.egAmplitude_.isSmoothing())
-            impl.switchState(State::cleanMeUp);
+void Voice::Impl::finishBlock(AudioSpan<float> buffer) noexcept
+{
+    if (!region_->flexAmpEG) {
+        if (!egAmplitude_.isSmoothing())
+            switchState(State::cleanMeUp);
     }
     else {
-        if (impl.flexEGs_[*region->flexAmpEG]->isFinished())
-            impl.switchState(State::cleanMeUp);
+        if (flexEGs_[*region_->flexAmpEG]->isFinished())
+            switchState(State::cleanMeUp);
     }
 
-    impl.powerFollower_.process(buffer);
+    powerFollower_.process(buffer);
 
-    impl.age_ += buffer.getNumFrames();
-    if (impl.triggerDelay_) {
+    age_ += buffer.getNumFrames();
+    if (triggerDelay_) {
         // Should be OK but just in case;
-        impl.age_ = min(impl.age_ - *impl.triggerDelay_, 0);
-        impl.triggerDelay_ = absl::nullopt;
+        age_ = min(age_ - *triggerDelay_, 0);
+        triggerDelay_ = absl::nullopt;
     }
-
-#if 0
-    ASSERT(!hasNanInf(buffer.getConstSpan(0)));
-    ASSERT(!hasNanInf(buffer.getConstSpan(1)));
-    SFIZZ_CHECK(isReasonableAudio(buffer.getConstSpan(0)));
-    SFIZZ_CHECK(isReasonableAudio(buffer.getConstSpan(1)));
-#endif
 }
 
 void Voice::Impl::resetCrossfades() noexcept
@@ -954,32 +1089,41 @@ void Voice::Impl::ampStageStereo(AudioSpan<float> buffer) noexcept
     buffer.applyGain(*modulationSpan);
 }
 
-void Voice::Impl::panStageMono(AudioSpan<float> buffer) noexcept
+void Voice::Impl::panEnvelope(absl::Span<float> panSpan) noexcept
 {
-    ScopedTiming logger { panningDuration_ };
+    ModMatrix& mm = resources_.getModMatrix();
 
-    const auto numSamples = buffer.getNumFrames();
-    const auto leftBuffer = buffer.getSpan(0);
-    const auto rightBuffer = buffer.getSpan(1);
+    fill(panSpan, region_->pan);
+    if (float* mod = mm.getModulation(panTarget_)) {
+        for (size_t i = 0; i < panSpan.size(); ++i)
+            panSpan[i] += mod[i];
+    }
+}
 
+void Voice::Impl::panStageMono(AudioSpan<float> buffer) noexcept
+{
     BufferPool& bufferPool = resources_.getBufferPool();
 
-    auto modulationSpan = bufferPool.getBuffer(numSamples);
+    auto modulationSpan = bufferPool.getBuffer(buffer.getNumFrames());
     if (!modulationSpan)
         return;
 
-    ModMatrix& mm = resources_.getModMatrix();
+    panEnvelope(*modulationSpan);
+    panStageMono(buffer, *modulationSpan);
+}
+
+void Voice::Impl::panStageMono(AudioSpan<float> buffer, absl::Span<const float> panSpan) noexcept
+{
+    ScopedTiming logger { panningDuration_ };
+
+    const auto leftBuffer = buffer.getSpan(0);
+    const auto rightBuffer = buffer.getSpan(1);
 
     // Prepare for stereo output
     copy<float>(leftBuffer, rightBuffer);
 
     // Apply panning
-    fill(*modulationSpan, region_->pan);
-    if (float* mod = mm.getModulation(panTarget_)) {
-        for (size_t i = 0; i < numSamples; ++i)
-            (*modulationSpan)[i] += mod[i];
-    }
-    pan(*modulationSpan, leftBuffer, rightBuffer);
+    pan(panSpan, leftBuffer, rightBuffer);
 
     // add +3dB (10^(3/20)) to compensate for the pan stage (-3dB per stage)
     applyGain1(1.4125375446227544f, leftBuffer);
@@ -1064,6 +1208,21 @@ void Voice::Impl::filterStageStereo(AudioSpan<float> buffer) noexcept
     }
 }
 
+void Voice::Impl::filterStageBatched(AudioSpan<float> buffer) noexcept
+{
+    ScopedTiming logger { filterDuration_ };
+    const auto numSamples = buffer.getNumFrames();
+    const auto leftBuffer = buffer.getSpan(0);
+    const auto rightBuffer = buffer.getSpan(1);
+
+    const float* inputChannels[2] { leftBuffer.data(), rightBuffer.data() };
+    float* outputChannels[2] { leftBuffer.data(), rightBuffer.data() };
+
+    for (unsigned i = 0; i < region_->filters.size(); ++i) {
+        filters_[i].scheduleBatch(inputChannels, outputChannels, numSamples);
+    }
+}
+
 void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
 {
     const size_t numSamples = buffer.getNumFrames();
@@ -1075,8 +1234,16 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
         return;
     }
 
-    auto source = currentPromise_->getData();
-    if (source.getNumFrames() == 0) {
+    const bool isEncoded = currentPromise_->isEncoded();
+    AudioSpan<const float> source;
+    EncodedAudioSpan encodedSource;
+    if (isEncoded)
+        encodedSource = currentPromise_->getEncodedData();
+    else
+        source = currentPromise_->getData();
+
+    const size_t numSourceFrames = isEncoded ? encodedSource.getNumFrames() : source.getNumFrames();
+    if (numSourceFrames == 0) {
         DBG("[Voice] Empty source in promise");
         return;
     }
@@ -1118,7 +1285,7 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
     const auto loop = this->loop_;
 
     // Looping logic
-    const bool hasLoopSamples = static_cast<size_t>(loop.end) < source.getNumFrames();
+    const bool hasLoopSamples = static_cast<size_t>(loop.end) < numSourceFrames;
     const bool loopCountReached = region_->loopCount && loop_.restarts >= *region_->loopCount;
     const bool loopContinuous = (region_->loopMode == LoopMode::loop_continuous);
     const bool loopSustain = (region_->loopMode == LoopMode::loop_sustain) && !released();
@@ -1162,7 +1329,7 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
         numPartitions = 1;
     }
 
-    const auto sampleEnd = min( int(sampleEnd_), int(currentPromise_->information.end), int(source.getNumFrames())) - 1;
+    const auto sampleEnd = min( int(sampleEnd_), oversampling_ * int(currentPromise_->information.end), int(numSourceFrames)) - 1;
 
     int blockRestarts { 0 };
     int oldIndex {};
@@ -1226,6 +1393,13 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
                     continue;
                 }
 
+                // Played past the frames streamed so far rather than the end
+                // of the sample; the voice keeps hitting the end while it fades
+                // out, so it is only counted once
+                if (!offed_ && !currentPromise_->fullyLoaded
+                    && sampleEnd < min(int(sampleEnd_), oversampling_ * int(currentPromise_->information.end)) - 1)
+                    resources_.getFilePool().countStreamUnderrun();
+
                 off(int(i), true);
                 fill<int>(indices->subspan(i), sampleEnd);
                 fill<float>(coeffs->subspan(i), 0x1.fffffep-1);
@@ -1249,8 +1423,12 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
         absl::Span<const int> ptIndices = indices->subspan(ptStart, ptSize);
         absl::Span<const float> ptCoeffs = coeffs->subspan(ptStart, ptSize);
 
-        fillInterpolatedWithQuality<false>(
-            source, ptBuffer, ptIndices, ptCoeffs, {}, quality);
+        if (isEncoded)
+            fillInterpolatedFromEncoded<false>(
+                encodedSource, ptBuffer, ptIndices, ptCoeffs, {}, quality);
+        else
+            fillInterpolatedWithQuality<false>(
+                source, ptBuffer, ptIndices, ptCoeffs, {}, quality);
 
         if (ptType == kPartitionLoopXfade) {
             auto xfTemp1 = bufferPool.getBuffer(numSamples);
@@ -1339,8 +1517,12 @@ void Voice::Impl::fillWithData(AudioSpan<float> buffer) noexcept
                         xfCurve[i] = clamp(xfInCurvePos[i], 0.0f, 1.0f);
                 }
                 // apply in curve
-                fillInterpolatedWithQuality<true>(
-                    source, xfInBuffer, xfInIndices, xfInCoeffs, xfCurve, quality);
+                if (isEncoded)
+                    fillInterpolatedFromEncoded<true>(
+                        encodedSource, xfInBuffer, xfInIndices, xfInCoeffs, xfCurve, quality);
+                else
+                    fillInterpolatedWithQuality<true>(
+                        source, xfInBuffer, xfInIndices, xfInCoeffs, xfCurve, quality);
             }
         }
     }
@@ -1480,6 +1662,63 @@ void Voice::Impl::fillInterpolatedWithQuality(
     }
 }
 
+template <bool Adding>
+void Voice::Impl::fillInterpolatedFromEncoded(
+    const EncodedAudioSpan& source, const AudioSpan<float>& dest,
+    absl::Span<const int> indices, absl::Span<const float> coeffs,
+    absl::Span<const float> addingGains, int quality) noexcept
+{
+    if (decodedWindow_.empty()) {
+        DBG("[Voice] No decoding window for an encoded sample");
+        return;
+    }
+
+    auto windowIndices = resources_.getBufferPool().getIndexBuffer(indices.size());
+    if (!windowIndices)
+        return;
+
+    const size_t numChannels = source.getNumChannels();
+    constexpr int maxSpread = config::encodedWindowFrames - 1;
+    size_t chunkStart = 0;
+    while (chunkStart < indices.size()) {
+        // Take as many positions as fit in a window
+        int first = indices[chunkStart];
+        int last = first;
+        size_t chunkEnd = chunkStart + 1;
+        while (chunkEnd < indices.size()) {
+            const int index = indices[chunkEnd];
+            if (max(last, index) - min(first, index) > maxSpread)
+                break;
+            first = min(first, index);
+            last = max(last, index);
+            ++chunkEnd;
+        }
+        const size_t chunkSize = chunkEnd - chunkStart;
+
+        // Decode the window, with room for the interpolator on either side
+        const int windowStart = first - config::excessFileFrames;
+        const size_t windowFrames = static_cast<size_t>(last - first + 1 + 2 * config::excessFileFrames);
+        const float* channels[2] = { nullptr, nullptr };
+        for (size_t c = 0; c < numChannels; ++c) {
+            absl::Span<float> window = decodedWindow_.getSpan(c).first(windowFrames);
+            source.read(c, windowStart, window);
+            channels[c] = window.data();
+        }
+
+        absl::Span<int> shiftedIndices = windowIndices->subspan(chunkStart, chunkSize);
+        for (size_t i = 0; i < chunkSize; ++i)
+            shiftedIndices[i] = indices[chunkStart + i] - windowStart;
+
+        fillInterpolatedWithQuality<Adding>(
+            AudioSpan<const float>(channels, numChannels, 0, windowFrames),
+            dest.subspan(chunkStart, chunkSize), shiftedIndices,
+            coeffs.subspan(chunkStart, chunkSize),
+            Adding ? addingGains.subspan(chunkStart, chunkSize) : addingGains, quality);
+
+        chunkStart = chunkEnd;
+    }
+}
+
 const Curve& Voice::Impl::getSCurve()
 {
     static const Curve curve = []() -> Curve {
@@ -1705,12 +1944,14 @@ void Voice::reset() noexcept
     impl.region_ = nullptr;
     impl.currentPromise_.reset();
     impl.sourcePosition_ = 0;
+    impl.oversampling_ = 1;
     impl.age_ = 0;
     impl.count_ = 1;
     impl.floatPositionOffset_ = 0.0f;
     impl.noteIsOff_ = false;
     impl.sostenutoState_ = Impl::SostenutoState::Up;
     impl.offed_ = false;
+    impl.filtersBatched_ = false;
 
     impl.resetLoopInformation();
 
@@ -1747,10 +1988,12 @@ void Voice::Impl::updateLoopInformation() noexcept
     const Region& region = *region_;
     MidiState& midiState = resources_.getMidiState();
     const FileInformation& info = currentPromise_->information;
-    const double rate = info.sampleRate;
+    const double rate = oversampling_ * info.sampleRate;
 
-    loop_.start = static_cast<int>(loopStart(region, midiState));
-    loop_.end = max(static_cast<int>(loopEnd(region, midiState)), loop_.start);
+    // The loop end is the last frame of the loop, so at a higher rate it
+    // spans to the last oversampled frame of that file frame
+    loop_.start = oversampling_ * static_cast<int>(loopStart(region, midiState));
+    loop_.end = max(oversampling_ * static_cast<int>(loopEnd(region, midiState) + 1) - 1, loop_.start);
     loop_.size = loop_.end + 1 - loop_.start;
     loop_.xfSize = static_cast<int>(lroundPositive(region.loopCrossfade * rate));
     // Clamp the crossfade to the part available before the loop starts
@@ -1806,8 +2049,12 @@ void Voice::setMaxFiltersPerVoice(size_t numFilters)
         return;
 
     impl.filters_.clear();
-    for (unsigned i = 0; i < numFilters; ++i)
+    impl.filtersBatched_ = false;
+    for (unsigned i = 0; i < numFilters; ++i) {
         impl.filters_.emplace_back(impl.resources_);
+        if (!impl.batchBuffer_.empty())
+            impl.filters_.back().setBatchBlockSize(impl.samplesPerBlock_);
+    }
 }
 
 void Voice::setMaxEQsPerVoice(size_t numFilters)
@@ -1880,6 +2127,36 @@ void Voice::setAmplitudeLFOEnabledPerVoice(bool haveAmplitudeLFO)
         impl.lfoAmplitude_.reset();
 }
 
+void Voice::setEncodedSamplesEnabledPerVoice(bool haveEncodedSamples)
+{
+    Impl& impl = *impl_;
+    if (!haveEncodedSamples)
+        impl.decodedWindow_.reset();
+    else if (impl.decodedWindow_.empty())
+        impl.decodedWindow_ = AudioBuffer<float, 2>(2, config::encodedWindowFrames + 2 * config::excessFileFrames);
+}
+
+void Voice::setFilterBatchingEnabledPerVoice(bool haveFilterBatching)
+{
+    Impl& impl = *impl_;
+    if (haveFilterBatching == !impl.batchBuffer_.empty())
+        return;
+
+    if (haveFilterBatching) {
+        impl.batchBuffer_ = AudioBuffer<float, 2>(2, impl.samplesPerBlock_);
+        impl.batchPan_.resize(impl.samplesPerBlock_);
+    } else {
+        impl.batchBuffer_.reset();
+        impl.batchPan_.clear();
+        impl.filtersBatched_ = false;
+    }
+
+    for (auto& filter : impl.filters_) {
+        filter.leaveBatch();
+        filter.setBatchBlockSize(haveFilterBatching ? impl.samplesPerBlock_ : 0);
+    }
+}
+
 void Voice::setPitchLFOEnabledPerVoice(bool havePitchLFO)
 {
     Impl& impl = *impl_;
@@ -2083,7 +2360,7 @@ int Voice::getRemainingDelay() const noexcept
 int Voice::getSourcePosition() const noexcept
 {
     Impl& impl = *impl_;
-    return impl.sourcePosition_;
+    return impl.sourcePosition_ / impl.oversampling_;
 }
 
 unsigned Voice::getStartTimestampSamples() const noexcept
@@ -197,6 +197,25 @@ public:
      * @param buffer
      */
     void renderBlock(AudioSpan<float, 2> buffer) noexcept;
+    /**
+     * @brief Render a block of data for this voice up to its filters, into a
+     * buffer of the voice, if its filters run in the filter batches. The
+     * filters are then scheduled in the batches, and the block is completed
+     * by renderBlockAfterFilterBatch() once the batches are processed.
+     *
+     * This reads the modulations of the voice like renderBlock().
+     *
+     * @param numFrames
+     * @return true if the voice was scheduled, false if it renders with
+     * renderBlock()
+     */
+    bool renderBlockBeforeFilterBatch(size_t numFrames) noexcept;
+    /**
+     * @brief Complete the block that renderBlockBeforeFilterBatch() scheduled.
+     *
+     * @return the block, valid until the next block of the voice
+     */
+    AudioSpan<float> renderBlockAfterFilterBatch() noexcept;
 
     /**
      * @brief Is the voice free?
@@ -358,6 +377,22 @@ public:
      * @param haveFilterLFO
      */
     void setFilterLFOEnabledPerVoice(bool haveFilterLFO);
+    /**
+     * @brief Set whether this voice may read encoded or mapped samples, which
+     * it decodes through a window of float frames. The window is only
+     * allocated when enabled.
+     *
+     * @param haveEncodedSamples
+     */
+    void setEncodedSamplesEnabledPerVoice(bool haveEncodedSamples);
+    /**
+     * @brief Set whether this voice may run its filters in the filter
+     * batches, which process the filters of all voices together. The block
+     * buffer of the voice for the batches is only allocated when enabled.
+     *
+     * @param haveFilterBatching
+     */
+    void setFilterBatchingEnabledPerVoice(bool haveFilterBatching);
     /**
      * @brief Release the voice after a given delay
      *
@@ -18,7 +18,7 @@ void VoiceManager::onVoiceStateChanging(NumericId<Voice> id, Voice::State state)
         const Region* region = voice->getRegion();
         const uint32_t group = region->group;
         RegionSet::removeVoiceFromHierarchy(region, voice);
-        swapAndPopFirst(activeVoices_, [voice](const Voice* v) { return v == voice; });
+        removeActiveVoice(voice);
         ASSERT(polyphonyGroups_.contains(group));
         polyphonyGroups_[group].removeVoice(voice);
     } else if (state == Voice::State::playing) {
@@ -65,22 +65,35 @@ void VoiceManager::reset()
     setStealingAlgorithm(StealingAlgorithm::Oldest);
 }
 
+void VoiceManager::removeActiveVoice(const Voice* voice) noexcept
+{
+    const auto it = absl::c_find(activeVoices_, voice);
+    if (it == activeVoices_.end())
+        return;
+
+    // Erase rather than swap and pop, so the others stay in the order they
+    // started, and step back any iteration that is at or past the voice
+    const size_t index = static_cast<size_t>(it - activeVoices_.begin());
+    for (ActiveVoiceCursor* cursor = cursors_; cursor != nullptr; cursor = cursor->next) {
+        if (index <= cursor->index)
+            --cursor->index;
+    }
+
+    activeVoices_.erase(it);
+}
+
 bool VoiceManager::playingAttackVoice(const Region* releaseRegion) noexcept
 {
-    const auto compatibleVoice = [releaseRegion](const Voice& v) -> bool {
-        const TriggerEvent& event = v.getTriggerEvent();
+    const auto compatibleVoice = [releaseRegion](const Voice* v) -> bool {
+        const TriggerEvent& event = v->getTriggerEvent();
         return (
-            !v.isFree()
-            && event.type == TriggerEventType::NoteOn
+            event.type == TriggerEventType::NoteOn
             && releaseRegion->keyRange.containsWithEnd(event.number)
             && releaseRegion->velocityRange.containsWithEnd(event.value)
         );
     };
 
-    if (absl::c_find_if(list_, compatibleVoice) == list_.end())
-        return false;
-    else
-        return true;
+    return absl::c_any_of(activeVoices_, compatibleVoice);
 }
 
 void VoiceManager::ensureNumPolyphonyGroups(int groupIdx) noexcept
@@ -155,16 +168,19 @@ void VoiceManager::checkPolyphony(const Region* region, int delay, const Trigger
 
 Voice* VoiceManager::findFreeVoice() noexcept
 {
-    Voice* freeVoice = nullptr;
-    for (auto& v: list_) {
-        if (v.isFree()) {
-            freeVoice = &v;
-            break;
+    // Every voice that is not active is free
+    if (activeVoices_.size() < list_.size()) {
+        for (auto& v: list_) {
+            if (v.isFree())
+                return &v;
         }
+    }
 
-        if (v.offedOrFree()) {
-            if (freeVoice == nullptr || v.getAge() > freeVoice->getAge())
-                freeVoice = &v;
+    Voice* freeVoice = nullptr;
+    for (Voice* v: activeVoices_) {
+        if (v->offedOrFree()) {
+            if (freeVoice == nullptr || v->getAge() > freeVoice->getAge())
+                freeVoice = v;
         }
     };
 
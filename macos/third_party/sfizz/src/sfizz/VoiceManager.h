@@ -87,6 +87,26 @@ struct VoiceManager final : public Voice::StateListener
      */
     std::vector<const Voice*> getActiveVoices() const noexcept;
 
+    /**
+     * @brief Call a function on each active voice, in the order they started.
+     * Voices may start and stop during the call: a voice that stops is not
+     * visited again, and one that starts is visited after the others. Calls
+     * can be nested.
+     *
+     * @param function
+     */
+    template <class F>
+    void forEachActiveVoice(F&& function)
+    {
+        ActiveVoiceCursor cursor { 0, cursors_ };
+        cursors_ = &cursor;
+
+        for (; cursor.index < activeVoices_.size(); ++cursor.index)
+            function(*activeVoices_[cursor.index]);
+
+        cursors_ = cursor.next;
+    }
+
     /**
      * @brief Clear all voices and polyphony groups.
      * Also resets the stealing algorithm to default.
@@ -150,14 +170,30 @@ struct VoiceManager final : public Voice::StateListener
     bool withinValidTimerRange(const Region* region, unsigned timestampSamples, float sampleRate) const noexcept;
 
 private:
+    // Where a forEachActiveVoice() call is in activeVoices_. The cursors of
+    // nested calls are chained, so removing a voice can move all of them.
+    struct ActiveVoiceCursor {
+        size_t index;
+        ActiveVoiceCursor* next;
+    };
+
     int numRequiredVoices_ { config::numVoices };
     std::vector<Voice> list_;
+    // The voices that are not idle, in the order they started
     std::vector<Voice*> activeVoices_;
+    ActiveVoiceCursor* cursors_ { nullptr };
     std::vector<Voice*> temp_;
     // These are the `group=` groups where you can off voices
     absl::flat_hash_map<int, PolyphonyGroup> polyphonyGroups_;
     std::unique_ptr<VoiceStealer> stealer_ { absl::make_unique<OldestStealer>() };
 
+    /**
+     * @brief Remove a voice from the active voices, if it is there
+     *
+     * @param voice
+     */
+    void removeActiveVoice(const Voice* voice) noexcept;
+
     /**
      * @brief Check the region polyphony, releasing voices if necessary
      *
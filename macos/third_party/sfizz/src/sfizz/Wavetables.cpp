@@ -8,8 +8,13 @@
 #include "FilePool.h"
 #include "Interpolators.h"
 #include "MathHelpers.h"
+#include "utility/StringViewHelpers.h"
 #include "absl/meta/type_traits.h"
+#include <absl/strings/str_cat.h>
 #include <kiss_fftr.h>
+#include <cstring>
+#include <thread>
+#include <vector>
 
 namespace sfz {
 
@@ -362,14 +367,15 @@ MipmapRange MipmapRange::getRangeForFrequency(float f)
 constexpr unsigned WavetableMulti::_tableExtra;
 
 WavetableMulti WavetableMulti::createForHarmonicProfile(
-    const HarmonicProfile& hp, double amplitude, unsigned tableSize, double refSampleRate)
+    const HarmonicProfile& hp, double amplitude, unsigned tableSize, double refSampleRate,
+    FilePool* filePool)
 {
     WavetableMulti wm;
     constexpr unsigned numTables = WavetableMulti::numTables();
 
     wm.allocateStorage(tableSize);
 
-    for (unsigned m = 0; m < numTables; ++m) {
+    auto generateTable = [&](size_t m) {
         MipmapRange range = MipmapRange::getRangeForIndex(m);
 
         double freq = range.maxFrequency;
@@ -383,6 +389,14 @@ WavetableMulti WavetableMulti::createForHarmonicProfile(
         absl::Span<float> table(ptr, tableSize);
 
         hp.generate(table, amplitude, cutoff);
+    };
+
+    // the tables are independent, so they can be generated on the loading threads
+    if (filePool)
+        filePool->runOnLoadingThreads(numTables, generateTable);
+    else {
+        for (unsigned m = 0; m < numTables; ++m)
+            generateTable(m);
     }
 
     wm.fillExtra();
@@ -440,6 +454,73 @@ void WavetableMulti::fillExtra()
     }
 }
 
+// The cache files are meant to stay on the machine which wrote them, so
+// numbers are stored in native byte order.
+static constexpr char wavetableCacheMagic[] = { 'S', 'F', 'Z', 'W' };
+// Increment whenever the format, or how the tables are computed, changes
+static constexpr uint32_t wavetableCacheVersion = 1;
+
+bool WavetableMulti::readCacheFile(const fs::path& path, uint64_t key)
+{
+    fs::ifstream stream(path, std::ios::binary);
+    if (!stream)
+        return false;
+
+    char magic[sizeof(wavetableCacheMagic)];
+    uint32_t version;
+    uint64_t storedKey;
+    uint32_t tableSize;
+    uint32_t storedNumTables;
+    stream.read(magic, sizeof(magic));
+    stream.read(reinterpret_cast<char*>(&version), sizeof(version));
+    stream.read(reinterpret_cast<char*>(&storedKey), sizeof(storedKey));
+    stream.read(reinterpret_cast<char*>(&tableSize), sizeof(tableSize));
+    stream.read(reinterpret_cast<char*>(&storedNumTables), sizeof(storedNumTables));
+    if (!stream || std::memcmp(magic, wavetableCacheMagic, sizeof(magic)) != 0
+        || version != wavetableCacheVersion || storedKey != key
+        || storedNumTables != numTables() || tableSize == 0)
+        return false;
+
+    allocateStorage(tableSize);
+    const auto numBytes = static_cast<std::streamsize>(_multiData.size() * sizeof(float));
+    stream.read(reinterpret_cast<char*>(_multiData.data()), numBytes);
+    return stream.gcount() == numBytes && stream.peek() == std::char_traits<char>::eof();
+}
+
+void WavetableMulti::writeCacheFile(const fs::path& path, uint64_t key) const
+{
+    const uint32_t version = wavetableCacheVersion;
+    const uint32_t tableSize = _tableSize;
+    const uint32_t storedNumTables = numTables();
+
+    // Write aside and rename, so that other instances loading the same
+    // wave never read a partial cache
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+    const fs::path tempPath = absl::StrCat(path.string(), ".",
+        std::hash<std::thread::id>()(std::this_thread::get_id()), ".tmp");
+    {
+        fs::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+        if (!stream)
+            return;
+        stream.write(wavetableCacheMagic, sizeof(wavetableCacheMagic));
+        stream.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        stream.write(reinterpret_cast<const char*>(&key), sizeof(key));
+        stream.write(reinterpret_cast<const char*>(&tableSize), sizeof(tableSize));
+        stream.write(reinterpret_cast<const char*>(&storedNumTables), sizeof(storedNumTables));
+        stream.write(reinterpret_cast<const char*>(_multiData.data()),
+            static_cast<std::streamsize>(_multiData.size() * sizeof(float)));
+        if (!stream.flush()) {
+            stream.close();
+            fs::remove(tempPath, ec);
+            return;
+        }
+    }
+    fs::rename(tempPath, path, ec);
+    if (ec)
+        fs::remove(tempPath, ec);
+}
+
 //------------------------------------------------------------------------------
 
 /**
@@ -533,6 +614,30 @@ bool WavetablePool::createFileWave(FilePool& filePool, const std::string& filena
     if (audioData.size() & 1)
         audioData = absl::MakeConstSpan(audioData.data(), audioData.size() + 1);
 
+    // The cached tables are keyed by the samples they are made of, along
+    // with the settings of the computation
+    uint64_t cacheKey = Fnv1aBasis;
+    fs::path cachePath;
+    if (!_cacheDirectory.empty()) {
+        const auto hashBytes = [&cacheKey](const void* data, size_t size) {
+            const auto* bytes = static_cast<const uint8_t*>(data);
+            for (size_t i = 0; i < size; ++i)
+                cacheKey = hashByte(bytes[i], cacheKey);
+        };
+        const uint32_t tableSize = config::tableSize;
+        const double refSampleRate = config::tableRefSampleRate;
+        hashBytes(audioData.data(), audioData.size() * sizeof(float));
+        hashBytes(&tableSize, sizeof(tableSize));
+        hashBytes(&refSampleRate, sizeof(refSampleRate));
+        cachePath = _cacheDirectory / absl::StrCat(absl::Hex(cacheKey, absl::kZeroPad16), ".wtcache");
+
+        auto wave = std::make_shared<WavetableMulti>();
+        if (wave->readCacheFile(cachePath, cacheKey)) {
+            _fileWaves[filename] = wave;
+            return true;
+        }
+    }
+
     size_t fftSize = audioData.size();
     size_t specSize = fftSize / 2 + 1;
 
@@ -556,7 +661,11 @@ bool WavetablePool::createFileWave(FilePool& filePool, const std::string& filena
     };
 
     auto wave = std::make_shared<WavetableMulti>(
-        WavetableMulti::createForHarmonicProfile(hp, 1.0));
+        WavetableMulti::createForHarmonicProfile(
+            hp, 1.0, config::tableSize, config::tableRefSampleRate, &filePool));
+
+    if (!cachePath.empty())
+        wave->writeCacheFile(cachePath, cacheKey);
 
     _fileWaves[filename] = wave;
     return true;
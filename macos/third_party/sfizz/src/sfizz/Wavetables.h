@@ -11,6 +11,7 @@
 #include "utility/LeakDetector.h"
 #include <absl/types/span.h>
 #include <absl/container/flat_hash_map.h>
+#include <ghc/fs_std.hpp>
 #include <array>
 #include <memory>
 #include <complex>
@@ -213,14 +214,23 @@ public:
     // create a multisample according to a given harmonic profile
     // the reference sample rate is the minimum value accepted by the DSP
     // system (most defavorable wrt. aliasing)
+    // with a file pool, the tables are generated on its loading threads
     static WavetableMulti createForHarmonicProfile(
         const HarmonicProfile& hp, double amplitude,
         unsigned tableSize = config::tableSize,
-        double refSampleRate = config::tableRefSampleRate);
+        double refSampleRate = config::tableRefSampleRate,
+        FilePool* filePool = nullptr);
 
     // get a tiny silent wavetable with null content for use with oscillators
     static const WavetableMulti* getSilenceWavetable();
 
+    // read the tables from a cache file written with the same key,
+    // return false if the file is missing or was written with another key
+    bool readCacheFile(const fs::path& path, uint64_t key);
+
+    // write the tables to a cache file, along with their key
+    void writeCacheFile(const fs::path& path, uint64_t key) const;
+
 private:
     // get a pointer to the beginning of the N-th table
     const float* getTablePointer(unsigned index) const
@@ -274,6 +284,14 @@ struct WavetablePool {
      * @brief Removes all the stored file waves from the wavetable pool.
      */
     void clearFileWaves();
+    /**
+     * @brief Keep the wavetables created from files in a cache in this
+     * directory, so that they are read rather than computed again.
+     * An empty path disables the cache, which is the default.
+     *
+     * @param directory
+     */
+    void setCacheDirectory(const fs::path& directory) { _cacheDirectory = directory; }
 
     static const WavetableMulti* getWaveSin();
     static const WavetableMulti* getWaveTriangle();
@@ -282,6 +300,7 @@ struct WavetablePool {
 
 private:
     absl::flat_hash_map<std::string, std::shared_ptr<WavetableMulti>> _fileWaves;
+    fs::path _cacheDirectory;
 };
 
 } // namespace sfz
@@ -20,6 +20,12 @@
 
 namespace sfz {
 
+static bool isConstantBuffer(absl::Span<const float> buffer)
+{
+    return std::all_of(buffer.begin(), buffer.end(),
+        [&buffer](float value) { return value == buffer.front(); });
+}
+
 struct ModMatrix::Impl {
     double sampleRate_ {};
     uint32_t samplesPerBlock_ {};
@@ -30,10 +36,18 @@ struct ModMatrix::Impl {
 
     float currentVoiceTriggerValue_ {};
 
+    // The buffers are ready when their stamp is the one of the current cycle,
+    // or of the current voice for the per-voice buffers, so that starting a
+    // cycle or a voice does not go through the sources and targets
+    uint32_t cycleStamp_ { 1 };
+    uint32_t voiceStamp_ { 1 };
+
     struct Source {
         ModKey key;
         ModGenerator* gen {};
-        bool bufferReady {};
+        uint32_t readyStamp {};
+        // All the frames of the buffer have the same value
+        bool constant {};
         Buffer<float> buffer;
     };
 
@@ -48,10 +62,35 @@ struct ModMatrix::Impl {
         ModKey key;
         uint32_t region {};
         absl::flat_hash_map<uint32_t, ConnectionData> connectedSources;
-        bool bufferReady {};
+        uint32_t readyStamp {};
+        bool constant {};
         Buffer<float> buffer;
     };
 
+    uint32_t currentStamp(const ModKey& key) const noexcept
+    {
+        return (key.flags() & kModIsPerVoice) ? voiceStamp_ : cycleStamp_;
+    }
+
+    template <class T>
+    bool isReady(const T& item) const noexcept
+    {
+        return item.readyStamp == currentStamp(item.key);
+    }
+
+    template <class T>
+    void setReady(T& item) noexcept
+    {
+        item.readyStamp = currentStamp(item.key);
+    }
+
+    static void nextStamp(uint32_t& stamp) noexcept
+    {
+        // Zero is the stamp of the buffers which were never ready
+        if (++stamp == 0)
+            stamp = 1;
+    }
+
     absl::flat_hash_map<ModKey, uint32_t> sourceIndex_;
     absl::flat_hash_map<ModKey, uint32_t> targetIndex_;
 
@@ -138,7 +177,6 @@ ModMatrix::SourceId ModMatrix::registerSource(const ModKey& key, ModGenerator& g
     Impl::Source &source = impl.sources_.back();
     source.key = key;
     source.gen = &gen;
-    source.bufferReady = false;
     source.buffer.resize(impl.samplesPerBlock_);
 
     impl.sourceIndex_[key] = id.number();
@@ -164,7 +202,6 @@ ModMatrix::TargetId ModMatrix::registerTarget(const ModKey& key)
 
     Impl::Target &target = impl.targets_.back();
     target.key = key;
-    target.bufferReady = false;
     target.buffer.resize(impl.samplesPerBlock_);
 
     impl.targetIndex_[key] = id.number();
@@ -307,15 +344,7 @@ void ModMatrix::beginCycle(unsigned numFrames)
     Impl& impl = *impl_;
 
     impl.numFrames_ = numFrames;
-
-    for (auto idx: impl.sourceIndicesForGlobal_) {
-        Impl::Source& source = impl.sources_[idx];
-        source.bufferReady = false;
-    }
-    for (auto idx: impl.targetIndicesForGlobal_) {
-        Impl::Target& target = impl.targets_[idx];
-        target.bufferReady = false;
-    }
+    Impl::nextStamp(impl.cycleStamp_);
 }
 
 void ModMatrix::endCycle()
@@ -325,7 +354,7 @@ void ModMatrix::endCycle()
 
     for (auto idx: impl.sourceIndicesForGlobal_) {
         Impl::Source& source = impl.sources_[idx];
-        if (!source.bufferReady) {
+        if (!impl.isReady(source)) {
             absl::Span<float> buffer(source.buffer.data(), numFrames);
             source.gen->generateDiscarded(source.key, {}, buffer);
         }
@@ -345,16 +374,7 @@ void ModMatrix::beginVoice(NumericId<Voice> voiceId, NumericId<Region> regionId,
 
     ASSERT(regionId);
 
-    const auto idNumber = static_cast<size_t>(regionId.number());
-    for (auto idx: impl.sourceIndicesForRegion_[idNumber]) {
-        Impl::Source& source = impl.sources_[idx];
-        source.bufferReady = false;
-    }
-
-    for (auto idx: impl.targetIndicesForRegion_[idNumber]) {
-        Impl::Target& target = impl.targets_[idx];
-        target.bufferReady = false;
-    }
+    Impl::nextStamp(impl.voiceStamp_);
 }
 
 void ModMatrix::endVoice()
@@ -371,7 +391,7 @@ void ModMatrix::endVoice()
 
     for (auto idx: impl.sourceIndicesForRegion_[idNumber]) {
         const Impl::Source& source = impl.sources_[idx];
-        if (!source.bufferReady) {
+        if (!impl.isReady(source)) {
             absl::Span<float> buffer(source.buffer.data(), numFrames);
             source.gen->generateDiscarded(source.key, voiceId, buffer);
         }
@@ -403,19 +423,43 @@ float* ModMatrix::getModulation(TargetId targetId)
         return nullptr;
 
     // check if already processed
-    if (target.bufferReady)
+    if (impl.isReady(target))
         return buffer.data();
 
     // set the ready flag to prevent a cycle
     // in case there is, be sure to initialize the buffer
-    target.bufferReady = true;
+    impl.setReady(target);
+    target.constant = false;
+
+    // generate sources in their dedicated buffers, and find out whether
+    // they are all constant over the cycle
+    bool allConstant = true;
+    for (const auto& connection : target.connectedSources) {
+        Impl::Source &source = impl.sources_[connection.first];
+        if ((source.key.flags() & kModIsPerVoice) && regionId != source.key.region())
+            continue;
+
+        if (!impl.isReady(source)) {
+            absl::Span<float> sourceBuffer(source.buffer.data(), numFrames);
+            source.gen->generate(source.key, impl.currentVoiceId_, sourceBuffer);
+            source.constant = isConstantBuffer(sourceBuffer);
+            impl.setReady(source);
+        }
+
+        const TargetId sourceDepthModId = connection.second.sourceDepthModId_;
+        allConstant = allConstant && source.constant
+            && (!getModulation(sourceDepthModId) || isModulationConstant(sourceDepthModId));
+    }
+
+    // with constant sources, the first frame is computed then repeated
+    const uint32_t numComputedFrames = allConstant ? std::min(numFrames, 1u) : numFrames;
+    buffer = buffer.first(numComputedFrames);
 
     auto sourcesPos = target.connectedSources.begin();
     auto sourcesEnd = target.connectedSources.end();
     bool isFirstSource = true;
 
-    // generate sources in their dedicated buffers
-    // then add or multiply, depending on target flags
+    // add or multiply the sources, depending on target flags
     while (sourcesPos != sourcesEnd) {
         Impl::Source &source = impl.sources_[sourcesPos->first];
         const int sourceFlags = source.key.flags();
@@ -426,13 +470,7 @@ float* ModMatrix::getModulation(TargetId targetId)
             useThisSource = (regionId == source.key.region());
 
         if (useThisSource) {
-            absl::Span<float> sourceBuffer(source.buffer.data(), numFrames);
-
-            // unless source is already done, process it
-            if (!source.bufferReady) {
-                source.gen->generate(source.key, impl.currentVoiceId_, sourceBuffer);
-                source.bufferReady = true;
-            }
+            absl::Span<float> sourceBuffer(source.buffer.data(), numComputedFrames);
 
             float sourceDepth = sourcesPos->second.sourceDepth_;
             if (sourceFlags & kModIsPerVoice) {
@@ -446,16 +484,16 @@ float* ModMatrix::getModulation(TargetId targetId)
                 if (sourceDepth == 1 && !sourceDepthMod)
                     copy(absl::Span<const float>(sourceBuffer), buffer);
                 else if (!sourceDepthMod) {
-                    for (uint32_t i = 0; i < numFrames; ++i)
+                    for (uint32_t i = 0; i < numComputedFrames; ++i)
                         buffer[i] = sourceDepth * sourceBuffer[i];
                 }
                 else if (targetFlags & kModIsMultiplicative) {
-                    for (uint32_t i = 0; i < numFrames; ++i)
+                    for (uint32_t i = 0; i < numComputedFrames; ++i)
                         buffer[i] = (sourceDepth * sourceDepthMod[i]) * sourceBuffer[i];
                 }
                 else {
                     ASSERT(targetFlags & kModIsAdditive);
-                    for (uint32_t i = 0; i < numFrames; ++i)
+                    for (uint32_t i = 0; i < numComputedFrames; ++i)
                         buffer[i] = (sourceDepth + sourceDepthMod[i]) * sourceBuffer[i];
                 }
                 isFirstSource = false;
@@ -465,7 +503,7 @@ float* ModMatrix::getModulation(TargetId targetId)
                     if (!sourceDepthMod)
                         multiplyMul1<float>(sourceDepth, sourceBuffer, buffer);
                     else {
-                        for (uint32_t i = 0; i < numFrames; ++i)
+                        for (uint32_t i = 0; i < numComputedFrames; ++i)
                             buffer[i] *= (sourceDepth * sourceDepthMod[i]) * sourceBuffer[i];
                     }
                 }
@@ -474,7 +512,7 @@ float* ModMatrix::getModulation(TargetId targetId)
                     if (!sourceDepthMod)
                         multiplyAdd1<float>(sourceDepth, sourceBuffer, buffer);
                     else {
-                        for (uint32_t i = 0; i < numFrames; ++i)
+                        for (uint32_t i = 0; i < numComputedFrames; ++i)
                             buffer[i] += (sourceDepth + sourceDepthMod[i]) * sourceBuffer[i];
                     }
                 }
@@ -494,9 +532,26 @@ float* ModMatrix::getModulation(TargetId targetId)
         }
     }
 
+    buffer = absl::Span<float>(target.buffer.data(), numFrames);
+    if (allConstant) {
+        if (numComputedFrames > 0)
+            fill(buffer, buffer.front());
+        target.constant = true;
+    }
+
     return buffer.data();
 }
 
+bool ModMatrix::isModulationConstant(TargetId targetId) const
+{
+    if (!validTarget(targetId))
+        return false;
+
+    const Impl& impl = *impl_;
+    const Impl::Target& target = impl.targets_[targetId.number()];
+    return impl.isReady(target) && target.constant;
+}
+
 bool ModMatrix::validTarget(TargetId id) const
 {
     return static_cast<unsigned>(id.number()) < impl_->targets_.size();
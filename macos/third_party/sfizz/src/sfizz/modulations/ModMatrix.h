@@ -127,7 +127,7 @@ public:
 
     /**
      * @brief Start modulation processing for the entire cycle.
-     * This clears all the buffers.
+     * This invalidates all the buffers, in constant time.
      *
      * @param numFrames
      */
@@ -141,7 +141,7 @@ public:
 
     /**
      * @brief Start modulation processing for a given voice.
-     * This clears all the buffers which are per-voice.
+     * This invalidates all the buffers which are per-voice, in constant time.
      *
      * @param voiceId the identifier of the current voice
      * @param regionId the identifier of the region of the current voice
@@ -172,6 +172,16 @@ public:
     float* getModulationByKey(const ModKey& targetKey)
         { return getModulation(findTarget(targetKey)); }
 
+    /**
+     * @brief Return whether the modulation buffer of the target holds the
+     * same value for all the frames, because all its sources were constant.
+     * Only the first value of the buffer is needed then.
+     * Call this after `getModulation` for the same target.
+     *
+     * @param targetId identifier of the modulation target
+     */
+    bool isModulationConstant(TargetId targetId) const;
+
     /**
      * @brief Return whether the target identifier is valid.
      *
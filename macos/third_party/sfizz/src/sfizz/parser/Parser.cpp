@@ -26,6 +26,7 @@ void Parser::clear()
     _currentDefinitions = _externalDefinitions;
     _currentHeader.reset();
     _currentOpcodes.clear();
+    _recordedBlocks.clear();
     _errorCount = 0;
     _warningCount = 0;
 }
@@ -42,7 +43,21 @@ void Parser::clearExternalDefinitions()
 
 void Parser::parseFile(const fs::path& path)
 {
+    if (_cacheDirectory.empty()) {
+        parseVirtualFile(path, nullptr);
+        return;
+    }
+
+    if (replayCache(path))
+        return;
+
+    _recordingBlocks = true;
     parseVirtualFile(path, nullptr);
+    _recordingBlocks = false;
+
+    if (_errorCount == 0 && _warningCount == 0)
+        writeCache(path);
+    _recordedBlocks.clear();
 }
 
 void Parser::parseString(const fs::path& path, absl::string_view sfzView)
@@ -403,6 +418,8 @@ void Parser::flushCurrentHeader()
     if (_currentHeader) {
         if (_listener)
             _listener->onParseFullBlock(*_currentHeader, _currentOpcodes);
+        if (_recordingBlocks)
+            _recordedBlocks.emplace_back(*_currentHeader, _currentOpcodes);
         _currentHeader.reset();
     }
 
@@ -40,6 +40,16 @@ public:
     void setRecursiveIncludeGuardEnabled(bool en) { _recursiveIncludeGuardEnabled = en; }
     void setMaximumIncludeDepth(size_t depth) { _maxIncludeDepth = depth; }
 
+    /**
+     * @brief Keep the outcome of parsing files in a binary cache in this
+     * directory, so that parseFile replays it instead of parsing when
+     * neither the file, the files it includes nor the external definitions
+     * changed. Only parses without errors nor warnings are cached.
+     * An empty path disables the cache, which is the default.
+     */
+    void setCacheDirectory(const fs::path& directory) { _cacheDirectory = directory; }
+    const fs::path& cacheDirectory() const noexcept { return _cacheDirectory; }
+
     const fs::path& originalDirectory() const noexcept { return _originalDirectory; }
 
     typedef absl::flat_hash_set<std::string> IncludeFileSet;
@@ -73,6 +83,11 @@ private:
     // state handling
     void flushCurrentHeader();
 
+    // binary cache, in ParserCache.cpp
+    fs::path cacheFilePath(const fs::path& path, uint64_t& key) const;
+    bool replayCache(const fs::path& path);
+    void writeCache(const fs::path& path) const;
+
     // helpers
     enum class CommentType {
         None,
@@ -110,6 +125,11 @@ private:
     absl::optional<std::string> _currentHeader;
     std::vector<Opcode> _currentOpcodes;
 
+    // binary cache
+    fs::path _cacheDirectory;
+    bool _recordingBlocks = false;
+    std::vector<std::pair<std::string, std::vector<Opcode>>> _recordedBlocks;
+
     // errors and warnings
     size_t _errorCount = 0;
     size_t _warningCount = 0;
@@ -0,0 +1,274 @@
+// SPDX-License-Identifier: BSD-2-Clause
+
+// This code is part of the sfizz library and is licensed under a BSD 2-clause
+// license. You should have receive a LICENSE.md file along with the code.
+// If not, contact the sfizz maintainers at https://github.com/sfztools/sfizz
+
+#include "Parser.h"
+#include "ParserListener.h"
+#include "utility/StringViewHelpers.h"
+#include <absl/strings/str_cat.h>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+// The cache holds what a parse of the file delivered to the listener: the
+// full blocks with their opcodes after includes and definitions were
+// resolved, along with the state that the parser exposes afterwards. Each
+// included file is stored with its size and a hash of its contents, and
+// any difference makes the cache stale.
+//
+// The cache is meant to stay on the machine which wrote it, so numbers are
+// stored in native byte order.
+
+namespace sfz {
+
+namespace {
+
+constexpr char cacheMagic[] = { 'S', 'F', 'Z', 'C' };
+// Increment whenever the format, or what the parser delivers, changes
+constexpr uint32_t cacheVersion = 1;
+
+uint64_t hashBytes(absl::string_view bytes, uint64_t h = Fnv1aBasis)
+{
+    for (char c : bytes)
+        h = hashByte(static_cast<uint8_t>(c), h);
+    return h;
+}
+
+bool readWholeFile(const fs::path& path, std::string& contents)
+{
+    fs::ifstream stream(path, std::ios::binary);
+    if (!stream)
+        return false;
+
+    contents.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    return !stream.bad();
+}
+
+class CacheWriter {
+public:
+    void write(uint64_t number)
+    {
+        char bytes[sizeof(number)];
+        std::memcpy(bytes, &number, sizeof(number));
+        data_.append(bytes, sizeof(number));
+    }
+
+    void write(absl::string_view text)
+    {
+        write(static_cast<uint64_t>(text.size()));
+        data_.append(text.data(), text.size());
+    }
+
+    const std::string& data() const noexcept { return data_; }
+
+private:
+    std::string data_;
+};
+
+class CacheReader {
+public:
+    explicit CacheReader(absl::string_view data)
+        : data_(data)
+    {
+    }
+
+    bool read(uint64_t& number)
+    {
+        if (data_.size() < sizeof(number))
+            return false;
+        std::memcpy(&number, data_.data(), sizeof(number));
+        data_.remove_prefix(sizeof(number));
+        return true;
+    }
+
+    bool read(std::string& text)
+    {
+        uint64_t size;
+        if (!read(size) || data_.size() < size)
+            return false;
+        text.assign(data_.data(), size);
+        data_.remove_prefix(size);
+        return true;
+    }
+
+    bool atEnd() const noexcept { return data_.empty(); }
+
+private:
+    absl::string_view data_;
+};
+
+void writeHeader(CacheWriter& writer, uint64_t key)
+{
+    writer.write(absl::string_view(cacheMagic, sizeof(cacheMagic)));
+    writer.write(static_cast<uint64_t>(cacheVersion));
+    writer.write(key);
+}
+
+bool readHeader(CacheReader& reader, uint64_t key)
+{
+    std::string magic;
+    uint64_t version = 0;
+    uint64_t storedKey = 0;
+    return reader.read(magic) && magic == absl::string_view(cacheMagic, sizeof(cacheMagic))
+        && reader.read(version) && version == cacheVersion
+        && reader.read(storedKey) && storedKey == key;
+}
+
+} // namespace
+
+fs::path Parser::cacheFilePath(const fs::path& path, uint64_t& key) const
+{
+    std::vector<std::pair<std::string, std::string>> definitions(
+        _externalDefinitions.begin(), _externalDefinitions.end());
+    std::sort(definitions.begin(), definitions.end());
+
+    key = hashBytes(path.string());
+    for (const auto& definition : definitions) {
+        key = hashBytes(definition.first, hashByte(0, key));
+        key = hashBytes(definition.second, hashByte(0, key));
+    }
+
+    return _cacheDirectory / absl::StrCat(absl::Hex(key, absl::kZeroPad16), ".sfzcache");
+}
+
+bool Parser::replayCache(const fs::path& path)
+{
+    uint64_t key;
+    const fs::path cachePath = cacheFilePath(path, key);
+
+    std::string data;
+    if (!readWholeFile(cachePath, data))
+        return false;
+
+    CacheReader reader { data };
+    if (!readHeader(reader, key))
+        return false;
+
+    std::string originalDirectory;
+    if (!reader.read(originalDirectory))
+        return false;
+
+    uint64_t count;
+    IncludeFileSet pathsIncluded;
+    if (!reader.read(count))
+        return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string includedPath;
+        uint64_t contentsHash;
+        std::string contents;
+        if (!reader.read(includedPath) || !reader.read(contentsHash))
+            return false;
+        if (!readWholeFile(includedPath, contents) || hashBytes(contents) != contentsHash)
+            return false;
+        pathsIncluded.insert(std::move(includedPath));
+    }
+
+    DefinitionSet definitions;
+    if (!reader.read(count))
+        return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string id;
+        std::string value;
+        if (!reader.read(id) || !reader.read(value))
+            return false;
+        definitions[id] = std::move(value);
+    }
+
+    std::vector<std::pair<std::string, std::vector<Opcode>>> blocks;
+    if (!reader.read(count))
+        return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string header;
+        uint64_t opcodeCount;
+        if (!reader.read(header) || !reader.read(opcodeCount))
+            return false;
+        std::vector<Opcode> opcodes;
+        for (uint64_t j = 0; j < opcodeCount; ++j) {
+            std::string name;
+            std::string value;
+            if (!reader.read(name) || !reader.read(value))
+                return false;
+            opcodes.emplace_back(name, value);
+        }
+        blocks.emplace_back(std::move(header), std::move(opcodes));
+    }
+
+    if (!reader.atEnd())
+        return false;
+
+    clear();
+    _originalDirectory = originalDirectory;
+    _pathsIncluded = std::move(pathsIncluded);
+    _currentDefinitions = std::move(definitions);
+
+    if (_listener) {
+        _listener->onParseBegin();
+        for (const auto& block : blocks)
+            _listener->onParseFullBlock(block.first, block.second);
+        _listener->onParseEnd();
+    }
+
+    return true;
+}
+
+void Parser::writeCache(const fs::path& path) const
+{
+    uint64_t key;
+    const fs::path cachePath = cacheFilePath(path, key);
+
+    CacheWriter writer;
+    writeHeader(writer, key);
+    writer.write(_originalDirectory.string());
+
+    writer.write(static_cast<uint64_t>(_pathsIncluded.size()));
+    for (const std::string& includedPath : _pathsIncluded) {
+        // Hash what is on disk now, an edit made during the parse then
+        // makes the cache stale rather than hiding the edit
+        std::string contents;
+        if (!readWholeFile(includedPath, contents))
+            return;
+        writer.write(includedPath);
+        writer.write(hashBytes(contents));
+    }
+
+    writer.write(static_cast<uint64_t>(_currentDefinitions.size()));
+    for (const auto& definition : _currentDefinitions) {
+        writer.write(definition.first);
+        writer.write(definition.second);
+    }
+
+    writer.write(static_cast<uint64_t>(_recordedBlocks.size()));
+    for (const auto& block : _recordedBlocks) {
+        writer.write(block.first);
+        writer.write(static_cast<uint64_t>(block.second.size()));
+        for (const Opcode& opcode : block.second) {
+            writer.write(opcode.name);
+            writer.write(opcode.value);
+        }
+    }
+
+    // Write aside and rename, so that other instances loading the same
+    // file never read a partial cache
+    std::error_code ec;
+    fs::create_directories(_cacheDirectory, ec);
+    const fs::path tempPath = absl::StrCat(cachePath.string(), ".",
+        std::hash<std::thread::id>()(std::this_thread::get_id()), ".tmp");
+    {
+        fs::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+        if (!stream)
+            return;
+        stream.write(writer.data().data(), writer.data().size());
+        if (!stream.flush()) {
+            stream.close();
+            fs::remove(tempPath, ec);
+            return;
+        }
+    }
+    fs::rename(tempPath, cachePath, ec);
+    if (ec)
+        fs::remove(tempPath, ec);
+}
+
+} // namespace sfz
@@ -175,6 +175,11 @@ void sfz::Sfizz::hdNoteOn(int delay, int noteNumber, float velocity) noexcept
     synth->synth.hdNoteOn(delay, noteNumber, velocity);
 }
 
+void sfz::Sfizz::prefetchNote(int noteNumber, float velocity, float seconds) noexcept
+{
+    synth->synth.prefetchNote(noteNumber, velocity, seconds);
+}
+
 void sfz::Sfizz::noteOff(int delay, int noteNumber, int velocity) noexcept
 {
     synth->synth.noteOff(delay, noteNumber, velocity);
@@ -286,15 +291,23 @@ void sfz::Sfizz::setNumVoices(int numVoices) noexcept
     synth->synth.setNumVoices(numVoices);
 }
 
-bool sfz::Sfizz::setOversamplingFactor(int) noexcept
+bool sfz::Sfizz::setOversamplingFactor(int factor) noexcept
 {
-    return true;
+    switch (factor) {
+    case 1:
+    case 2:
+    case 4:
+    case 8:
+        synth->synth.setOversamplingFactor(static_cast<sfz::Oversampling>(factor));
+        return true;
+    default:
+        return false;
+    }
 }
 
-
 int sfz::Sfizz::getOversamplingFactor() const noexcept
 {
-    return 1;
+    return static_cast<int>(synth->synth.getOversamplingFactor());
 }
 
 void sfz::Sfizz::setPreloadSize(uint32_t preloadSize) noexcept
@@ -307,6 +320,41 @@ uint32_t sfz::Sfizz::getPreloadSize() const noexcept
     return synth->synth.getPreloadSize();
 }
 
+void sfz::Sfizz::setSharedSampleCache(bool shared) noexcept
+{
+    synth->synth.setSharedSampleCache(shared);
+}
+
+size_t sfz::Sfizz::getSharedSampleCacheMemory() noexcept
+{
+    return sfz::Synth::getSharedSampleCacheMemory();
+}
+
+void sfz::Sfizz::setSampleMemoryMapping(bool mapped) noexcept
+{
+    synth->synth.setSampleMemoryMapping(mapped);
+}
+
+void sfz::Sfizz::setSampleStorage(SampleStorage storage) noexcept
+{
+    synth->synth.setSampleStorage(static_cast<sfz::SampleStorage>(storage));
+}
+
+void sfz::Sfizz::setFilterBatching(bool batching) noexcept
+{
+    synth->synth.setFilterBatching(batching);
+}
+
+size_t sfz::Sfizz::getStreamUnderruns() const noexcept
+{
+    return synth->synth.getStreamUnderruns();
+}
+
+void sfz::Sfizz::setInstrumentCacheDirectory(const std::string& directory) noexcept
+{
+    synth->synth.setInstrumentCacheDirectory(directory);
+}
+
 int sfz::Sfizz::getAllocatedBuffers() const noexcept
 {
     return synth->synth.getAllocatedBuffers();
@@ -122,6 +122,10 @@ void sfizz_send_hd_note_on(sfizz_synth_t* synth, int delay, int note_number, flo
 {
     synth->synth.hdNoteOn(delay, note_number, velocity);
 }
+void sfizz_prefetch_note(sfizz_synth_t* synth, int note_number, float velocity, float seconds)
+{
+    synth->synth.prefetchNote(note_number, velocity, seconds);
+}
 void sfizz_send_note_off(sfizz_synth_t* synth, int delay, int note_number, int velocity)
 {
     synth->synth.noteOff(delay, note_number, velocity);
@@ -210,14 +214,58 @@ void sfizz_set_preload_size(sfizz_synth_t* synth, unsigned int preload_size)
     synth->synth.setPreloadSize(preload_size);
 }
 
-sfizz_oversampling_factor_t sfizz_get_oversampling_factor(sfizz_synth_t*)
+void sfizz_set_shared_sample_cache(sfizz_synth_t* synth, bool shared)
+{
+    synth->synth.setSharedSampleCache(shared);
+}
+
+size_t sfizz_get_shared_sample_cache_memory(void)
+{
+    return sfz::Synth::getSharedSampleCacheMemory();
+}
+
+void sfizz_set_sample_memory_mapping(sfizz_synth_t* synth, bool mapped)
+{
+    synth->synth.setSampleMemoryMapping(mapped);
+}
+
+void sfizz_set_sample_storage(sfizz_synth_t* synth, sfizz_sample_storage_t storage)
+{
+    synth->synth.setSampleStorage(static_cast<sfz::SampleStorage>(storage));
+}
+
+void sfizz_set_filter_batching(sfizz_synth_t* synth, bool batching)
+{
+    synth->synth.setFilterBatching(batching);
+}
+
+size_t sfizz_get_stream_underruns(sfizz_synth_t* synth)
+{
+    return synth->synth.getStreamUnderruns();
+}
+
+void sfizz_set_instrument_cache_directory(sfizz_synth_t* synth, const char* directory)
+{
+    synth->synth.setInstrumentCacheDirectory(directory ? directory : "");
+}
+
+sfizz_oversampling_factor_t sfizz_get_oversampling_factor(sfizz_synth_t* synth)
 {
-    return SFIZZ_OVERSAMPLING_X1;
+    return static_cast<sfizz_oversampling_factor_t>(synth->synth.getOversamplingFactor());
 }
 
-bool sfizz_set_oversampling_factor(sfizz_synth_t*, sfizz_oversampling_factor_t)
+bool sfizz_set_oversampling_factor(sfizz_synth_t* synth, sfizz_oversampling_factor_t oversampling)
 {
-    return true;
+    switch (oversampling) {
+    case SFIZZ_OVERSAMPLING_X1:
+    case SFIZZ_OVERSAMPLING_X2:
+    case SFIZZ_OVERSAMPLING_X4:
+    case SFIZZ_OVERSAMPLING_X8:
+        synth->synth.setOversamplingFactor(static_cast<sfz::Oversampling>(oversampling));
+        return true;
+    default:
+        return false;
+    }
 }
 
 int sfizz_get_sample_quality(sfizz_synth_t* synth, sfizz_process_mode_t mode)
@@ -0,0 +1,102 @@
+import 'dart:ffi';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:flutter_sequencer/models/command_batch.dart';
+import 'package:flutter_sequencer/models/events.dart';
+import 'package:flutter_sequencer/native_bridge.dart';
+
+const TRACK_COUNT = 64;
+const EVENTS_PER_TRACK = 256;
+const SAMPLE_RATE = 44100;
+const TEMPO = 120.0;
+const WARMUP_ITERATIONS = 20;
+const TIMED_ITERATIONS = 100;
+
+List<SchedulerEvent> buildTrackEvents(int trackIndex) {
+  return List.generate(
+      EVENTS_PER_TRACK,
+      (i) => MidiEvent.ofNoteOn(
+          beat: i / 4, noteNumber: (trackIndex + i) % 128, velocity: 100));
+}
+
+/// A resync of every track, as Sequence._syncAllTracks builds it.
+CommandBatch buildResync(List<List<SchedulerEvent>> trackEvents) {
+  final batch = CommandBatch();
+
+  for (var trackIndex = 0; trackIndex < trackEvents.length; trackIndex++) {
+    batch.clearEvents(trackIndex, 0);
+    batch.scheduleEvents(
+        trackIndex, trackEvents[trackIndex], SAMPLE_RATE, TEMPO);
+  }
+
+  return batch;
+}
+
+/// The mean time of a UI isolate operation, in microseconds.
+double timeMicroseconds(void Function() operation) {
+  for (var i = 0; i < WARMUP_ITERATIONS; i++) {
+    operation();
+  }
+
+  final stopwatch = Stopwatch()..start();
+  for (var i = 0; i < TIMED_ITERATIONS; i++) {
+    operation();
+  }
+
+  return stopwatch.elapsedMicroseconds / TIMED_ITERATIONS;
+}
+
+void main() {
+  group('CommandBatch', () {
+    final trackEvents = List.generate(TRACK_COUNT, buildTrackEvents);
+
+    test('serializes a resync of every track into one buffer', () {
+      final bytes = buildResync(trackEvents).serialize();
+      final data = ByteData.sublistView(bytes);
+      const scheduleLength =
+          BATCH_COMMAND_HEADER_SIZE + EVENTS_PER_TRACK * SCHEDULER_EVENT_SIZE;
+
+      expect(bytes.length,
+          TRACK_COUNT * (BATCH_COMMAND_HEADER_SIZE + scheduleLength));
+
+      // The last track's schedule command follows its clear command
+      final lastClear = (TRACK_COUNT - 1) *
+          (BATCH_COMMAND_HEADER_SIZE + scheduleLength);
+      final lastSchedule = lastClear + BATCH_COMMAND_HEADER_SIZE;
+      expect(data.getInt32(lastClear, Endian.host), TRACK_COUNT - 1);
+      expect(data.getUint32(lastClear + 4, Endian.host),
+          BatchCommand.CLEAR_EVENTS);
+      expect(data.getInt32(lastSchedule, Endian.host), TRACK_COUNT - 1);
+      expect(data.getUint32(lastSchedule + 4, Endian.host),
+          BatchCommand.SCHEDULE_EVENTS);
+      expect(data.getUint32(lastSchedule + 8, Endian.host), EVENTS_PER_TRACK);
+    });
+
+    test('times a resync of 64 tracks against per-track calls', () {
+      // What NativeBridge.applyBatch does before the native call
+      final batchUs = timeMicroseconds(() {
+        final bytes = buildResync(trackEvents).serialize();
+        final commandData = malloc.allocate<Uint8>(bytes.length);
+        commandData.asTypedList(bytes.length).setAll(0, bytes);
+        malloc.free(commandData);
+      });
+
+      // What NativeBridge.scheduleEvents does for each track before its own
+      // native call
+      final perTrackUs = timeMicroseconds(() {
+        for (final events in trackEvents) {
+          NativeBridge.serializeEventsForTesting(events, SAMPLE_RATE, TEMPO);
+        }
+      });
+
+      print('Resync of $TRACK_COUNT tracks with $EVENTS_PER_TRACK events '
+          'each: batch ${batchUs.toStringAsFixed(0)} us, '
+          'per-track calls ${perTrackUs.toStringAsFixed(0)} us');
+
+      expect(batchUs, greaterThan(0));
+      expect(perTrackUs, greaterThan(0));
+    });
+  });
+}